@@ -26,6 +26,21 @@
  */
 #define palloc(ptr, ...) _tgalloc_palloc_choose(__VA_ARGS__)(ptr __VA_OPT__(,) __VA_ARGS__)
 
+// Helper macro for choosing between single and array zeroed allocation
+#define _tgalloc_pcalloc_choose(...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_pcalloc2, _tgalloc_pcalloc1)
+
+/**
+ * @brief Allocate zeroed memory for an object or array of objects
+ * 
+ * Same as palloc, but every byte of the new memory is zero. Backends with a
+ * TGA_CALLOC_A_S hook can skip clearing memory that is already zero.
+ * 
+ * @param ptr Pointer that will receive the allocated memory
+ * @param ... Optional length parameter for array allocations
+ * @return The assigned pointer (for chaining operations)
+ */
+#define pcalloc(ptr, ...) _tgalloc_pcalloc_choose(__VA_ARGS__)(ptr __VA_OPT__(,) __VA_ARGS__)
+
 // Helper macro for choosing between single and array free functions
 #define _tgalloc_pfree_choose(...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_pfree2, _tgalloc_pfree1)
 
@@ -40,4 +55,53 @@
  */
 #define pfree(ptr, ...) _tgalloc_pfree_choose(__VA_ARGS__)(ptr __VA_OPT__(,) __VA_ARGS__)
 
+/**
+ * @brief Allocate memory through a run-time allocator handle
+ * 
+ * Same as palloc, but through the tga_allocator `alloc` points to instead
+ * of the compile-time TGA.
+ * 
+ * @param alloc Pointer to the tga_allocator to allocate from
+ * @param ptr   Pointer that will receive the allocated memory
+ * @param ...   Optional length parameter for array allocations
+ * @return The assigned pointer (for chaining operations)
+ */
+#define palloc_with(alloc, ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_palloc_with2, _tgalloc_palloc_with1)(alloc, ptr __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief Allocate zeroed memory through a run-time allocator handle
+ */
+#define pcalloc_with(alloc, ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_pcalloc_with2, _tgalloc_pcalloc_with1)(alloc, ptr __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief Free memory allocated through a run-time allocator handle
+ * 
+ * @param alloc Pointer to the tga_allocator the memory came from
+ * @param ptr   Pointer to the memory to free
+ * @param ...   Optional length parameter for array allocations
+ */
+#define pfree_with(alloc, ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_pfree_with2, _tgalloc_pfree_with1)(alloc, ptr __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief Allocate like palloc, on cache lines no other block shares
+ * 
+ * Rounds the alignment and the size up to TGA_INTERFERENCE_SIZE, so objects
+ * written by different threads, such as per-thread counters, cannot false
+ * share with each other or with neighbouring allocations. Free the memory
+ * with pfree_isolated.
+ * 
+ * @param ptr Pointer that will receive the allocated memory
+ * @param ... Optional length parameter for array allocations
+ * @return The assigned pointer (for chaining operations)
+ */
+#define palloc_isolated(ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_palloc_isolated2, _tgalloc_palloc_isolated1)(ptr __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief Free memory allocated with palloc_isolated
+ * 
+ * @param ptr Pointer to the memory to free
+ * @param ... Optional length parameter for array allocations
+ */
+#define pfree_isolated(ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_pfree_isolated2, _tgalloc_pfree_isolated1)(ptr __VA_OPT__(,) __VA_ARGS__)
+
 #endif // TGALLOC_C23_H
@@ -0,0 +1,112 @@
+#ifndef TGALLOC_SYNC_H
+#define TGALLOC_SYNC_H
+
+// Minimal portable locking and thread-specific storage for the thread-aware
+// backends. POSIX threads are used everywhere except on Windows.
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+
+    typedef SRWLOCK _tgalloc_mutex_t;
+    // Returns 0, like pthread_mutex_init on success; SRW locks cannot fail to initialise
+    static inline int _tgalloc_mutex_init(_tgalloc_mutex_t * m){
+        InitializeSRWLock(m);
+        return 0;
+    }
+    #define _tgalloc_mutex_destroy(m) ((void)(m))
+    #define _tgalloc_mutex_lock(m) AcquireSRWLockExclusive(m)
+    #define _tgalloc_mutex_unlock(m) ReleaseSRWLockExclusive(m)
+
+    // Destructors run for every thread that stored a non-NULL value
+    #define _TGALLOC_TLS_DTOR NTAPI
+    typedef DWORD _tgalloc_tls_key_t;
+    static inline int _tgalloc_tls_create(_tgalloc_tls_key_t * key, void (_TGALLOC_TLS_DTOR * dtor)(void *)){
+        *key = FlsAlloc(dtor);
+        return *key == FLS_OUT_OF_INDEXES ? -1 : 0;
+    }
+    #define _tgalloc_tls_delete(key) ((void)FlsFree(key))
+    #define _tgalloc_tls_get(key) FlsGetValue(key)
+    #define _tgalloc_tls_set(key, value) ((void)FlsSetValue((key), (value)))
+#else
+    #include <pthread.h>
+
+    typedef pthread_mutex_t _tgalloc_mutex_t;
+    // Returns 0 on success, an error number otherwise
+    #define _tgalloc_mutex_init(m) pthread_mutex_init((m), NULL)
+    #define _tgalloc_mutex_destroy(m) ((void)pthread_mutex_destroy(m))
+    #define _tgalloc_mutex_lock(m) ((void)pthread_mutex_lock(m))
+    #define _tgalloc_mutex_unlock(m) ((void)pthread_mutex_unlock(m))
+
+    // Destructors run for every thread that stored a non-NULL value
+    #define _TGALLOC_TLS_DTOR
+    typedef pthread_key_t _tgalloc_tls_key_t;
+    #define _tgalloc_tls_create(key, dtor) pthread_key_create((key), (dtor))
+    #define _tgalloc_tls_delete(key) ((void)pthread_key_delete(key))
+    #define _tgalloc_tls_get(key) pthread_getspecific(key)
+    #define _tgalloc_tls_set(key, value) ((void)pthread_setspecific((key), (value)))
+#endif
+
+// Atomic operations on size_t and pointer-sized objects
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    // Interlocked operations are full barriers, so the order is ignored
+    #define _TGALLOC_RELAXED 0
+    #define _TGALLOC_ACQUIRE 0
+    #define _TGALLOC_RELEASE 0
+    #define _TGALLOC_ACQ_REL 0
+    #define _tgalloc_atomic_load(p, order) \
+        ((void)(order), (_tgalloc_typeof(*(p)))_InterlockedOr64((volatile __int64*)(p), 0))
+    #define _tgalloc_atomic_store(p, v, order) \
+        ((void)(order), (void)_InterlockedExchange64((volatile __int64*)(p), (__int64)(v)))
+    #define _tgalloc_atomic_fetch_add(p, v, order) \
+        ((void)(order), (size_t)_InterlockedExchangeAdd64((volatile __int64*)(p), (__int64)(v)))
+    #define _tgalloc_atomic_exchange(p, v, order) \
+        ((void)(order), (_tgalloc_typeof(*(p)))_InterlockedExchange64((volatile __int64*)(p), (__int64)(v)))
+    // Compare *p with *expected; on mismatch store the current value in *expected
+    static inline int _tgalloc_atomic_cas_impl(volatile __int64 * p, __int64 * expected, __int64 desired){
+        __int64 seen = _InterlockedCompareExchange64(p, desired, *expected);
+        if (seen == *expected) return 1;
+        *expected = seen;
+        return 0;
+    }
+    #define _tgalloc_atomic_cas(p, expected, desired, order) \
+        ((void)(order), _tgalloc_atomic_cas_impl((volatile __int64*)(p), (__int64*)(expected), (__int64)(desired)))
+    #define _tgalloc_atomic_fence() MemoryBarrier()
+#else
+    #define _TGALLOC_RELAXED __ATOMIC_RELAXED
+    #define _TGALLOC_ACQUIRE __ATOMIC_ACQUIRE
+    #define _TGALLOC_RELEASE __ATOMIC_RELEASE
+    #define _TGALLOC_ACQ_REL __ATOMIC_ACQ_REL
+    #define _tgalloc_atomic_load(p, order) __atomic_load_n((p), (order))
+    #define _tgalloc_atomic_store(p, v, order) __atomic_store_n((p), (v), (order))
+    #define _tgalloc_atomic_fetch_add(p, v, order) __atomic_fetch_add((p), (v), (order))
+    #define _tgalloc_atomic_exchange(p, v, order) __atomic_exchange_n((p), (v), (order))
+    // Compare *p with *expected; on mismatch store the current value in *expected
+    #define _tgalloc_atomic_cas(p, expected, desired, order) \
+        __atomic_compare_exchange_n((p), (expected), (desired), 1, (order), __ATOMIC_RELAXED)
+    // Full barrier: no load or store moves across it in either direction
+    #define _tgalloc_atomic_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+// Thread-local storage class for plain variables
+#if defined(__cplusplus)
+    #define _tgalloc_thread_local thread_local
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define _tgalloc_thread_local _Thread_local
+#elif defined(_MSC_VER)
+    #define _tgalloc_thread_local __declspec(thread)
+#else
+    #define _tgalloc_thread_local __thread
+#endif
+
+// Objects defined in headers but shared by every translation unit of a program
+#if defined(_MSC_VER)
+    #define _TGALLOC_WEAK __declspec(selectany)
+#else
+    #define _TGALLOC_WEAK __attribute__((weak))
+#endif
+
+#endif // TGALLOC_SYNC_H
@@ -0,0 +1,260 @@
+/**
+ * @file tgalloc_bench.c
+ * @brief Throughput, latency and memory benchmarks of the bundled backends
+ *
+ * Every workload of tgalloc_bench_workloads.h is run through palloc, pfree
+ * and pprealloc of every backend below, on 1, 2, 4, ... up to the requested
+ * number of threads for the thread-safe backends. Per run, one line reports
+ * operations per second, the p50/p99/p999 latency of a single call in
+ * nanoseconds, and the resident set at the workload's peak.
+ *
+ * Usage: tgalloc_bench [-n ops per thread] [-t max threads] [-b backend] [-w workload]
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "tgalloc_bench.h"
+#include "../tgalloc_arena.h"
+#include "../tgalloc_tcache.h"
+#include "../tgalloc_theap.h"
+#include "../tgalloc_large.h"
+#include "../tgalloc_pool.h"
+#include "../tgalloc_slab.h"
+
+// Object of the fixed-size workloads
+typedef struct {
+    long id;
+    long payload[7];
+} bench_object;
+
+TGPOOL_DEFINE(bench_object)
+
+// Instances of the backends, set up fresh for every run
+tga_arena_t arena;
+tga_arena_t tcache_arena;
+tga_tcache_t tcache;
+tgpool(bench_object) pool;
+tga_theap_t theap;
+tga_slab_t slab;
+tga_large_t large;
+
+static void default_setup(void){}
+static void default_teardown(void){}
+
+#define BENCH_BACKEND default
+#include "tgalloc_bench_workloads.h"
+
+static void arena_setup(void){ tga_arena_init(&arena); }
+static void arena_teardown(void){ tga_arena_destroy(&arena); }
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_arena_t*)&arena
+#define TGA_ALLOC_A_S tga_arena_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_arena_realloc_aligned_sized
+#define TGA_FREE_A_S tga_arena_free_aligned_sized
+#define TGA_EXPAND_A_S tga_arena_expand_aligned_sized
+
+#define BENCH_BACKEND arena
+#include "tgalloc_bench_workloads.h"
+
+static void tcache_setup(void){
+    tga_arena_init(&tcache_arena);
+    tga_tcache_init(&tcache, TGA_BACKEND(&tcache_arena, tga_arena_alloc_aligned_sized,
+                                         tga_arena_realloc_aligned_sized, tga_arena_free_aligned_sized));
+}
+static void tcache_teardown(void){
+    tga_tcache_destroy(&tcache);
+    tga_arena_destroy(&tcache_arena);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_tcache_t*)&tcache
+#define TGA_ALLOC_A_S tga_tcache_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_tcache_realloc_aligned_sized
+#define TGA_FREE_A_S tga_tcache_free_aligned_sized
+#define TGA_EXPAND_A_S tga_tcache_expand_aligned_sized
+
+#define BENCH_BACKEND tcache
+#include "tgalloc_bench_workloads.h"
+
+static void pool_setup(void){ tgpool_bench_object_init(&pool); }
+static void pool_teardown(void){ tgpool_bench_object_destroy(&pool); }
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tgpool(bench_object)*)&pool
+#define TGA_ALLOC_A_S tgpool_bench_object_alloc_aligned_sized
+#define TGA_REALLOC_A_S tgpool_bench_object_realloc_aligned_sized
+#define TGA_FREE_A_S tgpool_bench_object_free_aligned_sized
+#define TGA_EXPAND_A_S tgpool_bench_object_expand_aligned_sized
+
+#define BENCH_BACKEND pool
+#include "tgalloc_bench_workloads.h"
+
+static void slab_setup(void){ tga_slab_init(&slab); }
+static void slab_teardown(void){ tga_slab_destroy(&slab); }
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_slab_t*)&slab
+#define TGA_ALLOC_A_S tga_slab_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_slab_realloc_aligned_sized
+#define TGA_FREE_A_S tga_slab_free_aligned_sized
+#define TGA_EXPAND_A_S tga_slab_expand_aligned_sized
+
+#define BENCH_BACKEND slab
+#include "tgalloc_bench_workloads.h"
+
+static void theap_setup(void){ tga_theap_init(&theap, TGA_BACKEND_DEFAULT); }
+static void theap_teardown(void){ tga_theap_destroy(&theap); }
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_theap_t*)&theap
+#define TGA_ALLOC_A_S tga_theap_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_theap_realloc_aligned_sized
+#define TGA_FREE_A_S tga_theap_free_aligned_sized
+#define TGA_EXPAND_A_S tga_theap_expand_aligned_sized
+
+#define BENCH_BACKEND theap
+#include "tgalloc_bench_workloads.h"
+
+static void large_setup(void){ tga_large_init(&large); }
+static void large_teardown(void){}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_large_t*)&large
+#define TGA_ALLOC_A_S tga_large_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_large_realloc_aligned_sized
+#define TGA_FREE_A_S tga_large_free_aligned_sized
+#define TGA_EXPAND_A_S tga_large_expand_aligned_sized
+
+#define BENCH_BACKEND large
+#include "tgalloc_bench_workloads.h"
+
+#define BENCH_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+typedef struct {
+    char const * name;
+    void (*setup)(void);
+    void (*teardown)(void);
+    bench_workload const * workloads;
+    int thread_safe;
+} bench_backend;
+
+static bench_backend const backends[] = {
+    {"default", default_setup, default_teardown, bench_default_workloads, 1},
+    {"arena", arena_setup, arena_teardown, bench_arena_workloads, 0},
+    {"tcache", tcache_setup, tcache_teardown, bench_tcache_workloads, 1},
+    {"pool", pool_setup, pool_teardown, bench_pool_workloads, 0},
+    {"slab", slab_setup, slab_teardown, bench_slab_workloads, 0},
+    {"theap", theap_setup, theap_teardown, bench_theap_workloads, 1},
+    {"large", large_setup, large_teardown, bench_large_workloads, 1},
+};
+
+static int usage(char const * prog){
+    fprintf(stderr, "usage: %s [-n ops] [-t threads] [-b backend] [-w workload]\n", prog);
+    return 1;
+}
+
+// Whether a backend or workload filter matches anything
+static int bench_known(char const * only_backend, char const * only_workload){
+    int found = only_backend == NULL;
+    for (size_t b = 0; b < BENCH_COUNT(backends); b++) {
+        if (only_backend && strcmp(only_backend, backends[b].name) == 0) found = 1;
+    }
+    if (!found) {
+        fprintf(stderr, "unknown backend '%s'\n", only_backend);
+        return 0;
+    }
+    found = only_workload == NULL;
+    for (size_t w = 0; w < BENCH_COUNT(bench_default_workloads); w++) {
+        if (only_workload && strcmp(only_workload, bench_default_workloads[w].name) == 0) found = 1;
+    }
+    if (!found) {
+        fprintf(stderr, "unknown workload '%s'\n", only_workload);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char ** argv){
+    size_t ops = 1000000;
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    char const * only_backend = NULL;
+    char const * only_workload = NULL;
+    // Options all take a value, so anything left without one is an error
+    if (argc % 2 == 0) return usage(argv[0]);
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-n") == 0) ops = (size_t)strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-t") == 0) max_threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-b") == 0) only_backend = argv[i + 1];
+        else if (strcmp(argv[i], "-w") == 0) only_workload = argv[i + 1];
+        else return usage(argv[0]);
+    }
+    if (max_threads < 1) max_threads = 1;
+    if (!bench_known(only_backend, only_workload)) return usage(argv[0]);
+
+    printf("%-8s %-8s %7s %12s %8s %8s %8s %10s\n",
+           "backend", "workload", "threads", "ops/s", "p50 ns", "p99 ns", "p999 ns", "rss KiB");
+    size_t workload_count = BENCH_COUNT(bench_default_workloads);
+    size_t runs = 0;
+    for (size_t b = 0; b < BENCH_COUNT(backends); b++) {
+        bench_backend const * backend = &backends[b];
+        if (only_backend && strcmp(only_backend, backend->name) != 0) continue;
+        for (size_t w = 0; w < workload_count; w++) {
+            bench_workload const * workload = &backend->workloads[w];
+            if (only_workload && strcmp(only_workload, workload->name) != 0) continue;
+            int lowest = workload->paired ? 2 : 1;
+            int highest = backend->thread_safe ? max_threads : lowest;
+            // Paired workloads pass blocks from each producer to its own consumer, so the count stays even
+            if (workload->paired) highest &= ~1;
+            if (workload->paired && !backend->thread_safe) continue;
+            // Double the threads each step, ending on highest itself when it is not a power of two
+            for (int threads = lowest; threads <= highest;
+                 threads = threads < highest && threads * 2 > highest ? highest : threads * 2) {
+                backend->setup();
+                bench_result r = bench_run(workload, threads, ops);
+                backend->teardown();
+                printf("%-8s %-8s %7d %12.0f %8u %8u %8u %10ld\n", backend->name, workload->name, threads,
+                       r.ops_per_sec, r.p50, r.p99, r.p999, r.rss_kib);
+                fflush(stdout);
+                runs++;
+            }
+        }
+    }
+    if (runs == 0) {
+        fprintf(stderr, "nothing to run: no thread count fits the selected backend and workload\n");
+        return 1;
+    }
+    return 0;
+}
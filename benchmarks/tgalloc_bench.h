@@ -0,0 +1,255 @@
+#ifndef TGALLOC_BENCH_H
+#define TGALLOC_BENCH_H
+
+/**
+ * @file tgalloc_bench.h
+ * @brief Timing, latency and memory helpers shared by the benchmarks
+ *
+ * A benchmark thread counts every allocator call it makes with BENCH_OP;
+ * one call in BENCH_SAMPLE_EVERY is timed on its own for the latency
+ * percentiles, the rest only count towards the throughput.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/**
+ * @def BENCH_SAMPLE_EVERY
+ * @brief Every how many operations one is timed; a power of two
+ */
+#ifndef BENCH_SAMPLE_EVERY
+#define BENCH_SAMPLE_EVERY 64
+#endif
+
+/**
+ * @def BENCH_RING
+ * @brief Number of live blocks the churn workloads keep per thread
+ */
+#ifndef BENCH_RING
+#define BENCH_RING 1024
+#endif
+
+// Handoff queue between a producer and a consumer thread
+typedef struct {
+    void * slots[BENCH_RING];
+    size_t head;  // Written by the producer
+    size_t tail;  // Written by the consumer
+} bench_queue;
+
+// State of one benchmark thread
+typedef struct {
+    int index;
+    int count;
+    size_t ops_target;
+    size_t ops;
+    uint64_t rng;
+    uint32_t * latencies;
+    size_t latency_count;
+    size_t latency_cap;
+    bench_queue * queue;   // Shared with the partner thread in the cross-thread workload
+    long rss_kib;          // Resident set at the workload's peak, sampled by thread 0
+    uint64_t start_ns;
+    uint64_t end_ns;
+} bench_thread;
+
+static inline uint64_t bench_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64*: cheap and good enough to pick sizes
+static inline uint64_t bench_rand(bench_thread * t){
+    t->rng ^= t->rng >> 12;
+    t->rng ^= t->rng << 25;
+    t->rng ^= t->rng >> 27;
+    return t->rng * 0x2545F4914F6CDD1Dull;
+}
+
+// Log-uniform size between lo and hi, so small sizes are as common as in real programs
+static inline size_t bench_rand_size(bench_thread * t, size_t lo, size_t hi){
+    uint64_t r = bench_rand(t);
+    int lo_bits = 63 - __builtin_clzll((unsigned long long)lo);
+    int hi_bits = 63 - __builtin_clzll((unsigned long long)hi);
+    int bits = lo_bits + (int)(r % (uint64_t)(hi_bits - lo_bits + 1));
+    size_t size = ((size_t)1 << bits) + (size_t)((r >> 8) & (((uint64_t)1 << bits) - 1));
+    return size < lo ? lo : size > hi ? hi : size;
+}
+
+static inline long bench_rss_kib(void){
+    long pages = 0;
+    FILE * f = fopen("/proc/self/statm", "r");
+    if (f == NULL) return 0;
+    if (fscanf(f, "%*s %ld", &pages) != 1) pages = 0;
+    fclose(f);
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static inline void bench_note_rss(bench_thread * t){
+    if (t->index == 0) {
+        long rss = bench_rss_kib();
+        if (rss > t->rss_kib) t->rss_kib = rss;
+    }
+}
+
+static inline void bench_record(bench_thread * t, uint64_t ns){
+    if (t->latency_count < t->latency_cap) {
+        t->latencies[t->latency_count++] = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+    }
+}
+
+/**
+ * @def BENCH_OP
+ * @brief Run one allocator call, counting it and timing it when sampled
+ */
+#define BENCH_OP(t, stmt) do { \
+    if (((t)->ops++ & (BENCH_SAMPLE_EVERY - 1)) == 0) { \
+        uint64_t _bench_start = bench_now_ns(); \
+        stmt; \
+        bench_record((t), bench_now_ns() - _bench_start); \
+    } else { \
+        stmt; \
+    } \
+} while (0)
+
+// Queue operations; waiting yields so that pairs also make progress on fewer cores
+static inline void bench_queue_push(bench_queue * q, void * ptr){
+    size_t head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    while (head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == BENCH_RING) sched_yield();
+    q->slots[head % BENCH_RING] = ptr;
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static inline void * bench_queue_pop(bench_queue * q){
+    size_t tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == tail) sched_yield();
+    void * ptr = q->slots[tail % BENCH_RING];
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return ptr;
+}
+
+typedef void (*bench_fn)(bench_thread *);
+
+/**
+ * @struct bench_workload
+ * @brief A named access pattern
+ *
+ * Paired workloads run producer/consumer pairs and need an even thread
+ * count; ops_scale divides the operation count for expensive patterns.
+ */
+typedef struct {
+    char const * name;
+    bench_fn run;
+    int paired;
+    size_t ops_scale;
+} bench_workload;
+
+// Token pasting for the per-backend workload functions
+#define _BENCH_PASTE2(backend, name) bench_##backend##_##name
+#define _BENCH_PASTE(backend, name) _BENCH_PASTE2(backend, name)
+#define BENCH_FN(name) _BENCH_PASTE(BENCH_BACKEND, name)
+
+// Result of one run
+typedef struct {
+    double ops_per_sec;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+    long rss_kib;
+} bench_result;
+
+static inline int bench_cmp_u32(void const * a, void const * b){
+    uint32_t x = *(uint32_t const *)a;
+    uint32_t y = *(uint32_t const *)b;
+    return (x > y) - (x < y);
+}
+
+// Arguments handed to each worker: the barrier the run starts on and the workload
+typedef struct {
+    bench_thread * thread;
+    bench_fn run;
+    pthread_barrier_t * start;
+} bench_worker;
+
+static inline void * bench_worker_main(void * arg){
+    bench_worker * w = (bench_worker *)arg;
+    pthread_barrier_wait(w->start);
+    w->thread->start_ns = bench_now_ns();
+    w->run(w->thread);
+    w->thread->end_ns = bench_now_ns();
+    return NULL;
+}
+
+/**
+ * @brief Run a workload on `threads` threads and collect its numbers
+ */
+static inline bench_result bench_run(bench_workload const * workload, int threads, size_t ops){
+    bench_result result = {0, 0, 0, 0, 0};
+    bench_thread * ts = (bench_thread *)calloc((size_t)threads, sizeof(bench_thread));
+    bench_worker * ws = (bench_worker *)calloc((size_t)threads, sizeof(bench_worker));
+    pthread_t * ids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    bench_queue * queues = (bench_queue *)calloc((size_t)threads / 2 + 1, sizeof(bench_queue));
+    size_t per_thread = ops / workload->ops_scale;
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned)threads);
+
+    for (int i = 0; i < threads; i++) {
+        ts[i].index = i;
+        ts[i].count = threads;
+        ts[i].ops_target = per_thread;
+        ts[i].rng = 0x9E3779B97F4A7C15ull * (uint64_t)(i + 1);
+        ts[i].latency_cap = per_thread / BENCH_SAMPLE_EVERY + 16;
+        ts[i].latencies = (uint32_t *)malloc(ts[i].latency_cap * sizeof(uint32_t));
+        ts[i].queue = &queues[i / 2];
+        ws[i].thread = &ts[i];
+        ws[i].run = workload->run;
+        ws[i].start = &start;
+        pthread_create(&ids[i], NULL, bench_worker_main, &ws[i]);
+    }
+
+    for (int i = 0; i < threads; i++) pthread_join(ids[i], NULL);
+
+    // The run lasts from the first thread starting to the last one finishing
+    uint64_t begin = ts[0].start_ns;
+    uint64_t end = ts[0].end_ns;
+    size_t total_ops = 0;
+    size_t total_samples = 0;
+    for (int i = 0; i < threads; i++) {
+        if (ts[i].start_ns < begin) begin = ts[i].start_ns;
+        if (ts[i].end_ns > end) end = ts[i].end_ns;
+        total_ops += ts[i].ops;
+        total_samples += ts[i].latency_count;
+    }
+    uint64_t elapsed = end - begin;
+    uint32_t * samples = (uint32_t *)malloc((total_samples + 1) * sizeof(uint32_t));
+    size_t n = 0;
+    for (int i = 0; i < threads; i++) {
+        memcpy(samples + n, ts[i].latencies, ts[i].latency_count * sizeof(uint32_t));
+        n += ts[i].latency_count;
+        free(ts[i].latencies);
+    }
+    qsort(samples, n, sizeof(uint32_t), bench_cmp_u32);
+    if (n > 0) {
+        result.p50 = samples[n / 2];
+        result.p99 = samples[n * 99 / 100];
+        result.p999 = samples[n * 999 / 1000];
+    }
+    result.ops_per_sec = elapsed ? (double)total_ops * 1e9 / (double)elapsed : 0;
+    result.rss_kib = ts[0].rss_kib;
+
+    pthread_barrier_destroy(&start);
+    free(samples);
+    free(queues);
+    free(ids);
+    free(ws);
+    free(ts);
+    return result;
+}
+
+#endif // TGALLOC_BENCH_H
@@ -0,0 +1,104 @@
+/**
+ * @file tgalloc_bench_workloads.h
+ * @brief Benchmark workloads, generated once for every backend
+ *
+ * This header has no include guard: it is included once per backend, with
+ * TGA and its functions switched beforehand and BENCH_BACKEND naming the
+ * backend, so every workload inlines palloc and pfree of that backend.
+ * Each inclusion defines bench_<backend>_workloads.
+ */
+
+#ifndef BENCH_BACKEND
+#error "Define BENCH_BACKEND before including tgalloc_bench_workloads.h"
+#endif
+
+// Fixed-size objects: free the oldest of a ring of live ones, allocate a new one
+static void BENCH_FN(churn)(bench_thread * t){
+    bench_object * ring[BENCH_RING];
+    for (size_t i = 0; i < BENCH_RING; i++) BENCH_OP(t, palloc(ring[i]));
+    bench_note_rss(t);
+    for (size_t i = 0; t->ops < t->ops_target; i = (i + 1) % BENCH_RING) {
+        BENCH_OP(t, pfree(ring[i]));
+        BENCH_OP(t, palloc(ring[i]));
+        ring[i]->id = (long)i;
+    }
+    for (size_t i = 0; i < BENCH_RING; i++) BENCH_OP(t, pfree(ring[i]));
+}
+
+// Same as churn, with log-uniform sizes from 8 bytes to 64 KiB
+static void BENCH_FN(random)(bench_thread * t){
+    char * ring[BENCH_RING];
+    size_t sizes[BENCH_RING];
+    for (size_t i = 0; i < BENCH_RING; i++) {
+        sizes[i] = bench_rand_size(t, 8, 64 * 1024);
+        BENCH_OP(t, palloc(ring[i], sizes[i]));
+    }
+    bench_note_rss(t);
+    for (size_t i = 0; t->ops < t->ops_target; i = (i + 1) % BENCH_RING) {
+        BENCH_OP(t, pfree(ring[i], sizes[i]));
+        sizes[i] = bench_rand_size(t, 8, 64 * 1024);
+        BENCH_OP(t, palloc(ring[i], sizes[i]));
+        ring[i][0] = 1;
+    }
+    for (size_t i = 0; i < BENCH_RING; i++) BENCH_OP(t, pfree(ring[i], sizes[i]));
+}
+
+// Even threads allocate, odd threads free what their partner allocated
+static void BENCH_FN(xthread)(bench_thread * t){
+    size_t blocks = t->ops_target;
+    if (t->index % 2 == 0) {
+        for (size_t i = 0; i < blocks; i++) {
+            bench_object * obj;
+            BENCH_OP(t, palloc(obj));
+            obj->id = (long)i;
+            bench_queue_push(t->queue, obj);
+        }
+    } else {
+        for (size_t i = 0; i < blocks; i++) {
+            bench_object * obj = (bench_object *)bench_queue_pop(t->queue);
+            BENCH_OP(t, pfree(obj));
+        }
+    }
+    bench_note_rss(t);
+}
+
+// Grow an array by doubling with pprealloc, as a vector would
+static void BENCH_FN(vector)(bench_thread * t){
+    while (t->ops < t->ops_target) {
+        long * items = NULL;
+        size_t cap = 0;
+        for (size_t len = 0; len < 64 * 1024; len++) {
+            if (len == cap) {
+                size_t next = cap ? 2 * cap : 4;
+                BENCH_OP(t, pprealloc(&items, cap, next));
+                cap = next;
+            }
+            items[len] = (long)len;
+        }
+        bench_note_rss(t);
+        BENCH_OP(t, pfree(items, cap));
+    }
+}
+
+// Arrays of 1 to 16 MiB, touching every page
+static void BENCH_FN(large)(bench_thread * t){
+    long page = sysconf(_SC_PAGESIZE);
+    while (t->ops < t->ops_target) {
+        size_t size = (size_t)1 << (20 + bench_rand(t) % 5);
+        char * bytes;
+        BENCH_OP(t, palloc(bytes, size));
+        for (size_t i = 0; i < size; i += (size_t)page) bytes[i] = 1;
+        bench_note_rss(t);
+        BENCH_OP(t, pfree(bytes, size));
+    }
+}
+
+static bench_workload const BENCH_FN(workloads)[] = {
+    {"churn", BENCH_FN(churn), 0, 1},
+    {"random", BENCH_FN(random), 0, 1},
+    {"xthread", BENCH_FN(xthread), 1, 1},
+    {"vector", BENCH_FN(vector), 0, 64},
+    {"large", BENCH_FN(large), 0, 4000},
+};
+
+#undef BENCH_BACKEND
@@ -0,0 +1,487 @@
+/**
+ * @file tgalloc_shim.c
+ * @brief malloc interposition on top of a TGA backend
+ *
+ * Built into libtgalloc_shim.so by `make shim`, this routes a whole existing
+ * program through a tgalloc backend without touching its sources:
+ *
+ * @code
+ * make shim SHIM_BACKEND=THEAP
+ * LD_PRELOAD=build/libtgalloc_shim.so ./server
+ * @endcode
+ *
+ * The backend is chosen at build time by defining one of:
+ * - TGA_SHIM_THEAP: per-thread heaps (tgalloc_theap.h), the default
+ * - TGA_SHIM_SLAB:  headerless slabs (tgalloc_slab.h) behind one lock
+ * - TGA_SHIM_ARENA: the size-class arena (tgalloc_arena.h) behind one lock
+ * - TGA_SHIM_LIBC:  glibc itself, to measure the cost of the shim alone
+ * Whatever the backend takes from upstream comes from glibc's own
+ * __libc_malloc family, so nothing loops back into the shim.
+ *
+ * free, realloc and malloc_usable_size are not told the size, so the size
+ * and alignment of every block from the malloc family are kept in a side
+ * table: a hash table striped by address, each stripe with its own lock and
+ * 16 bytes per live block, held in pages mapped directly from the system.
+ * C++ sized delete does tell the size; tgalloc_shim_new.cpp then frees
+ * straight through when built with TGA_SHIM_SIZED_NEW, and scalar operator
+ * new skips the table altogether.
+ *
+ * A pointer the table does not know was allocated before the shim took
+ * over, and is handed to glibc, by malloc_usable_size as well as by free
+ * and realloc. Linux and glibc only.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(TGA_SHIM_THEAP) && !defined(TGA_SHIM_SLAB) && !defined(TGA_SHIM_ARENA) && !defined(TGA_SHIM_LIBC)
+    #define TGA_SHIM_THEAP
+#endif
+
+#if defined(TGA_SHIM_THEAP)
+    #include "../tgalloc_theap.h"
+#elif defined(TGA_SHIM_SLAB)
+    #include "../tgalloc_slab.h"
+#elif defined(TGA_SHIM_ARENA)
+    #include "../tgalloc_arena.h"
+#endif
+#include "../tgalloc.h"
+#include "../__tgalloc_sync.h"
+
+#if !defined(__GLIBC__)
+    #error "tgalloc_shim.c needs glibc's __libc_malloc family"
+#endif
+
+extern void * __libc_malloc(size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+extern void * __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void * ptr);
+
+/**
+ * @def TGA_SHIM_STRIPES
+ * @brief Number of independently locked parts of the side table
+ */
+#ifndef TGA_SHIM_STRIPES
+#define TGA_SHIM_STRIPES 64
+#endif
+
+// Alignment malloc guarantees, and the one its blocks are recorded with
+#define _TGALLOC_SHIM_ALIGN ((size_t)_tgalloc_max_align)
+
+// Upstream of the backend: glibc's allocator, reached without interposition
+static void * _tgalloc_shim_libc_alloc(void * self, size_t alignment, size_t size){
+    (void)self; // Mark as unused to prevent compiler warnings
+    return alignment <= _TGALLOC_SHIM_ALIGN ? __libc_malloc(size) : __libc_memalign(alignment, size);
+}
+
+static void * _tgalloc_shim_libc_realloc(void * self, void * ptr, size_t alignment, size_t old_size,
+                                         size_t new_size){
+    if (alignment <= _TGALLOC_SHIM_ALIGN) return __libc_realloc(ptr, new_size);
+    void * moved = _tgalloc_shim_libc_alloc(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    if (ptr) {
+        memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+        __libc_free(ptr);
+    }
+    return moved;
+}
+
+static void _tgalloc_shim_libc_free(void * self, void const * ptr, size_t alignment, size_t size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    (void)size;      // Mark as unused to prevent compiler warnings
+    __libc_free((void*)ptr);
+}
+
+#define _TGALLOC_SHIM_UPSTREAM TGA_BACKEND(NULL, _tgalloc_shim_libc_alloc, _tgalloc_shim_libc_realloc, \
+    _tgalloc_shim_libc_free)
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#if defined(TGA_SHIM_THEAP)
+    static tga_theap_t _tgalloc_shim_theap;
+    #define TGA (tga_theap_t*)&_tgalloc_shim_theap
+    #define TGA_ALLOC_A_S tga_theap_alloc_aligned_sized
+    #define TGA_REALLOC_A_S tga_theap_realloc_aligned_sized
+    #define TGA_FREE_A_S tga_theap_free_aligned_sized
+    #define _tgalloc_shim_backend_init() tga_theap_init(&_tgalloc_shim_theap, _TGALLOC_SHIM_UPSTREAM)
+#elif defined(TGA_SHIM_SLAB)
+    static tga_slab_t _tgalloc_shim_slab;
+    #define TGA (tga_slab_t*)&_tgalloc_shim_slab
+    #define TGA_ALLOC_A_S tga_slab_alloc_aligned_sized
+    #define TGA_REALLOC_A_S tga_slab_realloc_aligned_sized
+    #define TGA_FREE_A_S tga_slab_free_aligned_sized
+    #define _tgalloc_shim_backend_init() tga_slab_init_with(&_tgalloc_shim_slab, _TGALLOC_SHIM_UPSTREAM)
+    #define _TGALLOC_SHIM_LOCKED
+#elif defined(TGA_SHIM_ARENA)
+    static tga_arena_t _tgalloc_shim_arena;
+    #define TGA (tga_arena_t*)&_tgalloc_shim_arena
+    #define TGA_ALLOC_A_S tga_arena_alloc_aligned_sized
+    #define TGA_REALLOC_A_S tga_arena_realloc_aligned_sized
+    #define TGA_FREE_A_S tga_arena_free_aligned_sized
+    #define _tgalloc_shim_backend_init() tga_arena_init_with(&_tgalloc_shim_arena, _TGALLOC_SHIM_UPSTREAM)
+    #define _TGALLOC_SHIM_LOCKED
+#else
+    #define TGA NULL
+    #define TGA_ALLOC_A_S _tgalloc_shim_libc_alloc
+    #define TGA_REALLOC_A_S _tgalloc_shim_libc_realloc
+    #define TGA_FREE_A_S _tgalloc_shim_libc_free
+    #define _tgalloc_shim_backend_init() ((void)0)
+#endif
+
+// Backends that are not thread-safe themselves are serialised by one lock
+#ifdef _TGALLOC_SHIM_LOCKED
+    static _tgalloc_mutex_t _tgalloc_shim_backend_lock;
+    #define _tgalloc_shim_lock() _tgalloc_mutex_lock(&_tgalloc_shim_backend_lock)
+    #define _tgalloc_shim_unlock() _tgalloc_mutex_unlock(&_tgalloc_shim_backend_lock)
+#else
+    #define _tgalloc_shim_lock() ((void)0)
+    #define _tgalloc_shim_unlock() ((void)0)
+#endif
+
+// One live block; size keeps log2 of the alignment in its top byte
+typedef struct _tgalloc_shim_entry {
+    uintptr_t ptr;
+    size_t meta;
+} _tgalloc_shim_entry;
+
+#define _TGALLOC_SHIM_SIZE_BITS 56
+#define _tgalloc_shim_meta(alignment, size) \
+    ((size) | ((size_t)__builtin_ctzl(alignment) << _TGALLOC_SHIM_SIZE_BITS))
+#define _tgalloc_shim_meta_size(meta) ((meta) & (((size_t)1 << _TGALLOC_SHIM_SIZE_BITS) - 1))
+#define _tgalloc_shim_meta_align(meta) ((size_t)1 << ((meta) >> _TGALLOC_SHIM_SIZE_BITS))
+
+// Open-addressing table of one stripe, probed linearly; ptr 0 marks a free slot
+typedef struct _tgalloc_shim_stripe {
+    _tgalloc_mutex_t lock;
+    _tgalloc_shim_entry * slots;
+    size_t mask;
+    size_t count;
+} _tgalloc_shim_stripe;
+
+static _tgalloc_shim_stripe _tgalloc_shim_stripes[TGA_SHIM_STRIPES];
+static pthread_once_t _tgalloc_shim_once = PTHREAD_ONCE_INIT;
+
+#define _TGALLOC_SHIM_MIN_SLOTS 1024
+
+static void _tgalloc_shim_init(void){
+    for (size_t i = 0; i < TGA_SHIM_STRIPES; i++) _tgalloc_mutex_init(&_tgalloc_shim_stripes[i].lock);
+#ifdef _TGALLOC_SHIM_LOCKED
+    _tgalloc_mutex_init(&_tgalloc_shim_backend_lock);
+#endif
+    _tgalloc_shim_backend_init();
+}
+
+#define _tgalloc_shim_ready() ((void)pthread_once(&_tgalloc_shim_once, _tgalloc_shim_init))
+
+// Hash of a block address: the top bits pick the stripe, the low bits the slot
+static inline uint64_t _tgalloc_shim_hash(uintptr_t ptr){
+    uint64_t hash = (uint64_t)(ptr >> 4) * 0x9e3779b97f4a7c15ull;
+    return hash ^ (hash >> 29);
+}
+
+static inline _tgalloc_shim_stripe * _tgalloc_shim_stripe_of(uint64_t hash){
+    return &_tgalloc_shim_stripes[(hash >> 58) % TGA_SHIM_STRIPES];
+}
+
+static void * _tgalloc_shim_map(size_t size){
+    void * pages = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return pages == MAP_FAILED ? NULL : pages;
+}
+
+// Double a stripe's table, or create it; 0 on failure
+static int _tgalloc_shim_grow(_tgalloc_shim_stripe * stripe){
+    size_t slots = stripe->slots ? 2 * (stripe->mask + 1) : _TGALLOC_SHIM_MIN_SLOTS;
+    _tgalloc_shim_entry * table = (_tgalloc_shim_entry*)_tgalloc_shim_map(slots * sizeof(*table));
+    if (table == NULL) return 0;
+    for (size_t i = 0; stripe->slots && i <= stripe->mask; i++) {
+        _tgalloc_shim_entry entry = stripe->slots[i];
+        if (entry.ptr == 0) continue;
+        size_t at = _tgalloc_shim_hash(entry.ptr) & (slots - 1);
+        while (table[at].ptr) at = (at + 1) & (slots - 1);
+        table[at] = entry;
+    }
+    if (stripe->slots) munmap(stripe->slots, (stripe->mask + 1) * sizeof(*table));
+    stripe->slots = table;
+    stripe->mask = slots - 1;
+    return 1;
+}
+
+// Record a block; 0 if the table could not grow
+static int _tgalloc_shim_record(void * ptr, size_t alignment, size_t size){
+    uint64_t hash = _tgalloc_shim_hash((uintptr_t)ptr);
+    _tgalloc_shim_stripe * stripe = _tgalloc_shim_stripe_of(hash);
+    _tgalloc_mutex_lock(&stripe->lock);
+    if ((stripe->count + 1) * 2 > stripe->mask + 1 && !_tgalloc_shim_grow(stripe)) {
+        _tgalloc_mutex_unlock(&stripe->lock);
+        return 0;
+    }
+    size_t at = hash & stripe->mask;
+    while (stripe->slots[at].ptr) at = (at + 1) & stripe->mask;
+    stripe->slots[at].ptr = (uintptr_t)ptr;
+    stripe->slots[at].meta = _tgalloc_shim_meta(alignment, size);
+    stripe->count++;
+    _tgalloc_mutex_unlock(&stripe->lock);
+    return 1;
+}
+
+// Remove a block and return its metadata, or 0 if it was never recorded
+static size_t _tgalloc_shim_forget(void const * ptr){
+    uint64_t hash = _tgalloc_shim_hash((uintptr_t)ptr);
+    _tgalloc_shim_stripe * stripe = _tgalloc_shim_stripe_of(hash);
+    size_t meta = 0;
+    _tgalloc_mutex_lock(&stripe->lock);
+    if (stripe->slots) {
+        size_t at = hash & stripe->mask;
+        while (stripe->slots[at].ptr && stripe->slots[at].ptr != (uintptr_t)ptr) at = (at + 1) & stripe->mask;
+        if (stripe->slots[at].ptr) {
+            meta = stripe->slots[at].meta;
+            // Shift later entries of the probe run back, so no tombstones are needed
+            size_t hole = at;
+            for (size_t next = (at + 1) & stripe->mask; stripe->slots[next].ptr; next = (next + 1) & stripe->mask) {
+                size_t home = _tgalloc_shim_hash(stripe->slots[next].ptr) & stripe->mask;
+                if (((next - home) & stripe->mask) >= ((next - hole) & stripe->mask)) {
+                    stripe->slots[hole] = stripe->slots[next];
+                    hole = next;
+                }
+            }
+            stripe->slots[hole].ptr = 0;
+            stripe->count--;
+        }
+    }
+    _tgalloc_mutex_unlock(&stripe->lock);
+    return meta;
+}
+
+// Metadata of a recorded block without removing it, or 0
+static size_t _tgalloc_shim_lookup(void const * ptr){
+    uint64_t hash = _tgalloc_shim_hash((uintptr_t)ptr);
+    _tgalloc_shim_stripe * stripe = _tgalloc_shim_stripe_of(hash);
+    size_t meta = 0;
+    _tgalloc_mutex_lock(&stripe->lock);
+    if (stripe->slots) {
+        size_t at = hash & stripe->mask;
+        while (stripe->slots[at].ptr && stripe->slots[at].ptr != (uintptr_t)ptr) at = (at + 1) & stripe->mask;
+        if (stripe->slots[at].ptr) meta = stripe->slots[at].meta;
+    }
+    _tgalloc_mutex_unlock(&stripe->lock);
+    return meta;
+}
+
+static void * _tgalloc_shim_backend_alloc(size_t alignment, size_t size){
+    _tgalloc_shim_lock();
+    void * ptr = TGA_ALLOC_A_S(TGA, alignment, size);
+    _tgalloc_shim_unlock();
+    return ptr;
+}
+
+static void _tgalloc_shim_backend_free(void * ptr, size_t alignment, size_t size){
+    _tgalloc_shim_lock();
+    TGA_FREE_A_S(TGA, ptr, alignment, size);
+    _tgalloc_shim_unlock();
+}
+
+/**
+ * @brief Allocate from the backend, recording the size if `tracked`
+ *
+ * Shared with tgalloc_shim_new.cpp. Zero-byte requests get a block of their
+ * own. Sets errno and returns NULL on failure.
+ */
+void * _tgalloc_shim_alloc(size_t alignment, size_t size, int tracked){
+    _tgalloc_shim_ready();
+    if (alignment < _TGALLOC_SHIM_ALIGN) alignment = _TGALLOC_SHIM_ALIGN;
+    if (size == 0) size = 1;
+    if (size >> _TGALLOC_SHIM_SIZE_BITS) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    void * ptr = _tgalloc_shim_backend_alloc(alignment, size);
+    if (ptr && tracked && !_tgalloc_shim_record(ptr, alignment, size)) {
+        _tgalloc_shim_backend_free(ptr, alignment, size);
+        ptr = NULL;
+    }
+    if (ptr == NULL) errno = ENOMEM;
+    return ptr;
+}
+
+/**
+ * @brief Free a block by its recorded size
+ *
+ * Shared with tgalloc_shim_new.cpp. A block the table does not know
+ * predates the shim and goes to glibc.
+ */
+void _tgalloc_shim_free(void * ptr){
+    if (ptr == NULL) return;
+    _tgalloc_shim_ready();
+    size_t meta = _tgalloc_shim_forget(ptr);
+    if (meta == 0) {
+        __libc_free(ptr);
+        return;
+    }
+    _tgalloc_shim_backend_free(ptr, _tgalloc_shim_meta_align(meta), _tgalloc_shim_meta_size(meta));
+}
+
+/**
+ * @brief Free a block that must be recorded
+ *
+ * Shared with tgalloc_shim_new.cpp, for unsized scalar delete when built
+ * with TGA_SHIM_SIZED_NEW. Operator new records nothing then, so a block the
+ * table does not know is a backend block of unknown size: handing it to
+ * glibc would corrupt its heap, and the process aborts instead.
+ */
+void _tgalloc_shim_free_recorded(void * ptr){
+    if (ptr == NULL) return;
+    _tgalloc_shim_ready();
+    size_t meta = _tgalloc_shim_forget(ptr);
+    if (meta == 0) {
+        static char const message[] = "tgalloc shim: unsized operator delete of a block from operator new, "
+                                      "whose size is not recorded with TGA_SHIM_SIZED_NEW\n";
+        ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+        (void)written; // Nothing more to do if the diagnostic is lost
+        abort();
+    }
+    _tgalloc_shim_backend_free(ptr, _tgalloc_shim_meta_align(meta), _tgalloc_shim_meta_size(meta));
+}
+
+/**
+ * @brief Free an untracked block by the size and alignment it was allocated with
+ *
+ * Shared with tgalloc_shim_new.cpp, for sized delete.
+ */
+void _tgalloc_shim_free_sized(void * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (alignment < _TGALLOC_SHIM_ALIGN) alignment = _TGALLOC_SHIM_ALIGN;
+    _tgalloc_shim_backend_free(ptr, alignment, size ? size : 1);
+}
+
+/**
+ * @brief Number of blocks whose size the side table currently holds
+ */
+size_t tga_shim_tracked(void){
+    size_t count = 0;
+    for (size_t i = 0; i < TGA_SHIM_STRIPES; i++) {
+        _tgalloc_mutex_lock(&_tgalloc_shim_stripes[i].lock);
+        count += _tgalloc_shim_stripes[i].count;
+        _tgalloc_mutex_unlock(&_tgalloc_shim_stripes[i].lock);
+    }
+    return count;
+}
+
+void * malloc(size_t size){
+    return _tgalloc_shim_alloc(_TGALLOC_SHIM_ALIGN, size, 1);
+}
+
+void free(void * ptr){
+    _tgalloc_shim_free(ptr);
+}
+
+void * calloc(size_t count, size_t size){
+    if (size && count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    // Not malloc + memset: GCC folds that pair into a call to calloc itself
+    void * ptr = _tgalloc_shim_alloc(_TGALLOC_SHIM_ALIGN, count * size, 1);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void * realloc(void * ptr, size_t size){
+    if (ptr == NULL) return malloc(size);
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    _tgalloc_shim_ready();
+    size_t meta = _tgalloc_shim_forget(ptr);
+    if (meta == 0) return __libc_realloc(ptr, size);
+    size_t alignment = _tgalloc_shim_meta_align(meta);
+    size_t old_size = _tgalloc_shim_meta_size(meta);
+    void * resized = NULL;
+    if (!(size >> _TGALLOC_SHIM_SIZE_BITS)) {
+        _tgalloc_shim_lock();
+        resized = TGA_REALLOC_A_S(TGA, ptr, alignment, old_size, size);
+        _tgalloc_shim_unlock();
+    }
+    if (resized == NULL) {
+        // The block is unchanged; the table had room for it a moment ago
+        _tgalloc_shim_record(ptr, alignment, old_size);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!_tgalloc_shim_record(resized, alignment, size)) {
+        _tgalloc_shim_backend_free(resized, alignment, size);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return resized;
+}
+
+void * reallocarray(void * ptr, size_t count, size_t size){
+    if (size && count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr, count * size);
+}
+
+void * memalign(size_t alignment, size_t size){
+    if (alignment == 0 || (alignment & (alignment - 1))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return _tgalloc_shim_alloc(alignment, size, 1);
+}
+
+void * aligned_alloc(size_t alignment, size_t size){
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void ** out, size_t alignment, size_t size){
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1))) return EINVAL;
+    void * ptr = _tgalloc_shim_alloc(alignment, size, 1);
+    if (ptr == NULL) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void * valloc(size_t size){
+    return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+void * pvalloc(size_t size){
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return memalign(page, (size + page - 1) / page * page);
+}
+
+// glibc's own malloc_usable_size, which it exports under no other name; looked up on first use, since
+// dlsym may allocate and must not run while the shim initialises
+static size_t (*_tgalloc_shim_libc_usable)(void * ptr);
+static pthread_once_t _tgalloc_shim_usable_once = PTHREAD_ONCE_INIT;
+
+static void _tgalloc_shim_find_libc_usable(void){
+    void * found = dlsym(RTLD_NEXT, "malloc_usable_size");
+    if (found != (void*)malloc_usable_size) *(void**)&_tgalloc_shim_libc_usable = found;
+}
+
+size_t malloc_usable_size(void * ptr){
+    if (ptr == NULL) return 0;
+    _tgalloc_shim_ready();
+    size_t meta = _tgalloc_shim_lookup(ptr);
+    if (meta) return _tgalloc_shim_meta_size(meta);
+    // Not in the table: a glibc block, as for free and realloc
+    (void)pthread_once(&_tgalloc_shim_usable_once, _tgalloc_shim_find_libc_usable);
+    return _tgalloc_shim_libc_usable ? _tgalloc_shim_libc_usable(ptr) : 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file tgalloc_shim_new.cpp
+ * @brief Replacement operator new and delete for the malloc shim
+ *
+ * Linked into libtgalloc_shim.so next to tgalloc_shim.c, so C++ programs
+ * allocate from the same backend. By default every block from operator new
+ * is recorded in the shim's side table like a malloc block, which keeps
+ * unsized delete working.
+ *
+ * With TGA_SHIM_SIZED_NEW defined, scalar operator new records nothing and
+ * sized delete passes the size and alignment it is given straight to the
+ * backend. That saves the table for code built with sized deallocation (the
+ * default from C++14 on with GCC and with -fsized-deallocation on Clang).
+ * Arrays are still recorded, since delete[] of a type without a destructor
+ * is unsized even then. A scalar block must be released by a sized delete;
+ * an unsized one aborts with a diagnostic rather than corrupt the heap.
+ */
+
+#include <cstddef>
+#include <new>
+
+extern "C" {
+void * _tgalloc_shim_alloc(std::size_t alignment, std::size_t size, int tracked);
+void _tgalloc_shim_free(void * ptr);
+void _tgalloc_shim_free_sized(void * ptr, std::size_t alignment, std::size_t size);
+void _tgalloc_shim_free_recorded(void * ptr);
+}
+
+// Whether scalar operator new records its blocks; operator new[] always does
+#if defined(TGA_SHIM_SIZED_NEW)
+    #define _TGALLOC_SHIM_NEW_TRACKED 0
+#else
+    #define _TGALLOC_SHIM_NEW_TRACKED 1
+#endif
+
+// Alignment of plain operator new
+#if defined(__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    #define _TGALLOC_SHIM_NEW_ALIGN static_cast<std::size_t>(__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+#else
+    #define _TGALLOC_SHIM_NEW_ALIGN alignof(std::max_align_t)
+#endif
+
+// Allocate, running the new handler until it succeeds or there is none
+static void * _tgalloc_shim_new(std::size_t alignment, std::size_t size, bool nothrow, int tracked){
+    for (;;) {
+        void * ptr = _tgalloc_shim_alloc(alignment, size, tracked);
+        if (ptr) return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            if (nothrow) return nullptr;
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+// Release a block from scalar operator new; size 0 when the caller did not pass one
+static void _tgalloc_shim_delete(void * ptr, std::size_t alignment, std::size_t size){
+#if defined(TGA_SHIM_SIZED_NEW)
+    if (size) _tgalloc_shim_free_sized(ptr, alignment, size);
+    else _tgalloc_shim_free_recorded(ptr);
+#else
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    (void)size;      // Mark as unused to prevent compiler warnings
+    _tgalloc_shim_free(ptr);
+#endif
+}
+
+void * operator new(std::size_t size){
+    return _tgalloc_shim_new(_TGALLOC_SHIM_NEW_ALIGN, size, false, _TGALLOC_SHIM_NEW_TRACKED);
+}
+
+void * operator new[](std::size_t size){
+    return _tgalloc_shim_new(_TGALLOC_SHIM_NEW_ALIGN, size, false, 1);
+}
+
+void * operator new(std::size_t size, std::nothrow_t const &) noexcept {
+    try {
+        return _tgalloc_shim_new(_TGALLOC_SHIM_NEW_ALIGN, size, true, _TGALLOC_SHIM_NEW_TRACKED);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void * operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+    try {
+        return _tgalloc_shim_new(_TGALLOC_SHIM_NEW_ALIGN, size, true, 1);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void * ptr) noexcept {
+    _tgalloc_shim_delete(ptr, _TGALLOC_SHIM_NEW_ALIGN, 0);
+}
+
+// Blocks from operator new[] are always recorded, so delete[] frees by the table whatever size it is given
+void operator delete[](void * ptr) noexcept {
+    _tgalloc_shim_free(ptr);
+}
+
+void operator delete(void * ptr, std::nothrow_t const &) noexcept {
+    _tgalloc_shim_delete(ptr, _TGALLOC_SHIM_NEW_ALIGN, 0);
+}
+
+void operator delete[](void * ptr, std::nothrow_t const &) noexcept {
+    _tgalloc_shim_free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation) || __cplusplus >= 201402L
+void operator delete(void * ptr, std::size_t size) noexcept {
+    _tgalloc_shim_delete(ptr, _TGALLOC_SHIM_NEW_ALIGN, size);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept {
+    _tgalloc_shim_free(ptr);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+void * operator new(std::size_t size, std::align_val_t alignment){
+    return _tgalloc_shim_new(static_cast<std::size_t>(alignment), size, false, _TGALLOC_SHIM_NEW_TRACKED);
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment){
+    return _tgalloc_shim_new(static_cast<std::size_t>(alignment), size, false, 1);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const &) noexcept {
+    try {
+        return _tgalloc_shim_new(static_cast<std::size_t>(alignment), size, true, _TGALLOC_SHIM_NEW_TRACKED);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const &) noexcept {
+    try {
+        return _tgalloc_shim_new(static_cast<std::size_t>(alignment), size, true, 1);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void * ptr, std::align_val_t alignment) noexcept {
+    _tgalloc_shim_delete(ptr, static_cast<std::size_t>(alignment), 0);
+}
+
+void operator delete[](void * ptr, std::align_val_t) noexcept {
+    _tgalloc_shim_free(ptr);
+}
+
+void operator delete(void * ptr, std::align_val_t alignment, std::nothrow_t const &) noexcept {
+    _tgalloc_shim_delete(ptr, static_cast<std::size_t>(alignment), 0);
+}
+
+void operator delete[](void * ptr, std::align_val_t, std::nothrow_t const &) noexcept {
+    _tgalloc_shim_free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t size, std::align_val_t alignment) noexcept {
+    _tgalloc_shim_delete(ptr, static_cast<std::size_t>(alignment), size);
+}
+
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept {
+    _tgalloc_shim_free(ptr);
+}
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file tgalloc_allocator_tests.c
+ * @brief Test suite for run-time allocator handles
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_arena.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    int x;
+    int y;
+} Point;
+
+static tga_allocator_ops const arena_ops = TGA_ALLOCATOR_OPS(tga_arena_alloc_aligned_sized,
+    tga_arena_realloc_aligned_sized, tga_arena_free_aligned_sized, tga_arena_expand_aligned_sized, NULL);
+
+// Backend that counts its calls and forwards to the default one
+typedef struct {
+    long allocs;
+    long reallocs;
+    long frees;
+} CountingBackend;
+
+void* counting_alloc(CountingBackend* self, size_t alignment, size_t size) {
+    self->allocs++;
+    return _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+}
+
+void* counting_realloc(CountingBackend* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    self->reallocs++;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingBackend* self, void const* ptr, size_t alignment, size_t size) {
+    self->frees++;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+static tga_allocator_ops const counting_ops = TGA_ALLOCATOR_OPS(counting_alloc, counting_realloc, counting_free,
+                                                                NULL, NULL);
+
+// Library-style code that takes its allocator as a parameter
+static Point* make_points(tga_allocator const* alloc, int count) {
+    Point* points = NULL;
+    palloc_with(alloc, points, count);
+    if (points == NULL) return NULL;
+    for (int i = 0; i < count; i++) {
+        points[i].x = i;
+        points[i].y = -i;
+    }
+    return points;
+}
+
+TEST_CASE(choose_at_run_time) {
+    tga_arena_t arena;
+    tga_arena_init(&arena);
+    CountingBackend counting = {0, 0, 0};
+
+    tga_allocator handles[3];
+    handles[0] = tga_allocator_default();
+    handles[1] = TGA_ALLOCATOR(&arena, &arena_ops);
+    handles[2] = TGA_ALLOCATOR(&counting, &counting_ops);
+
+    for (int h = 0; h < 3; h++) {
+        Point* points = make_points(&handles[h], 16);
+        assert(points != NULL);
+        assert((uintptr_t)points % _Alignof(Point) == 0);
+        assert(points[15].x == 15 && points[15].y == -15);
+
+        pprealloc_with(&handles[h], &points, 16, 64);
+        assert(points != NULL);
+        assert(points[15].x == 15);
+
+        Point* single = NULL;
+        palloc_with(&handles[h], single);
+        assert(single != NULL);
+        single->x = 1;
+
+        pfree_with(&handles[h], single);
+        pfree_with(&handles[h], points, 64);
+    }
+
+    assert(counting.allocs == 2);
+    assert(counting.reallocs == 1);
+    assert(counting.frees == 2);
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(zeroed_and_expand) {
+    tga_arena_t arena;
+    tga_arena_init(&arena);
+    CountingBackend counting = {0, 0, 0};
+    tga_allocator const arena_alloc = TGA_ALLOCATOR(&arena, &arena_ops);
+    tga_allocator const counting_alloc_handle = TGA_ALLOCATOR(&counting, &counting_ops);
+
+    // Without a calloc entry the block is cleared after a plain allocation
+    long* nums = NULL;
+    pcalloc_with(&arena_alloc, nums, 20);
+    assert(nums != NULL);
+    for (int i = 0; i < 20; i++) assert(nums[i] == 0);
+
+    // The arena resizes within a size class in place
+    int expanded = pptry_expand_with(&arena_alloc, &nums, 20, 19);
+    assert(expanded);
+    pfree_with(&arena_alloc, nums, 19);
+
+    // Without an expand entry only an unchanged size succeeds
+    char* bytes = NULL;
+    pcalloc_with(&counting_alloc_handle, bytes, 32);
+    assert(bytes != NULL && bytes[31] == 0);
+    expanded = pptry_expand_with(&counting_alloc_handle, &bytes, 32, 32);
+    assert(expanded);
+    expanded = pptry_expand_with(&counting_alloc_handle, &bytes, 32, 33);
+    assert(!expanded);
+    pfree_with(&counting_alloc_handle, bytes, 32);
+    assert(counting.allocs == 1 && counting.frees == 1);
+
+    tga_arena_destroy(&arena);
+}
+
+tga_allocator current;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_CALLOC_A_S
+
+#define TGA (tga_allocator const*)&current
+#define TGA_ALLOC_A_S tga_allocator_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_allocator_realloc_aligned_sized
+#define TGA_FREE_A_S tga_allocator_free_aligned_sized
+#define TGA_EXPAND_A_S tga_allocator_expand_aligned_sized
+#define TGA_CALLOC_A_S tga_allocator_calloc_aligned_sized
+
+TEST_CASE(handle_as_backend) {
+    CountingBackend counting = {0, 0, 0};
+    current = TGA_ALLOCATOR(&counting, &counting_ops);
+
+    // The plain macros go through whatever handle is current
+    Point* point = NULL;
+    palloc(point);
+    assert(point != NULL);
+    memset(point, 0, sizeof(*point));
+    pfree(point);
+
+    int* zeros = NULL;
+    pcalloc(zeros, 8);
+    assert(zeros != NULL && zeros[7] == 0);
+    pfree(zeros, 8);
+    assert(counting.allocs == 2 && counting.frees == 2);
+
+    current = tga_allocator_default();
+    pcalloc(zeros, 8);
+    assert(zeros != NULL && zeros[7] == 0);
+    pfree(zeros, 8);
+    assert(counting.allocs == 2);
+}
+
+int main() {
+    printf("Running tgalloc allocator handle tests...\n");
+
+    RUN_TEST(choose_at_run_time);
+    RUN_TEST(zeroed_and_expand);
+    RUN_TEST(handle_as_backend);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file tgalloc_arena_tests.c
+ * @brief Test suite for the size-class arena backend
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include "../tgalloc_arena.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    int id;
+    double weight;
+    char tag[20];
+} Node;
+
+typedef struct {
+    char bytes[1000];
+} BigBlob;
+
+tga_arena_t arena;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (tga_arena_t*)&arena
+#define TGA_ALLOC_A_S tga_arena_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_arena_realloc_aligned_sized
+#define TGA_FREE_A_S tga_arena_free_aligned_sized
+
+TEST_CASE(freed_block_is_reused) {
+    tga_arena_init(&arena);
+
+    Node* a = NULL;
+    palloc(a);
+    assert(a != NULL);
+    assert((uintptr_t)a % TGA_ARENA_QUANTUM == 0);
+    a->id = 1;
+    pfree(a);
+
+    Node* b = NULL;
+    palloc(b);
+    assert(b == a);
+    pfree(b);
+
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(sizes_share_class) {
+    tga_arena_init(&arena);
+
+    // 17..32 bytes all live in the same class
+    char* p = NULL;
+    palloc(p, 20);
+    pfree(p, 20);
+
+    char* q = NULL;
+    palloc(q, 32);
+    assert(q == p);
+    pfree(q, 32);
+
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(many_small_objects) {
+    tga_arena_init(&arena);
+
+    enum { COUNT = 10000 };
+    Node** nodes = malloc(COUNT * sizeof(Node*));
+    for (int i = 0; i < COUNT; i++) {
+        palloc(nodes[i]);
+        assert(nodes[i] != NULL);
+        nodes[i]->id = i;
+    }
+    for (int i = 0; i < COUNT; i++) {
+        assert(nodes[i]->id == i);
+    }
+    for (int i = 0; i < COUNT; i++) {
+        pfree(nodes[i]);
+    }
+    free(nodes);
+
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(large_goes_upstream) {
+    tga_arena_init(&arena);
+
+    BigBlob* blob = NULL;
+    palloc(blob);
+    assert(blob != NULL);
+    memset(blob->bytes, 0xab, sizeof(blob->bytes));
+    pfree(blob);
+
+    // Nothing was carved from a chunk
+    assert(arena.chunks == NULL);
+
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(realloc_paths) {
+    tga_arena_init(&arena);
+
+    int* nums = NULL;
+    palloc(nums, 5);
+    for (int i = 0; i < 5; i++) nums[i] = i;
+
+    // 20 -> 24 bytes stays in the same class
+    int* before = nums;
+    pprealloc(&nums, 5, 6);
+    assert(nums == before);
+
+    // Cross into another class
+    pprealloc(&nums, 6, 40);
+    assert(nums != NULL);
+    for (int i = 0; i < 5; i++) assert(nums[i] == i);
+
+    // Leave the size classes altogether
+    pprealloc(&nums, 40, 1000);
+    assert(nums != NULL);
+    for (int i = 0; i < 5; i++) assert(nums[i] == i);
+
+    // And come back
+    pprealloc(&nums, 1000, 8);
+    assert(nums != NULL);
+    for (int i = 0; i < 5; i++) assert(nums[i] == i);
+
+    pfree(nums, 8);
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(batch_hooks) {
+    tga_arena_init(&arena);
+
+    #undef TGA_ALLOC_BATCH_A_S
+    #undef TGA_FREE_BATCH_A_S
+    #define TGA_ALLOC_BATCH_A_S tga_arena_alloc_batch_aligned_sized
+    #define TGA_FREE_BATCH_A_S tga_arena_free_batch_aligned_sized
+
+    Node* nodes[64] = {0};
+    size_t got = palloc_many(nodes, 64);
+    assert(got == 64);
+    for (int i = 0; i < 64; i++) {
+        assert(nodes[i] != NULL);
+        nodes[i]->id = i;
+    }
+    for (int i = 0; i < 64; i++) assert(nodes[i]->id == i);
+    pfree_many(nodes, 64);
+
+    // The spliced list hands the same blocks back in the same order
+    Node* again[64] = {0};
+    got = palloc_many(again, 64);
+    assert(got == 64);
+    for (int i = 0; i < 64; i++) assert(again[i] == nodes[i]);
+    pfree_many(again, 64);
+
+    // Large objects go upstream one by one
+    BigBlob* blobs[3] = {0};
+    got = palloc_many(blobs, 3);
+    assert(got == 3);
+    pfree_many(blobs, 3);
+
+    #undef TGA_ALLOC_BATCH_A_S
+    #undef TGA_FREE_BATCH_A_S
+    #define TGA_ALLOC_BATCH_A_S TGA_ALLOC_BATCH_LOOP
+    #define TGA_FREE_BATCH_A_S TGA_FREE_BATCH_LOOP
+
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(try_expand) {
+    tga_arena_init(&arena);
+
+    #undef TGA_EXPAND_A_S
+    #define TGA_EXPAND_A_S tga_arena_expand_aligned_sized
+
+    // 20 -> 32 bytes stays in its class, 20 -> 40 does not
+    int* nums = NULL;
+    palloc(nums, 5);
+    assert(pptry_expand(&nums, 5, 8));
+    assert(!pptry_expand(&nums, 8, 10));
+    pfree(nums, 8);
+
+    // Large blocks ask the default upstream backend
+    BigBlob* blob = NULL;
+    palloc(blob, 2);
+    assert(pptry_expand(&blob, 2, 1));
+    pfree(blob, 1);
+
+    #undef TGA_EXPAND_A_S
+    #define TGA_EXPAND_A_S TGA_EXPAND_FALLBACK
+
+    tga_arena_destroy(&arena);
+}
+
+int main() {
+    printf("Running tgalloc arena tests...\n");
+
+    RUN_TEST(freed_block_is_reused);
+    RUN_TEST(sizes_share_class);
+    RUN_TEST(many_small_objects);
+    RUN_TEST(large_goes_upstream);
+    RUN_TEST(realloc_paths);
+    RUN_TEST(batch_hooks);
+    RUN_TEST(try_expand);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
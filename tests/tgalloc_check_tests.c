@@ -0,0 +1,222 @@
+/**
+ * @file tgalloc_check_tests.c
+ * @brief Test suite for the checking backend
+ */
+
+#define TGA_CHECK
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_check.h"
+#include "../tgalloc_arena.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    int x;
+    int y;
+} Pair;
+
+tga_arena_t arena;
+tga_check_t check;
+
+int reports;
+tga_check_report_t last;
+
+void remember(tga_check_report_t const* report) {
+    reports++;
+    last = *report;
+}
+
+static void setup(void) {
+    tga_arena_init(&arena);
+    int rc = tga_check_init_with_expand(&check, TGA_BACKEND(&arena, tga_arena_alloc_aligned_sized,
+                                                            tga_arena_realloc_aligned_sized,
+                                                            tga_arena_free_aligned_sized),
+                                        (tga_expand_fn)tga_arena_expand_aligned_sized);
+    assert(rc == 0);
+    (void)rc;
+    check.on_error = remember;
+    reports = 0;
+}
+
+static void teardown(void) {
+    assert(tga_check_live_count(&check) == 0);
+    tga_check_destroy(&check);
+    tga_arena_destroy(&arena);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_check_t*)&check
+#define TGA_ALLOC_A_S tga_check_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_check_realloc_aligned_sized
+#define TGA_FREE_A_S tga_check_free_aligned_sized
+#define TGA_EXPAND_A_S tga_check_expand_aligned_sized
+
+TEST_CASE(matching_calls_pass) {
+    setup();
+
+    long* nums = NULL;
+    palloc(nums, 10);
+    for (long i = 0; i < 10; i++) nums[i] = i;
+    pprealloc(&nums, 10, 1000);
+    assert(nums[9] == 9);
+    pprealloc(&nums, 1000, 3);
+    // The arena's own expand decides: within a size class only, and the record follows
+    int expanded = pptry_expand(&nums, 3, 4);
+    assert(expanded);
+    expanded = pptry_expand(&nums, 4, 2);
+    assert(!expanded);
+
+    Pair* pairs[8];
+    for (int i = 0; i < 8; i++) palloc(pairs[i]);
+    assert(tga_check_live_count(&check) == 9);
+    for (int i = 0; i < 8; i++) pfree(pairs[i]);
+    pfree(nums, 4);
+
+    assert(reports == 0);
+    teardown();
+}
+
+TEST_CASE(size_mismatch) {
+    setup();
+
+    int* nums = NULL;
+    palloc(nums, 10);
+    int alloc_line = __LINE__ - 1;
+    pfree(nums, 12);
+    int free_line = __LINE__ - 1;
+
+    assert(reports == 1);
+    assert(last.error == TGA_CHECK_SIZE_MISMATCH);
+    assert(strcmp(last.op, "free") == 0);
+    assert(last.call.size == 12 * sizeof(int) && last.recorded.size == 10 * sizeof(int));
+    assert(last.call.line == (uint32_t)free_line && last.recorded.line == (uint32_t)alloc_line);
+    assert(strstr(last.recorded.file, "tgalloc_check_tests.c") != NULL);
+
+    // The block went back with its real size, so the arena hands it out again
+    int* again = NULL;
+    palloc(again, 10);
+    assert(again == nums);
+    pfree(again, 10);
+    assert(reports == 1);
+    teardown();
+}
+
+TEST_CASE(alignment_and_type_mismatch) {
+    setup();
+
+    // Same size, different alignment
+    char* bytes = NULL;
+    palloc(bytes, 16);
+    long* as_longs = (long*)(void*)bytes;
+    pfree(as_longs, 2);
+    assert(reports == 1);
+    assert(last.error == TGA_CHECK_ALIGNMENT_MISMATCH);
+
+    // Same size and alignment, different element type
+    int* ints = NULL;
+    palloc(ints, 4);
+    Pair* as_pairs = (Pair*)(void*)ints;
+    pprealloc(&as_pairs, 2, 4);
+    assert(reports == 2);
+    assert(last.error == TGA_CHECK_TYPE_MISMATCH);
+    assert(strcmp(last.op, "realloc") == 0);
+    assert(last.call.type_size == sizeof(Pair) && last.recorded.type_size == sizeof(int));
+    assert(as_pairs != NULL);
+
+    pfree(as_pairs, 4);
+    assert(reports == 2);
+    teardown();
+}
+
+TEST_CASE(unknown_pointers) {
+    setup();
+
+    Pair* pair = NULL;
+    palloc(pair);
+    Pair* freed = pair;
+    pfree(pair);
+    pfree(freed);
+    assert(reports == 1);
+    assert(last.error == TGA_CHECK_UNKNOWN_POINTER);
+    assert(last.recorded.ptr == NULL);
+
+    Pair stack_pair;
+    Pair* not_ours = &stack_pair;
+    pprealloc(&not_ours, 1, 2);
+    assert(reports == 2 && not_ours == NULL);
+
+    // Leaks can be listed with their allocation site
+    palloc(pair);
+    FILE* out = tmpfile();
+    assert(out != NULL);
+    size_t listed = tga_check_dump_live(&check, out);
+    assert(listed == 1);
+    rewind(out);
+    char line[256] = {0};
+    char* got = fgets(line, sizeof(line), out);
+    assert(got != NULL && strstr(line, "tgalloc_check_tests.c") != NULL);
+    fclose(out);
+
+    pfree(pair);
+    teardown();
+}
+
+TEST_CASE(batches) {
+    setup();
+
+    // Every block of a batch is recorded with the site and element size
+    Pair* pairs[4];
+    assert(palloc_many(pairs, 4) == 4);
+    FILE* out = tmpfile();
+    assert(out != NULL);
+    assert(tga_check_dump_live(&check, out) == 4);
+    rewind(out);
+    char line[256];
+    for (int i = 0; i < 4; i++) {
+        char* got = fgets(line, sizeof(line), out);
+        assert(got != NULL && strstr(line, "tgalloc_check_tests.c") != NULL);
+        assert(strstr(line, "element size 8") != NULL);
+    }
+    fclose(out);
+
+    // And every free of a batch is checked with them
+    double** as_doubles = (double**)(void*)pairs;
+    pfree_many(as_doubles, 4);
+    assert(reports == 4);
+    assert(last.error == TGA_CHECK_ALIGNMENT_MISMATCH);
+    assert(last.call.file != NULL && last.call.type_size == sizeof(double));
+
+    // A site left over by a batch does not describe later calls
+    void* raw = tga_check_alloc_aligned_sized(&check, 8, 24);
+    assert(raw != NULL);
+    tga_check_free_aligned_sized(&check, raw, 8, 24);
+    assert(reports == 4);
+    teardown();
+}
+
+int main() {
+    printf("Running tgalloc check tests...\n");
+
+    RUN_TEST(matching_calls_pass);
+    RUN_TEST(size_mismatch);
+    RUN_TEST(alignment_and_type_mismatch);
+    RUN_TEST(unknown_pointers);
+    RUN_TEST(batches);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
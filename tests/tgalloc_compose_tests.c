@@ -0,0 +1,238 @@
+/**
+ * @file tgalloc_compose_tests.c
+ * @brief Test suite for composed backends
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_compose.h"
+#include "../tgalloc_region.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    double x, y, z;
+} Point;
+
+// Backend that counts its live blocks and bytes, named as tgalloc_compose.h expects
+typedef struct {
+    long live_blocks;
+    size_t live_bytes;
+    size_t largest;
+} counter_t;
+
+void counter_init(counter_t* self) {
+    memset(self, 0, sizeof(*self));
+}
+
+void counter_destroy(counter_t* self) {
+    assert(self->live_blocks == 0);
+}
+
+void* counter_alloc_aligned_sized(counter_t* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) {
+        self->live_blocks++;
+        self->live_bytes += size;
+        if (size > self->largest) self->largest = size;
+    }
+    return ptr;
+}
+
+void* counter_realloc_aligned_sized(counter_t* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    void* moved = _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+    if (moved) {
+        if (ptr == NULL) self->live_blocks++;
+        self->live_bytes += new_size - old_size;
+    }
+    return moved;
+}
+
+void counter_free_aligned_sized(counter_t* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) {
+        self->live_blocks--;
+        self->live_bytes -= size;
+    }
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+// Bounded bump allocator over a fixed buffer, which can tell its own blocks
+typedef struct {
+    char bytes[1024];
+    size_t used;
+} buffer_t;
+
+void* buffer_alloc_aligned_sized(buffer_t* self, size_t alignment, size_t size) {
+    uintptr_t base = (uintptr_t)self->bytes;
+    size_t start = (size_t)(((base + self->used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+    if (start > sizeof(self->bytes) || sizeof(self->bytes) - start < size) return NULL;
+    self->used = start + size;
+    return self->bytes + start;
+}
+
+void* buffer_realloc_aligned_sized(buffer_t* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    if (new_size <= old_size) return ptr;
+    void* moved = buffer_alloc_aligned_sized(self, alignment, new_size);
+    if (moved && ptr) memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+void buffer_free_aligned_sized(buffer_t* self, void const* ptr, size_t alignment, size_t size) {
+    (void)self;
+    (void)ptr;
+    (void)alignment;
+    (void)size;
+}
+
+int buffer_owns(buffer_t const* self, void const* ptr) {
+    return (char const*)ptr >= self->bytes && (char const*)ptr < self->bytes + sizeof(self->bytes);
+}
+
+TGA_SEGREGATOR(split, 64, counter, counter)
+TGA_FALLBACK(spill, buffer, counter)
+TGA_BUCKETIZER(sized, 1, 128, 32, counter)
+TGA_SEGREGATOR(layered, 128, sized, tga_default)
+
+TEST_CASE(segregator) {
+    counter_t small, large;
+    counter_init(&small);
+    counter_init(&large);
+    split_t split = {&small, &large};
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+    #define TGA (split_t*)&split
+    #define TGA_ALLOC_A_S split_alloc_aligned_sized
+    #define TGA_REALLOC_A_S split_realloc_aligned_sized
+    #define TGA_FREE_A_S split_free_aligned_sized
+
+    Point* point = NULL;
+    double* samples = NULL;
+    palloc(point);
+    palloc(samples, 100);
+    assert(small.live_blocks == 1 && small.live_bytes == sizeof(Point));
+    assert(large.live_blocks == 1 && large.live_bytes == 100 * sizeof(double));
+
+    // Crossing the threshold moves the block and keeps its contents
+    for (int i = 0; i < 100; i++) samples[i] = i;
+    pprealloc(&samples, 100, 4);
+    for (int i = 0; i < 4; i++) assert(samples[i] == i);
+    assert(small.live_blocks == 2 && large.live_blocks == 0);
+    pprealloc(&samples, 4, 8);
+    assert(small.live_blocks == 2 && small.live_bytes == sizeof(Point) + 8 * sizeof(double));
+
+    pfree(point);
+    pfree(samples, 8);
+    assert(small.live_blocks == 0 && small.live_bytes == 0 && large.live_bytes == 0);
+}
+
+TEST_CASE(fallback) {
+    buffer_t buffer = {{0}, 0};
+    counter_t heap;
+    counter_init(&heap);
+    spill_t spill = {&buffer, &heap};
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+    #define TGA (spill_t*)&spill
+    #define TGA_ALLOC_A_S spill_alloc_aligned_sized
+    #define TGA_REALLOC_A_S spill_realloc_aligned_sized
+    #define TGA_FREE_A_S spill_free_aligned_sized
+
+    // The buffer serves what fits, the heap the rest
+    char* first = NULL;
+    char* second = NULL;
+    palloc(first, 600);
+    palloc(second, 600);
+    assert(buffer_owns(&buffer, first) && !buffer_owns(&buffer, second));
+    assert(heap.live_blocks == 1);
+
+    // A realloc the buffer cannot serve moves to the heap and stays there
+    memset(first, 'a', 600);
+    pprealloc(&first, 600, 2000);
+    assert(first[599] == 'a' && !buffer_owns(&buffer, first));
+    assert(heap.live_blocks == 2);
+    pprealloc(&first, 2000, 3000);
+    assert(heap.live_bytes == 3600);
+
+    pfree(first, 3000);
+    pfree(second, 600);
+    assert(heap.live_blocks == 0 && heap.live_bytes == 0);
+}
+
+TEST_CASE(bucketizer) {
+    sized_t sized;
+    sized_init(&sized);
+    layered_t layered = {&sized, NULL};
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+    #define TGA (layered_t*)&layered
+    #define TGA_ALLOC_A_S layered_alloc_aligned_sized
+    #define TGA_REALLOC_A_S layered_realloc_aligned_sized
+    #define TGA_FREE_A_S layered_free_aligned_sized
+
+    // Sizes 1-32, 33-64, 65-96 and 97-128 each have their own bucket
+    char* tiny = NULL;
+    char* mid = NULL;
+    char* big = NULL;
+    palloc(tiny, 32);
+    palloc(mid, 33);
+    palloc(big, 4096);
+    assert(sized.buckets[0].live_blocks == 1 && sized.buckets[1].live_blocks == 1);
+    assert(sized.buckets[2].live_blocks == 0 && sized.buckets[3].live_blocks == 0);
+
+    // Within a bucket, realloc stays; across buckets, the block moves
+    pprealloc(&mid, 33, 60);
+    assert(sized.buckets[1].live_blocks == 1 && sized.buckets[1].live_bytes == 60);
+    strcpy(mid, "kept");
+    pprealloc(&mid, 60, 100);
+    assert(strcmp(mid, "kept") == 0);
+    assert(sized.buckets[1].live_blocks == 0 && sized.buckets[3].live_blocks == 1);
+
+    // Out of range, the bucketizer itself fails
+    assert(sized_alloc_aligned_sized(&sized, 8, 0) == NULL);
+    assert(sized_alloc_aligned_sized(&sized, 8, 129) == NULL);
+
+    pfree(tiny, 32);
+    pfree(mid, 100);
+    pfree(big, 4096);
+    sized_destroy(&sized);
+}
+
+TEST_CASE(owns) {
+    tga_region_t region;
+    tga_region_init(&region);
+    int local = 0;
+    assert(!tga_region_owns(&region, &local));
+    void* block = tga_region_alloc_aligned_sized(&region, 8, 100);
+    assert(tga_region_owns(&region, block) && tga_region_owns(&region, (char*)block + 99));
+    assert(!tga_region_owns(&region, &local));
+    tga_region_destroy(&region);
+}
+
+int main() {
+    printf("Running tgalloc compose tests...\n");
+
+    RUN_TEST(segregator);
+    RUN_TEST(fallback);
+    RUN_TEST(bucketizer);
+    RUN_TEST(owns);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
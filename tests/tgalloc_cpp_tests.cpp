@@ -0,0 +1,183 @@
+/**
+ * @file tgalloc_cpp_tests.cpp
+ * @brief Test suite for the C++ allocator and memory resource adapters
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../tgalloc.hpp"
+#include "../tgalloc_arena.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+struct alignas(32) Wide {
+    double lanes[4];
+};
+
+// Backend that tracks its live bytes, so a wrong size on free shows up
+struct CountingBackend {
+    long live_blocks;
+    size_t live_bytes;
+    size_t max_alignment;
+    bool exhausted;
+};
+
+void* counting_alloc(CountingBackend* self, size_t alignment, size_t size) {
+    if (self->exhausted) return nullptr;
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(nullptr, alignment, size);
+    if (ptr) {
+        self->live_blocks++;
+        self->live_bytes += size;
+        if (alignment > self->max_alignment) self->max_alignment = alignment;
+    }
+    return ptr;
+}
+
+void counting_free(CountingBackend* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) {
+        self->live_blocks--;
+        self->live_bytes -= size;
+    }
+    _tgalloc_dflt_free_aligned_sized(nullptr, ptr, alignment, size);
+}
+
+typedef tga::backend<CountingBackend, counting_alloc, counting_free> counting_backend;
+typedef tga::backend<tga_arena_t, tga_arena_alloc_aligned_sized, tga_arena_free_aligned_sized> arena_backend;
+
+TEST_CASE(sized_deallocation) {
+    CountingBackend counting = {};
+    {
+        tga::allocator<int, counting_backend> alloc(&counting);
+        std::vector<int, tga::allocator<int, counting_backend> > v(alloc);
+        for (int i = 0; i < 10000; i++) v.push_back(i);
+        assert(counting.live_blocks == 1);
+        assert(counting.live_bytes == v.capacity() * sizeof(int));
+
+        // Rebound copies draw from the same instance and compare equal
+        std::map<int, int, std::less<int>, tga::allocator<std::pair<const int, int>, counting_backend> >
+            map(std::less<int>(), alloc);
+        for (int i = 0; i < 100; i++) map[i] = i;
+        assert(counting.live_blocks == 101);
+        tga::allocator<long, counting_backend> other(alloc);
+        assert(other == alloc);
+    }
+    assert(counting.live_blocks == 0 && counting.live_bytes == 0);
+}
+
+TEST_CASE(alignment_and_failure) {
+    CountingBackend counting = {};
+    tga::allocator<Wide, counting_backend> alloc(&counting);
+    Wide* wide = alloc.allocate(3);
+    assert((uintptr_t)wide % 32 == 0 && counting.max_alignment == 32);
+    alloc.deallocate(wide, 3);
+
+    counting.exhausted = true;
+    bool threw = false;
+    try {
+        alloc.allocate(1);
+    } catch (std::bad_alloc const&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        alloc.allocate(SIZE_MAX / 2);
+    } catch (std::bad_alloc const&) {
+        threw = true;
+    }
+    assert(threw && counting.live_blocks == 0);
+}
+
+TEST_CASE(arena_backed_containers) {
+    tga_arena_t arena;
+    tga_arena_init(&arena);
+    {
+        typedef tga::allocator<std::pair<const int, int>, arena_backend> pair_alloc;
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, pair_alloc>
+            map(16, std::hash<int>(), std::equal_to<int>(), pair_alloc(&arena));
+        for (int i = 0; i < 1000; i++) map[i] = 2 * i;
+        for (int i = 0; i < 1000; i++) assert(map[i] == 2 * i);
+        for (int i = 0; i < 1000; i += 2) map.erase(i);
+        assert(map.size() == 500);
+
+        // Different instances are different allocators
+        tga_arena_t other;
+        tga_arena_init(&other);
+        assert(pair_alloc(&arena) != pair_alloc(&other));
+        tga_arena_destroy(&other);
+    }
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(default_and_any_backend) {
+    std::vector<std::string, tga::allocator<std::string> > names;
+    names.push_back("malloc");
+    names.push_back("backed");
+    assert(names[1] == "backed");
+
+    CountingBackend counting = {};
+    tga_backend_t chosen = TGA_BACKEND(&counting, counting_alloc, _tgalloc_dflt_realloc_aligned_sized, counting_free);
+    {
+        std::vector<double, tga::allocator<double, tga::any_backend> > v(
+            (tga::allocator<double, tga::any_backend>(&chosen)));
+        v.resize(100);
+        assert(counting.live_bytes == 100 * sizeof(double));
+    }
+    assert(counting.live_blocks == 0);
+}
+
+#ifdef _TGALLOC_HAS_PMR
+TEST_CASE(memory_resource) {
+    CountingBackend counting = {};
+    tga::memory_resource<counting_backend> resource(&counting);
+    {
+        std::pmr::vector<Wide> wides(&resource);
+        wides.resize(10);
+        assert((uintptr_t)wides.data() % 32 == 0);
+        std::pmr::unordered_map<int, int> map(&resource);
+        for (int i = 0; i < 100; i++) map[i] = i;
+        assert(counting.live_blocks > 1);
+    }
+    assert(counting.live_blocks == 0 && counting.live_bytes == 0);
+
+    // Zero-byte requests still get a block of their own
+    void* a = resource.allocate(0, 8);
+    void* b = resource.allocate(0, 8);
+    assert(a != nullptr && b != nullptr && a != b);
+    resource.deallocate(a, 0, 8);
+    resource.deallocate(b, 0, 8);
+    assert(counting.live_bytes == 0);
+
+    tga::memory_resource<counting_backend> same(&counting);
+    CountingBackend elsewhere = {};
+    tga::memory_resource<counting_backend> different(&elsewhere);
+    assert(resource.is_equal(same) && !resource.is_equal(different));
+    assert(!resource.is_equal(*std::pmr::new_delete_resource()));
+}
+#endif
+
+int main() {
+    printf("Running tgalloc C++ tests...\n");
+
+    RUN_TEST(sized_deallocation);
+    RUN_TEST(alignment_and_failure);
+    RUN_TEST(arena_backed_containers);
+    RUN_TEST(default_and_any_backend);
+#ifdef _TGALLOC_HAS_PMR
+    RUN_TEST(memory_resource);
+#endif
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file tgalloc_epoch_tests.c
+ * @brief Test suite for epoch-based deferred frees
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../tgalloc_epoch.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct Node {
+    long key;
+    long value;
+    struct Node * next;
+} Node;
+
+// Backend that records the sizes of its live blocks
+typedef struct {
+    long live_blocks;   // Touched atomically: frees may come from any thread
+    size_t live_bytes;
+} CountingBackend;
+
+void* counting_alloc(CountingBackend* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) {
+        __atomic_fetch_add(&self->live_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&self->live_bytes, size, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+void* counting_realloc(CountingBackend* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    (void)self;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingBackend* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) {
+        __atomic_fetch_sub(&self->live_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&self->live_bytes, size, __ATOMIC_RELAXED);
+        // Poison the block, so that a reader still using it notices
+        memset((void*)ptr, 0xa5, size);
+        if (size >= sizeof(long)) *(long*)ptr = -1;
+    }
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+CountingBackend backend;
+tga_epoch_t epoch;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (CountingBackend*)&backend
+#define TGA_ALLOC_A_S counting_alloc
+#define TGA_REALLOC_A_S counting_realloc
+#define TGA_FREE_A_S counting_free
+#define TGA_EPOCH &epoch
+
+TEST_CASE(no_readers) {
+    int rc = tga_epoch_init(&epoch);
+    assert(rc == 0);
+    (void)rc;
+    Node * node = NULL;
+    long * values = NULL;
+    palloc(node);
+    palloc(values, 10);
+    assert(backend.live_blocks == 2);
+
+    // Queued with the sizes pfree would use, freed once nobody can see them
+    assert(pfree_deferred(node));
+    assert(pfree_deferred(values, 10));
+    assert(pfree_deferred((Node*)NULL));
+    assert(tga_epoch_pending(&epoch) == 2 && backend.live_blocks == 2);
+    assert(tga_epoch_reclaim(&epoch) == 2);
+    assert(backend.live_blocks == 0 && backend.live_bytes == 0);
+    tga_epoch_destroy(&epoch);
+}
+
+TEST_CASE(waits_for_quiescent_readers) {
+    tga_epoch_init(&epoch);
+    tga_epoch_reader_t first, second;
+    tga_epoch_register(&epoch, &first);
+    tga_epoch_register(&epoch, &second);
+
+    Node * node = NULL;
+    palloc(node);
+    pfree_deferred(node);
+    assert(tga_epoch_reclaim(&epoch) == 0);
+
+    // Both readers have to pass a quiescent point after the free was queued
+    tga_epoch_quiescent(&first);
+    assert(tga_epoch_reclaim(&epoch) == 0);
+    tga_epoch_quiescent(&second);
+    assert(tga_epoch_reclaim(&epoch) == 1);
+    assert(backend.live_blocks == 0);
+
+    // An offline reader holds nothing up
+    palloc(node);
+    pfree_deferred(node);
+    tga_epoch_offline(&second);
+    tga_epoch_quiescent(&first);
+    assert(tga_epoch_reclaim(&epoch) == 1);
+
+    // Back online, it counts again
+    tga_epoch_online(&second);
+    palloc(node);
+    pfree_deferred(node);
+    tga_epoch_quiescent(&first);
+    assert(tga_epoch_reclaim(&epoch) == 0);
+    tga_epoch_unregister(&second);
+    assert(tga_epoch_reclaim(&epoch) == 1);
+
+    tga_epoch_unregister(&first);
+    tga_epoch_destroy(&epoch);
+    assert(backend.live_blocks == 0);
+}
+
+TEST_CASE(batches) {
+    tga_epoch_init(&epoch);
+    tga_epoch_reader_t reader;
+    tga_epoch_register(&epoch, &reader);
+
+    // A full batch triggers reclamation by itself
+    Node * nodes[3 * TGA_EPOCH_BATCH];
+    for (int i = 0; i < 3 * TGA_EPOCH_BATCH; i++) {
+        palloc(nodes[i]);
+        pfree_deferred(nodes[i]);
+        tga_epoch_quiescent(&reader);
+    }
+    assert(tga_epoch_pending(&epoch) < 3 * TGA_EPOCH_BATCH);
+    assert((size_t)backend.live_blocks == tga_epoch_pending(&epoch));
+
+    // Destroying the domain frees the rest
+    tga_epoch_unregister(&reader);
+    tga_epoch_destroy(&epoch);
+    assert(backend.live_blocks == 0 && backend.live_bytes == 0);
+}
+
+// A shared list: readers walk it, the writer replaces its head
+#define READERS 3
+#define UPDATES 20000
+
+Node * volatile head;
+int done;
+
+static void* read_list(void* arg) {
+    (void)arg;
+    tga_epoch_reader_t reader;
+    tga_epoch_register(&epoch, &reader);
+    long sum = 0;
+    while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+        for (Node * node = __atomic_load_n(&head, __ATOMIC_ACQUIRE); node; node = node->next) {
+            // A node freed too early would have been poisoned
+            assert(node->key == node->value);
+            sum += node->key;
+        }
+        tga_epoch_quiescent(&reader);
+    }
+    tga_epoch_unregister(&reader);
+    return (void*)sum;
+}
+
+TEST_CASE(concurrent_readers) {
+    tga_epoch_init(&epoch);
+    pthread_t readers[READERS];
+    for (int t = 0; t < READERS; t++) pthread_create(&readers[t], NULL, read_list, NULL);
+
+    for (long i = 0; i < UPDATES; i++) {
+        Node * node = NULL;
+        palloc(node);
+        node->key = node->value = i;
+        node->next = NULL;
+        Node * old = __atomic_exchange_n(&head, node, __ATOMIC_ACQ_REL);
+        if (old) {
+            pfree_deferred(old);
+        }
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    for (int t = 0; t < READERS; t++) pthread_join(readers[t], NULL);
+
+    // Only the live head and the last partial batches are still allocated
+    assert((size_t)backend.live_blocks == tga_epoch_pending(&epoch) + 1);
+    assert(tga_epoch_reclaim(&epoch) > 0 || tga_epoch_pending(&epoch) == 0);
+    pfree(head);
+    tga_epoch_destroy(&epoch);
+    assert(backend.live_blocks == 0);
+}
+
+int main() {
+    printf("Running tgalloc epoch tests...\n");
+
+    RUN_TEST(no_readers);
+    RUN_TEST(waits_for_quiescent_readers);
+    RUN_TEST(batches);
+    RUN_TEST(concurrent_readers);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
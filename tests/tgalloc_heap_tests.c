@@ -0,0 +1,167 @@
+/**
+ * @file tgalloc_heap_tests.c
+ * @brief Test suite for heap walks and heap reports
+ */
+
+#include "../tgalloc_large.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_arena.h"
+#include "../tgalloc_slab.h"
+#include "../tgalloc_region.h"
+#include "../tgalloc_heap.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+// Every chunk must account for at most its own size
+static void check_chunk(void * ctx, tga_heap_chunk_t const * chunk) {
+    size_t * visited = (size_t*)ctx;
+    assert(chunk->start != NULL);
+    assert(chunk->used_bytes + chunk->free_bytes <= chunk->size);
+    (*visited)++;
+}
+
+TEST_CASE(arena) {
+    tga_arena_t arena;
+    tga_arena_init(&arena);
+    tga_heap_report_t report;
+    assert(tga_arena_report(&arena, &report));
+    assert(report.chunks == 0 && report.reserved_bytes == 0);
+
+    void* blocks[1000];
+    for (int i = 0; i < 1000; i++) blocks[i] = tga_arena_alloc_aligned_sized(&arena, 8, 32);
+    for (int i = 0; i < 1000; i += 2) tga_arena_free_aligned_sized(&arena, blocks[i], 8, 32);
+
+    assert(tga_arena_report(&arena, &report));
+    assert(report.chunks == 1 && report.reserved_bytes == TGA_ARENA_CHUNK_SIZE);
+    assert(report.used_bytes == 500 * 32);
+    assert(report.classes[1].block_size == 32 && report.classes[1].free_blocks == 500);
+    // Only the holes between used blocks are stuck; the uncarved tail is not
+    assert(report.releasable_bytes == 0);
+    assert(tga_heap_fragmentation(&report) > 0.0 && tga_heap_fragmentation(&report) < 1.0);
+
+    size_t visited = 0;
+    assert(tga_arena_walk(&arena, check_chunk, &visited));
+    assert(visited == 1);
+
+    // Once everything is free, the whole chunk can go back
+    for (int i = 1; i < 1000; i += 2) tga_arena_free_aligned_sized(&arena, blocks[i], 8, 32);
+    assert(tga_arena_report(&arena, &report));
+    assert(report.used_bytes == 0 && report.releasable_bytes == report.free_bytes);
+    assert(tga_heap_fragmentation(&report) == 0.0);
+    tga_arena_destroy(&arena);
+}
+
+TEST_CASE(slab) {
+    tga_slab_t slab;
+    tga_slab_init(&slab);
+    void* small = tga_slab_alloc_aligned_sized(&slab, 8, 16);
+    void* nodes[100];
+    for (int i = 0; i < 100; i++) nodes[i] = tga_slab_alloc_aligned_sized(&slab, 8, 64);
+
+    tga_heap_report_t report;
+    assert(tga_slab_report(&slab, &report));
+    assert(report.chunks == 2 && report.reserved_bytes == 2 * TGA_SLAB_PAGE_SIZE);
+    assert(report.used_bytes == 16 + 100 * 64);
+    tga_heap_class_t const * cls = &report.classes[_tgalloc_slab_class(64)];
+    assert(cls->block_size == 64 && cls->blocks - cls->free_blocks == 100);
+
+    size_t visited = 0;
+    assert(tga_slab_walk(&slab, check_chunk, &visited));
+    assert(visited == 2);
+
+    // The kept empty page of the class shows as releasable
+    for (int i = 0; i < 100; i++) tga_slab_free_aligned_sized(&slab, nodes[i], 8, 64);
+    assert(tga_slab_report(&slab, &report));
+    assert(report.used_bytes == 16 && report.releasable_bytes == cls->blocks * 64);
+    tga_slab_free_aligned_sized(&slab, small, 8, 16);
+    tga_slab_destroy(&slab);
+}
+
+TEST_CASE(region) {
+    tga_region_t region;
+    tga_region_init_with(&region, TGA_BACKEND_DEFAULT, 4096);
+    for (int i = 0; i < 3; i++) tga_region_alloc_aligned_sized(&region, 8, 3000);
+
+    tga_heap_report_t report;
+    assert(tga_region_report(&region, &report));
+    assert(report.chunks == 3 && report.used_bytes >= 9000 && report.releasable_bytes == 0);
+
+    // After a reset, the spare chunks are entirely free
+    tga_region_reset(&region);
+    assert(tga_region_report(&region, &report));
+    assert(report.chunks == 3 && report.used_bytes == 0);
+    assert(report.free_bytes == report.releasable_bytes && report.free_bytes > 9000);
+    tga_region_destroy(&region);
+}
+
+TEST_CASE(large) {
+    tga_large_t large;
+    tga_large_init_with(&large, TGA_BACKEND_DEFAULT, 64 * 1024, 0);
+    char* big = (char*)tga_large_alloc_aligned_sized(&large, 8, 100 * 1000);
+    char* small = (char*)tga_large_alloc_aligned_sized(&large, 8, 100);
+
+    tga_heap_report_t report;
+    assert(tga_large_report(&large, &report));
+    assert(report.chunks == 1 && report.used_bytes == 100 * 1000);
+    assert(report.reserved_bytes == _tgalloc_large_length(&large, 100 * 1000));
+
+    big = (char*)tga_large_realloc_aligned_sized(&large, big, 8, 100 * 1000, 1000 * 1000);
+    assert(tga_large_report(&large, &report));
+    assert(report.chunks == 1 && report.used_bytes == 1000 * 1000);
+    assert(report.reserved_bytes == _tgalloc_large_length(&large, 1000 * 1000));
+
+    tga_large_free_aligned_sized(&large, big, 8, 1000 * 1000);
+    tga_large_free_aligned_sized(&large, small, 8, 100);
+    assert(tga_large_report(&large, &report));
+    assert(report.chunks == 0 && report.reserved_bytes == 0 && report.used_bytes == 0);
+}
+
+TEST_CASE(json) {
+    tga_slab_t slab;
+    tga_slab_init(&slab);
+    void* block = tga_slab_alloc_aligned_sized(&slab, 8, 24);
+    tga_heap_report_t report;
+    tga_slab_report(&slab, &report);
+
+    FILE* out = tmpfile();
+    assert(out != NULL);
+    tga_heap_report_json(out, "slab", &report);
+    tga_slab_walk(&slab, tga_heap_chunk_json, out);
+    char text[1024];
+    rewind(out);
+    assert(fgets(text, sizeof(text), out) != NULL);
+    assert(strncmp(text, "{\"backend\":\"slab\",\"chunks\":1,", 29) == 0);
+    assert(strstr(text, "\"used_bytes\":24,") != NULL);
+    // Only the one class with a page is listed
+    assert(strstr(text, "\"classes\":[{\"block_size\":24,") != NULL);
+    assert(strstr(text, "},{") == NULL && strcmp(text + strlen(text) - 3, "]}\n") == 0);
+    assert(fgets(text, sizeof(text), out) != NULL);
+    assert(strstr(text, "\"block_size\":24}") != NULL);
+    assert(fgets(text, sizeof(text), out) == NULL);
+    fclose(out);
+
+    tga_slab_free_aligned_sized(&slab, block, 8, 24);
+    tga_slab_destroy(&slab);
+}
+
+int main() {
+    printf("Running tgalloc heap tests...\n");
+
+    RUN_TEST(arena);
+    RUN_TEST(slab);
+    RUN_TEST(region);
+    RUN_TEST(large);
+    RUN_TEST(json);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file tgalloc_large_tests.c
+ * @brief Test suite for the large-object mapping backend
+ */
+
+#include "../tgalloc_large.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+#define THRESHOLD (64 * 1024)
+
+// Upstream that counts what reaches it
+typedef struct {
+    size_t live_blocks;
+} CountingUpstream;
+
+CountingUpstream upstream = {0};
+
+void* counting_alloc(CountingUpstream* self, size_t alignment, size_t size) {
+    self->live_blocks++;
+    return _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+}
+
+void* counting_realloc(CountingUpstream* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    if (ptr == NULL) self->live_blocks++;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingUpstream* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) self->live_blocks--;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+tga_large_t large;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_CALLOC_A_S
+
+#define TGA (tga_large_t*)&large
+#define TGA_ALLOC_A_S tga_large_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_large_realloc_aligned_sized
+#define TGA_FREE_A_S tga_large_free_aligned_sized
+#define TGA_EXPAND_A_S tga_large_expand_aligned_sized
+#define TGA_CALLOC_A_S tga_large_calloc_aligned_sized
+
+void init_large(int flags) {
+    upstream.live_blocks = 0;
+    tga_large_init_with(&large, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free),
+                        THRESHOLD, flags);
+}
+
+TEST_CASE(threshold_routing) {
+    init_large(0);
+
+    char* small = NULL;
+    palloc(small, THRESHOLD - 1);
+    assert(small != NULL);
+    assert(upstream.live_blocks == 1);
+
+    char* big = NULL;
+    palloc(big, THRESHOLD);
+    assert(big != NULL);
+    assert(upstream.live_blocks == 1);
+    assert((uintptr_t)big % large.page_size == 0);
+    big[0] = 1;
+    big[THRESHOLD - 1] = 2;
+
+    pfree(big, THRESHOLD);
+    pfree(small, THRESHOLD - 1);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(realloc_keeps_contents) {
+    init_large(0);
+
+    int* nums = NULL;
+    size_t len = 1000;  // starts below the threshold
+    palloc(nums, len);
+    for (size_t i = 0; i < len; i++) nums[i] = (int)i;
+
+    // Cross into the mapped path, then keep growing
+    size_t sizes[] = {THRESHOLD, 4 * THRESHOLD, 64 * THRESHOLD, 3 * THRESHOLD, 500};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t new_len = sizes[k];
+        pprealloc(&nums, len, new_len);
+        assert(nums != NULL);
+        size_t kept = len < new_len ? len : new_len;
+        for (size_t i = 0; i < kept; i++) assert(nums[i] == (int)i);
+        for (size_t i = kept; i < new_len; i++) nums[i] = (int)i;
+        len = new_len;
+    }
+    assert(upstream.live_blocks == 1);
+    pfree(nums, len);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(expand_in_place) {
+    init_large(0);
+
+    char* buf = NULL;
+    palloc(buf, 8 * THRESHOLD);
+    memset(buf, 7, 8 * THRESHOLD);
+    char* before = buf;
+
+    // Shrinking a mapping always stays in place
+    assert(pptry_expand(&buf, 8 * THRESHOLD, 2 * THRESHOLD));
+    assert(buf == before);
+    assert(buf[2 * THRESHOLD - 1] == 7);
+
+    // Within the same page count nothing needs to happen
+    assert(pptry_expand(&buf, 2 * THRESHOLD, 2 * THRESHOLD - 1));
+
+    // Crossing the threshold is never done in place
+    assert(!pptry_expand(&buf, 2 * THRESHOLD - 1, 100));
+
+    pfree(buf, 2 * THRESHOLD - 1);
+}
+
+TEST_CASE(huge_page_flags) {
+    // Explicit huge pages are usually not reserved; the backend then falls
+    // back to normal pages but keeps the huge page rounding
+    int flag_sets[] = {TGA_LARGE_THP, TGA_LARGE_HUGETLB, TGA_LARGE_THP | TGA_LARGE_HUGETLB};
+    for (size_t f = 0; f < 3; f++) {
+        init_large(flag_sets[f]);
+
+        char* buf = NULL;
+        size_t len = 3 * TGA_LARGE_HUGE_PAGE_SIZE + 5;
+        palloc(buf, len);
+        assert(buf != NULL);
+        memset(buf, 1, len);
+#if defined(MADV_HUGEPAGE)
+        if (flag_sets[f] == TGA_LARGE_THP) assert((uintptr_t)buf % TGA_LARGE_HUGE_PAGE_SIZE == 0);
+#endif
+
+        pprealloc(&buf, len, 2 * len);
+        assert(buf != NULL);
+        assert(buf[len - 1] == 1);
+        pfree(buf, 2 * len);
+    }
+}
+
+TEST_CASE(zeroed_alloc) {
+    init_large(TGA_LARGE_THP);
+
+    // Both paths hand out cleared memory
+    size_t lens[] = {100, THRESHOLD, 3 * TGA_LARGE_HUGE_PAGE_SIZE};
+    for (size_t k = 0; k < 3; k++) {
+        unsigned char* buf = NULL;
+        pcalloc(buf, lens[k]);
+        assert(buf != NULL);
+        for (size_t i = 0; i < lens[k]; i++) assert(buf[i] == 0);
+        memset(buf, 0xFF, lens[k]);
+
+        pprealloc_zero(&buf, lens[k], 2 * lens[k]);
+        assert(buf != NULL);
+        assert(buf[lens[k] - 1] == 0xFF);
+        for (size_t i = lens[k]; i < 2 * lens[k]; i++) assert(buf[i] == 0);
+        pfree(buf, 2 * lens[k]);
+    }
+    assert(upstream.live_blocks == 0);
+}
+
+int main() {
+    printf("Running tgalloc large tests...\n");
+
+    RUN_TEST(threshold_routing);
+    RUN_TEST(realloc_keeps_contents);
+    RUN_TEST(expand_in_place);
+    RUN_TEST(huge_page_flags);
+    RUN_TEST(zeroed_alloc);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
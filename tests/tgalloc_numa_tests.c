@@ -0,0 +1,214 @@
+/**
+ * @file tgalloc_numa_tests.c
+ * @brief Test suite for the NUMA-aware backend
+ */
+
+#define TGA_CHECK
+#include "../tgalloc_numa.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    long id;
+    double weight;
+} Item;
+
+tga_numa_t numa;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (tga_numa_t*)&numa
+#define TGA_ALLOC_A_S tga_numa_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_numa_realloc_aligned_sized
+#define TGA_FREE_A_S tga_numa_free_aligned_sized
+
+// Two nodes regardless of the machine; binding to a missing node is ignored
+static void setup(void) {
+    int rc = tga_numa_init_with(&numa, TGA_BACKEND_DEFAULT, 2);
+    assert(rc == 0);
+    (void)rc;
+}
+
+TEST_CASE(system_nodes) {
+    int rc = tga_numa_init(&numa);
+    assert(rc == 0);
+    assert(numa.node_count >= 1 && numa.node_count <= TGA_NUMA_MAX_NODES);
+
+    Item* item = NULL;
+    palloc(item);
+    assert(item != NULL);
+    assert(tga_numa_node_of(&numa, item) == (long)(tga_numa_current_node() % numa.node_count));
+    pfree(item);
+    tga_numa_destroy(&numa);
+}
+
+TEST_CASE(node_hints) {
+    setup();
+
+    Item* here = NULL;
+    palloc(here, 4);
+    assert(here != NULL);
+    assert(tga_numa_node_of(&numa, here) == (long)(tga_numa_current_node() % 2));
+
+    Item* there = NULL;
+    palloc_on_node(there, 4, 1);
+    assert(there != NULL);
+    assert(tga_numa_node_of(&numa, there) == 1);
+    there[3].id = 3;
+
+    // The hint only applies to the allocation it was given for
+    Item* after = NULL;
+    palloc(after);
+    assert(tga_numa_node_of(&numa, after) == tga_numa_node_of(&numa, here));
+
+    // Node numbers wrap, and resizing keeps a small block on its node
+    int* wrapped = NULL;
+    palloc_on_node(wrapped, 2, 3);
+    assert(tga_numa_node_of(&numa, wrapped) == 1);
+    pprealloc(&there, 4, 8);
+    assert(tga_numa_node_of(&numa, there) == 1);
+    assert(there[3].id == 3);
+
+    pfree(wrapped, 2);
+    pfree(after);
+    pfree(there, 8);
+    pfree(here, 4);
+    tga_numa_destroy(&numa);
+}
+
+Item* handed_over;
+
+void* free_elsewhere(void* arg) {
+    (void)arg; // Mark as unused to prevent compiler warnings
+    pfree(handed_over);
+    return NULL;
+}
+
+TEST_CASE(free_from_other_thread) {
+    setup();
+
+    palloc_on_node(handed_over, 1, 1);
+    Item* freed = handed_over;
+    pthread_t thread;
+    pthread_create(&thread, NULL, free_elsewhere, NULL);
+    pthread_join(thread, NULL);
+
+    // The block went back to the arena of its own node
+    Item* again = NULL;
+    palloc_on_node(again, 1, 1);
+    assert(again == freed);
+    pfree(again, 1);
+    tga_numa_destroy(&numa);
+}
+
+TEST_CASE(medium_and_large) {
+    setup();
+
+    // Between the arena classes and the large threshold: the slice of the node asked for
+    char* medium = NULL;
+    palloc_on_node(medium, 4096, 1);
+    assert(medium != NULL && (uintptr_t)medium % 64 == 0);
+    assert(tga_numa_node_of(&numa, medium) == 1);
+    memset(medium, 1, 4096);
+
+    // Freed medium blocks are reused by their class on their node
+    double* doubles = NULL;
+    palloc_on_node(doubles, 1024, 1);
+    assert(tga_numa_node_of(&numa, doubles) == 1);
+    double* freed = doubles;
+    pfree(doubles, 1024);
+    palloc_on_node(doubles, 1000, 1);
+    assert(doubles == freed);
+    pfree(doubles, 1000);
+
+    // From the threshold on: a mapping of its own
+    size_t len = TGA_NUMA_LARGE_THRESHOLD / sizeof(long) * 4;
+    long* large = NULL;
+    palloc_on_node(large, len, 1);
+    assert(large != NULL);
+    assert(tga_numa_node_of(&numa, large) == -1);
+    for (size_t i = 0; i < len; i++) large[i] = (long)i;
+
+    pprealloc(&large, len, 2 * len);
+    assert(large != NULL);
+    for (size_t i = 0; i < len; i++) assert(large[i] == (long)i);
+
+    // Crossing classes and tiers keeps the contents and the node
+    pprealloc(&medium, 4096, 300);
+    assert(medium != NULL && medium[299] == 1);
+    assert(tga_numa_node_of(&numa, medium) == 1);
+    pprealloc(&medium, 300, 10);
+    assert(medium != NULL && medium[9] == 1);
+    assert(tga_numa_node_of(&numa, medium) == 1);
+    pprealloc(&medium, 10, 2 * TGA_NUMA_LARGE_THRESHOLD);
+    assert(medium != NULL && medium[9] == 1);
+    pprealloc(&medium, 2 * TGA_NUMA_LARGE_THRESHOLD, 4096);
+    assert(medium != NULL && medium[9] == 1);
+    // A large mapping only remembers its node where the kernel accepted the binding
+    if (_tgalloc_numa_system_nodes() >= 2) assert(tga_numa_node_of(&numa, medium) == 1);
+    else assert(tga_numa_node_of(&numa, medium) >= 0);
+    pprealloc(&medium, 4096, 2 * TGA_NUMA_LARGE_THRESHOLD);
+    assert(medium != NULL && medium[9] == 1);
+
+    pfree(medium, 2 * TGA_NUMA_LARGE_THRESHOLD);
+    pfree(large, 2 * len);
+    tga_numa_destroy(&numa);
+}
+
+// The node of palloc_on_node reaches the NUMA-aware backend through a checker wrapping it
+tga_check_t check;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (tga_check_t*)&check
+#define TGA_ALLOC_A_S tga_check_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_check_realloc_aligned_sized
+#define TGA_FREE_A_S tga_check_free_aligned_sized
+
+TEST_CASE(through_checker) {
+    setup();
+    int rc = tga_check_init(&check, TGA_BACKEND(&numa, tga_numa_alloc_aligned_sized,
+                                                tga_numa_realloc_aligned_sized, tga_numa_free_aligned_sized));
+    assert(rc == 0);
+    (void)rc;
+
+    Item* item = NULL;
+    palloc_on_node(item, 3, 1);
+    assert(item != NULL && tga_numa_node_of(&numa, item) == 1);
+    assert(tga_check_live_count(&check) == 1);
+    pfree(item, 3);
+    assert(tga_check_live_count(&check) == 0);
+
+    tga_check_destroy(&check);
+    tga_numa_destroy(&numa);
+}
+
+int main() {
+    printf("Running tgalloc numa tests...\n");
+
+    RUN_TEST(system_nodes);
+    RUN_TEST(node_hints);
+    RUN_TEST(free_from_other_thread);
+    RUN_TEST(medium_and_large);
+    RUN_TEST(through_checker);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
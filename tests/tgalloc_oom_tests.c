@@ -0,0 +1,278 @@
+/**
+ * @file tgalloc_oom_tests.c
+ * @brief Test suite for the out-of-memory handler and emergency reserve
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#define TGA_OOM
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../tgalloc_oom.h"
+#include "../tgalloc_vec.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    long id;
+    double weight;
+} Item;
+
+// Backend that fails while it is "out of memory"
+typedef struct {
+    int exhausted;
+    int calls;
+} FlakyBackend;
+
+void* flaky_alloc(FlakyBackend* self, size_t alignment, size_t size) {
+    self->calls++;
+    if (self->exhausted || size == 0) return NULL;
+    return _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+}
+
+void* flaky_realloc(FlakyBackend* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    self->calls++;
+    if (self->exhausted) return NULL;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void flaky_free(FlakyBackend* self, void const* ptr, size_t alignment, size_t size) {
+    (void)self;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+FlakyBackend backend;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (FlakyBackend*)&backend
+#define TGA_ALLOC_A_S flaky_alloc
+#define TGA_REALLOC_A_S flaky_realloc
+#define TGA_FREE_A_S flaky_free
+
+// Handler that sheds a cache, i.e. ends the exhaustion, when it has one
+int handler_calls;
+size_t handler_size;
+size_t handler_alignment;
+int handler_can_release;
+
+int shed_cache(void* ctx, size_t alignment, size_t size) {
+    FlakyBackend* flaky = (FlakyBackend*)ctx;
+    handler_calls++;
+    handler_size = size;
+    handler_alignment = alignment;
+    if (!handler_can_release) return 0;
+    flaky->exhausted = 0;
+    return 1;
+}
+
+// Handler that allocates itself, which must not recurse
+int nested_calls;
+
+int allocating_handler(void* ctx, size_t alignment, size_t size) {
+    (void)ctx;
+    (void)alignment;
+    (void)size;
+    nested_calls++;
+    Item* scratch = NULL;
+    palloc(scratch);
+    assert(scratch == NULL);
+    return 0;
+}
+
+// Handler whose own allocation succeeds, although it releases nothing
+Item* handler_scratch;
+
+int succeeding_handler(void* ctx, size_t alignment, size_t size) {
+    FlakyBackend* flaky = (FlakyBackend*)ctx;
+    (void)alignment;
+    (void)size;
+    flaky->exhausted = 0;
+    palloc(handler_scratch, 2);
+    flaky->exhausted = 1;
+    return 0;
+}
+
+static void setup(void) {
+    memset(&backend, 0, sizeof(backend));
+    handler_calls = 0;
+    handler_can_release = 1;
+    tga_oom_set_handler(shed_cache, &backend);
+    tga_oom_reserve(0);
+}
+
+TEST_CASE(handler_runs_and_retries) {
+    setup();
+    size_t failures = tga_oom_failures();
+
+    Item* items = NULL;
+    backend.exhausted = 1;
+    palloc(items, 8);
+    assert(items != NULL);
+    assert(handler_calls == 1 && backend.calls == 2);
+    assert(handler_size == 8 * sizeof(Item) && handler_alignment == _Alignof(Item));
+    assert(tga_oom_failures() == failures + 1);
+
+    // No failure, no handler
+    Item* one = NULL;
+    pcalloc(one);
+    assert(one != NULL && one->id == 0);
+    assert(handler_calls == 1);
+
+    // A handler that cannot help leaves the NULL to the caller
+    handler_can_release = 0;
+    backend.exhausted = 1;
+    Item* none = NULL;
+    palloc(none);
+    assert(none == NULL && handler_calls == 2);
+
+    // A NULL for zero bytes is not a failure
+    backend.exhausted = 0;
+    palloc(none, 0);
+    assert(handler_calls == 2);
+
+    pfree(one);
+    pfree(items, 8);
+}
+
+TEST_CASE(realloc_keeps_block_for_retry) {
+    setup();
+
+    long* nums = NULL;
+    palloc(nums, 4);
+    for (long i = 0; i < 4; i++) nums[i] = i;
+    backend.exhausted = 1;
+    pprealloc(&nums, 4, 1000);
+    assert(nums != NULL && handler_calls == 1);
+    for (long i = 0; i < 4; i++) assert(nums[i] == i);
+    pfree(nums, 1000);
+}
+
+TEST_CASE(vector_first_push_retries) {
+    setup();
+
+    tgvec(Item) items = TGVEC_INIT;
+    Item item = {1, 2.0};
+    backend.exhausted = 1;
+    assert(tgvec_push(items, item));
+    assert(handler_calls == 1 && items.len == 1 && items.data[0].id == 1);
+
+    // Growing goes through the handler as well
+    backend.exhausted = 1;
+    while (items.len < items.cap) assert(tgvec_push(items, item));
+    assert(tgvec_push(items, item));
+    assert(handler_calls == 2);
+    tgvec_free(items);
+}
+
+TEST_CASE(emergency_reserve) {
+    setup();
+    handler_can_release = 0;
+
+    assert(tga_oom_reserve(1 << 20) == 0);
+    assert(tga_oom_reserve_size() == 1 << 20);
+
+    // The handler frees nothing, so the reserve is given back and the call retried
+    backend.exhausted = 1;
+    Item* item = NULL;
+    palloc(item);
+    assert(item == NULL);
+    assert(handler_calls == 1 && backend.calls == 2);
+    assert(tga_oom_reserve_size() == 0);
+
+    // Once used up, failures go straight back to the caller
+    palloc(item);
+    assert(item == NULL && backend.calls == 3);
+
+    // Without a handler the reserve still helps
+    tga_oom_set_handler(NULL, NULL);
+    assert(tga_oom_reserve(4096) == 0);
+    palloc(item);
+    assert(backend.calls == 5 && tga_oom_reserve_size() == 0);
+}
+
+TEST_CASE(handler_is_not_reentered) {
+    setup();
+    tga_oom_set_handler(allocating_handler, NULL);
+    nested_calls = 0;
+
+    backend.exhausted = 1;
+    Item* item = NULL;
+    palloc(item);
+    assert(item == NULL && nested_calls == 1);
+}
+
+TEST_CASE(handler_allocation_is_not_returned) {
+    setup();
+    tga_oom_set_handler(succeeding_handler, &backend);
+
+    // The failed request gets NULL, not the block the handler allocated meanwhile
+    backend.exhausted = 1;
+    long* nums = NULL;
+    palloc(nums, 512);
+    assert(handler_scratch != NULL);
+    assert(nums == NULL);
+    pfree(handler_scratch, 2);
+}
+
+TEST_CASE(or_die) {
+    setup();
+
+    Item* item = NULL;
+    palloc_or_die(item);
+    item->id = 7;
+    long* nums = NULL;
+    palloc_or_die(nums, 16);
+    backend.exhausted = 1;
+    pprealloc_or_die(&nums, 16, 32);
+    assert(handler_calls == 1);
+    nums[31] = 1;
+    pfree(nums, 32);
+    pfree(item);
+
+    // Nothing can be released: the process aborts
+    fflush(stdout);
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        freopen("/dev/null", "w", stderr);
+        handler_can_release = 0;
+        backend.exhausted = 1;
+        palloc_or_die(nums, 16);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+}
+
+int main() {
+    printf("Running tgalloc oom tests...\n");
+
+    RUN_TEST(handler_runs_and_retries);
+    RUN_TEST(realloc_keeps_block_for_retry);
+    RUN_TEST(vector_first_push_retries);
+    RUN_TEST(emergency_reserve);
+    RUN_TEST(handler_is_not_reentered);
+    RUN_TEST(handler_allocation_is_not_returned);
+    RUN_TEST(or_die);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
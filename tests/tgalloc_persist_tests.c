@@ -0,0 +1,196 @@
+/**
+ * @file tgalloc_persist_tests.c
+ * @brief Test suite for the persistent arena backend
+ */
+
+#include "../tgalloc_persist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+// List node linked by offsets, so it reads back at any mapping address
+typedef struct {
+    long value;
+    tga_poff_t next;
+} Node;
+
+#define CAPACITY ((size_t)16 << 20)
+
+tga_persist_t heap;
+char path[64];
+
+static void setup(void) {
+    snprintf(path, sizeof(path), "/tmp/tgalloc_persist_%ld.heap", (long)getpid());
+    unlink(path);
+}
+
+static void teardown(void) {
+    unlink(path);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_persist_t*)&heap
+#define TGA_ALLOC_A_S tga_persist_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_persist_realloc_aligned_sized
+#define TGA_FREE_A_S tga_persist_free_aligned_sized
+#define TGA_EXPAND_A_S tga_persist_expand_aligned_sized
+
+// Build the list 0..count-1, rooted at the arena's root
+static void build_list(long count) {
+    tga_poff_t head = 0;
+    for (long i = count - 1; i >= 0; i--) {
+        Node* node = NULL;
+        palloc(node);
+        assert(node != NULL);
+        node->value = i;
+        node->next = head;
+        head = tga_persist_offset(&heap, node);
+    }
+    tga_persist_set_root(&heap, tga_persist_pointer(&heap, head));
+}
+
+static long sum_list(void) {
+    long sum = 0;
+    for (Node* node = (Node*)tga_persist_get_root(&heap); node; node = (Node*)tga_persist_pointer(&heap, node->next)) {
+        sum += node->value;
+    }
+    return sum;
+}
+
+TEST_CASE(survives_reopen) {
+    setup();
+
+    // Without TGA_PERSIST_CREATE a missing file is an error
+    assert(tga_persist_open(&heap, path, CAPACITY, NULL, 0) == -1);
+
+    int rc = tga_persist_open(&heap, path, CAPACITY, NULL, TGA_PERSIST_CREATE);
+    assert(rc == 0);
+    assert(!heap.reopened && tga_persist_get_root(&heap) == NULL);
+    build_list(1000);
+    char* name = NULL;
+    palloc(name, 32);
+    strcpy(name, "kept across restarts");
+    Node* first = (Node*)tga_persist_get_root(&heap);
+    first->value = tga_persist_offset(&heap, name);
+    assert(tga_persist_sync(&heap) == 0);
+    char* old_base = heap.base;
+    tga_persist_close(&heap);
+
+    // The capacity of an existing file wins over the argument
+    rc = tga_persist_open(&heap, path, 1, NULL, 0);
+    assert(rc == 0);
+    assert(heap.reopened && !heap.relocated);
+    assert(heap.base == old_base && heap.capacity == CAPACITY);
+    // Raw pointers are still valid at the same base
+    first = (Node*)tga_persist_get_root(&heap);
+    assert(strcmp((char*)tga_persist_pointer(&heap, (tga_poff_t)first->value), "kept across restarts") == 0);
+    first->value = 0;
+    assert(sum_list() == 999L * 1000 / 2);
+
+    // New allocations do not overlap the old ones
+    Node* extra = NULL;
+    palloc(extra);
+    assert(tga_persist_offset(&heap, extra) > tga_persist_offset(&heap, name));
+    pfree(extra);
+    tga_persist_close(&heap);
+
+    teardown();
+}
+
+TEST_CASE(relocation) {
+    setup();
+
+    int rc = tga_persist_open(&heap, path, CAPACITY, NULL, TGA_PERSIST_CREATE);
+    assert(rc == 0);
+    build_list(100);
+    char* old_base = heap.base;
+    tga_persist_close(&heap);
+
+    // Occupy the old address range
+    void* blocker = mmap(old_base, CAPACITY, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    assert(blocker == old_base);
+
+    rc = tga_persist_open(&heap, path, CAPACITY, NULL, TGA_PERSIST_FIXED);
+    assert(rc == -1 && errno == EADDRINUSE);
+
+    rc = tga_persist_open(&heap, path, CAPACITY, NULL, 0);
+    assert(rc == 0);
+    assert(heap.reopened && heap.relocated && heap.base != old_base);
+    // Offsets still lead through the list
+    assert(sum_list() == 99L * 100 / 2);
+    tga_persist_close(&heap);
+    munmap(blocker, CAPACITY);
+
+    // The new base is remembered for the next open
+    rc = tga_persist_open(&heap, path, CAPACITY, NULL, 0);
+    assert(rc == 0 && !heap.relocated);
+    tga_persist_close(&heap);
+
+    teardown();
+}
+
+TEST_CASE(size_classes_and_reuse) {
+    setup();
+
+    int rc = tga_persist_open(&heap, path, CAPACITY, NULL, TGA_PERSIST_CREATE);
+    assert(rc == 0);
+
+    // Freed blocks are reused for their class
+    long* nums = NULL;
+    palloc(nums, 10);
+    long* freed = nums;
+    pfree(nums, 10);
+    palloc(nums, 9);
+    assert(nums == freed);
+
+    // Within a class a block resizes in place
+    int expanded = pptry_expand(&nums, 9, 10);
+    assert(expanded);
+    expanded = pptry_expand(&nums, 10, 40);
+    assert(!expanded);
+    for (long i = 0; i < 8; i++) nums[i] = i;
+    pprealloc(&nums, 10, 4000);
+    assert(nums != NULL && nums != freed);
+    for (long i = 0; i < 8; i++) assert(nums[i] == i);
+    pfree(nums, 4000);
+
+    // Power-of-two classes provide larger alignments
+    typedef struct { _Alignas(256) char bytes[100]; } Wide;
+    Wide* wide = NULL;
+    palloc(wide);
+    assert((uintptr_t)wide % 256 == 0);
+    pfree(wide);
+
+    // Running out of space fails instead of growing the file
+    char* huge = NULL;
+    palloc(huge, CAPACITY);
+    assert(huge == NULL);
+
+    tga_persist_close(&heap);
+    teardown();
+}
+
+int main() {
+    printf("Running tgalloc persist tests...\n");
+
+    RUN_TEST(survives_reopen);
+    RUN_TEST(relocation);
+    RUN_TEST(size_classes_and_reuse);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file tgalloc_pool_tests.c
+ * @brief Test suite for the typed object pools
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include "../tgalloc_pool.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    int id;
+    double weight;
+    char tag[20];
+} Node;
+
+TGPOOL_DEFINE(Node)
+TGPOOL_DEFINE(char)
+
+// Upstream that counts what reaches it
+typedef struct {
+    size_t live_blocks;
+    size_t allocs;
+} CountingUpstream;
+
+CountingUpstream upstream = {0};
+
+void* counting_alloc(CountingUpstream* self, size_t alignment, size_t size) {
+    self->live_blocks++;
+    self->allocs++;
+    return _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+}
+
+void* counting_realloc(CountingUpstream* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    if (ptr == NULL) self->live_blocks++;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingUpstream* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) self->live_blocks--;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+tgpool(Node) pool;
+
+void init_pool(void) {
+    memset(&upstream, 0, sizeof(upstream));
+    tgpool_Node_init_with(&pool, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tgpool(Node)*)&pool
+#define TGA_ALLOC_A_S tgpool_Node_alloc_aligned_sized
+#define TGA_REALLOC_A_S tgpool_Node_realloc_aligned_sized
+#define TGA_FREE_A_S tgpool_Node_free_aligned_sized
+#define TGA_EXPAND_A_S tgpool_Node_expand_aligned_sized
+
+TEST_CASE(free_list_reuse) {
+    init_pool();
+
+    Node* first = NULL;
+    palloc(first);
+    assert(first != NULL);
+    assert((uintptr_t)first % _tgalloc_alignof_impl(Node) == 0);
+    first->id = 1;
+    assert(upstream.allocs == 1);
+
+    // Freed objects are handed out again, most recent first
+    pfree(first);
+    Node* again = NULL;
+    palloc(again);
+    assert(again == first);
+
+    // One slab serves many objects
+    Node* nodes[100];
+    for (int i = 0; i < 100; i++) {
+        nodes[i] = NULL;
+        palloc(nodes[i]);
+        assert(nodes[i] != NULL);
+        nodes[i]->id = i;
+        snprintf(nodes[i]->tag, sizeof(nodes[i]->tag), "node %d", i);
+    }
+    assert(upstream.allocs == 1);
+    for (int i = 0; i < 100; i++) {
+        assert(nodes[i]->id == i);
+        assert((uintptr_t)nodes[i] % _tgalloc_alignof_impl(Node) == 0);
+    }
+    for (int i = 0; i < 100; i++) pfree(nodes[i]);
+    pfree(again);
+
+    tgpool_Node_destroy(&pool);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(slab_growth) {
+    init_pool();
+
+    size_t count = 4 * TGA_POOL_SLAB_SIZE / sizeof(Node);
+    Node** nodes = (Node**)malloc(count * sizeof(Node*));
+    for (size_t i = 0; i < count; i++) {
+        nodes[i] = NULL;
+        palloc(nodes[i]);
+        assert(nodes[i] != NULL);
+        nodes[i]->id = (int)i;
+    }
+    assert(upstream.allocs >= 4);
+    for (size_t i = 0; i < count; i++) assert(nodes[i]->id == (int)i);
+
+    // Once everything is back on the free list, nothing new is requested
+    size_t slabs = upstream.allocs;
+    for (size_t i = 0; i < count; i++) pfree(nodes[i]);
+    for (size_t i = 0; i < count; i++) palloc(nodes[i]);
+    assert(upstream.allocs == slabs);
+    for (size_t i = 0; i < count; i++) pfree(nodes[i]);
+    free(nodes);
+
+    tgpool_Node_destroy(&pool);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(arrays_go_upstream) {
+    init_pool();
+
+    Node* array = NULL;
+    palloc(array, 10);
+    assert(array != NULL);
+    assert(upstream.live_blocks == 1);
+    for (int i = 0; i < 10; i++) array[i].id = i;
+
+    // Shrinking to one element moves the array into the pool
+    int expanded = pptry_expand(&array, 10, 1);
+    assert(!expanded);
+    pprealloc(&array, 10, 1);
+    assert(array != NULL && array[0].id == 0);
+    assert(upstream.live_blocks == 1);   // now the pool's first slab
+
+    // And growing moves it back out
+    pprealloc(&array, 1, 3);
+    assert(array != NULL && array[0].id == 0);
+    assert(upstream.live_blocks == 2);
+    pfree(array, 3);
+
+    tgpool_Node_destroy(&pool);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(objects_smaller_than_a_link) {
+    tgpool(char) chars;
+    tgpool_char_init(&chars);
+
+    char* a = (char*)tgpool_char_alloc_aligned_sized(&chars, 1, 1);
+    char* b = (char*)tgpool_char_alloc_aligned_sized(&chars, 1, 1);
+    assert(a != NULL && b != NULL);
+    assert((size_t)(a > b ? a - b : b - a) >= sizeof(void*));
+    *a = 'a';
+    *b = 'b';
+    tgpool_char_free_aligned_sized(&chars, a, 1, 1);
+    assert(*b == 'b');
+    tgpool_char_free_aligned_sized(&chars, b, 1, 1);
+    tgpool_char_destroy(&chars);
+}
+
+int main() {
+    printf("Running tgalloc pool tests...\n");
+
+    RUN_TEST(free_list_reuse);
+    RUN_TEST(slab_growth);
+    RUN_TEST(arrays_go_upstream);
+    RUN_TEST(objects_smaller_than_a_link);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
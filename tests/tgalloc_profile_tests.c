@@ -0,0 +1,181 @@
+/**
+ * @file tgalloc_profile_tests.c
+ * @brief Test suite for the TGA_PROFILE call-site profiler
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define TGA_STATS
+#define TGA_PROFILE
+#include "../tgalloc.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    double x;
+    double y;
+} Vec2;
+
+// Look up the site recorded for a line of this file
+tga_profile_site_t find_site(size_t line) {
+    tga_profile_site_t sites[64];
+    size_t count = tga_profile_sites(sites, 64);
+    assert(count <= 64);
+    for (size_t i = 0; i < count; i++) {
+        if (sites[i].line == line && strcmp(sites[i].file, __FILE__) == 0) return sites[i];
+    }
+    tga_profile_site_t none = {0};
+    return none;
+}
+
+TEST_CASE(sites_are_separate) {
+    tga_profile_reset();
+
+    Vec2* a = NULL;
+    Vec2* b = NULL;
+    size_t line_a = __LINE__; palloc(a);
+    size_t line_b = __LINE__; palloc(b, 10);
+    size_t line_free = __LINE__; pfree(a);
+    pfree(b, 10);
+
+    tga_profile_site_t site = find_site(line_a);
+    assert(site.alloc_count == 1);
+    assert(site.alloc_bytes == sizeof(Vec2));
+    assert(site.type_size == sizeof(Vec2));
+    assert(site.alignment == _Alignof(Vec2));
+
+    site = find_site(line_b);
+    assert(site.alloc_count == 1);
+    assert(site.alloc_bytes == 10 * sizeof(Vec2));
+    assert(site.type_size == sizeof(Vec2));
+
+    site = find_site(line_free);
+    assert(site.free_count == 1);
+    assert(site.free_bytes == sizeof(Vec2));
+    assert(site.alloc_count == 0);
+}
+
+TEST_CASE(repeated_calls_aggregate) {
+    tga_profile_reset();
+
+    size_t line = 0;
+    for (int i = 0; i < 100; i++) {
+        int* nums = NULL;
+        line = __LINE__; palloc(nums, i + 1);
+        pfree(nums, i + 1);
+    }
+
+    tga_profile_site_t site = find_site(line);
+    assert(site.alloc_count == 100);
+    assert(site.alloc_bytes == 5050 * sizeof(int));
+}
+
+TEST_CASE(realloc_and_batches) {
+    tga_profile_reset();
+
+    int* nums = NULL;
+    palloc(nums, 4);
+    size_t line_realloc = __LINE__; pprealloc(&nums, 4, 16);
+    pfree(nums, 16);
+
+    Vec2* vecs[8] = {0};
+    size_t line_many = __LINE__; size_t got = palloc_many(vecs, 8);
+    assert(got == 8);
+    size_t line_free_many = __LINE__; pfree_many(vecs, 8);
+
+    tga_profile_site_t site = find_site(line_realloc);
+    assert(site.realloc_count == 1);
+    assert(site.realloc_bytes == 16 * sizeof(int));
+
+    site = find_site(line_many);
+    assert(site.alloc_count == 8);
+    assert(site.alloc_bytes == 8 * sizeof(Vec2));
+
+    site = find_site(line_free_many);
+    assert(site.free_count == 8);
+}
+
+TEST_CASE(stats_still_counted) {
+    tga_stats_reset();
+
+    Vec2* v = NULL;
+    palloc(v);
+    pfree(v);
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.alloc_count == 1);
+    assert(stats.free_count == 1);
+    assert(stats.live_bytes == 0);
+}
+
+size_t churn_line = 0;
+
+// Only the first thread reports the line, to keep the test free of races
+void* churn(void* report_line) {
+    for (int i = 0; i < 1000; i++) {
+        Vec2* v = NULL;
+        size_t line = __LINE__; palloc(v);
+        if (report_line) churn_line = line;
+        pfree(v);
+    }
+    return NULL;
+}
+
+TEST_CASE(threads) {
+    tga_profile_reset();
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, churn, i == 0 ? &churn_line : NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+    tga_profile_site_t site = find_site(churn_line);
+    assert(site.alloc_count == 4000);
+    assert(tga_profile_dropped() == 0);
+}
+
+TEST_CASE(folded_output) {
+    tga_profile_reset();
+
+    Vec2* v = NULL;
+    size_t line = __LINE__; palloc(v, 3);
+    pfree(v, 3);
+
+    char expected[256];
+    snprintf(expected, sizeof(expected), "%s;%s:%zu %zu B align %zu %zu\n", __FILE__, __FILE__, line,
+             sizeof(Vec2), _Alignof(Vec2), 3 * sizeof(Vec2));
+
+    FILE* out = tmpfile();
+    assert(out != NULL);
+    tga_profile_dump_folded(out, TGA_PROFILE_BYTES);
+    rewind(out);
+    char text[4096] = {0};
+    size_t len = fread(text, 1, sizeof(text) - 1, out);
+    fclose(out);
+    assert(len > 0);
+    assert(strstr(text, expected) != NULL);
+}
+
+int main() {
+    printf("Running tgalloc profile tests...\n");
+
+    RUN_TEST(sites_are_separate);
+    RUN_TEST(repeated_calls_aggregate);
+    RUN_TEST(realloc_and_batches);
+    RUN_TEST(stats_still_counted);
+    RUN_TEST(threads);
+    RUN_TEST(folded_output);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
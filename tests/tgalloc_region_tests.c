@@ -0,0 +1,169 @@
+/**
+ * @file tgalloc_region_tests.c
+ * @brief Test suite for the linear region backend
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include "../tgalloc_region.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    char c;
+    short s;
+} Small;
+
+typedef struct {
+    _Alignas(64) double lanes[8];
+} Block64;
+
+tga_region_t region;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_region_t*)&region
+#define TGA_ALLOC_A_S tga_region_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_region_realloc_aligned_sized
+#define TGA_FREE_A_S tga_region_free_aligned_sized
+#define TGA_EXPAND_A_S tga_region_expand_aligned_sized
+
+TEST_CASE(bump_respects_alignment) {
+    tga_region_init(&region);
+
+    Small* s = NULL;
+    double* d = NULL;
+    Block64* b = NULL;
+    palloc(s);
+    palloc(d);
+    palloc(b);
+    assert(s != NULL && d != NULL && b != NULL);
+    assert((uintptr_t)d % _Alignof(double) == 0);
+    assert((uintptr_t)b % 64 == 0);
+
+    // Successive allocations come from the same chunk
+    assert((char*)d > (char*)s && (char*)b > (char*)d);
+
+    tga_region_destroy(&region);
+}
+
+TEST_CASE(reset_reuses_memory) {
+    tga_region_init(&region);
+
+    int* first = NULL;
+    palloc(first, 100);
+    for (int i = 0; i < 200; i++) {
+        int* tmp = NULL;
+        palloc(tmp, 1000);
+        assert(tmp != NULL);
+        tmp[999] = i;
+        pfree(tmp, 1000);
+    }
+    _tgalloc_region_chunk * chunks = region.first;
+
+    tga_region_reset(&region);
+    int* again = NULL;
+    palloc(again, 100);
+    assert(again == first);
+    assert(region.first == chunks);
+
+    tga_region_destroy(&region);
+}
+
+TEST_CASE(save_and_restore) {
+    tga_region_init(&region);
+
+    long* keep = NULL;
+    palloc(keep);
+    *keep = 7;
+
+    tga_region_mark_t mark = tga_region_save(&region);
+    long* scratch = NULL;
+    palloc(scratch, 50000);
+    assert(scratch != NULL);
+    tga_region_restore(&region, mark);
+
+    long* next = NULL;
+    palloc(next);
+    assert(next == keep + 1);
+    assert(*keep == 7);
+
+    tga_region_destroy(&region);
+}
+
+TEST_CASE(oversized_and_realloc) {
+    tga_region_init(&region);
+
+    char* big = NULL;
+    palloc(big, TGA_REGION_CHUNK_SIZE * 3);
+    assert(big != NULL);
+    memset(big, 1, TGA_REGION_CHUNK_SIZE * 3);
+
+    int* nums = NULL;
+    palloc(nums, 4);
+    for (int i = 0; i < 4; i++) nums[i] = i;
+
+    // The most recent block grows in place
+    int* before = nums;
+    pprealloc(&nums, 4, 64);
+    assert(nums == before);
+
+    // An older block has to move
+    pprealloc(&big, TGA_REGION_CHUNK_SIZE * 3, TGA_REGION_CHUNK_SIZE * 4);
+    assert(big != NULL);
+    assert(big[TGA_REGION_CHUNK_SIZE * 3 - 1] == 1);
+    pfree(big, TGA_REGION_CHUNK_SIZE * 4);
+
+    for (int i = 0; i < 4; i++) assert(nums[i] == i);
+
+    tga_region_destroy(&region);
+}
+
+TEST_CASE(try_expand) {
+    tga_region_init(&region);
+
+    char* older = NULL;
+    palloc(older, 32);
+    char* last = NULL;
+    palloc(last, 32);
+
+    // Only the most recent block can grow, never past its chunk
+    assert(!pptry_expand(&older, 32, 64));
+    assert(pptry_expand(&last, 32, 1024));
+    assert(!pptry_expand(&last, 1024, TGA_REGION_CHUNK_SIZE));
+
+    // Shrinking always works and gives the tail back to the cursor
+    assert(pptry_expand(&older, 32, 16));
+    assert(pptry_expand(&last, 1024, 16));
+    char* next = NULL;
+    palloc(next, 1);
+    assert(next == last + 16);
+
+    tga_region_destroy(&region);
+}
+
+int main() {
+    printf("Running tgalloc region tests...\n");
+
+    RUN_TEST(bump_respects_alignment);
+    RUN_TEST(reset_reuses_memory);
+    RUN_TEST(save_and_restore);
+    RUN_TEST(oversized_and_realloc);
+    RUN_TEST(try_expand);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
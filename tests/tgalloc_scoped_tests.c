@@ -0,0 +1,171 @@
+/**
+ * @file tgalloc_scoped_tests.c
+ * @brief Test suite for scope-bound scratch allocations
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../tgalloc_scoped.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    long id;
+    double weight;
+} Item;
+
+typedef struct {
+    char bytes[64];
+} __attribute__((aligned(64))) Line;
+
+// Backend that records the sizes of its live blocks
+typedef struct {
+    long live_blocks;
+    size_t live_bytes;
+    size_t last_free_size;
+} CountingBackend;
+
+void* counting_alloc(CountingBackend* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) {
+        self->live_blocks++;
+        self->live_bytes += size;
+    }
+    return ptr;
+}
+
+void* counting_realloc(CountingBackend* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    (void)self;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingBackend* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) {
+        self->live_blocks--;
+        self->live_bytes -= size;
+        self->last_free_size = size;
+    }
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+CountingBackend backend;
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (CountingBackend*)&backend
+#define TGA_ALLOC_A_S counting_alloc
+#define TGA_REALLOC_A_S counting_realloc
+#define TGA_FREE_A_S counting_free
+
+TEST_CASE(released_at_scope_exit) {
+    assert(tga_scoped_stack_used() == 0);
+    {
+        tga_scoped(Item, items, 16);
+        assert(items != NULL);
+        assert((uintptr_t)items % _Alignof(Item) == 0);
+        for (int i = 0; i < 16; i++) items[i].id = i;
+        size_t used = tga_scoped_stack_used();
+        assert(used >= 16 * sizeof(Item));
+        {
+            tga_scoped(char, name, 10);
+            assert(name != NULL && (char*)name >= (char*)(items + 16));
+            assert(tga_scoped_stack_used() > used);
+        }
+        assert(tga_scoped_stack_used() == used);
+        for (int i = 0; i < 16; i++) assert(items[i].id == i);
+    }
+    assert(tga_scoped_stack_used() == 0);
+    assert(backend.live_blocks == 0);
+}
+
+TEST_CASE(alignment) {
+    {
+        tga_scoped(char, pad, 3);
+        tga_scoped(Line, lines, 4);
+        assert(pad != NULL && lines != NULL);
+        assert((uintptr_t)lines % 64 == 0);
+        memset(lines, 0, 4 * sizeof(Line));
+    }
+    assert(tga_scoped_stack_used() == 0);
+}
+
+static int early_return(int bail) {
+    tga_scoped(long, scratch, 100);
+    scratch[0] = 1;
+    if (bail) return -1;
+    tga_scoped(long, more, 50000);
+    more[49999] = 2;
+    return (int)(scratch[0] + more[49999]);
+}
+
+TEST_CASE(early_return_and_backend_fallback) {
+    memset(&backend, 0, sizeof(backend));
+
+    // Returning before the second scratch buffer releases only the first
+    assert(early_return(1) == -1);
+    assert(tga_scoped_stack_used() == 0);
+
+    // 50000 longs do not fit in the buffer and come from the backend
+    assert(early_return(0) == 3);
+    assert(tga_scoped_stack_used() == 0);
+    assert(backend.live_blocks == 0 && backend.live_bytes == 0);
+    assert(backend.last_free_size == 50000 * sizeof(long));
+
+    // Loops release every iteration
+    for (int i = 0; i < 1000; i++) {
+        tga_scoped(Item, item, 1);
+        item->id = i;
+        if (i % 2) continue;
+        assert(tga_scoped_stack_used() == sizeof(Item));
+    }
+    assert(tga_scoped_stack_used() == 0);
+
+    // Absurd counts give NULL without reaching the backend
+    {
+        tga_scoped(Item, none, SIZE_MAX / 2);
+        assert(none == NULL);
+    }
+    assert(backend.live_blocks == 0);
+}
+
+static void* thread_body(void* arg) {
+    (void)arg;
+    assert(tga_scoped_stack_used() == 0);
+    tga_scoped(char, bytes, 1000);
+    memset(bytes, 1, 1000);
+    assert(tga_scoped_stack_used() == 1000);
+    return NULL;
+}
+
+TEST_CASE(per_thread_buffers) {
+    tga_scoped(char, mine, 500);
+    assert(mine != NULL);
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, thread_body, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+    assert(tga_scoped_stack_used() == 500);
+}
+
+int main() {
+    printf("Running tgalloc scoped tests...\n");
+
+    RUN_TEST(released_at_scope_exit);
+    RUN_TEST(alignment);
+    RUN_TEST(early_return_and_backend_fallback);
+    RUN_TEST(per_thread_buffers);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
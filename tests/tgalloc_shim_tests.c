@@ -0,0 +1,167 @@
+/**
+ * @file tgalloc_shim_tests.c
+ * @brief Test suite for the malloc interposition shim
+ *
+ * The shim is compiled into the test itself, so its malloc family replaces
+ * glibc's for the whole process just as it does under LD_PRELOAD.
+ */
+
+#include "../shim/tgalloc_shim.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <malloc.h>
+#include <pthread.h>
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+TEST_CASE(malloc_family) {
+    size_t before = tga_shim_tracked();
+
+    char* bytes = (char*)malloc(100);
+    assert(bytes != NULL && (uintptr_t)bytes % _TGALLOC_SHIM_ALIGN == 0);
+    memset(bytes, 1, 100);
+    assert(malloc_usable_size(bytes) == 100);
+    assert(tga_shim_tracked() == before + 1);
+
+    // realloc moves the record along with the block
+    bytes = (char*)realloc(bytes, 5000);
+    assert(bytes != NULL && bytes[99] == 1);
+    assert(malloc_usable_size(bytes) == 5000);
+    assert(tga_shim_tracked() == before + 1);
+
+    long* zeroed = (long*)calloc(64, sizeof(long));
+    assert(zeroed != NULL);
+    for (int i = 0; i < 64; i++) assert(zeroed[i] == 0);
+    assert(calloc(SIZE_MAX / 2, 4) == NULL);
+
+    // Zero-byte requests get distinct blocks
+    void* a = malloc(0);
+    void* b = malloc(0);
+    assert(a != NULL && b != NULL && a != b);
+
+    free(a);
+    free(b);
+    free(zeroed);
+    assert(realloc(bytes, 0) == NULL);
+    free(NULL);
+    assert(tga_shim_tracked() == before);
+}
+
+TEST_CASE(aligned) {
+    size_t before = tga_shim_tracked();
+
+    void* page = aligned_alloc(4096, 10000);
+    assert(page != NULL && (uintptr_t)page % 4096 == 0);
+    memset(page, 2, 10000);
+
+    void* line = NULL;
+    assert(posix_memalign(&line, 64, 24) == 0);
+    assert(line != NULL && (uintptr_t)line % 64 == 0);
+    assert(posix_memalign(&line, 3, 24) == EINVAL);
+
+    // Growing keeps the alignment
+    char* grown = (char*)realloc(line, 3000);
+    assert(grown != NULL && (uintptr_t)grown % 64 == 0);
+
+    void* mem = memalign(256, 1);
+    assert(mem != NULL && (uintptr_t)mem % 256 == 0);
+
+    free(mem);
+    free(grown);
+    free(page);
+    assert(tga_shim_tracked() == before);
+}
+
+TEST_CASE(libc_internal_allocations) {
+    // Memory allocated inside glibc is freed by the caller and must come from the shim
+    size_t before = tga_shim_tracked();
+    char* copy = strdup("through the shim");
+    assert(copy != NULL && tga_shim_tracked() == before + 1);
+    free(copy);
+
+    char* text = NULL;
+    int n = asprintf(&text, "%d-%s", 42, "formatted");
+    assert(n > 0 && strcmp(text, "42-formatted") == 0);
+    free(text);
+    assert(tga_shim_tracked() == before);
+
+    // Blocks from before the shim took over still belong to glibc
+    char* old = (char*)__libc_malloc(40);
+    assert(old != NULL && malloc_usable_size(old) >= 40);
+    old = (char*)realloc(old, 80);
+    assert(old != NULL && malloc_usable_size(old) >= 80);
+    free(old);
+}
+
+TEST_CASE(sized_free) {
+    // The C++ side frees untracked blocks by the size it is handed
+    size_t before = tga_shim_tracked();
+    void* block = _tgalloc_shim_alloc(8, 40, 0);
+    assert(block != NULL && tga_shim_tracked() == before);
+    memset(block, 3, 40);
+    _tgalloc_shim_free_sized(block, 8, 40);
+
+    // Unsized delete of a recorded block, such as one from operator new[], goes by the table
+    block = _tgalloc_shim_alloc(8, 40, 1);
+    assert(block != NULL && tga_shim_tracked() == before + 1);
+    _tgalloc_shim_free_recorded(block);
+    _tgalloc_shim_free_recorded(NULL);
+    assert(tga_shim_tracked() == before);
+}
+
+#define THREADS 4
+#define BLOCKS 20000
+
+void* blocks[THREADS][BLOCKS];
+
+static void* allocate_blocks(void* arg) {
+    void** mine = (void**)arg;
+    for (int i = 0; i < BLOCKS; i++) {
+        mine[i] = malloc((size_t)(i % 300) + 1);
+        assert(mine[i] != NULL);
+        memset(mine[i], i & 0xff, (size_t)(i % 300) + 1);
+    }
+    return NULL;
+}
+
+static void* free_blocks(void* arg) {
+    void** theirs = (void**)arg;
+    for (int i = 0; i < BLOCKS; i++) free(theirs[i]);
+    return NULL;
+}
+
+TEST_CASE(threads) {
+    size_t before = tga_shim_tracked();
+    pthread_t workers[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&workers[t], NULL, allocate_blocks, blocks[t]);
+    for (int t = 0; t < THREADS; t++) pthread_join(workers[t], NULL);
+    // The thread library keeps a few blocks of its own per thread
+    size_t after = tga_shim_tracked();
+    assert(after >= before + THREADS * BLOCKS && after <= before + THREADS * BLOCKS + THREADS);
+
+    // Every thread frees the blocks of another
+    for (int t = 0; t < THREADS; t++) pthread_create(&workers[t], NULL, free_blocks, blocks[(t + 1) % THREADS]);
+    for (int t = 0; t < THREADS; t++) pthread_join(workers[t], NULL);
+    assert(tga_shim_tracked() <= after - THREADS * BLOCKS + THREADS);
+}
+
+int main() {
+    printf("Running tgalloc shim tests...\n");
+
+    RUN_TEST(malloc_family);
+    RUN_TEST(aligned);
+    RUN_TEST(libc_internal_allocations);
+    RUN_TEST(sized_free);
+    RUN_TEST(threads);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
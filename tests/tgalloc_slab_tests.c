@@ -0,0 +1,205 @@
+/**
+ * @file tgalloc_slab_tests.c
+ * @brief Test suite for the headerless slab backend
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_slab.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    void* left;
+    void* right;
+} Node;
+
+// Upstream that counts the bytes it hands out
+typedef struct {
+    long live_blocks;
+    size_t live_bytes;
+} CountingUpstream;
+
+void* counting_alloc(CountingUpstream* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) {
+        self->live_blocks++;
+        self->live_bytes += size;
+    }
+    return ptr;
+}
+
+void* counting_realloc(CountingUpstream* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    void* moved = _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+    if (moved) {
+        if (ptr == NULL) self->live_blocks++;
+        self->live_bytes += new_size - old_size;
+    }
+    return moved;
+}
+
+void counting_free(CountingUpstream* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) {
+        self->live_blocks--;
+        self->live_bytes -= size;
+    }
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+CountingUpstream upstream;
+tga_slab_t slab;
+
+static void setup(void) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_slab_init_with(&slab, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+}
+
+static void teardown(void) {
+    tga_slab_destroy(&slab);
+    assert(upstream.live_blocks == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_slab_t*)&slab
+#define TGA_ALLOC_A_S tga_slab_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_slab_realloc_aligned_sized
+#define TGA_FREE_A_S tga_slab_free_aligned_sized
+#define TGA_EXPAND_A_S tga_slab_expand_aligned_sized
+
+#define NODES 100000
+
+Node* nodes[NODES];
+
+TEST_CASE(no_per_block_overhead) {
+    setup();
+
+    for (int i = 0; i < NODES; i++) {
+        palloc(nodes[i]);
+        assert(nodes[i] != NULL);
+        assert((uintptr_t)nodes[i] % _Alignof(Node) == 0);
+        nodes[i]->left = nodes[i];
+    }
+    // Neighbouring blocks are packed back to back
+    assert((char*)nodes[1] - (char*)nodes[0] == sizeof(Node));
+    // Page headers cost about a bit per block plus a cache line per page
+    assert(upstream.live_bytes < (size_t)NODES * sizeof(Node) * 102 / 100 + TGA_SLAB_PAGE_SIZE);
+    for (int i = 0; i < NODES; i++) assert(nodes[i]->left == nodes[i]);
+
+    for (int i = 0; i < NODES; i++) pfree(nodes[i]);
+    // Only the last empty page of the class is kept
+    assert(upstream.live_blocks == 1);
+    teardown();
+}
+
+TEST_CASE(reuse_lowest_free_block) {
+    setup();
+
+    char* blocks[200];
+    for (int i = 0; i < 200; i++) palloc(blocks[i], 32);
+
+    // Freed blocks are handed out again, lowest first
+    pfree(blocks[150], 32);
+    pfree(blocks[70], 32);
+    char* again = NULL;
+    palloc(again, 32);
+    assert(again == blocks[70]);
+    palloc(again, 32);
+    assert(again == blocks[150]);
+
+    // Other size classes use pages of their own
+    char* other = NULL;
+    palloc(other, 24);
+    assert(_tgalloc_slab_page_of(other) != _tgalloc_slab_page_of(blocks[0]));
+    pfree(other, 24);
+
+    for (int i = 0; i < 200; i++) pfree(blocks[i], 32);
+    teardown();
+}
+
+TEST_CASE(full_pages_come_back) {
+    setup();
+
+    // Fill more than one page of 128-byte blocks
+    size_t per_page = (TGA_SLAB_PAGE_SIZE - _tgalloc_slab_first(TGA_SLAB_PAGE_SIZE / 128)) / 128;
+    size_t count = per_page * 2 + 3;
+    char** blocks = NULL;
+    palloc(blocks, count);
+    for (size_t i = 0; i < count; i++) palloc(blocks[i], 128);
+    assert(upstream.live_blocks == 1 + 3);
+
+    // A full page gets free blocks again and is allocated from
+    pfree(blocks[5], 128);
+    char* again = NULL;
+    palloc(again, 128);
+    assert(again == blocks[5]);
+
+    for (size_t i = 0; i < count; i++) pfree(blocks[i], 128);
+    pfree(blocks, count);
+    teardown();
+}
+
+TEST_CASE(large_and_realloc) {
+    setup();
+
+    long* nums = NULL;
+    palloc(nums, 10);
+    for (long i = 0; i < 10; i++) nums[i] = i;
+    long live = upstream.live_blocks;
+
+    // Crossing TGA_SLAB_MAX_SMALL moves the block to the upstream backend
+    pprealloc(&nums, 10, 100);
+    assert(nums != NULL);
+    assert(upstream.live_blocks == live + 1);
+    for (long i = 0; i < 10; i++) assert(nums[i] == i);
+
+    // Moving back takes a page of the new class; the old one stays cached
+    pprealloc(&nums, 100, 12);
+    assert(upstream.live_blocks == live + 1);
+    for (long i = 0; i < 10; i++) assert(nums[i] == i);
+
+    // Within a size class a block resizes in place
+    char* bytes = NULL;
+    palloc(bytes, 20);
+    int expanded = pptry_expand(&bytes, 20, 24);
+    assert(expanded);
+    expanded = pptry_expand(&bytes, 24, 25);
+    assert(!expanded);
+    pfree(bytes, 24);
+
+    // Alignments a class does not provide go upstream
+    typedef struct { _Alignas(32) char bytes[40]; } Wide;
+    Wide* wide = NULL;
+    live = upstream.live_blocks;
+    palloc(wide);
+    assert((uintptr_t)wide % 32 == 0);
+    assert(upstream.live_blocks == live + 1);
+    pfree(wide);
+
+    pfree(nums, 12);
+    teardown();
+}
+
+int main() {
+    printf("Running tgalloc slab tests...\n");
+
+    RUN_TEST(no_per_block_overhead);
+    RUN_TEST(reuse_lowest_free_block);
+    RUN_TEST(full_pages_come_back);
+    RUN_TEST(large_and_realloc);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
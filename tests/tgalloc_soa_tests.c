@@ -0,0 +1,149 @@
+/**
+ * @file tgalloc_soa_tests.c
+ * @brief Test suite for struct-of-arrays containers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_soa.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+// Backend that remembers its one live block, to check the sizes it is given back
+typedef struct {
+    void* block;
+    size_t size;
+    size_t alignment;
+    size_t calls;
+    int should_fail;
+} RecordingBackend;
+
+RecordingBackend recorder;
+
+void* recording_alloc(RecordingBackend* self, size_t alignment, size_t size) {
+    if (self->should_fail) return NULL;
+    assert(self->block == NULL);
+    self->block = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    self->size = size;
+    self->alignment = alignment;
+    self->calls++;
+    return self->block;
+}
+
+void* recording_realloc(RecordingBackend* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    if (self->should_fail) return NULL;
+    assert(ptr == self->block && old_size == self->size && alignment == self->alignment);
+    self->block = _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+    self->size = new_size;
+    self->calls++;
+    return self->block;
+}
+
+void recording_free(RecordingBackend* self, void const* ptr, size_t alignment, size_t size) {
+    assert(ptr == self->block && size == self->size && alignment == self->alignment);
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+    self->block = NULL;
+    self->size = 0;
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (RecordingBackend*)&recorder
+#define TGA_ALLOC_A_S recording_alloc
+#define TGA_REALLOC_A_S recording_realloc
+#define TGA_FREE_A_S recording_free
+
+#define PARTICLE_FIELDS(X) X(float, x) X(float, vx) X(double, mass) X(char, tag)
+TGSOA_DEFINE(particles, PARTICLE_FIELDS)
+
+TEST_CASE(layout) {
+    particles_t p = TGSOA_INIT;
+    assert(tgsoa_reserve(particles, p, 10));
+    assert(p.len == 0 && p.cap == 10);
+    assert(recorder.alignment == TGA_SOA_ALIGN && recorder.size == particles_bytes(10));
+    // One block, every column on its own aligned boundary
+    assert(p.block == (void*)p.x);
+    assert((uintptr_t)p.x % TGA_SOA_ALIGN == 0 && (uintptr_t)p.vx % TGA_SOA_ALIGN == 0);
+    assert((uintptr_t)p.mass % TGA_SOA_ALIGN == 0 && (uintptr_t)p.tag % TGA_SOA_ALIGN == 0);
+    assert((char*)p.vx - (char*)p.x == TGA_SOA_ALIGN && (char*)p.tag - (char*)p.mass == 2 * TGA_SOA_ALIGN);
+    assert(particles_bytes(10) == 5 * TGA_SOA_ALIGN);
+
+    // Reserving less does not touch the block
+    size_t calls = recorder.calls;
+    assert(tgsoa_reserve(particles, p, 4));
+    assert(recorder.calls == calls && p.cap == 10);
+    tgsoa_free(particles, p);
+    assert(p.block == NULL && p.x == NULL && p.cap == 0 && recorder.block == NULL);
+}
+
+TEST_CASE(growth_keeps_columns) {
+    particles_t p = TGSOA_INIT;
+    for (size_t i = 0; i < 5000; i++) {
+        assert(tgsoa_resize(particles, p, i + 1));
+        p.x[i] = (float)i;
+        p.vx[i] = (float)(2 * i);
+        p.mass[i] = (double)i / 4;
+        p.tag[i] = (char)(i % 100);
+    }
+    assert(p.len == 5000 && p.cap >= 5000);
+    // Geometric growth: a handful of reallocs, not one per row
+    assert(recorder.calls < 40);
+    assert(recorder.size == particles_bytes(p.cap));
+
+    float sum = 0;
+    for (size_t i = 0; i < p.len; i++) {
+        assert(p.x[i] == (float)i && p.vx[i] == (float)(2 * i));
+        assert(p.mass[i] == (double)i / 4 && p.tag[i] == (char)(i % 100));
+        p.x[i] += p.vx[i];
+        sum += p.x[i] - 3 * (float)i;
+    }
+    assert(sum == 0);
+
+    // Shrinking the length keeps the block
+    assert(tgsoa_resize(particles, p, 10));
+    assert(p.len == 10 && p.cap >= 5000 && p.x[9] == 27.0f);
+    tgsoa_free(particles, p);
+    assert(recorder.block == NULL && p.len == 0);
+}
+
+TEST_CASE(failure) {
+    particles_t p = TGSOA_INIT;
+    assert(tgsoa_resize(particles, p, 3));
+    p.x[2] = 1.5f;
+    particles_t before = p;
+
+    recorder.should_fail = 1;
+    assert(!tgsoa_resize(particles, p, 1000));
+    assert(!tgsoa_reserve(particles, p, 1000));
+    recorder.should_fail = 0;
+    assert(memcmp(&p, &before, sizeof(p)) == 0 && p.x[2] == 1.5f);
+
+    // Sizes that do not fit in a size_t fail without calling the backend
+    assert(particles_bytes(SIZE_MAX / 4) == 0);
+    size_t calls = recorder.calls;
+    assert(!tgsoa_reserve(particles, p, SIZE_MAX / 4));
+    assert(recorder.calls == calls && p.cap == before.cap);
+    tgsoa_free(particles, p);
+}
+
+int main() {
+    printf("Running tgalloc soa tests...\n");
+
+    RUN_TEST(layout);
+    RUN_TEST(growth_keeps_columns);
+    RUN_TEST(failure);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file tgalloc_stats_tests.c
+ * @brief Test suite for the TGA_STATS counting layer
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define TGA_STATS
+#include "../tgalloc.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    int x;
+    int y;
+} Point;
+
+typedef struct {
+    _Alignas(64) float lanes[16];
+} CacheLine;
+
+// Backend that can be told to fail
+int fail_next = 0;
+
+void* failing_alloc(void* self, size_t alignment, size_t size) {
+    if (fail_next) return NULL;
+    return _tgalloc_dflt_alloc_aligned_sized((dflt_allo_t*)self, alignment, size);
+}
+
+TEST_CASE(counts_and_live_bytes) {
+    tga_stats_reset();
+
+    Point* p = NULL;
+    palloc(p);
+    int* nums = NULL;
+    pcalloc(nums, 10);    // zeroed allocations count like any other
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.alloc_count == 2);
+    assert(stats.free_count == 0);
+    assert(stats.live_bytes == sizeof(Point) + 10 * sizeof(int));
+    assert(stats.allocated_bytes == stats.live_bytes);
+
+    pfree(p);
+    pfree(nums, 10);
+
+    tga_stats_snapshot(&stats);
+    assert(stats.free_count == 2);
+    assert(stats.live_bytes == 0);
+    assert(stats.peak_live_bytes == sizeof(Point) + 10 * sizeof(int));
+    assert(stats.freed_bytes == stats.allocated_bytes);
+}
+
+TEST_CASE(histograms) {
+    tga_stats_reset();
+
+    char* c = NULL;
+    palloc(c, 100);       // 65..128 bytes -> bucket 7
+    CacheLine* line = NULL;
+    palloc(line);         // 64 bytes aligned to 64
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.size_hist[7] == 1);
+    assert(stats.size_hist[6] == 1);
+    assert(stats.align_hist[0] == 1);
+    assert(stats.align_hist[6] == 1);
+
+    pfree(c, 100);
+    pfree(line);
+}
+
+TEST_CASE(realloc_growth) {
+    tga_stats_reset();
+
+    int* nums = NULL;
+    palloc(nums, 4);
+    pprealloc(&nums, 4, 8);    // x2
+    pprealloc(&nums, 8, 9);    // x1.125
+    pprealloc(&nums, 9, 3);    // shrink
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.realloc_count == 3);
+    assert(stats.growth_hist[4] == 1);
+    assert(stats.growth_hist[1] == 1);
+    assert(stats.growth_hist[0] == 1);
+    assert(stats.live_bytes == 3 * sizeof(int));
+    assert(stats.peak_live_bytes == 9 * sizeof(int));
+
+    pfree(nums, 3);
+    tga_stats_snapshot(&stats);
+    assert(stats.live_bytes == 0);
+}
+
+TEST_CASE(failures_are_counted) {
+    tga_stats_reset();
+
+    #undef TGA_ALLOC_A_S
+    #define TGA_ALLOC_A_S failing_alloc
+
+    fail_next = 1;
+    Point* p = NULL;
+    palloc(p);
+    assert(p == NULL);
+    fail_next = 0;
+
+    #undef TGA_ALLOC_A_S
+    #define TGA_ALLOC_A_S _tgalloc_dflt_alloc_aligned_sized
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.failed_count == 1);
+    assert(stats.alloc_count == 0);
+    assert(stats.live_bytes == 0);
+}
+
+TEST_CASE(batches) {
+    tga_stats_reset();
+
+    Point* points[16] = {0};
+    size_t got = palloc_many(points, 16);
+    assert(got == 16);
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.alloc_count == 16);
+    assert(stats.live_bytes == 16 * sizeof(Point));
+
+    pfree_many(points, 16);
+    tga_stats_snapshot(&stats);
+    assert(stats.free_count == 16);
+    assert(stats.live_bytes == 0);
+}
+
+void* churn(void* arg) {
+    (void)arg; // Mark as unused to prevent compiler warnings
+    for (int i = 0; i < 1000; i++) {
+        Point* p = NULL;
+        palloc(p);
+        pfree(p);
+    }
+    return NULL;
+}
+
+TEST_CASE(threads) {
+    tga_stats_reset();
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, churn, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+    assert(stats.alloc_count == 4000);
+    assert(stats.free_count == 4000);
+    assert(stats.live_bytes == 0);
+    assert(stats.peak_live_bytes >= sizeof(Point));
+    assert(stats.peak_live_bytes <= 4 * sizeof(Point));
+}
+
+TEST_CASE(dump) {
+    tga_stats_reset();
+
+    Point* p = NULL;
+    palloc(p);
+
+    FILE* out = tmpfile();
+    assert(out != NULL);
+    tga_stats_dump(out);
+    rewind(out);
+    char text[1024] = {0};
+    size_t len = fread(text, 1, sizeof(text) - 1, out);
+    fclose(out);
+    assert(len > 0);
+    assert(strstr(text, "allocs 1") != NULL);
+    assert(strstr(text, "<= 8 B: 1") != NULL);
+
+    pfree(p);
+}
+
+int main() {
+    printf("Running tgalloc stats tests...\n");
+
+    RUN_TEST(counts_and_live_bytes);
+    RUN_TEST(histograms);
+    RUN_TEST(realloc_growth);
+    RUN_TEST(failures_are_counted);
+    RUN_TEST(batches);
+    RUN_TEST(threads);
+    RUN_TEST(dump);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file tgalloc_tcache_tests.c
+ * @brief Test suite for the thread-caching front-end
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../tgalloc_arena.h"
+#include "../tgalloc_tcache.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    long id;
+    long payload[5];
+} Request;
+
+// Arena wrapper that counts live blocks, called only under the tcache lock
+typedef struct {
+    tga_arena_t arena;
+    long live_blocks;
+    long backend_calls;
+} CountingArena;
+
+void* counting_alloc(CountingArena* self, size_t alignment, size_t size) {
+    void* ptr = tga_arena_alloc_aligned_sized(&self->arena, alignment, size);
+    if (ptr) self->live_blocks++;
+    self->backend_calls++;
+    return ptr;
+}
+
+void* counting_realloc(CountingArena* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    self->backend_calls++;
+    return tga_arena_realloc_aligned_sized(&self->arena, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingArena* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) self->live_blocks--;
+    self->backend_calls++;
+    tga_arena_free_aligned_sized(&self->arena, ptr, alignment, size);
+}
+
+CountingArena backing;
+tga_tcache_t tcache;
+
+static void setup(void) {
+    memset(&backing, 0, sizeof(backing));
+    tga_arena_init(&backing.arena);
+    int rc = tga_tcache_init(&tcache, TGA_BACKEND(&backing, counting_alloc, counting_realloc, counting_free));
+    assert(rc == 0);
+    (void)rc;
+}
+
+static void teardown(void) {
+    tga_tcache_destroy(&tcache);
+    assert(backing.live_blocks == 0);
+    tga_arena_destroy(&backing.arena);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (tga_tcache_t*)&tcache
+#define TGA_ALLOC_A_S tga_tcache_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_tcache_realloc_aligned_sized
+#define TGA_FREE_A_S tga_tcache_free_aligned_sized
+
+TEST_CASE(fast_path_skips_backend) {
+    setup();
+
+    Request* r = NULL;
+    palloc(r);
+    assert(r != NULL);
+    pfree(r);
+
+    // Once the magazine is primed, churn never reaches the backend
+    long calls = backing.backend_calls;
+    for (int i = 0; i < 1000; i++) {
+        palloc(r);
+        r->id = i;
+        pfree(r);
+    }
+    assert(backing.backend_calls == calls);
+
+    teardown();
+}
+
+TEST_CASE(overflow_drains_to_backend) {
+    setup();
+
+    enum { COUNT = TGA_TCACHE_MAG_SIZE * 4 };
+    Request* reqs[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        palloc(reqs[i]);
+        assert(reqs[i] != NULL);
+        reqs[i]->id = i;
+    }
+    for (int i = 0; i < COUNT; i++) {
+        assert(reqs[i]->id == i);
+        pfree(reqs[i]);
+    }
+    // One more live block holds this thread's magazines
+    assert(backing.live_blocks <= TGA_TCACHE_MAG_SIZE + 1);
+
+    tga_tcache_flush(&tcache);
+    assert(backing.live_blocks == 1);
+
+    teardown();
+}
+
+TEST_CASE(large_and_realloc) {
+    setup();
+
+    long* values = NULL;
+    palloc(values, 4);
+    for (int i = 0; i < 4; i++) values[i] = i;
+
+    pprealloc(&values, 4, 100);
+    assert(values != NULL);
+    for (int i = 0; i < 4; i++) assert(values[i] == i);
+
+    pprealloc(&values, 100, 200);
+    assert(values != NULL);
+    for (int i = 0; i < 4; i++) assert(values[i] == i);
+
+    pfree(values, 200);
+    teardown();
+}
+
+TEST_CASE(batch_single_lock) {
+    setup();
+
+    #undef TGA_ALLOC_BATCH_A_S
+    #undef TGA_FREE_BATCH_A_S
+    #define TGA_ALLOC_BATCH_A_S tga_tcache_alloc_batch_aligned_sized
+    #define TGA_FREE_BATCH_A_S tga_tcache_free_batch_aligned_sized
+
+    enum { COUNT = TGA_TCACHE_MAG_SIZE * 2 };
+    Request* reqs[COUNT] = {0};
+    size_t got = palloc_many(reqs, COUNT);
+    assert(got == COUNT);
+    for (int i = 0; i < COUNT; i++) {
+        assert(reqs[i] != NULL);
+        reqs[i]->id = i;
+    }
+    pfree_many(reqs, COUNT);
+
+    // Half of the batch fits the magazine, the rest went back to the backend
+    assert(backing.live_blocks == TGA_TCACHE_MAG_SIZE + 1);
+
+    #undef TGA_ALLOC_BATCH_A_S
+    #undef TGA_FREE_BATCH_A_S
+    #define TGA_ALLOC_BATCH_A_S TGA_ALLOC_BATCH_LOOP
+    #define TGA_FREE_BATCH_A_S TGA_FREE_BATCH_LOOP
+
+    teardown();
+}
+
+// Workers churn their own objects and leave one behind for the main thread
+enum { THREADS = 8, ROUNDS = 20000 };
+Request* volatile handoff[THREADS];
+
+static void* worker(void* arg) {
+    long index = (long)arg;
+    Request* keep[16] = {0};
+    for (long i = 0; i < ROUNDS; i++) {
+        Request* r = NULL;
+        palloc(r);
+        assert(r != NULL);
+        r->id = index * ROUNDS + i;
+        size_t slot = (size_t)i % 16;
+        if (keep[slot]) pfree(keep[slot]);
+        keep[slot] = r;
+    }
+    for (int i = 0; i < 16; i++) pfree(keep[i]);
+
+    // Leave one object for the main thread to free
+    palloc(handoff[index]);
+    return NULL;
+}
+
+TEST_CASE(threads_and_remote_frees) {
+    setup();
+
+    pthread_t threads[THREADS];
+    for (long i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, worker, (void*)i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pfree(handoff[i]);
+    }
+
+    teardown();
+}
+
+int main() {
+    printf("Running tgalloc tcache tests...\n");
+
+    RUN_TEST(fast_path_skips_backend);
+    RUN_TEST(overflow_drains_to_backend);
+    RUN_TEST(large_and_realloc);
+    RUN_TEST(batch_single_lock);
+    RUN_TEST(threads_and_remote_frees);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "../tgalloc.h"
 
 // Custom testing macros
@@ -28,6 +29,10 @@ typedef struct {
     double values[16];  // 128 bytes with alignment requirements
 } AlignedStruct;
 
+typedef struct {
+    _Alignas(64) float lanes[16];  // One full cache line
+} CacheLine;
+
 // Custom allocator for testing
 typedef struct {
     size_t alloc_count;
@@ -281,6 +286,250 @@ TEST_CASE(complex_struct_array) {
     pfree(structs, num_objects);
 }
 
+TEST_CASE(overaligned_alloc_realloc) {
+    CacheLine* line = NULL;
+    ppalloc(&line);
+
+    assert(line != NULL);
+    assert((uintptr_t)line % 64 == 0);
+    pfree(line);
+
+    CacheLine* lines = NULL;
+    ppalloc(&lines, 3);
+    assert(lines != NULL);
+    assert((uintptr_t)lines % 64 == 0);
+
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 16; j++) {
+            lines[i].lanes[j] = (float)(i * 16 + j);
+        }
+    }
+
+    // Growth must keep both the alignment and the contents
+    for (size_t n = 3; n < 200; n = n * 2) {
+        pprealloc(&lines, n, n * 2);
+        assert(lines != NULL);
+        assert((uintptr_t)lines % 64 == 0);
+        for (size_t i = 0; i < 3; i++) {
+            for (size_t j = 0; j < 16; j++) {
+                assert(lines[i].lanes[j] == (float)(i * 16 + j));
+            }
+        }
+    }
+
+    pfree(lines, 384);
+}
+
+TEST_CASE(batch_alloc_free) {
+    // Default backend uses the per-object fallback loop
+    Point* points[8] = {0};
+    size_t got = palloc_many(points, 8);
+    assert(got == 8);
+    for (size_t i = 0; i < 8; i++) {
+        assert(points[i] != NULL);
+        points[i]->x = (int)i;
+    }
+    pfree_many(points, 8);
+
+    // The fallback follows whichever backend TGA selects
+    reset_test_allocator();
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (TestAllocator*)&test_allocator
+    #define TGA_ALLOC_A_S test_alloc
+    #define TGA_REALLOC_A_S test_realloc
+    #define TGA_FREE_A_S test_free
+
+    double* values[5] = {0};
+    got = palloc_many(values, 5);
+    assert(got == 5);
+    assert(test_allocator.alloc_count == 5);
+    assert(test_allocator.total_allocated == 5 * sizeof(double));
+
+    pfree_many(values, 5);
+    assert(test_allocator.free_count == 5);
+    assert(test_allocator.total_allocated == 0);
+
+    test_allocator.should_fail = true;
+    got = palloc_many(values, 5);
+    assert(got == 0);
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (dflt_allo_t*)NULL
+    #define TGA_ALLOC_A_S _tgalloc_dflt_alloc_aligned_sized
+    #define TGA_REALLOC_A_S _tgalloc_dflt_realloc_aligned_sized
+    #define TGA_FREE_A_S _tgalloc_dflt_free_aligned_sized
+}
+
+TEST_CASE(try_expand) {
+    int* nums = NULL;
+    ppalloc(&nums, 16);
+    assert(nums != NULL);
+    for (int i = 0; i < 16; i++) nums[i] = i;
+
+    // Shrinking a malloc block never moves it
+    int* before = nums;
+    assert(pptry_expand(&nums, 16, 8));
+    assert(nums == before);
+
+    // Growing within the usable size succeeds, far beyond it fails untouched
+    assert(pptry_expand(&nums, 8, 8));
+    assert(!pptry_expand(&nums, 8, 1 << 24));
+    assert(nums == before);
+    for (int i = 0; i < 8; i++) assert(nums[i] == i);
+    pfree(nums, 8);
+
+    // Backends without the hook only accept an unchanged size
+    reset_test_allocator();
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (TestAllocator*)&test_allocator
+    #define TGA_ALLOC_A_S test_alloc
+    #define TGA_REALLOC_A_S test_realloc
+    #define TGA_FREE_A_S test_free
+
+    double* values = NULL;
+    palloc(values, 4);
+    assert(pptry_expand(&values, 4, 4));
+    assert(!pptry_expand(&values, 4, 2));
+    assert(!pptry_expand(&values, 4, 5));
+    assert(test_allocator.total_allocated == 4 * sizeof(double));
+    pfree(values, 4);
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (dflt_allo_t*)NULL
+    #define TGA_ALLOC_A_S _tgalloc_dflt_alloc_aligned_sized
+    #define TGA_REALLOC_A_S _tgalloc_dflt_realloc_aligned_sized
+    #define TGA_FREE_A_S _tgalloc_dflt_free_aligned_sized
+}
+
+TEST_CASE(zeroed_alloc) {
+    // The default backend uses calloc, including for over-aligned types
+    int* nums = NULL;
+    pcalloc(nums, 1000);
+    assert(nums != NULL);
+    for (int i = 0; i < 1000; i++) assert(nums[i] == 0);
+
+    CacheLine* line = NULL;
+    ppcalloc(&line);
+    assert(line != NULL);
+    assert(((uintptr_t)line % 64) == 0);
+    for (int i = 0; i < 16; i++) assert(line->lanes[i] == 0.0f);
+    pfree(line);
+
+    // Growing zeroes only the new tail
+    for (int i = 0; i < 1000; i++) nums[i] = i + 1;
+    pprealloc_zero(&nums, 1000, 5000);
+    assert(nums != NULL);
+    for (int i = 0; i < 1000; i++) assert(nums[i] == i + 1);
+    for (int i = 1000; i < 5000; i++) assert(nums[i] == 0);
+    pprealloc_zero(&nums, 5000, 10);
+    assert(nums != NULL && nums[9] == 10);
+    pfree(nums, 10);
+
+    // Backends without the hook get a cleared block from their alloc function
+    reset_test_allocator();
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (TestAllocator*)&test_allocator
+    #define TGA_ALLOC_A_S test_alloc
+    #define TGA_REALLOC_A_S test_realloc
+    #define TGA_FREE_A_S test_free
+
+    Point* points = NULL;
+    palloc(points, 64);
+    memset(points, 0xAB, 64 * sizeof(Point));
+    pfree(points, 64);
+
+    pcalloc(points, 64);
+    assert(points != NULL);
+    assert(test_allocator.alloc_count == 2);
+    for (int i = 0; i < 64; i++) assert(points[i].x == 0 && points[i].y == 0);
+    pfree(points, 64);
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (dflt_allo_t*)NULL
+    #define TGA_ALLOC_A_S _tgalloc_dflt_alloc_aligned_sized
+    #define TGA_REALLOC_A_S _tgalloc_dflt_realloc_aligned_sized
+    #define TGA_FREE_A_S _tgalloc_dflt_free_aligned_sized
+}
+
+TEST_CASE(isolated_alloc) {
+    // Whole lines on line boundaries, so neighbours never share one
+    int* counter = NULL;
+    palloc_isolated(counter);
+    assert(counter != NULL);
+    assert(((uintptr_t)counter % TGA_INTERFERENCE_SIZE) == 0);
+    *counter = 42;
+
+    int* other = NULL;
+    palloc_isolated(other);
+    assert(other != NULL);
+    uintptr_t distance = (uintptr_t)other > (uintptr_t)counter ? (uintptr_t)other - (uintptr_t)counter
+                                                              : (uintptr_t)counter - (uintptr_t)other;
+    assert(distance >= TGA_INTERFERENCE_SIZE);
+    pfree_isolated(other);
+    pfree_isolated(counter);
+
+    // The backend sees rounded sizes, and the free passes the same ones
+    reset_test_allocator();
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (TestAllocator*)&test_allocator
+    #define TGA_ALLOC_A_S test_alloc
+    #define TGA_REALLOC_A_S test_realloc
+    #define TGA_FREE_A_S test_free
+
+    Point* point = NULL;
+    palloc_isolated(point);
+    assert(test_allocator.total_allocated == TGA_INTERFERENCE_SIZE);
+    Point* points = NULL;
+    palloc_isolated(points, TGA_INTERFERENCE_SIZE / sizeof(Point) + 1);
+    assert(test_allocator.total_allocated == 3 * TGA_INTERFERENCE_SIZE);
+    pfree_isolated(points, TGA_INTERFERENCE_SIZE / sizeof(Point) + 1);
+    pfree_isolated(point);
+    assert(test_allocator.alloc_count == 2 && test_allocator.free_count == 2);
+    assert(test_allocator.total_allocated == 0);
+
+    #undef TGA
+    #undef TGA_ALLOC_A_S
+    #undef TGA_REALLOC_A_S
+    #undef TGA_FREE_A_S
+
+    #define TGA (dflt_allo_t*)NULL
+    #define TGA_ALLOC_A_S _tgalloc_dflt_alloc_aligned_sized
+    #define TGA_REALLOC_A_S _tgalloc_dflt_realloc_aligned_sized
+    #define TGA_FREE_A_S _tgalloc_dflt_free_aligned_sized
+}
+
 int main() {
     printf("Running tgalloc tests...\n");
     
@@ -291,6 +540,11 @@ int main() {
     RUN_TEST(custom_allocator);
     RUN_TEST(allocation_failure);
     RUN_TEST(complex_struct_array);
+    RUN_TEST(overaligned_alloc_realloc);
+    RUN_TEST(batch_alloc_free);
+    RUN_TEST(try_expand);
+    RUN_TEST(zeroed_alloc);
+    RUN_TEST(isolated_alloc);
     
     printf("All tests passed successfully!\n");
     return 0;
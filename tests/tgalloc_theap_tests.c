@@ -0,0 +1,223 @@
+/**
+ * @file tgalloc_theap_tests.c
+ * @brief Test suite for the per-thread heaps
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../tgalloc_theap.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    long id;
+    long payload[5];
+} Request;
+
+// Upstream that counts what reaches it, called only under the theap lock
+typedef struct {
+    long live_blocks;
+    long chunks;
+} CountingUpstream;
+
+void* counting_alloc(CountingUpstream* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) self->live_blocks++;
+    if (ptr && size == TGA_THEAP_CHUNK_SIZE) self->chunks++;
+    return ptr;
+}
+
+void* counting_realloc(CountingUpstream* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    if (ptr == NULL) self->live_blocks++;
+    return _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+}
+
+void counting_free(CountingUpstream* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) self->live_blocks--;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+CountingUpstream upstream;
+tga_theap_t theap;
+
+static void setup(void) {
+    memset(&upstream, 0, sizeof(upstream));
+    int rc = tga_theap_init(&theap, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+    assert(rc == 0);
+    (void)rc;
+}
+
+static void teardown(void) {
+    tga_theap_destroy(&theap);
+    assert(upstream.live_blocks == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+
+#define TGA (tga_theap_t*)&theap
+#define TGA_ALLOC_A_S tga_theap_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_theap_realloc_aligned_sized
+#define TGA_FREE_A_S tga_theap_free_aligned_sized
+#define TGA_EXPAND_A_S tga_theap_expand_aligned_sized
+
+TEST_CASE(local_reuse) {
+    setup();
+
+    Request* req = NULL;
+    palloc(req);
+    assert(req != NULL);
+    assert((uintptr_t)req % TGA_THEAP_QUANTUM == 0);
+    req->id = 7;
+
+    // A block freed by its owner is the next one handed out
+    Request* before = req;
+    pfree(req);
+    palloc(req);
+    assert(req == before);
+
+    // Every block of a chunk routes back to the same heap
+    char* bytes = NULL;
+    palloc(bytes, 100);
+    assert(_tgalloc_theap_owner(bytes) == _tgalloc_theap_owner(req));
+    assert(upstream.chunks == 1);
+
+    pfree(bytes, 100);
+    pfree(req);
+    teardown();
+}
+
+#define ROUNDS 20
+#define PER_ROUND 2000
+
+Request* volatile slots[PER_ROUND];
+long produced;
+long consumed;
+
+void* consumer(void* arg) {
+    (void)arg; // Mark as unused to prevent compiler warnings
+    for (long n = 0; n < ROUNDS * PER_ROUND; n++) {
+        while (__atomic_load_n(&produced, __ATOMIC_ACQUIRE) <= n) {}
+        Request* req = slots[n % PER_ROUND];
+        assert(req->id == n);
+        pfree(req);
+        __atomic_store_n(&consumed, n + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+TEST_CASE(producer_consumer) {
+    setup();
+    produced = 0;
+    consumed = 0;
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, consumer, NULL);
+    for (long round = 0; round < ROUNDS; round++) {
+        for (long i = 0; i < PER_ROUND; i++) {
+            Request* req = NULL;
+            palloc(req);
+            assert(req != NULL);
+            req->id = round * PER_ROUND + i;
+            slots[i] = req;
+            __atomic_store_n(&produced, round * PER_ROUND + i + 1, __ATOMIC_RELEASE);
+        }
+        // Wait until the whole round has been freed remotely before reusing slots
+        while (__atomic_load_n(&consumed, __ATOMIC_ACQUIRE) < (round + 1) * PER_ROUND) {}
+    }
+    pthread_join(thread, NULL);
+
+    // Remote frees flow back to the producer instead of piling up
+    size_t per_chunk = (TGA_THEAP_CHUNK_SIZE - _tgalloc_theap_chunk_header)
+                       / _tgalloc_theap_class_size(_tgalloc_theap_class(sizeof(Request)));
+    assert(upstream.chunks <= (long)(PER_ROUND / per_chunk + 2));
+    teardown();
+}
+
+Request* orphan_block;
+
+void* allocate_and_exit(void* arg) {
+    (void)arg; // Mark as unused to prevent compiler warnings
+    palloc(orphan_block);
+    return NULL;
+}
+
+void* allocate_again(void* arg) {
+    Request* req = NULL;
+    palloc(req);
+    *(Request**)arg = req;
+    return NULL;
+}
+
+TEST_CASE(exited_thread_heap_is_adopted) {
+    setup();
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, allocate_and_exit, NULL);
+    pthread_join(thread, NULL);
+    assert(orphan_block != NULL);
+
+    // The heap outlives its thread, so freeing into it is still safe...
+    Request* freed = orphan_block;
+    pfree(orphan_block);
+
+    // ...and the next new thread takes it over, remote frees included
+    Request* reused = NULL;
+    pthread_create(&thread, NULL, allocate_again, &reused);
+    pthread_join(thread, NULL);
+    assert(reused == freed);
+    assert(upstream.chunks == 1);
+
+    pfree(reused);
+    teardown();
+}
+
+TEST_CASE(large_and_realloc) {
+    setup();
+
+    long* nums = NULL;
+    palloc(nums, 10);
+    for (long i = 0; i < 10; i++) nums[i] = i;
+    long live = upstream.live_blocks;
+
+    // Crossing TGA_THEAP_MAX_SMALL moves the block to the upstream backend
+    pprealloc(&nums, 10, 1000);
+    assert(nums != NULL);
+    assert(upstream.live_blocks == live + 1);
+    for (long i = 0; i < 10; i++) assert(nums[i] == i);
+
+    pprealloc(&nums, 1000, 12);
+    assert(nums != NULL);
+    assert(upstream.live_blocks == live);
+    for (long i = 0; i < 10; i++) assert(nums[i] == i);
+
+    // Within a size class a block resizes in place
+    int expanded = pptry_expand(&nums, 12, 11);
+    assert(expanded);
+    pfree(nums, 11);
+    teardown();
+}
+
+int main() {
+    printf("Running tgalloc theap tests...\n");
+
+    RUN_TEST(local_reuse);
+    RUN_TEST(producer_consumer);
+    RUN_TEST(exited_thread_heap_is_adopted);
+    RUN_TEST(large_and_realloc);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file tgalloc_trim_tests.c
+ * @brief Test suite for ptrim and the TGA_TRIM hooks
+ */
+
+#include "../tgalloc_trim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_arena.h"
+#include "../tgalloc_slab.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    void* left;
+    void* right;
+} Node;
+
+// Upstream that counts its blocks and never moves a shrinking one, like a
+// malloc that keeps the tail resident
+typedef struct {
+    long live_blocks;
+} CountingUpstream;
+
+void* counting_alloc(CountingUpstream* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) self->live_blocks++;
+    return ptr;
+}
+
+void* counting_realloc(CountingUpstream* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    if (ptr && new_size <= old_size) return ptr;
+    void* moved = _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+    if (moved && ptr == NULL) self->live_blocks++;
+    return moved;
+}
+
+void counting_free(CountingUpstream* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) self->live_blocks--;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+CountingUpstream upstream;
+tga_arena_t arena;
+tga_slab_t slab;
+
+// Number of resident pages in a page-aligned range
+static size_t resident_pages(void* start, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t pages = size / page;
+    unsigned char* vec = (unsigned char*)calloc(pages, 1);
+    assert(vec != NULL);
+    int rc = mincore(start, pages * page, vec);
+    assert(rc == 0);
+    (void)rc;
+    size_t resident = 0;
+    for (size_t i = 0; i < pages; i++) resident += vec[i] & 1;
+    free(vec);
+    return resident;
+}
+
+TEST_CASE(default_backend_trim) {
+    // Without a hook of its own the default backend falls back to malloc_trim
+    char* bytes = NULL;
+    palloc(bytes, 1 << 20);
+    memset(bytes, 1, 1 << 20);
+    ptrim(bytes, 1 << 20, 100);
+    assert(bytes != NULL && bytes[99] == 1);
+    pfree(bytes, 100);
+    assert(tga_trim() == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (CountingUpstream*)&upstream
+#define TGA_ALLOC_A_S counting_alloc
+#define TGA_REALLOC_A_S counting_realloc
+#define TGA_FREE_A_S counting_free
+
+TEST_CASE(ptrim_releases_tail) {
+    memset(&upstream, 0, sizeof(upstream));
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = 256 * page;
+
+    char* bytes = NULL;
+    palloc(bytes, len);
+    assert(bytes != NULL);
+    memset(bytes, 7, len);
+    char* block = bytes;
+    char* first_whole = (char*)(((uintptr_t)bytes + 2 * page + page - 1) & ~(uintptr_t)(page - 1));
+    size_t tail = (size_t)(bytes + len - first_whole) & ~(page - 1);
+    assert(resident_pages(first_whole, tail) == tail / page);
+
+    // The backend keeps the block, but its tail pages leave the resident set
+    ptrim(bytes, len, 2 * page);
+    assert(bytes == block);
+    assert(resident_pages(first_whole, tail) == 0);
+    for (size_t i = 0; i < 2 * page; i++) assert(bytes[i] == 7);
+
+    // Tails shorter than a page are only passed on to the backend
+    ptrim(bytes, 2 * page, 2 * page - 10);
+    assert(bytes == block && bytes[0] == 7);
+    assert(tga_release_pages(bytes, page - 1) == 0);
+
+    pfree(bytes, 2 * page - 10);
+    assert(upstream.live_blocks == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_TRIM
+
+#define TGA (tga_arena_t*)&arena
+#define TGA_ALLOC_A_S tga_arena_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_arena_realloc_aligned_sized
+#define TGA_FREE_A_S tga_arena_free_aligned_sized
+#define TGA_EXPAND_A_S tga_arena_expand_aligned_sized
+#define TGA_TRIM tga_arena_trim
+
+#define NODES 20000
+
+Node* nodes[NODES];
+
+TEST_CASE(arena_releases_free_chunks) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_arena_init_with(&arena, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+
+    for (int i = 0; i < NODES; i++) palloc(nodes[i]);
+    long chunks = upstream.live_blocks;
+    assert(chunks > 2);
+
+    // Keep one block alive in the oldest chunk
+    for (int i = 1; i < NODES; i++) pfree(nodes[i]);
+    assert(tga_trim() == 0);
+    assert(upstream.live_blocks == chunks);
+
+    // A second trim in a row releases every chunk that stayed unused
+    size_t released = tga_trim();
+    assert(released == (size_t)(chunks - 1) * TGA_ARENA_CHUNK_SIZE);
+    assert(upstream.live_blocks == 1);
+    assert(nodes[0] != NULL);
+
+    // The arena keeps working on its remaining chunk and grows again
+    for (int i = 1; i < NODES; i++) {
+        palloc(nodes[i]);
+        nodes[i]->left = nodes[i];
+    }
+    for (int i = 1; i < NODES; i++) assert(nodes[i]->left == nodes[i]);
+    assert(upstream.live_blocks == chunks);
+
+    // With no decay the first trim releases everything that is free
+    for (int i = 0; i < NODES; i++) pfree(nodes[i]);
+    arena.trim_decay = 0;
+    released = tga_trim();
+    assert(released == (size_t)chunks * TGA_ARENA_CHUNK_SIZE);
+    assert(upstream.live_blocks == 0 && arena.chunks == NULL);
+
+    palloc(nodes[0]);
+    assert(nodes[0] != NULL);
+    pfree(nodes[0]);
+    tga_arena_destroy(&arena);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(arena_decay_restarts_on_use) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_arena_init_with(&arena, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+    arena.trim_decay = 2;
+
+    Node* node = NULL;
+    palloc(node);
+    pfree(node);
+    assert(tga_trim() == 0);
+    assert(tga_trim() == 0);
+    // In use at a trim: the count starts over
+    palloc(node);
+    assert(tga_trim() == 0);
+    pfree(node);
+    assert(tga_trim() == 0);
+    assert(tga_trim() == 0);
+    assert(tga_trim() == TGA_ARENA_CHUNK_SIZE);
+    assert(upstream.live_blocks == 0);
+    tga_arena_destroy(&arena);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_TRIM
+
+#define TGA (tga_slab_t*)&slab
+#define TGA_ALLOC_A_S tga_slab_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_slab_realloc_aligned_sized
+#define TGA_FREE_A_S tga_slab_free_aligned_sized
+#define TGA_EXPAND_A_S tga_slab_expand_aligned_sized
+#define TGA_TRIM tga_slab_trim
+
+TEST_CASE(slab_releases_cached_pages) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_slab_init_with(&slab, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+
+    Node* node = NULL;
+    char* bytes = NULL;
+    palloc(node);
+    palloc(bytes, 100);
+    pfree(node);
+    // The last page of each class stays cached until it has been idle for a trim
+    assert(upstream.live_blocks == 2);
+    assert(tga_trim() == 0);
+
+    // Emptied again since the last trim: the page counts as freshly idle
+    palloc(node);
+    pfree(node);
+    assert(tga_trim() == 0);
+    assert(tga_trim() == TGA_SLAB_PAGE_SIZE);
+    assert(upstream.live_blocks == 1);
+
+    // Pages with live blocks stay
+    assert(tga_trim() == 0);
+    assert(bytes != NULL);
+    pfree(bytes, 100);
+    assert(tga_trim() == 0);
+    assert(tga_trim() == TGA_SLAB_PAGE_SIZE);
+    assert(upstream.live_blocks == 0);
+
+    tga_slab_destroy(&slab);
+}
+
+// Switching back resets the trim hook along with the others
+#include "../tgalloc_default.h"
+
+TEST_CASE(default_after_backend_trim) {
+    int* nums = NULL;
+    palloc(nums, 10);
+    pfree(nums, 10);
+    assert(tga_trim() == 0);
+}
+
+int main() {
+    printf("Running tgalloc trim tests...\n");
+
+    RUN_TEST(default_backend_trim);
+    RUN_TEST(ptrim_releases_tail);
+    RUN_TEST(arena_releases_free_chunks);
+    RUN_TEST(arena_decay_restarts_on_use);
+    RUN_TEST(slab_releases_cached_pages);
+    RUN_TEST(default_after_backend_trim);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,246 @@
+/**
+ * @file tgalloc_usable_tests.c
+ * @brief Test suite for palloc_at_least and the TGA_USABLE_SIZE_A_S hooks
+ */
+
+#include "../tgalloc_large.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../tgalloc_arena.h"
+#include "../tgalloc_slab.h"
+#include "../tgalloc_vec.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+// Upstream that counts its calls and remembers the last size it was handed
+typedef struct {
+    long allocs;
+    long reallocs;
+    long live_blocks;
+    size_t last_size;
+} CountingUpstream;
+
+void* counting_alloc(CountingUpstream* self, size_t alignment, size_t size) {
+    void* ptr = _tgalloc_dflt_alloc_aligned_sized(NULL, alignment, size);
+    if (ptr) self->live_blocks++;
+    self->allocs++;
+    self->last_size = size;
+    return ptr;
+}
+
+void* counting_realloc(CountingUpstream* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    void* moved = _tgalloc_dflt_realloc_aligned_sized(NULL, ptr, alignment, old_size, new_size);
+    if (moved && ptr == NULL) self->live_blocks++;
+    self->reallocs++;
+    self->last_size = new_size;
+    return moved;
+}
+
+void counting_free(CountingUpstream* self, void const* ptr, size_t alignment, size_t size) {
+    if (ptr) self->live_blocks--;
+    self->last_size = size;
+    _tgalloc_dflt_free_aligned_sized(NULL, ptr, alignment, size);
+}
+
+CountingUpstream upstream;
+tga_arena_t arena;
+tga_slab_t slab;
+tga_large_t large;
+
+typedef tgvec(char) char_vec;
+
+TEST_CASE(default_backend) {
+    // Whatever malloc reports is usable, and at least what was asked for
+    size_t actual = 0;
+    char* bytes = NULL;
+    palloc_at_least(bytes, 13, &actual);
+    assert(bytes != NULL && actual >= 13);
+    memset(bytes, 1, actual);
+    pfree(bytes, actual);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (CountingUpstream*)&upstream
+#define TGA_ALLOC_A_S counting_alloc
+#define TGA_REALLOC_A_S counting_realloc
+#define TGA_FREE_A_S counting_free
+
+TEST_CASE(exact_backend) {
+    // A backend without the hook hands back exactly the requested count
+    memset(&upstream, 0, sizeof(upstream));
+    size_t actual = 1;
+    char* bytes = NULL;
+    palloc_at_least(bytes, 13, &actual);
+    assert(bytes != NULL && actual == 13);
+    assert(upstream.last_size == 13);
+    pfree(bytes, actual);
+    assert(upstream.last_size == 13 && upstream.live_blocks == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_USABLE_SIZE_A_S
+
+#define TGA (tga_arena_t*)&arena
+#define TGA_ALLOC_A_S tga_arena_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_arena_realloc_aligned_sized
+#define TGA_FREE_A_S tga_arena_free_aligned_sized
+#define TGA_EXPAND_A_S tga_arena_expand_aligned_sized
+#define TGA_USABLE_SIZE_A_S tga_arena_usable_size_aligned_sized
+
+TEST_CASE(arena_size_classes) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_arena_init_with(&arena, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+
+    // 17 bytes land in the 32-byte class
+    size_t actual = 0;
+    char* bytes = NULL;
+    palloc_at_least(bytes, 17, &actual);
+    assert(bytes != NULL && actual == 2 * TGA_ARENA_QUANTUM);
+    memset(bytes, 2, actual);
+
+    // Elements that do not divide the class only get the whole ones
+    typedef struct { char c[12]; } Twelve;
+    Twelve* twelves = NULL;
+    size_t count = 0;
+    palloc_at_least(twelves, 2, &count);
+    assert(twelves != NULL && count == 2 * TGA_ARENA_QUANTUM / sizeof(Twelve));
+
+    // Blocks outside the classes are left to the upstream, which does not round
+    long* longs = NULL;
+    size_t longs_count = 0;
+    palloc_at_least(longs, 1000, &longs_count);
+    assert(longs != NULL && longs_count == 1000);
+    assert(upstream.last_size == 1000 * sizeof(long));
+
+    pfree(longs, longs_count);
+    pfree(twelves, count);
+    pfree(bytes, actual);
+
+    // The freed class block is handed out again for any size in the class
+    char* again = NULL;
+    palloc(again, 2 * TGA_ARENA_QUANTUM);
+    assert(again == bytes);
+    pfree(again, 2 * TGA_ARENA_QUANTUM);
+    tga_arena_destroy(&arena);
+    assert(upstream.live_blocks == 0);
+}
+
+TEST_CASE(vec_grows_into_slack) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_arena_init_with(&arena, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+
+    char_vec v = TGVEC_INIT;
+    int pushed = tgvec_push(v, 'a');
+    assert(pushed);
+    // TGA_VEC_MIN_CAP chars take a whole quantum
+    assert(v.cap == TGA_ARENA_QUANTUM);
+    char* first = v.data;
+    for (size_t i = 1; i < TGA_ARENA_QUANTUM; i++) {
+        pushed = tgvec_push(v, 'a');
+        assert(pushed);
+    }
+    assert(v.data == first);
+
+    int reserved = tgvec_reserve(v, 3 * TGA_ARENA_QUANTUM + 1);
+    assert(reserved);
+    assert(v.cap == 4 * TGA_ARENA_QUANTUM);
+    for (size_t i = 0; i < v.len; i++) assert(v.data[i] == 'a');
+
+    tgvec_free(v);
+    tga_arena_destroy(&arena);
+    assert(upstream.live_blocks == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_USABLE_SIZE_A_S
+
+#define TGA (tga_slab_t*)&slab
+#define TGA_ALLOC_A_S tga_slab_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_slab_realloc_aligned_sized
+#define TGA_FREE_A_S tga_slab_free_aligned_sized
+#define TGA_EXPAND_A_S tga_slab_expand_aligned_sized
+#define TGA_USABLE_SIZE_A_S tga_slab_usable_size_aligned_sized
+
+TEST_CASE(slab_size_classes) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_slab_init_with(&slab, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free));
+
+    size_t actual = 0;
+    char* bytes = NULL;
+    palloc_at_least(bytes, TGA_SLAB_QUANTUM + 1, &actual);
+    assert(bytes != NULL && actual == 2 * TGA_SLAB_QUANTUM);
+    memset(bytes, 3, actual);
+    pfree(bytes, actual);
+
+    tga_slab_destroy(&slab);
+    assert(upstream.live_blocks == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_USABLE_SIZE_A_S
+
+#define TGA (tga_large_t*)&large
+#define TGA_ALLOC_A_S tga_large_alloc_aligned_sized
+#define TGA_REALLOC_A_S tga_large_realloc_aligned_sized
+#define TGA_FREE_A_S tga_large_free_aligned_sized
+#define TGA_EXPAND_A_S tga_large_expand_aligned_sized
+#define TGA_USABLE_SIZE_A_S tga_large_usable_size_aligned_sized
+
+TEST_CASE(large_whole_pages) {
+    memset(&upstream, 0, sizeof(upstream));
+    tga_large_init_with(&large, TGA_BACKEND(&upstream, counting_alloc, counting_realloc, counting_free), 4096, 0);
+
+    // A mapping always covers whole pages
+    size_t actual = 0;
+    char* bytes = NULL;
+    palloc_at_least(bytes, large.page_size + 1, &actual);
+    assert(bytes != NULL && actual == 2 * large.page_size);
+    memset(bytes, 4, actual);
+    assert(upstream.allocs == 0);
+
+    // Growing over the slack needs no further system calls or copies
+    char_vec v = TGVEC_INIT;
+    int reserved = tgvec_reserve(v, large.page_size + 1);
+    assert(reserved && v.cap == 2 * large.page_size);
+    tgvec_free(v);
+
+    pfree(bytes, actual);
+}
+
+int main() {
+    printf("Running tgalloc usable size tests...\n");
+
+    RUN_TEST(default_backend);
+    RUN_TEST(exact_backend);
+    RUN_TEST(arena_size_classes);
+    RUN_TEST(vec_grows_into_slack);
+    RUN_TEST(slab_size_classes);
+    RUN_TEST(large_whole_pages);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file tgalloc_vec_tests.c
+ * @brief Test suite for the tgvec growable array
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include "../tgalloc_vec.h"
+
+// Custom testing macros
+#define TEST_CASE(name) void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("Running test: %s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+} while (0)
+
+typedef struct {
+    int id;
+    char name[12];
+} Item;
+
+typedef tgvec(int) int_vec;
+typedef tgvec(Item) item_vec;
+
+// Backend that checks every resize and free is given the size it allocated
+typedef struct {
+    void* ptr;
+    size_t size;
+    size_t allocs;
+    size_t reallocs;
+    size_t frees;
+    bool should_fail;
+} SizedAllocator;
+
+SizedAllocator sized = {0};
+
+void* sized_alloc(SizedAllocator* self, size_t alignment, size_t size) {
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    if (self->should_fail) return NULL;
+    assert(self->ptr == NULL);
+    self->ptr = malloc(size);
+    self->size = size;
+    self->allocs++;
+    return self->ptr;
+}
+
+void* sized_realloc(SizedAllocator* self, void* ptr, size_t alignment, size_t old_size, size_t new_size) {
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    if (self->should_fail) return NULL;
+    assert(ptr == self->ptr);
+    assert(old_size == self->size);
+    self->ptr = realloc(ptr, new_size);
+    self->size = new_size;
+    self->reallocs++;
+    return self->ptr;
+}
+
+void sized_free(SizedAllocator* self, void const* ptr, size_t alignment, size_t size) {
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    assert(ptr == self->ptr);
+    assert(size == self->size);
+    free((void*)ptr);
+    self->ptr = NULL;
+    self->size = 0;
+    self->frees++;
+}
+
+TEST_CASE(push_and_pop) {
+    int_vec v = TGVEC_INIT;
+    for (int i = 0; i < 1000; i++) {
+        int pushed = tgvec_push(v, i);
+        assert(pushed);
+    }
+    assert(v.len == 1000);
+    assert(v.cap >= 1000);
+    for (int i = 0; i < 1000; i++) assert(v.data[i] == i);
+    for (int i = 999; i >= 500; i--) assert(tgvec_pop(v) == i);
+    assert(v.len == 500);
+    tgvec_free(v);
+    assert(v.data == NULL && v.len == 0 && v.cap == 0);
+}
+
+#undef TGA
+#undef TGA_ALLOC_A_S
+#undef TGA_REALLOC_A_S
+#undef TGA_FREE_A_S
+
+#define TGA (SizedAllocator*)&sized
+#define TGA_ALLOC_A_S sized_alloc
+#define TGA_REALLOC_A_S sized_realloc
+#define TGA_FREE_A_S sized_free
+
+TEST_CASE(geometric_growth_with_exact_sizes) {
+    memset(&sized, 0, sizeof(sized));
+
+    item_vec items = TGVEC_INIT;
+    for (int i = 0; i < 10000; i++) {
+        Item item = {i, "item"};
+        int pushed = tgvec_push(items, item);
+        assert(pushed);
+        assert(sized.size == items.cap * sizeof(Item));
+    }
+    // Doubling from TGA_VEC_MIN_CAP needs about log2(10000 / 4) resizes
+    assert(sized.allocs == 1);
+    assert(sized.reallocs <= 12);
+    for (int i = 0; i < 10000; i++) assert(items.data[i].id == i);
+
+    tgvec_free(items);
+    assert(sized.frees == 1);
+}
+
+TEST_CASE(reserve_and_shrink) {
+    memset(&sized, 0, sizeof(sized));
+
+    int_vec v = TGVEC_INIT;
+    int reserved = tgvec_reserve(v, 100);
+    assert(reserved);
+    assert(v.cap == 100);
+    assert(sized.size == 100 * sizeof(int));
+
+    // Smaller reservations do nothing
+    reserved = tgvec_reserve(v, 10);
+    assert(reserved);
+    assert(v.cap == 100);
+    assert(sized.reallocs == 0);
+
+    for (int i = 0; i < 100; i++) {
+        int pushed = tgvec_push(v, i);
+        assert(pushed);
+    }
+    assert(sized.reallocs == 0);
+
+    v.len = 30;
+    int shrunk = tgvec_shrink_to_fit(v);
+    assert(shrunk);
+    assert(v.cap == 30);
+    assert(sized.size == 30 * sizeof(int));
+    for (int i = 0; i < 30; i++) assert(v.data[i] == i);
+
+    tgvec_clear(v);
+    shrunk = tgvec_shrink_to_fit(v);
+    assert(shrunk);
+    assert(v.data == NULL && v.cap == 0);
+    assert(sized.frees == 1);
+}
+
+TEST_CASE(failure_keeps_contents) {
+    memset(&sized, 0, sizeof(sized));
+
+    int_vec v = TGVEC_INIT;
+    for (int i = 0; i < 4; i++) {
+        int pushed = tgvec_push(v, i);
+        assert(pushed);
+    }
+    assert(v.len == v.cap);
+
+    sized.should_fail = true;
+    int* before = v.data;
+    int pushed = tgvec_push(v, 4);
+    int reserved = tgvec_reserve(v, 1000);
+    assert(!pushed && !reserved);
+    assert(v.data == before);
+    assert(v.len == 4 && v.cap == 4);
+    for (int i = 0; i < 4; i++) assert(v.data[i] == i);
+
+    // Absurd sizes fail before reaching the backend
+    sized.should_fail = false;
+    reserved = tgvec_reserve(v, SIZE_MAX / 2);
+    assert(!reserved);
+    assert(v.cap == 4);
+
+    tgvec_free(v);
+}
+
+int main() {
+    printf("Running tgalloc vec tests...\n");
+
+    RUN_TEST(push_and_pop);
+    RUN_TEST(geometric_growth_with_exact_sizes);
+    RUN_TEST(reserve_and_shrink);
+    RUN_TEST(failure_keeps_contents);
+
+    printf("All tests passed successfully!\n");
+    return 0;
+}
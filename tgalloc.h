@@ -18,6 +18,37 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+   #include <malloc.h>
+#elif defined(__GLIBC__) || defined(__linux__)
+   #include <malloc.h>
+#elif defined(__APPLE__)
+   #include <malloc/malloc.h>
+#endif
+
+// Pick the platform's aligned allocation family for over-aligned requests
+#if defined(_MSC_VER) || defined(__MINGW32__)
+   #define _TGALLOC_DFLT_ALIGNED_MALLOC
+#elif (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L) || (defined(__cplusplus) && __cplusplus >= 201703L)
+   #define _TGALLOC_DFLT_ALIGNED_ALLOC
+#elif defined(__unix__) || defined(__APPLE__)
+   #define _TGALLOC_DFLT_POSIX_MEMALIGN
+#endif
+
+// Strictest alignment that plain malloc is guaranteed to honour
+#if defined(__cplusplus)
+   #define _tgalloc_max_align alignof(max_align_t)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+   #define _tgalloc_max_align _Alignof(max_align_t)
+#elif defined(__GNUC__) || defined(__clang__)
+   #define _tgalloc_max_align __alignof__(long double)
+#else
+   #define _tgalloc_max_align (2 * sizeof(void*))
+#endif
 
 /**
  * @typedef dflt_allo_t
@@ -25,34 +56,128 @@
  * 
  * Structure representing the default allocator. When using the default allocator,
  * this can be NULL as the actual implementation uses standard malloc/realloc/free.
+ * Requests aligned more strictly than max_align_t are routed to the platform's
+ * aligned allocation function instead.
  */
 typedef struct dflt_allo_t dflt_allo_t;
 
+// Allocate a block aligned more strictly than malloc guarantees
+static inline void * _tgalloc_dflt_alloc_overaligned(size_t alignment, size_t size){
+#if defined(_TGALLOC_DFLT_ALIGNED_MALLOC)
+    return _aligned_malloc(size, alignment);
+#elif defined(_TGALLOC_DFLT_ALIGNED_ALLOC)
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#elif defined(_TGALLOC_DFLT_POSIX_MEMALIGN)
+    void * ptr = NULL;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL;
+#else
+    // Over-allocate and keep the address returned by malloc just below the block
+    char * raw = (char*)malloc(size + alignment + sizeof(void*));
+    if (raw == NULL) return NULL;
+    uintptr_t aligned = ((uintptr_t)(raw + sizeof(void*)) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+#endif
+}
+
+// Release a block obtained from _tgalloc_dflt_alloc_overaligned
+static inline void _tgalloc_dflt_free_overaligned(void * ptr){
+#if defined(_TGALLOC_DFLT_ALIGNED_MALLOC)
+    _aligned_free(ptr);
+#elif defined(_TGALLOC_DFLT_ALIGNED_ALLOC) || defined(_TGALLOC_DFLT_POSIX_MEMALIGN)
+    free(ptr);
+#else
+    if (ptr) free(((void**)ptr)[-1]);
+#endif
+}
+
+// Bytes actually usable in a block of the default backend, or 0 if unknown
+static inline size_t _tgalloc_dflt_usable_size(void * ptr, size_t alignment){
+#if defined(_TGALLOC_DFLT_ALIGNED_MALLOC)
+    return alignment > _tgalloc_max_align ? _aligned_msize(ptr, alignment, 0) : _msize(ptr);
+#else
+   #if !defined(_TGALLOC_DFLT_ALIGNED_ALLOC) && !defined(_TGALLOC_DFLT_POSIX_MEMALIGN)
+    // Over-aligned blocks do not start where malloc's block starts
+    if (alignment > _tgalloc_max_align) return 0;
+   #endif
+   #if defined(__GLIBC__) || defined(__linux__)
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    return malloc_usable_size(ptr);
+   #elif defined(__APPLE__)
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    return malloc_size(ptr);
+   #else
+    (void)ptr;       // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    return 0;
+   #endif
+#endif
+}
+
 // Default allocation function using malloc
-static void * _tgalloc_dflt_alloc_aligned_sized(dflt_allo_t * self, size_t alignment, size_t size){
+static inline void * _tgalloc_dflt_alloc_aligned_sized(dflt_allo_t * self, size_t alignment, size_t size){
     (void)self;      // Mark as unused to prevent compiler warnings
-    (void)alignment; // Mark as unused to prevent compiler warnings
+    if (alignment > _tgalloc_max_align) return _tgalloc_dflt_alloc_overaligned(alignment, size);
     return malloc(size);
 }
 
 // Default reallocation function using realloc
-static void * _tgalloc_dflt_realloc_aligned_sized(dflt_allo_t * self, void * ptr, size_t alignment, size_t old_size, size_t new_size){
+static inline void * _tgalloc_dflt_realloc_aligned_sized(dflt_allo_t * self, void * ptr, size_t alignment, size_t old_size, size_t new_size){
     (void)self;      // Mark as unused to prevent compiler warnings
-    (void)alignment; // Mark as unused to prevent compiler warnings
+    if (alignment <= _tgalloc_max_align) return realloc(ptr, new_size);
+    if (ptr == NULL) return _tgalloc_dflt_alloc_overaligned(alignment, new_size);
+#if defined(_TGALLOC_DFLT_ALIGNED_MALLOC)
     (void)old_size;  // Mark as unused to prevent compiler warnings
-    return realloc(ptr, new_size);
+    return _aligned_realloc(ptr, new_size, alignment);
+#else
+    // realloc would drop the alignment, so grow in place when the block has
+    // room and otherwise move only the bytes that are in use
+    if (new_size <= old_size || new_size <= _tgalloc_dflt_usable_size(ptr, alignment)) return ptr;
+    void * moved = _tgalloc_dflt_alloc_overaligned(alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size);
+    _tgalloc_dflt_free_overaligned(ptr);
+    return moved;
+#endif
 }
 
 // Default deallocation function using free
-static void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * ptr,
-                                        size_t alignment, size_t size){
+static inline void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * ptr,
+                                               size_t alignment, size_t size){
     (void)self;      // Mark as unused to prevent compiler warnings
-    (void)alignment; // Mark as unused to prevent compiler warnings
     (void)size;      // Mark as unused to prevent compiler warnings
+    if (alignment > _tgalloc_max_align) {
+        _tgalloc_dflt_free_overaligned((void*)ptr);
+        return;
+    }
     free((void*)ptr);
     
 }
 
+// Default in-place resize: malloc blocks can always shrink, and grow as far
+// as the allocator's usable size reaches
+static inline int _tgalloc_dflt_expand_aligned_sized(dflt_allo_t * self, void * ptr, size_t alignment,
+                                                     size_t old_size, size_t new_size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    if (ptr == NULL) return 0;
+    if (new_size <= old_size) return 1;
+#if defined(_TGALLOC_DFLT_ALIGNED_MALLOC)
+    if (alignment <= _tgalloc_max_align) return _expand(ptr, new_size) != NULL;
+#endif
+    return new_size <= _tgalloc_dflt_usable_size(ptr, alignment);
+}
+
+// Default zeroed allocation using calloc, which can hand out pages the
+// system has already zeroed instead of clearing them again
+static inline void * _tgalloc_dflt_calloc_aligned_sized(dflt_allo_t * self, size_t alignment, size_t size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    if (alignment <= _tgalloc_max_align) return calloc(1, size);
+    void * ptr = _tgalloc_dflt_alloc_overaligned(alignment, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
 /**
  * @def TGA
  * @brief Default allocator instance
@@ -123,6 +248,501 @@ static void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * pt
 #define TGA_FREE_A_S _tgalloc_dflt_free_aligned_sized
 #endif // TGA
 
+/**
+ * @typedef tga_alloc_fn
+ * @brief Type-erased form of a TGA_ALLOC_A_S function
+ */
+typedef void * (*tga_alloc_fn)(void * self, size_t alignment, size_t size);
+
+/**
+ * @typedef tga_realloc_fn
+ * @brief Type-erased form of a TGA_REALLOC_A_S function
+ */
+typedef void * (*tga_realloc_fn)(void * self, void * ptr, size_t alignment, size_t old_size, size_t new_size);
+
+/**
+ * @typedef tga_free_fn
+ * @brief Type-erased form of a TGA_FREE_A_S function
+ */
+typedef void (*tga_free_fn)(void * self, void const * ptr, size_t alignment, size_t size);
+
+/**
+ * @typedef tga_expand_fn
+ * @brief Signature shared by all TGA_EXPAND_A_S implementations
+ */
+typedef int (*tga_expand_fn)(void * self, void * ptr, size_t alignment, size_t old_size, size_t new_size);
+
+/**
+ * @struct tga_backend_t
+ * @brief A backend instance bundled with its allocation functions
+ * 
+ * Backends that sit on top of another backend (arenas, caches, ...) store their
+ * upstream as a tga_backend_t so that any allocator honouring the TGA contract
+ * can be plugged underneath them.
+ */
+typedef struct tga_backend_t {
+    void * self;
+    tga_alloc_fn alloc_a_s;
+    tga_realloc_fn realloc_a_s;
+    tga_free_fn free_a_s;
+} tga_backend_t;
+
+/**
+ * @def TGA_BACKEND
+ * @brief Build a tga_backend_t from an instance and its three functions
+ */
+#define TGA_BACKEND(self, alloc_fn, realloc_fn, free_fn) \
+    ((tga_backend_t){(void*)(self), (tga_alloc_fn)(alloc_fn), (tga_realloc_fn)(realloc_fn), (tga_free_fn)(free_fn)})
+
+/**
+ * @def TGA_BACKEND_DEFAULT
+ * @brief The malloc-based default backend as a tga_backend_t
+ */
+#define TGA_BACKEND_DEFAULT TGA_BACKEND(NULL, _tgalloc_dflt_alloc_aligned_sized, \
+    _tgalloc_dflt_realloc_aligned_sized, _tgalloc_dflt_free_aligned_sized)
+
+/**
+ * @def TGA_BACKEND_CURRENT
+ * @brief Whatever backend TGA currently selects, as a tga_backend_t
+ */
+#define TGA_BACKEND_CURRENT TGA_BACKEND(TGA, TGA_ALLOC_A_S, TGA_REALLOC_A_S, TGA_FREE_A_S)
+
+/**
+ * @def TGA_ALLOC_BATCH_A_S
+ * @brief Optional batch allocation hook
+ * 
+ * Allocates `count` separate blocks of the same size and alignment in one call.
+ * The function must have the signature:
+ * size_t function(allocator_t* self, size_t alignment, size_t size, void** out, size_t count)
+ * 
+ * Return value:
+ * - Number of blocks stored at the start of `out`; fewer than `count` on failure
+ * 
+ * Backends without such a function leave this at TGA_ALLOC_BATCH_LOOP, which
+ * calls TGA_ALLOC_A_S once per block. When switching away from a backend that
+ * defines it, reset it to TGA_ALLOC_BATCH_LOOP.
+ */
+
+/**
+ * @def TGA_FREE_BATCH_A_S
+ * @brief Optional batch deallocation hook
+ * 
+ * Frees `count` blocks of the same size and alignment in one call.
+ * The function must have the signature:
+ * void function(allocator_t* self, void* const* ptrs, size_t alignment, size_t size, size_t count)
+ * 
+ * Backends without such a function leave this at TGA_FREE_BATCH_LOOP, which
+ * calls TGA_FREE_A_S once per block.
+ */
+
+// Fallback batch allocation: one backend call per block
+static inline size_t _tgalloc_alloc_batch_loop(void * self, tga_alloc_fn alloc_fn, size_t alignment, size_t size,
+                                               void ** out, size_t count){
+    size_t done = 0;
+    while (done < count && (out[done] = alloc_fn(self, alignment, size)) != NULL) done++;
+    return done;
+}
+
+// Fallback batch deallocation: one backend call per block
+static inline void _tgalloc_free_batch_loop(void * self, tga_free_fn free_fn, void * const * ptrs, size_t alignment,
+                                            size_t size, size_t count){
+    for (size_t i = 0; i < count; i++) free_fn(self, ptrs[i], alignment, size);
+}
+
+#define TGA_ALLOC_BATCH_LOOP(self, alignment, size, out, count) \
+    _tgalloc_alloc_batch_loop((void*)(self), (tga_alloc_fn)TGA_ALLOC_A_S, alignment, size, out, count)
+#define TGA_FREE_BATCH_LOOP(self, ptrs, alignment, size, count) \
+    _tgalloc_free_batch_loop((void*)(self), (tga_free_fn)TGA_FREE_A_S, ptrs, alignment, size, count)
+
+#ifndef TGA_ALLOC_BATCH_A_S
+#define TGA_ALLOC_BATCH_A_S TGA_ALLOC_BATCH_LOOP
+#endif
+#ifndef TGA_FREE_BATCH_A_S
+#define TGA_FREE_BATCH_A_S TGA_FREE_BATCH_LOOP
+#endif
+
+/**
+ * @def TGA_EXPAND_A_S
+ * @brief Optional in-place resize hook
+ * 
+ * Resizes a block without ever moving it. The function must have the signature:
+ * int function(allocator_t* self, void* ptr, size_t alignment, size_t old_size, size_t new_size)
+ * 
+ * Return value:
+ * - Non-zero if the block now holds new_size bytes at the same address, after
+ *   which it must be resized and freed with new_size; 0 if it is unchanged
+ * 
+ * Backends without such a function leave this at TGA_EXPAND_FALLBACK, which
+ * uses the default backend's check when the default backend is active and
+ * otherwise only accepts an unchanged size. When switching away from a
+ * backend that defines it, reset it to TGA_EXPAND_FALLBACK.
+ */
+
+// In-place resize for backends that cannot do better than an unchanged size
+static inline int _tgalloc_expand_unchanged(void * self, void * ptr, size_t alignment, size_t old_size,
+                                            size_t new_size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    return ptr != NULL && new_size == old_size;
+}
+
+// Fallback in-place resize, safe for any backend: the default backend's own
+// check when it is the active one, _tgalloc_expand_unchanged otherwise
+static inline tga_expand_fn _tgalloc_expand_fallback(tga_alloc_fn alloc_fn){
+    if (alloc_fn == (tga_alloc_fn)_tgalloc_dflt_alloc_aligned_sized) {
+        return (tga_expand_fn)_tgalloc_dflt_expand_aligned_sized;
+    }
+    return _tgalloc_expand_unchanged;
+}
+
+#define TGA_EXPAND_FALLBACK _tgalloc_expand_fallback((tga_alloc_fn)TGA_ALLOC_A_S)
+
+#ifndef TGA_EXPAND_A_S
+#define TGA_EXPAND_A_S TGA_EXPAND_FALLBACK
+#endif
+
+/**
+ * @def TGA_USABLE_SIZE_A_S
+ * @brief Optional hook reporting the slack the backend rounded a block up to
+ *
+ * Returns how many bytes a block allocated with `size` can actually hold,
+ * e.g. its size class. The function must have the signature:
+ * size_t function(allocator_t* self, void const* ptr, size_t alignment, size_t size)
+ *
+ * Return value:
+ * - At least `size`; TGA_EXPAND_A_S must accept growing the block to it
+ *
+ * Backends without such a function leave this at TGA_USABLE_SIZE_FALLBACK,
+ * which asks malloc when the default backend is active and otherwise reports
+ * `size` itself. When switching away from a backend that defines it, reset it
+ * to TGA_USABLE_SIZE_FALLBACK.
+ */
+
+/**
+ * @typedef tga_usable_size_fn
+ * @brief Type-erased form of a TGA_USABLE_SIZE_A_S function
+ */
+typedef size_t (*tga_usable_size_fn)(void * self, void const * ptr, size_t alignment, size_t size);
+
+// Usable size for backends that do not round: exactly the requested size
+static inline size_t _tgalloc_usable_size_exact(void * self, void const * ptr, size_t alignment, size_t size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    (void)ptr;       // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    return size;
+}
+
+// Default usable size: whatever malloc reports, when it reports anything
+static inline size_t _tgalloc_dflt_usable_size_aligned_sized(dflt_allo_t * self, void const * ptr, size_t alignment,
+                                                             size_t size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    if (ptr == NULL) return size;
+    size_t usable = _tgalloc_dflt_usable_size((void*)ptr, alignment);
+    return usable > size ? usable : size;
+}
+
+// Fallback usable size: malloc's for the default backend, the exact size otherwise
+static inline tga_usable_size_fn _tgalloc_usable_size_fallback(tga_alloc_fn alloc_fn){
+    if (alloc_fn == (tga_alloc_fn)_tgalloc_dflt_alloc_aligned_sized) {
+        return (tga_usable_size_fn)_tgalloc_dflt_usable_size_aligned_sized;
+    }
+    return _tgalloc_usable_size_exact;
+}
+
+#define TGA_USABLE_SIZE_FALLBACK _tgalloc_usable_size_fallback((tga_alloc_fn)TGA_ALLOC_A_S)
+
+#ifndef TGA_USABLE_SIZE_A_S
+#define TGA_USABLE_SIZE_A_S TGA_USABLE_SIZE_FALLBACK
+#endif
+
+/**
+ * @def TGA_CALLOC_A_S
+ * @brief Optional zeroed allocation hook
+ * 
+ * Allocates a block whose bytes are all zero. The function has the same
+ * signature as TGA_ALLOC_A_S and its blocks are resized and freed in the same way.
+ * 
+ * Backends without such a function leave this at TGA_CALLOC_FALLBACK, which
+ * uses calloc when the default backend is active and otherwise clears a block
+ * from TGA_ALLOC_A_S. When switching away from a backend that defines it,
+ * reset it to TGA_CALLOC_FALLBACK.
+ */
+
+// Zeroed allocation through calloc_fn, or through alloc_fn and an explicit
+// clear when the backend has no zeroed allocation of its own
+static inline void * _tgalloc_calloc(void * self, tga_alloc_fn calloc_fn, tga_alloc_fn alloc_fn, size_t alignment,
+                                     size_t size){
+    if (calloc_fn) return calloc_fn(self, alignment, size);
+    void * ptr = alloc_fn(self, alignment, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+// Fallback zeroed allocation: calloc for the default backend, none otherwise
+static inline tga_alloc_fn _tgalloc_calloc_fallback(tga_alloc_fn alloc_fn){
+    if (alloc_fn == (tga_alloc_fn)_tgalloc_dflt_alloc_aligned_sized) {
+        return (tga_alloc_fn)_tgalloc_dflt_calloc_aligned_sized;
+    }
+    return NULL;
+}
+
+#define TGA_CALLOC_FALLBACK _tgalloc_calloc_fallback((tga_alloc_fn)TGA_ALLOC_A_S)
+
+#ifndef TGA_CALLOC_A_S
+#define TGA_CALLOC_A_S TGA_CALLOC_FALLBACK
+#endif
+
+/**
+ * @def TGA_TRIM
+ * @brief Optional hook returning idle memory to the system
+ *
+ * Releases memory the backend holds without any live block in it, such as
+ * empty pages or chunks, to the system or to its upstream backend. The
+ * function must have the signature:
+ * size_t function(allocator_t* self)
+ *
+ * Return value:
+ * - Number of bytes released, or 0 if none were or the backend cannot tell
+ *
+ * Backends without such a function leave this at TGA_TRIM_FALLBACK, which
+ * calls malloc_trim on glibc when the default backend is active and does
+ * nothing otherwise. When switching away from a backend that defines it,
+ * reset it to TGA_TRIM_FALLBACK.
+ */
+
+/**
+ * @typedef tga_trim_fn
+ * @brief Type-erased form of a TGA_TRIM function
+ */
+typedef size_t (*tga_trim_fn)(void * self);
+
+/**
+ * @def TGA_TRIM_DECAY
+ * @brief Default number of earlier trims that must also have found memory idle
+ *
+ * Backends that cache empty memory only release it once that many trims in
+ * a row found it unused, so memory that is emptied and refilled between two
+ * periodic trims is not handed back and fetched again every time. 0
+ * releases everything idle on the first trim.
+ */
+#ifndef TGA_TRIM_DECAY
+#define TGA_TRIM_DECAY 1
+#endif
+
+// Default trim: hand free heap memory back with malloc_trim where it exists
+static inline size_t _tgalloc_dflt_trim(dflt_allo_t * self){
+    (void)self;      // Mark as unused to prevent compiler warnings
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+    return 0;
+}
+
+// Fallback trim: malloc_trim for the default backend, none otherwise
+static inline tga_trim_fn _tgalloc_trim_fallback(tga_alloc_fn alloc_fn){
+    if (alloc_fn == (tga_alloc_fn)_tgalloc_dflt_alloc_aligned_sized) return (tga_trim_fn)_tgalloc_dflt_trim;
+    return NULL;
+}
+
+static inline size_t _tgalloc_trim(void * self, tga_trim_fn trim_fn){
+    return trim_fn ? trim_fn(self) : 0;
+}
+
+// Trim the upstream of a wrapped backend, which has no trim entry of its own
+static inline size_t _tgalloc_trim_upstream(tga_backend_t const * upstream){
+    return _tgalloc_trim(upstream->self, _tgalloc_trim_fallback(upstream->alloc_a_s));
+}
+
+#define TGA_TRIM_FALLBACK _tgalloc_trim_fallback((tga_alloc_fn)TGA_ALLOC_A_S)
+
+#ifndef TGA_TRIM
+#define TGA_TRIM TGA_TRIM_FALLBACK
+#endif
+
+/**
+ * @brief Return the current backend's idle memory to the system
+ *
+ * Calls the backend's TGA_TRIM hook. Meant to be called after a batch of
+ * work has freed most of its memory, or periodically; see TGA_TRIM_DECAY.
+ *
+ * @return Number of bytes released, or 0 if none were or the backend cannot tell
+ */
+#define tga_trim() _tgalloc_trim((void*)(TGA), (tga_trim_fn)(TGA_TRIM))
+
+/**
+ * @struct tga_heap_chunk_t
+ * @brief One chunk, page or mapping of a backend, as seen by a heap walk
+ *
+ * size = used_bytes + free_bytes + the backend's own headers and padding.
+ */
+typedef struct tga_heap_chunk_t {
+    void const * start;
+    size_t size;         // Bytes obtained from upstream or the system
+    size_t used_bytes;   // Bytes in blocks handed out
+    size_t free_bytes;   // Bytes available for new blocks
+    size_t block_size;   // Size of every block of the chunk, 0 when it holds mixed sizes
+} tga_heap_chunk_t;
+
+/**
+ * @typedef tga_heap_visit_fn
+ * @brief Function a heap walk calls on every chunk
+ */
+typedef void (*tga_heap_visit_fn)(void * ctx, tga_heap_chunk_t const * chunk);
+
+/**
+ * @def TGA_HEAP_MAX_CLASSES
+ * @brief Number of size classes a heap report has room for
+ */
+#ifndef TGA_HEAP_MAX_CLASSES
+#define TGA_HEAP_MAX_CLASSES 64
+#endif
+
+/**
+ * @struct tga_heap_class_t
+ * @brief Occupancy of one size class
+ */
+typedef struct tga_heap_class_t {
+    size_t block_size;
+    size_t blocks;       // Blocks carved for the class, 0 where the backend does not track it
+    size_t free_blocks;  // Blocks on the class free lists or free in its pages
+} tga_heap_class_t;
+
+/**
+ * @struct tga_heap_report_t
+ * @brief Summary of a backend's heap, filled by its tga_<backend>_report
+ *
+ * Free bytes in chunks that still hold a used block cannot be handed back
+ * by a trim; free_bytes - releasable_bytes is the memory that keeps the
+ * resident set above the live bytes.
+ */
+typedef struct tga_heap_report_t {
+    size_t chunks;
+    size_t reserved_bytes;    // Sum of the chunk sizes
+    size_t used_bytes;
+    size_t free_bytes;
+    size_t releasable_bytes;  // Free bytes in chunks with no used block
+    size_t class_count;       // Entries of classes in use, at most TGA_HEAP_MAX_CLASSES
+    tga_heap_class_t classes[TGA_HEAP_MAX_CLASSES];
+} tga_heap_report_t;
+
+// Heap walk visitor adding a chunk to a tga_heap_report_t
+static inline void _tgalloc_heap_tally(void * ctx, tga_heap_chunk_t const * chunk){
+    tga_heap_report_t * report = (tga_heap_report_t*)ctx;
+    report->chunks++;
+    report->reserved_bytes += chunk->size;
+    report->used_bytes += chunk->used_bytes;
+    report->free_bytes += chunk->free_bytes;
+    if (chunk->used_bytes == 0) report->releasable_bytes += chunk->free_bytes;
+}
+
+// Append a size class to a report, dropping classes past TGA_HEAP_MAX_CLASSES
+static inline void _tgalloc_heap_add_class(tga_heap_report_t * report, size_t block_size, size_t blocks,
+                                           size_t free_blocks){
+    if (report->class_count == TGA_HEAP_MAX_CLASSES) return;
+    tga_heap_class_t * cls = &report->classes[report->class_count++];
+    cls->block_size = block_size;
+    cls->blocks = blocks;
+    cls->free_blocks = free_blocks;
+}
+
+/**
+ * @struct tga_allocator_ops
+ * @brief Table of the functions of a backend, for choosing backends at run time
+ * 
+ * expand_a_s and calloc_a_s may be NULL; in-place resizing then only accepts
+ * an unchanged size and zeroed allocations clear a block from alloc_a_s.
+ */
+typedef struct tga_allocator_ops {
+    tga_alloc_fn alloc_a_s;
+    tga_realloc_fn realloc_a_s;
+    tga_free_fn free_a_s;
+    tga_expand_fn expand_a_s;
+    tga_alloc_fn calloc_a_s;
+} tga_allocator_ops;
+
+/**
+ * @def TGA_ALLOCATOR_OPS
+ * @brief Initialiser for a tga_allocator_ops from a backend's functions
+ * 
+ * Usage:
+ * @code
+ * static tga_allocator_ops const arena_ops = TGA_ALLOCATOR_OPS(tga_arena_alloc_aligned_sized,
+ *     tga_arena_realloc_aligned_sized, tga_arena_free_aligned_sized, tga_arena_expand_aligned_sized, NULL);
+ * @endcode
+ */
+#define TGA_ALLOCATOR_OPS(alloc_fn, realloc_fn, free_fn, expand_fn, calloc_fn) \
+    {(tga_alloc_fn)(alloc_fn), (tga_realloc_fn)(realloc_fn), (tga_free_fn)(free_fn), \
+     (tga_expand_fn)(expand_fn), (tga_alloc_fn)(calloc_fn)}
+
+/**
+ * @struct tga_allocator
+ * @brief Run-time allocator handle: a backend instance and its function table
+ * 
+ * The *_with macros allocate through a handle chosen at run time, one
+ * indirect call per operation. The handle can also be made the compile-time
+ * backend with the tga_allocator_*_aligned_sized functions below, while hot
+ * code elsewhere keeps inlining a static backend through TGA.
+ */
+typedef struct tga_allocator {
+    void * self;
+    tga_allocator_ops const * ops;
+} tga_allocator;
+
+/**
+ * @def TGA_ALLOCATOR
+ * @brief Build a tga_allocator from an instance and a pointer to its function table
+ */
+#define TGA_ALLOCATOR(self, ops) ((tga_allocator){(void*)(self), (ops)})
+
+/**
+ * @brief Handle for the malloc-based default backend
+ */
+static inline tga_allocator tga_allocator_default(void){
+    static tga_allocator_ops const ops = TGA_ALLOCATOR_OPS(_tgalloc_dflt_alloc_aligned_sized,
+        _tgalloc_dflt_realloc_aligned_sized, _tgalloc_dflt_free_aligned_sized, _tgalloc_dflt_expand_aligned_sized,
+        _tgalloc_dflt_calloc_aligned_sized);
+    return TGA_ALLOCATOR(NULL, &ops);
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation dispatching through a handle
+ */
+static inline void * tga_allocator_alloc_aligned_sized(tga_allocator const * self, size_t alignment, size_t size){
+    return self->ops->alloc_a_s(self->self, alignment, size);
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation dispatching through a handle
+ */
+static inline void * tga_allocator_realloc_aligned_sized(tga_allocator const * self, void * ptr, size_t alignment,
+                                                         size_t old_size, size_t new_size){
+    return self->ops->realloc_a_s(self->self, ptr, alignment, old_size, new_size);
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation dispatching through a handle
+ */
+static inline void tga_allocator_free_aligned_sized(tga_allocator const * self, void const * ptr, size_t alignment,
+                                                    size_t size){
+    self->ops->free_a_s(self->self, ptr, alignment, size);
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation dispatching through a handle
+ */
+static inline int tga_allocator_expand_aligned_sized(tga_allocator const * self, void * ptr, size_t alignment,
+                                                     size_t old_size, size_t new_size){
+    if (self->ops->expand_a_s == NULL) return _tgalloc_expand_unchanged(self->self, ptr, alignment, old_size, new_size);
+    return self->ops->expand_a_s(self->self, ptr, alignment, old_size, new_size);
+}
+
+/**
+ * @brief TGA_CALLOC_A_S implementation dispatching through a handle
+ */
+static inline void * tga_allocator_calloc_aligned_sized(tga_allocator const * self, size_t alignment, size_t size){
+    return _tgalloc_calloc(self->self, self->ops->calloc_a_s, self->ops->alloc_a_s, alignment, size);
+}
+
 // Utility macros to get alignment and size information
 
 // Check for typeof support across different compilers
@@ -164,19 +784,146 @@ static void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * pt
 #define _tgalloc_sizeof(ptr) sizeof(*(ptr))
 #define _tgalloc_sizeof_n(ptr, n) ((_tgalloc_sizeof(ptr)) * (n))
 
+// Backend invocation used by the allocation macros. Instrumentation such as
+// TGA_STATS or TGA_PROFILE replaces these with wrappers around the same calls;
+// type_size is the sizeof of the pointee type, size the full byte count.
+#ifdef TGA_STATS
+    #include "tgalloc_stats.h"
+#endif
+#ifdef TGA_PROFILE
+    #include "tgalloc_profile.h"
+#endif
+#ifdef TGA_CHECK
+    #include "tgalloc_check.h"
+#endif
+#ifdef TGA_OOM
+    #include "tgalloc_oom.h"
+#endif
+#ifndef _tgalloc_call_alloc
+    #define _tgalloc_call_alloc(fn, self, alignment, type_size, size) fn(self, alignment, size)
+    #define _tgalloc_call_calloc(fn, alloc_fn, self, alignment, type_size, size) \
+        _tgalloc_calloc((void*)(self), (tga_alloc_fn)(fn), (tga_alloc_fn)(alloc_fn), alignment, size)
+    #define _tgalloc_call_realloc(fn, self, ptr, alignment, type_size, old_size, new_size) \
+        fn(self, ptr, alignment, old_size, new_size)
+    #define _tgalloc_call_free(fn, self, ptr, alignment, type_size, size) fn(self, ptr, alignment, size)
+    #define _tgalloc_call_expand(fn, self, ptr, alignment, type_size, old_size, new_size) \
+        fn(self, ptr, alignment, old_size, new_size)
+    #define _tgalloc_note_alloc_batch(done, alignment, size) (done)
+    #define _tgalloc_note_free_batch(count, alignment, size) (count)
+#endif
+
+// Backend instance passed by the allocation macros. TGA_CHECK routes it
+// through tgalloc_check.h to hand over the call site and element size, for
+// the next call or, with _tgalloc_tga_n, the next n calls of a batch.
+#ifdef TGA_CHECK
+    #define _tgalloc_tga(type_size) _tgalloc_check_at(TGA, __FILE__, __LINE__, type_size)
+    #define _tgalloc_tga_n(type_size, n) _tgalloc_check_at_n(TGA, __FILE__, __LINE__, type_size, n)
+#else
+    #define _tgalloc_tga(type_size) TGA
+    #define _tgalloc_tga_n(type_size, n) TGA
+#endif
+
+// Failed allocations of palloc, pcalloc and pprealloc. TGA_OOM routes them
+// through tgalloc_oom.h, which retries after running the out-of-memory handler.
+#ifdef TGA_OOM
+    #define _tgalloc_retry(call, alignment, size) _tgalloc_retry_always(call, alignment, size)
+#else
+    #define _tgalloc_retry(call, alignment, size) (call)
+#endif
+
+// Backend calls behind palloc, pcalloc and pprealloc
+#define _tgalloc_alloc1(ptr) _tgalloc_call_alloc(TGA_ALLOC_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof(ptr))
+#define _tgalloc_alloc2(ptr, len) _tgalloc_call_alloc(TGA_ALLOC_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof_n(ptr, len))
+#define _tgalloc_calloc1(ptr) _tgalloc_call_calloc(TGA_CALLOC_A_S, TGA_ALLOC_A_S, \
+    _tgalloc_tga(_tgalloc_sizeof(ptr)), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof(ptr))
+#define _tgalloc_calloc2(ptr, len) _tgalloc_call_calloc(TGA_CALLOC_A_S, TGA_ALLOC_A_S, \
+    _tgalloc_tga(_tgalloc_sizeof(ptr)), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof_n(ptr, len))
+#define _tgalloc_realloc_call(ptr, old_len, new_len) _tgalloc_call_realloc(TGA_REALLOC_A_S, \
+    _tgalloc_tga(_tgalloc_sizeof(ptr)), (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_sizeof_n(ptr, old_len), _tgalloc_sizeof_n(ptr, new_len))
+
 // Helper macro for allocating memory for a single object
-#define _tgalloc_palloc1(ptr) \
-    ((ptr) = (_tgalloc_typeof(ptr))TGA_ALLOC_A_S(TGA, _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr)))
+#define _tgalloc_palloc1(ptr) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_retry(_tgalloc_alloc1(ptr), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr)))
 
 // Helper macro for allocating memory for an array of objects
-#define _tgalloc_palloc2(ptr, len) \
-    ((ptr) = (_tgalloc_typeof(ptr))TGA_ALLOC_A_S(TGA, _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, len)))
+#define _tgalloc_palloc2(ptr, len) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_retry(_tgalloc_alloc2(ptr, len), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, len)))
+
+// Helper macro for allocating a zeroed object
+#define _tgalloc_pcalloc1(ptr) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_retry(_tgalloc_calloc1(ptr), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr)))
+
+// Helper macro for allocating a zeroed array of objects
+#define _tgalloc_pcalloc2(ptr, len) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_retry(_tgalloc_calloc2(ptr, len), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, len)))
+
+// Helpers for the *_with macros, which allocate through a tga_allocator handle
+#define _tgalloc_palloc_with1(alloc, ptr) \
+    ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_call_alloc(tga_allocator_alloc_aligned_sized, \
+    (tga_allocator const*)(alloc), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof(ptr)))
+#define _tgalloc_palloc_with2(alloc, ptr, len) \
+    ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_call_alloc(tga_allocator_alloc_aligned_sized, \
+    (tga_allocator const*)(alloc), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof_n(ptr, len)))
+#define _tgalloc_pcalloc_with1(alloc, ptr) \
+    ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_call_calloc(tga_allocator_calloc_aligned_sized, \
+    tga_allocator_alloc_aligned_sized, (tga_allocator const*)(alloc), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_sizeof(ptr)))
+#define _tgalloc_pcalloc_with2(alloc, ptr, len) \
+    ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_call_calloc(tga_allocator_calloc_aligned_sized, \
+    tga_allocator_alloc_aligned_sized, (tga_allocator const*)(alloc), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_sizeof_n(ptr, len)))
+#define _tgalloc_pfree_with1(alloc, ptr) _tgalloc_call_free(tga_allocator_free_aligned_sized, \
+    (tga_allocator const*)(alloc), (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof(ptr))
+#define _tgalloc_pfree_with2(alloc, ptr, len) _tgalloc_call_free(tga_allocator_free_aligned_sized, \
+    (tga_allocator const*)(alloc), (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_sizeof_n(ptr, len))
 
 // Helper macro for freeing memory of a single object
-#define _tgalloc_pfree1(ptr) TGA_FREE_A_S(TGA, (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr))
+#define _tgalloc_pfree1(ptr) _tgalloc_call_free(TGA_FREE_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), (void*)(ptr), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof(ptr))
 
 // Helper macro for freeing memory of an array of objects
-#define _tgalloc_pfree2(ptr, len) TGA_FREE_A_S(TGA, (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, len))
+#define _tgalloc_pfree2(ptr, len) _tgalloc_call_free(TGA_FREE_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), (void*)(ptr), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof_n(ptr, len))
+
+/**
+ * @def TGA_INTERFERENCE_SIZE
+ * @brief Distance in bytes that keeps two objects from sharing a cache line
+ *
+ * Used by palloc_isolated. 128 where the hardware moves lines in pairs or
+ * uses 128-byte lines (Apple silicon, POWER), 64 elsewhere.
+ */
+#ifndef TGA_INTERFERENCE_SIZE
+    #if (defined(__APPLE__) && defined(__aarch64__)) || defined(__powerpc64__)
+        #define TGA_INTERFERENCE_SIZE 128
+    #else
+        #define TGA_INTERFERENCE_SIZE 64
+    #endif
+#endif
+
+// Alignment and size of an isolated block: whole lines, starting on a line boundary
+#define _tgalloc_isolated_align(ptr) \
+    (_tgalloc_alignof(ptr) > TGA_INTERFERENCE_SIZE ? _tgalloc_alignof(ptr) : (size_t)TGA_INTERFERENCE_SIZE)
+#define _tgalloc_isolated_size(size) \
+    (((size) + TGA_INTERFERENCE_SIZE - 1) / TGA_INTERFERENCE_SIZE * TGA_INTERFERENCE_SIZE)
+
+// Helpers for palloc_isolated and pfree_isolated
+#define _tgalloc_palloc_isolated1(ptr) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_retry(_tgalloc_call_alloc(TGA_ALLOC_A_S, \
+    _tgalloc_tga(_tgalloc_sizeof(ptr)), _tgalloc_isolated_align(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_isolated_size(_tgalloc_sizeof(ptr))), _tgalloc_isolated_align(ptr), \
+    _tgalloc_isolated_size(_tgalloc_sizeof(ptr))))
+#define _tgalloc_palloc_isolated2(ptr, len) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_retry(_tgalloc_call_alloc( \
+    TGA_ALLOC_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), _tgalloc_isolated_align(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_isolated_size(_tgalloc_sizeof_n(ptr, len))), _tgalloc_isolated_align(ptr), \
+    _tgalloc_isolated_size(_tgalloc_sizeof_n(ptr, len))))
+#define _tgalloc_pfree_isolated1(ptr) _tgalloc_call_free(TGA_FREE_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), \
+    (void*)(ptr), _tgalloc_isolated_align(ptr), _tgalloc_sizeof(ptr), _tgalloc_isolated_size(_tgalloc_sizeof(ptr)))
+#define _tgalloc_pfree_isolated2(ptr, len) _tgalloc_call_free(TGA_FREE_A_S, _tgalloc_tga(_tgalloc_sizeof(ptr)), \
+    (void*)(ptr), _tgalloc_isolated_align(ptr), _tgalloc_sizeof(ptr), \
+    _tgalloc_isolated_size(_tgalloc_sizeof_n(ptr, len)))
 
 #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202000L
     #include "__tgalloc_c23.h"
@@ -196,6 +943,47 @@ static void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * pt
 
 #define ppalloc(pptr, ...) palloc(*(pptr) __VA_OPT__(,) __VA_ARGS__)
 
+/**
+ * @brief Allocate zeroed memory through a pointer to pointer
+ * 
+ * Same as ppalloc, but every byte of the new memory is zero. Uses the
+ * backend's TGA_CALLOC_A_S hook.
+ * 
+ * @param pptr Pointer to pointer that will receive the allocated memory
+ * @param ... Optional length parameter for array allocations
+ */
+#define ppcalloc(pptr, ...) pcalloc(*(pptr) __VA_OPT__(,) __VA_ARGS__)
+
+// Number of elements a block of len elements can hold, per TGA_USABLE_SIZE_A_S
+#define _tgalloc_usable_len(ptr, len) (TGA_USABLE_SIZE_A_S(TGA, (void const*)(ptr), _tgalloc_alignof(ptr), \
+    _tgalloc_sizeof_n(ptr, len)) / _tgalloc_sizeof(ptr))
+
+// Grow a block of len elements in place over the slack its backend rounded it
+// up to; evaluates to the number of elements it holds afterwards
+#define _tgalloc_take_slack(ptr, len) \
+    (_tgalloc_usable_len(ptr, len) > (len) && _tgalloc_call_expand(TGA_EXPAND_A_S, \
+        _tgalloc_tga(_tgalloc_sizeof(ptr)), (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), \
+        _tgalloc_sizeof_n(ptr, len), _tgalloc_sizeof_n(ptr, _tgalloc_usable_len(ptr, len))) \
+     ? _tgalloc_usable_len(ptr, len) : (size_t)(len))
+
+/**
+ * @brief Allocate an array of at least len elements, and learn how many fit
+ *
+ * Backends round requests up to size classes, pages or malloc buckets. This
+ * allocates len elements and then grows the block in place over that slack,
+ * so all of it can be used. The block must afterwards be resized and freed
+ * with the count stored in *actual. Uses the backend's TGA_USABLE_SIZE_A_S
+ * and TGA_EXPAND_A_S hooks; backends that do not round report len itself.
+ * ptr and len are evaluated more than once.
+ *
+ * @param ptr    Pointer that will receive the allocated memory
+ * @param len    Minimum number of elements
+ * @param actual Pointer to a size_t receiving the number of elements
+ * @return The number of elements stored in *actual, 0 if the allocation failed
+ */
+#define palloc_at_least(ptr, len, actual) \
+    (*(actual) = _tgalloc_palloc2(ptr, len) ? _tgalloc_take_slack(ptr, len) : 0)
+
  // Uncomment to enable ppfree functionality
  // /**
  //  * @brief Free memory allocated with ppalloc
@@ -209,8 +997,8 @@ static void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * pt
  // #define ppfree(pptr, ...) pfree(*(pptr) __VA_OPT__(,) __VA_ARGS__)
  
  // Helper macro for reallocating memory
-#define _tgalloc_realloc2(ptr, old_len, new_len) TGA_REALLOC_A_S(TGA, (void*)(ptr), _tgalloc_alignof(ptr), \
-     _tgalloc_sizeof_n(ptr, old_len), _tgalloc_sizeof_n(ptr, new_len))
+#define _tgalloc_realloc2(ptr, old_len, new_len) _tgalloc_retry(_tgalloc_realloc_call(ptr, old_len, new_len), \
+     _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, new_len))
  
  /**
   * @brief Reallocate memory through a pointer to pointer
@@ -226,4 +1014,85 @@ static void _tgalloc_dflt_free_aligned_sized(dflt_allo_t * self, void const * pt
   */
 #define pprealloc(pptr, old_len, new_len) (*(pptr)=_tgalloc_realloc2(*(pptr), old_len, new_len))
 
+// Clear the bytes a resize added to a block; passes the block through
+static inline void * _tgalloc_zero_tail(void * ptr, size_t old_size, size_t new_size){
+    if (ptr && new_size > old_size) memset((char*)ptr + old_size, 0, new_size - old_size);
+    return ptr;
+}
+
+/**
+ * @brief Reallocate memory through a pointer to pointer, zeroing the added elements
+ * 
+ * Same as pprealloc, but when the array grows the elements from old_len to
+ * new_len are set to zero. Only that tail is cleared, so growing a large
+ * zeroed buffer never clears it in full. old_len and new_len are evaluated twice.
+ * 
+ * @param pptr    Pointer to pointer to the memory to reallocate
+ * @param old_len Current number of elements
+ * @param new_len Desired number of elements after reallocation
+ * @return The assigned pointer (for chaining operations)
+ */
+#define pprealloc_zero(pptr, old_len, new_len) (*(pptr)=_tgalloc_zero_tail(_tgalloc_realloc2(*(pptr), old_len, \
+    new_len), _tgalloc_sizeof_n(*(pptr), old_len), _tgalloc_sizeof_n(*(pptr), new_len)))
+
+/**
+ * @brief Resize an array in place, never moving it
+ * 
+ * Unlike pprealloc, the pointer is left untouched: on success the block now
+ * holds new_len elements and must be resized and freed with new_len, on
+ * failure nothing changes and the caller can fall back to a new allocation.
+ * Uses the backend's TGA_EXPAND_A_S hook.
+ * 
+ * @param pptr    Pointer to pointer to the memory to resize
+ * @param old_len Current number of elements
+ * @param new_len Desired number of elements
+ * @return Non-zero on success, 0 if the block could not be resized in place
+ */
+#define pptry_expand(pptr, old_len, new_len) _tgalloc_call_expand(TGA_EXPAND_A_S, \
+    _tgalloc_tga(_tgalloc_sizeof(*(pptr))), (void*)*(pptr), _tgalloc_alignof(*(pptr)), _tgalloc_sizeof(*(pptr)), \
+    _tgalloc_sizeof_n(*(pptr), old_len), _tgalloc_sizeof_n(*(pptr), new_len))
+
+/**
+ * @brief Reallocate memory through a run-time allocator handle
+ * 
+ * Same as pprealloc, but through the tga_allocator `alloc` points to, which
+ * must be the one the memory came from.
+ */
+#define pprealloc_with(alloc, pptr, old_len, new_len) (*(pptr)=_tgalloc_call_realloc( \
+    tga_allocator_realloc_aligned_sized, (tga_allocator const*)(alloc), (void*)*(pptr), _tgalloc_alignof(*(pptr)), \
+    _tgalloc_sizeof(*(pptr)), _tgalloc_sizeof_n(*(pptr), old_len), _tgalloc_sizeof_n(*(pptr), new_len)))
+
+/**
+ * @brief Resize an array in place through a run-time allocator handle
+ * 
+ * Same as pptry_expand, but through the tga_allocator `alloc` points to.
+ */
+#define pptry_expand_with(alloc, pptr, old_len, new_len) _tgalloc_call_expand(tga_allocator_expand_aligned_sized, \
+    (tga_allocator const*)(alloc), (void*)*(pptr), _tgalloc_alignof(*(pptr)), _tgalloc_sizeof(*(pptr)), \
+    _tgalloc_sizeof_n(*(pptr), old_len), _tgalloc_sizeof_n(*(pptr), new_len))
+
+/**
+ * @brief Allocate a batch of separate objects
+ * 
+ * Fills ptrs[0..count) with individually allocated objects of the pointee
+ * type, using the backend's batch hook when it has one.
+ * 
+ * @param ptrs  Array of pointers that will receive the objects
+ * @param count Number of objects to allocate, evaluated twice under TGA_CHECK
+ * @return Number of objects allocated; the first that many entries are valid
+ */
+#define palloc_many(ptrs, count) _tgalloc_note_alloc_batch(TGA_ALLOC_BATCH_A_S( \
+    _tgalloc_tga_n(_tgalloc_sizeof((ptrs)[0]), count), _tgalloc_alignof((ptrs)[0]), \
+    _tgalloc_sizeof((ptrs)[0]), (void**)(ptrs), count), _tgalloc_alignof((ptrs)[0]), _tgalloc_sizeof((ptrs)[0]))
+
+/**
+ * @brief Free a batch of objects allocated with palloc or palloc_many
+ * 
+ * @param ptrs  Array of pointers to the objects to free
+ * @param count Number of objects to free, evaluated twice under TGA_CHECK
+ */
+#define pfree_many(ptrs, count) TGA_FREE_BATCH_A_S(_tgalloc_tga_n(_tgalloc_sizeof((ptrs)[0]), count), \
+    (void* const*)(ptrs), _tgalloc_alignof((ptrs)[0]), \
+    _tgalloc_sizeof((ptrs)[0]), _tgalloc_note_free_batch(count, _tgalloc_alignof((ptrs)[0]), _tgalloc_sizeof((ptrs)[0])))
+
 #endif // TGALLOC_H
@@ -0,0 +1,206 @@
+#ifndef TGALLOC_HPP
+#define TGALLOC_HPP
+
+/**
+ * @file tgalloc.hpp
+ * @brief C++ allocator and memory resource adapters for TGA backends
+ *
+ * tga::allocator<T, Backend> is a standard allocator, and
+ * tga::memory_resource<Backend> a std::pmr::memory_resource, over any
+ * backend honouring the TGA function contract. STL containers can then
+ * draw from the same arenas, pools and caches as the C code they share data
+ * with. Both pass the alignment of each request to the backend and hand the
+ * exact size back on deallocation, as sized-free backends require.
+ *
+ * A Backend is a tga::backend type naming an instance type and its
+ * allocation and deallocation functions; allocators and resources hold a
+ * pointer to the instance. Allocators compare equal when they use the same
+ * instance.
+ *
+ * Usage:
+ * @code
+ * typedef tga::backend<tga_arena_t, tga_arena_alloc_aligned_sized, tga_arena_free_aligned_sized> arena_backend;
+ *
+ * tga_arena_t arena;
+ * tga_arena_init(&arena);
+ * {
+ *     tga::allocator<int, arena_backend> alloc(&arena);
+ *     std::vector<int, tga::allocator<int, arena_backend> > v(alloc);
+ *     v.push_back(42);
+ *
+ *     tga::memory_resource<arena_backend> resource(&arena);
+ *     std::pmr::unordered_map<int, int> map(&resource);
+ *     map[1] = 2;
+ * }
+ * tga_arena_destroy(&arena);
+ * @endcode
+ *
+ * A failed allocation throws std::bad_alloc, or aborts when exceptions are
+ * disabled. Like the backends themselves, the adapters are only as
+ * thread-safe as the instance behind them.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include "tgalloc.h"
+
+#if __cplusplus >= 201703L && defined(__has_include)
+   #if __has_include(<memory_resource>)
+      #include <memory_resource>
+      #define _TGALLOC_HAS_PMR
+   #endif
+#endif
+
+namespace tga {
+
+/**
+ * @brief Bind an instance type to its TGA_ALLOC_A_S and TGA_FREE_A_S functions
+ *
+ * @tparam Self  Backend instance type
+ * @tparam Alloc Allocation function, as TGA_ALLOC_A_S
+ * @tparam Free  Deallocation function, as TGA_FREE_A_S
+ */
+template <class Self, void * (*Alloc)(Self *, std::size_t, std::size_t),
+          void (*Free)(Self *, void const *, std::size_t, std::size_t)>
+struct backend {
+    typedef Self self_type;
+
+    static void * allocate(Self * self, std::size_t alignment, std::size_t size){
+        return Alloc(self, alignment, size);
+    }
+
+    static void deallocate(Self * self, void const * ptr, std::size_t alignment, std::size_t size){
+        Free(self, ptr, alignment, size);
+    }
+};
+
+/**
+ * @brief The malloc-based default backend; its instance pointer is NULL
+ */
+typedef backend<dflt_allo_t, _tgalloc_dflt_alloc_aligned_sized, _tgalloc_dflt_free_aligned_sized> default_backend;
+
+/**
+ * @brief Any backend chosen at run time, through a tga_backend_t
+ */
+struct any_backend {
+    typedef tga_backend_t self_type;
+
+    static void * allocate(tga_backend_t * self, std::size_t alignment, std::size_t size){
+        return self->alloc_a_s(self->self, alignment, size);
+    }
+
+    static void deallocate(tga_backend_t * self, void const * ptr, std::size_t alignment, std::size_t size){
+        self->free_a_s(self->self, ptr, alignment, size);
+    }
+};
+
+// Report a failed allocation the way the build allows
+[[noreturn]] inline void _tgalloc_throw_bad_alloc(){
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+}
+
+/**
+ * @brief Standard allocator drawing from a TGA backend instance
+ *
+ * @tparam T       Element type
+ * @tparam Backend A tga::backend, tga::default_backend or tga::any_backend
+ */
+template <class T, class Backend = default_backend>
+class allocator {
+public:
+    typedef T value_type;
+    typedef typename Backend::self_type self_type;
+
+    template <class U>
+    struct rebind {
+        typedef allocator<U, Backend> other;
+    };
+
+    /**
+     * @brief Allocate from the given instance; NULL for the default backend
+     */
+    explicit allocator(self_type * self = nullptr) noexcept : self_(self) {}
+
+    template <class U>
+    allocator(allocator<U, Backend> const & other) noexcept : self_(other.self()) {}
+
+    /**
+     * @brief Allocate n elements; throws std::bad_alloc on failure
+     */
+    T * allocate(std::size_t n){
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) _tgalloc_throw_bad_alloc();
+        void * ptr = Backend::allocate(self_, alignof(T), n * sizeof(T));
+        if (ptr == nullptr && n != 0) _tgalloc_throw_bad_alloc();
+        return static_cast<T *>(ptr);
+    }
+
+    /**
+     * @brief Free n elements, passing their exact size to the backend
+     */
+    void deallocate(T * ptr, std::size_t n) noexcept {
+        Backend::deallocate(self_, ptr, alignof(T), n * sizeof(T));
+    }
+
+    self_type * self() const noexcept { return self_; }
+
+private:
+    self_type * self_;
+};
+
+template <class T, class U, class Backend>
+bool operator==(allocator<T, Backend> const & a, allocator<U, Backend> const & b) noexcept {
+    return a.self() == b.self();
+}
+
+template <class T, class U, class Backend>
+bool operator!=(allocator<T, Backend> const & a, allocator<U, Backend> const & b) noexcept {
+    return a.self() != b.self();
+}
+
+#ifdef _TGALLOC_HAS_PMR
+/**
+ * @brief std::pmr::memory_resource drawing from a TGA backend instance
+ *
+ * Zero-byte requests are served as one byte, so every allocation has an
+ * address of its own.
+ *
+ * @tparam Backend A tga::backend, tga::default_backend or tga::any_backend
+ */
+template <class Backend = default_backend>
+class memory_resource : public std::pmr::memory_resource {
+public:
+    typedef typename Backend::self_type self_type;
+
+    explicit memory_resource(self_type * self = nullptr) noexcept : self_(self) {}
+
+    self_type * self() const noexcept { return self_; }
+
+private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void * ptr = Backend::allocate(self_, alignment, bytes ? bytes : 1);
+        if (ptr == nullptr) _tgalloc_throw_bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void * ptr, std::size_t bytes, std::size_t alignment) override {
+        Backend::deallocate(self_, ptr, alignment, bytes ? bytes : 1);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const & other) const noexcept override {
+        memory_resource const * same = dynamic_cast<memory_resource const *>(&other);
+        return same != nullptr && same->self_ == self_;
+    }
+
+    self_type * self_;
+};
+#endif
+
+} // namespace tga
+
+#endif // TGALLOC_HPP
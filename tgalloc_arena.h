@@ -0,0 +1,453 @@
+#ifndef TGALLOC_ARENA_H
+#define TGALLOC_ARENA_H
+
+/**
+ * @file tgalloc_arena.h
+ * @brief Size-class arena backend for small objects
+ *
+ * Requests of up to TGA_ARENA_MAX_SMALL bytes are rounded up to a multiple of
+ * TGA_ARENA_QUANTUM and served from one free list per size class. The lists
+ * are fed by carving large chunks obtained from an upstream backend. Since
+ * tgalloc passes the exact size back on every free, a freed block is pushed
+ * straight onto the list of its class: blocks carry no header and a free
+ * involves no lookup.
+ *
+ * Requests that are too large or too strictly aligned for the size classes
+ * are forwarded to the upstream backend unchanged.
+ *
+ * Chunks are kept until the arena is destroyed, or until tga_arena_trim finds
+ * every block of a chunk free and hands the chunk back to upstream.
+ *
+ * An arena is not thread-safe; use one arena per thread or put a locking
+ * layer in front of it.
+ *
+ * Usage:
+ * @code
+ * tga_arena_t arena;
+ * tga_arena_init(&arena);
+ *
+ * #undef TGA
+ * #undef TGA_ALLOC_A_S
+ * #undef TGA_REALLOC_A_S
+ * #undef TGA_FREE_A_S
+ * #define TGA (tga_arena_t*)&arena
+ * #define TGA_ALLOC_A_S tga_arena_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_arena_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_arena_free_aligned_sized
+ * @endcode
+ */
+
+#include <string.h>
+#include "tgalloc.h"
+
+/**
+ * @def TGA_ARENA_QUANTUM
+ * @brief Granularity of the size classes, also the alignment they guarantee
+ */
+#ifndef TGA_ARENA_QUANTUM
+#define TGA_ARENA_QUANTUM 16
+#endif
+
+/**
+ * @def TGA_ARENA_MAX_SMALL
+ * @brief Largest request served from the size classes
+ */
+#ifndef TGA_ARENA_MAX_SMALL
+#define TGA_ARENA_MAX_SMALL 256
+#endif
+
+/**
+ * @def TGA_ARENA_CHUNK_SIZE
+ * @brief Number of bytes requested from upstream each time the arena grows
+ */
+#ifndef TGA_ARENA_CHUNK_SIZE
+#define TGA_ARENA_CHUNK_SIZE (64 * 1024)
+#endif
+
+#define TGA_ARENA_NUM_CLASSES (TGA_ARENA_MAX_SMALL / TGA_ARENA_QUANTUM)
+
+// Free blocks are threaded through their own storage
+typedef struct _tgalloc_arena_block {
+    struct _tgalloc_arena_block * next;
+} _tgalloc_arena_block;
+
+// Every chunk starts with a link to the previously allocated chunk
+typedef struct _tgalloc_arena_chunk {
+    struct _tgalloc_arena_chunk * next;
+    size_t idle;  // Number of trims in a row that found the chunk unused
+} _tgalloc_arena_chunk;
+
+/**
+ * @struct tga_arena_t
+ * @brief State of a size-class arena
+ */
+typedef struct tga_arena_t {
+    _tgalloc_arena_block * free_lists[TGA_ARENA_NUM_CLASSES];
+    char * cursor;                  // Next uncarved byte of the newest chunk
+    char * limit;                   // End of the newest chunk
+    _tgalloc_arena_chunk * chunks;  // All chunks, newest first
+    tga_backend_t upstream;         // Source of chunks and of large blocks
+    unsigned trim_decay;            // Trims a chunk must stay unused before it is released
+} tga_arena_t;
+
+// Offset of the first block in a chunk, keeping blocks quantum-aligned
+#define _tgalloc_arena_chunk_header \
+    ((sizeof(_tgalloc_arena_chunk) + TGA_ARENA_QUANTUM - 1) / TGA_ARENA_QUANTUM * TGA_ARENA_QUANTUM)
+
+// Size class of a request; size 0 shares the smallest class
+#define _tgalloc_arena_class(size) ((size) ? ((size) - 1) / TGA_ARENA_QUANTUM : 0)
+
+// Byte size of the blocks of a class
+#define _tgalloc_arena_class_size(cls) (((cls) + 1) * TGA_ARENA_QUANTUM)
+
+// Whether a request is served by the size classes
+#define _tgalloc_arena_is_small(alignment, size) \
+    ((size) <= TGA_ARENA_MAX_SMALL && (alignment) <= TGA_ARENA_QUANTUM)
+
+/**
+ * @brief Initialise an arena that takes its chunks from a given backend
+ *
+ * @param self     Arena to initialise
+ * @param upstream Backend used for chunks and for requests outside the size classes
+ */
+static inline void tga_arena_init_with(tga_arena_t * self, tga_backend_t upstream){
+    memset(self, 0, sizeof(*self));
+    self->upstream = upstream;
+    self->trim_decay = TGA_TRIM_DECAY;
+}
+
+/**
+ * @brief Initialise an arena on top of the default malloc backend
+ *
+ * @param self Arena to initialise
+ */
+static inline void tga_arena_init(tga_arena_t * self){
+    tga_arena_init_with(self, TGA_BACKEND_DEFAULT);
+}
+
+/**
+ * @brief Return every chunk to the upstream backend
+ *
+ * All blocks served from the size classes become invalid. Blocks forwarded to
+ * upstream are not tracked and must be freed individually beforehand.
+ *
+ * @param self Arena to destroy
+ */
+static inline void tga_arena_destroy(tga_arena_t * self){
+    _tgalloc_arena_chunk * chunk = self->chunks;
+    while (chunk) {
+        _tgalloc_arena_chunk * next = chunk->next;
+        self->upstream.free_a_s(self->upstream.self, chunk, TGA_ARENA_QUANTUM, TGA_ARENA_CHUNK_SIZE);
+        chunk = next;
+    }
+    memset(self->free_lists, 0, sizeof(self->free_lists));
+    self->cursor = self->limit = NULL;
+    self->chunks = NULL;
+}
+
+// Slow path: cut a fresh block of the given class from the newest chunk
+static inline void * _tgalloc_arena_carve(tga_arena_t * self, size_t cls){
+    size_t block_size = _tgalloc_arena_class_size(cls);
+    if ((size_t)(self->limit - self->cursor) < block_size) {
+        // Hand the unusable tail of the current chunk to a smaller class
+        size_t rest = (size_t)(self->limit - self->cursor);
+        if (rest >= TGA_ARENA_QUANTUM) {
+            _tgalloc_arena_block * tail = (_tgalloc_arena_block*)self->cursor;
+            size_t tail_cls = rest / TGA_ARENA_QUANTUM - 1;
+            tail->next = self->free_lists[tail_cls];
+            self->free_lists[tail_cls] = tail;
+        }
+        _tgalloc_arena_chunk * chunk = (_tgalloc_arena_chunk*)self->upstream.alloc_a_s(
+            self->upstream.self, TGA_ARENA_QUANTUM, TGA_ARENA_CHUNK_SIZE);
+        if (chunk == NULL) {
+            self->cursor = self->limit = NULL;
+            return NULL;
+        }
+        chunk->next = self->chunks;
+        chunk->idle = 0;
+        self->chunks = chunk;
+        self->cursor = (char*)chunk + _tgalloc_arena_chunk_header;
+        self->limit = (char*)chunk + TGA_ARENA_CHUNK_SIZE;
+    }
+    void * block = self->cursor;
+    self->cursor += block_size;
+    return block;
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the arena
+ */
+static inline void * tga_arena_alloc_aligned_sized(tga_arena_t * self, size_t alignment, size_t size){
+    if (_tgalloc_arena_is_small(alignment, size)) {
+        size_t cls = _tgalloc_arena_class(size);
+        _tgalloc_arena_block * block = self->free_lists[cls];
+        if (block) {
+            self->free_lists[cls] = block->next;
+            return block;
+        }
+        return _tgalloc_arena_carve(self, cls);
+    }
+    return self->upstream.alloc_a_s(self->upstream.self, alignment, size);
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the arena
+ */
+static inline void tga_arena_free_aligned_sized(tga_arena_t * self, void const * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (_tgalloc_arena_is_small(alignment, size)) {
+        size_t cls = _tgalloc_arena_class(size);
+        _tgalloc_arena_block * block = (_tgalloc_arena_block*)ptr;
+        block->next = self->free_lists[cls];
+        self->free_lists[cls] = block;
+        return;
+    }
+    self->upstream.free_a_s(self->upstream.self, ptr, alignment, size);
+}
+
+/**
+ * @brief TGA_ALLOC_BATCH_A_S implementation of the arena
+ *
+ * Pops as many blocks as the class free list holds and carves the rest.
+ */
+static inline size_t tga_arena_alloc_batch_aligned_sized(tga_arena_t * self, size_t alignment, size_t size,
+                                                         void ** out, size_t count){
+    if (!_tgalloc_arena_is_small(alignment, size)) {
+        return _tgalloc_alloc_batch_loop(self->upstream.self, self->upstream.alloc_a_s, alignment, size, out, count);
+    }
+    size_t cls = _tgalloc_arena_class(size);
+    size_t done = 0;
+    _tgalloc_arena_block * block = self->free_lists[cls];
+    while (done < count && block) {
+        out[done++] = block;
+        block = block->next;
+    }
+    self->free_lists[cls] = block;
+    while (done < count && (out[done] = _tgalloc_arena_carve(self, cls)) != NULL) done++;
+    return done;
+}
+
+/**
+ * @brief TGA_FREE_BATCH_A_S implementation of the arena
+ *
+ * Links the blocks into a chain and splices it onto the class free list.
+ */
+static inline void tga_arena_free_batch_aligned_sized(tga_arena_t * self, void * const * ptrs, size_t alignment,
+                                                      size_t size, size_t count){
+    if (!_tgalloc_arena_is_small(alignment, size)) {
+        _tgalloc_free_batch_loop(self->upstream.self, self->upstream.free_a_s, ptrs, alignment, size, count);
+        return;
+    }
+    size_t cls = _tgalloc_arena_class(size);
+    _tgalloc_arena_block * head = self->free_lists[cls];
+    for (size_t i = count; i-- > 0;) {
+        if (ptrs[i] == NULL) continue;
+        _tgalloc_arena_block * block = (_tgalloc_arena_block*)ptrs[i];
+        block->next = head;
+        head = block;
+    }
+    self->free_lists[cls] = head;
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the arena
+ *
+ * Resizing within a size class returns the same block. Blocks that stay
+ * outside the size classes are resized by the upstream backend; every other
+ * case allocates, copies and frees.
+ */
+static inline void * tga_arena_realloc_aligned_sized(tga_arena_t * self, void * ptr, size_t alignment,
+                                                     size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_arena_alloc_aligned_sized(self, alignment, new_size);
+    int old_small = _tgalloc_arena_is_small(alignment, old_size);
+    int new_small = _tgalloc_arena_is_small(alignment, new_size);
+    if (old_small && new_small && _tgalloc_arena_class(old_size) == _tgalloc_arena_class(new_size)) {
+        return ptr;
+    }
+    if (!old_small && !new_small) {
+        return self->upstream.realloc_a_s(self->upstream.self, ptr, alignment, old_size, new_size);
+    }
+    void * moved = tga_arena_alloc_aligned_sized(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_arena_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the arena
+ *
+ * Succeeds within a size class, and for blocks outside the size classes
+ * whenever the upstream backend can resize them in place.
+ */
+static inline int tga_arena_expand_aligned_sized(tga_arena_t * self, void * ptr, size_t alignment,
+                                                 size_t old_size, size_t new_size){
+    if (ptr == NULL) return 0;
+    int old_small = _tgalloc_arena_is_small(alignment, old_size);
+    int new_small = _tgalloc_arena_is_small(alignment, new_size);
+    if (old_small && new_small) return _tgalloc_arena_class(old_size) == _tgalloc_arena_class(new_size);
+    if (!old_small && !new_small) {
+        return _tgalloc_expand_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment,
+                                                                  old_size, new_size);
+    }
+    return 0;
+}
+
+/**
+ * @brief TGA_USABLE_SIZE_A_S implementation of the arena
+ *
+ * Blocks in the size classes can hold their whole class; the upstream
+ * backend answers for the others.
+ */
+static inline size_t tga_arena_usable_size_aligned_sized(tga_arena_t * self, void const * ptr, size_t alignment,
+                                                         size_t size){
+    if (_tgalloc_arena_is_small(alignment, size)) return _tgalloc_arena_class_size(_tgalloc_arena_class(size));
+    return _tgalloc_usable_size_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment, size);
+}
+
+// Per-chunk tally of a trim
+typedef struct _tgalloc_arena_tally {
+    char * start;
+    size_t free_bytes;
+    int release;
+} _tgalloc_arena_tally;
+
+static inline int _tgalloc_arena_tally_cmp(void const * a, void const * b){
+    char const * x = ((_tgalloc_arena_tally const*)a)->start;
+    char const * y = ((_tgalloc_arena_tally const*)b)->start;
+    return x < y ? -1 : x > y;
+}
+
+// Tally of the chunk holding a block, by binary search over the sorted tallies
+static inline _tgalloc_arena_tally * _tgalloc_arena_tally_of(_tgalloc_arena_tally * tallies, size_t count,
+                                                               void const * block){
+    size_t lo = 0, hi = count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((char const*)block < tallies[mid].start) hi = mid;
+        else lo = mid;
+    }
+    return &tallies[lo];
+}
+
+// Tallies of the free bytes of every chunk, sorted by address; NULL without chunks or memory from upstream
+static inline _tgalloc_arena_tally * _tgalloc_arena_tallies(tga_arena_t * self, size_t * count){
+    *count = 0;
+    for (_tgalloc_arena_chunk * chunk = self->chunks; chunk; chunk = chunk->next) (*count)++;
+    if (*count == 0) return NULL;
+    _tgalloc_arena_tally * tallies = (_tgalloc_arena_tally*)self->upstream.alloc_a_s(
+        self->upstream.self, _tgalloc_max_align, *count * sizeof(_tgalloc_arena_tally));
+    if (tallies == NULL) return NULL;
+
+    size_t i = 0;
+    for (_tgalloc_arena_chunk * chunk = self->chunks; chunk; chunk = chunk->next, i++) {
+        tallies[i].start = (char*)chunk;
+        // The uncarved rest of the newest chunk is free as well
+        tallies[i].free_bytes = chunk == self->chunks ? (size_t)(self->limit - self->cursor) : 0;
+        tallies[i].release = 0;
+    }
+    qsort(tallies, *count, sizeof(_tgalloc_arena_tally), _tgalloc_arena_tally_cmp);
+    for (size_t cls = 0; cls < TGA_ARENA_NUM_CLASSES; cls++) {
+        for (_tgalloc_arena_block * block = self->free_lists[cls]; block; block = block->next) {
+            _tgalloc_arena_tally_of(tallies, *count, block)->free_bytes += _tgalloc_arena_class_size(cls);
+        }
+    }
+    return tallies;
+}
+
+/**
+ * @brief TGA_TRIM implementation of the arena
+ *
+ * Counts the free bytes of every chunk by walking the free lists. A chunk
+ * with no block in use is handed back to upstream once trim_decay earlier
+ * trims in a row have also found it unused; its blocks are taken off the
+ * free lists first. The upstream backend is trimmed afterwards.
+ *
+ * Takes time proportional to the number of free blocks, so it belongs after
+ * a batch of work rather than on a hot path.
+ *
+ * @return Number of bytes released
+ */
+static inline size_t tga_arena_trim(tga_arena_t * self){
+    size_t count;
+    _tgalloc_arena_tally * tallies = _tgalloc_arena_tallies(self, &count);
+    if (tallies == NULL) return _tgalloc_trim_upstream(&self->upstream);
+
+    size_t released = 0;
+    for (size_t i = 0; i < count; i++) {
+        _tgalloc_arena_chunk * chunk = (_tgalloc_arena_chunk*)tallies[i].start;
+        if (tallies[i].free_bytes < TGA_ARENA_CHUNK_SIZE - _tgalloc_arena_chunk_header) chunk->idle = 0;
+        else if (chunk->idle++ >= self->trim_decay) tallies[i].release = 1;
+    }
+    for (size_t cls = 0; cls < TGA_ARENA_NUM_CLASSES; cls++) {
+        _tgalloc_arena_block ** link = &self->free_lists[cls];
+        while (*link) {
+            if (_tgalloc_arena_tally_of(tallies, count, *link)->release) *link = (*link)->next;
+            else link = &(*link)->next;
+        }
+    }
+    for (_tgalloc_arena_chunk ** link = &self->chunks; *link;) {
+        _tgalloc_arena_chunk * chunk = *link;
+        if (!_tgalloc_arena_tally_of(tallies, count, chunk)->release) {
+            link = &chunk->next;
+            continue;
+        }
+        if (self->limit == (char*)chunk + TGA_ARENA_CHUNK_SIZE) self->cursor = self->limit = NULL;
+        *link = chunk->next;
+        self->upstream.free_a_s(self->upstream.self, chunk, TGA_ARENA_QUANTUM, TGA_ARENA_CHUNK_SIZE);
+        released += TGA_ARENA_CHUNK_SIZE;
+    }
+    self->upstream.free_a_s(self->upstream.self, tallies, _tgalloc_max_align, count * sizeof(_tgalloc_arena_tally));
+    return released + _tgalloc_trim_upstream(&self->upstream);
+}
+
+/**
+ * @brief Call visit on every chunk of the arena, in address order
+ *
+ * Chunks hold blocks of mixed sizes, so block_size is 0. Like tga_arena_trim,
+ * this walks the free lists and takes time proportional to the free blocks.
+ *
+ * @param self  Arena to walk
+ * @param visit Function called on every chunk
+ * @param ctx   Passed on to visit
+ * @return 1, or 0 if upstream had no memory for the walk and no chunk was visited
+ */
+static inline int tga_arena_walk(tga_arena_t * self, tga_heap_visit_fn visit, void * ctx){
+    size_t count;
+    _tgalloc_arena_tally * tallies = _tgalloc_arena_tallies(self, &count);
+    if (tallies == NULL) return count == 0;
+    for (size_t i = 0; i < count; i++) {
+        tga_heap_chunk_t chunk;
+        chunk.start = tallies[i].start;
+        chunk.size = TGA_ARENA_CHUNK_SIZE;
+        chunk.free_bytes = tallies[i].free_bytes;
+        chunk.used_bytes = TGA_ARENA_CHUNK_SIZE - _tgalloc_arena_chunk_header - tallies[i].free_bytes;
+        chunk.block_size = 0;
+        visit(ctx, &chunk);
+    }
+    self->upstream.free_a_s(self->upstream.self, tallies, _tgalloc_max_align, count * sizeof(_tgalloc_arena_tally));
+    return 1;
+}
+
+/**
+ * @brief Summarise the chunks and free lists of the arena
+ *
+ * Reports every size class with its free list length; the arena does not
+ * count the blocks carved per class, so their blocks field is 0. Blocks
+ * forwarded to upstream are not included.
+ *
+ * @param self Arena to inspect
+ * @param out  Receives the report
+ * @return 1, or 0 if upstream had no memory for the walk
+ */
+static inline int tga_arena_report(tga_arena_t * self, tga_heap_report_t * out){
+    memset(out, 0, sizeof(*out));
+    for (size_t cls = 0; cls < TGA_ARENA_NUM_CLASSES; cls++) {
+        size_t free_blocks = 0;
+        for (_tgalloc_arena_block * block = self->free_lists[cls]; block; block = block->next) free_blocks++;
+        _tgalloc_heap_add_class(out, _tgalloc_arena_class_size(cls), 0, free_blocks);
+    }
+    return tga_arena_walk(self, _tgalloc_heap_tally, out);
+}
+
+#endif // TGALLOC_ARENA_H
@@ -0,0 +1,446 @@
+#ifndef TGALLOC_CHECK_H
+#define TGALLOC_CHECK_H
+
+/**
+ * @file tgalloc_check.h
+ * @brief Backend that verifies sized frees against what was allocated
+ *
+ * pfree(ptr, len) trusts the caller's length, and backends that rely on it,
+ * such as the arena or the slab, corrupt their free lists when it is wrong.
+ * A tga_check_t wraps any backend and, when TGA_CHECK is defined before
+ * including tgalloc.h, records every live block in a side table: its size,
+ * alignment, the sizeof of its element type and the call site that
+ * allocated it. The table lives apart from the blocks, so their layout and
+ * cache behaviour stay exactly those of the wrapped backend.
+ *
+ * Every free, realloc and pptry_expand is checked against the record first.
+ * A tga_backend_t has no in-place resize, so pass the wrapped backend's
+ * own to tga_check_init_with_expand; tga_check_init only keeps that of the
+ * default backend, and grows nothing else in place.
+ * A mismatch is reported to on_error, which by default prints both call
+ * sites and aborts. When on_error returns, the operation goes ahead with the
+ * recorded size and alignment, so the wrapped backend stays consistent;
+ * pointers without a record are left alone.
+ *
+ * Without TGA_CHECK the functions forward to the wrapped backend and keep
+ * no state, so a binary can keep the checking backend in place and turn
+ * the checks on with a compile flag. TGA_CHECK must be defined the same way
+ * in every translation unit sharing a tga_check_t.
+ *
+ * Usage:
+ * @code
+ * #define TGA_CHECK
+ * #include "tgalloc_check.h"
+ *
+ * tga_check_t check;
+ * tga_check_init(&check, TGA_BACKEND(&arena, tga_arena_alloc_aligned_sized,
+ *     tga_arena_realloc_aligned_sized, tga_arena_free_aligned_sized));
+ *
+ * #define TGA (tga_check_t*)&check
+ * #define TGA_ALLOC_A_S tga_check_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_check_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_check_free_aligned_sized
+ * #define TGA_EXPAND_A_S tga_check_expand_aligned_sized
+ *
+ * int * nums = NULL;
+ * palloc(nums, 10);
+ * pfree(nums, 12);     // reported: freed as 48 bytes, allocated as 40
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+/**
+ * @def TGA_CHECK_TABLE_MIN
+ * @brief Initial number of slots of the side table; a power of two
+ */
+#ifndef TGA_CHECK_TABLE_MIN
+#define TGA_CHECK_TABLE_MIN 1024
+#endif
+
+/**
+ * @struct tga_check_record_t
+ * @brief A block as recorded at allocation, or as described by a later call
+ *
+ * file is NULL and type_size 0 for calls that did not come from the palloc
+ * family, such as other backends calling their upstream.
+ */
+typedef struct tga_check_record_t {
+    void const * ptr;
+    size_t size;
+    char const * file;
+    uint32_t line;
+    uint32_t type_size;   // sizeof of the element type
+    size_t alignment;
+} tga_check_record_t;
+
+/**
+ * @enum tga_check_error_t
+ * @brief Kind of mismatch found by the checking backend
+ */
+typedef enum tga_check_error_t {
+    TGA_CHECK_UNKNOWN_POINTER,    // Not allocated by this backend, or already freed
+    TGA_CHECK_SIZE_MISMATCH,
+    TGA_CHECK_ALIGNMENT_MISMATCH,
+    TGA_CHECK_TYPE_MISMATCH       // Same size, but a different element type
+} tga_check_error_t;
+
+/**
+ * @struct tga_check_report_t
+ * @brief What on_error receives
+ */
+typedef struct tga_check_report_t {
+    tga_check_error_t error;
+    char const * op;              // "free", "realloc" or "expand"
+    tga_check_record_t call;      // The block as the failing call described it
+    tga_check_record_t recorded;  // The block as allocated; ptr is NULL if unknown
+} tga_check_report_t;
+
+typedef void (*tga_check_handler_t)(tga_check_report_t const * report);
+
+/**
+ * @struct tga_check_t
+ * @brief State of a checking backend
+ */
+typedef struct tga_check_t {
+    tga_backend_t upstream;
+    tga_expand_fn expand;         // In-place resize of the upstream backend
+#ifdef TGA_CHECK
+    tga_check_handler_t on_error;
+    _tgalloc_mutex_t lock;
+    tga_check_record_t * table;   // Open addressing on the block address
+    size_t capacity;
+    size_t used;                  // Live records and tombstones
+    size_t live;
+#endif
+} tga_check_t;
+
+static inline char const * _tgalloc_check_file(char const * file){
+    return file ? file : "?";
+}
+
+/**
+ * @brief Default on_error: describe the mismatch on stderr and abort
+ */
+static inline void tga_check_abort(tga_check_report_t const * report){
+    static char const * const what[] = {
+        "pointer was not allocated by this backend or was already freed",
+        "size mismatch", "alignment mismatch", "element type mismatch"
+    };
+    tga_check_record_t const * call = &report->call;
+    fprintf(stderr, "tgalloc check: %s of %p at %s:%u: %s\n", report->op, call->ptr,
+            _tgalloc_check_file(call->file), (unsigned)call->line, what[report->error]);
+    if (report->recorded.ptr) {
+        tga_check_record_t const * rec = &report->recorded;
+        fprintf(stderr, "  passed %zu bytes, alignment %zu, element size %u\n",
+                call->size, call->alignment, (unsigned)call->type_size);
+        fprintf(stderr, "  allocated %zu bytes, alignment %zu, element size %u at %s:%u\n",
+                rec->size, rec->alignment, (unsigned)rec->type_size, _tgalloc_check_file(rec->file),
+                (unsigned)rec->line);
+    }
+    abort();
+}
+
+#ifdef TGA_CHECK
+
+// Call site and element size noted by the palloc family for the next calls into this backend
+typedef struct _tgalloc_check_site {
+    void const * self;
+    char const * file;
+    uint32_t line;
+    uint32_t type_size;
+    size_t remaining;               // Calls left to describe, more than one for a batch
+} _tgalloc_check_site;
+
+static _tgalloc_thread_local _tgalloc_check_site _tgalloc_check_pending;
+
+// Used by _tgalloc_tga_n: note the call site for the next count calls, then pass the backend instance on
+static inline void * _tgalloc_check_at_n(void const * self, char const * file, int line, size_t type_size,
+                                         size_t count){
+    _tgalloc_check_pending.self = count ? self : NULL;
+    _tgalloc_check_pending.file = file;
+    _tgalloc_check_pending.line = (uint32_t)line;
+    _tgalloc_check_pending.type_size = (uint32_t)type_size;
+    _tgalloc_check_pending.remaining = count;
+    return (void*)self;
+}
+
+// Used by _tgalloc_tga: note the call site for the next call
+static inline void * _tgalloc_check_at(void const * self, char const * file, int line, size_t type_size){
+    return _tgalloc_check_at_n(self, file, line, type_size, 1);
+}
+
+// Describe the current call, taking over the site noted for this instance
+static inline tga_check_record_t _tgalloc_check_call(tga_check_t * self, void const * ptr, size_t alignment,
+                                                     size_t size){
+    tga_check_record_t call = {ptr, size, NULL, 0, 0, alignment};
+    if (_tgalloc_check_pending.self == self) {
+        call.file = _tgalloc_check_pending.file;
+        call.line = _tgalloc_check_pending.line;
+        call.type_size = _tgalloc_check_pending.type_size;
+        if (--_tgalloc_check_pending.remaining == 0) _tgalloc_check_pending.self = NULL;
+    }
+    return call;
+}
+
+// Empty slots have a NULL pointer, removed ones this marker
+#define _TGALLOC_CHECK_TOMBSTONE ((void const*)(uintptr_t)1)
+
+static inline size_t _tgalloc_check_hash(void const * ptr){
+    size_t hash = (size_t)((uintptr_t)ptr >> 4) * (size_t)0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+// Slot holding ptr, or NULL; called with the lock held
+static inline tga_check_record_t * _tgalloc_check_find(tga_check_t * self, void const * ptr){
+    if (self->table == NULL) return NULL;
+    size_t mask = self->capacity - 1;
+    for (size_t i = _tgalloc_check_hash(ptr) & mask;; i = (i + 1) & mask) {
+        if (self->table[i].ptr == ptr) return &self->table[i];
+        if (self->table[i].ptr == NULL) return NULL;
+    }
+}
+
+// Move the live records into a table of the given capacity; called with the lock held
+static inline int _tgalloc_check_rehash(tga_check_t * self, size_t capacity){
+    tga_check_record_t * table = (tga_check_record_t*)calloc(capacity, sizeof(tga_check_record_t));
+    if (table == NULL) return 0;
+    for (size_t i = 0; i < self->capacity; i++) {
+        void const * ptr = self->table[i].ptr;
+        if (ptr == NULL || ptr == _TGALLOC_CHECK_TOMBSTONE) continue;
+        size_t j = _tgalloc_check_hash(ptr) & (capacity - 1);
+        while (table[j].ptr) j = (j + 1) & (capacity - 1);
+        table[j] = self->table[i];
+    }
+    free(self->table);
+    self->table = table;
+    self->capacity = capacity;
+    self->used = self->live;
+    return 1;
+}
+
+// Called with the lock held; a block that cannot be recorded is simply not checked later
+static inline void _tgalloc_check_insert(tga_check_t * self, tga_check_record_t const * record){
+    if ((self->used + 1) * 2 > self->capacity) {
+        size_t capacity = self->capacity ? self->capacity : TGA_CHECK_TABLE_MIN;
+        while ((self->live + 1) * 2 > capacity / 2) capacity *= 2;
+        if (!_tgalloc_check_rehash(self, capacity)) return;
+    }
+    size_t mask = self->capacity - 1;
+    size_t i = _tgalloc_check_hash(record->ptr) & mask;
+    while (self->table[i].ptr && self->table[i].ptr != _TGALLOC_CHECK_TOMBSTONE) i = (i + 1) & mask;
+    if (self->table[i].ptr == NULL) self->used++;
+    self->table[i] = *record;
+    self->live++;
+}
+
+static inline void _tgalloc_check_remove(tga_check_t * self, tga_check_record_t * slot){
+    slot->ptr = _TGALLOC_CHECK_TOMBSTONE;
+    self->live--;
+}
+
+static inline void _tgalloc_check_record(tga_check_t * self, tga_check_record_t const * record){
+    _tgalloc_mutex_lock(&self->lock);
+    _tgalloc_check_insert(self, record);
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+// Take the record of a block out of the table and compare it with the call.
+// Returns 0 and reports if the pointer is unknown; reports mismatches otherwise.
+static inline int _tgalloc_check_take(tga_check_t * self, char const * op, tga_check_record_t const * call,
+                                      tga_check_record_t * recorded){
+    tga_check_report_t report;
+    memset(&report, 0, sizeof(report));
+    _tgalloc_mutex_lock(&self->lock);
+    tga_check_record_t * slot = _tgalloc_check_find(self, call->ptr);
+    if (slot) {
+        *recorded = *slot;
+        _tgalloc_check_remove(self, slot);
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+
+    report.op = op;
+    report.call = *call;
+    if (slot == NULL) {
+        report.error = TGA_CHECK_UNKNOWN_POINTER;
+        self->on_error(&report);
+        return 0;
+    }
+    report.recorded = *recorded;
+    if (call->size != recorded->size) report.error = TGA_CHECK_SIZE_MISMATCH;
+    else if (call->alignment != recorded->alignment) report.error = TGA_CHECK_ALIGNMENT_MISMATCH;
+    else if (call->type_size && recorded->type_size && call->type_size != recorded->type_size) {
+        report.error = TGA_CHECK_TYPE_MISMATCH;
+    } else return 1;
+    self->on_error(&report);
+    return 1;
+}
+
+#endif // TGA_CHECK
+
+/**
+ * @brief Initialise a checking backend around a given backend and its in-place resize
+ *
+ * @param self     Backend to initialise
+ * @param upstream Backend to wrap
+ * @param expand   TGA_EXPAND_A_S implementation of the wrapped backend, e.g. tga_arena_expand_aligned_sized
+ * @return 0 on success, non-zero if the lock could not be created
+ */
+static inline int tga_check_init_with_expand(tga_check_t * self, tga_backend_t upstream, tga_expand_fn expand){
+    memset(self, 0, sizeof(*self));
+    self->upstream = upstream;
+    self->expand = expand;
+#ifdef TGA_CHECK
+    self->on_error = tga_check_abort;
+    return _tgalloc_mutex_init(&self->lock);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Initialise a checking backend around a given backend
+ *
+ * Blocks only grow in place if the wrapped backend is the default one.
+ *
+ * @return 0 on success, non-zero if the lock could not be created
+ */
+static inline int tga_check_init(tga_check_t * self, tga_backend_t upstream){
+    return tga_check_init_with_expand(self, upstream, _tgalloc_expand_fallback(upstream.alloc_a_s));
+}
+
+/**
+ * @brief Release the side table; live blocks are not freed
+ */
+static inline void tga_check_destroy(tga_check_t * self){
+#ifdef TGA_CHECK
+    free(self->table);
+    self->table = NULL;
+    self->capacity = self->used = self->live = 0;
+    _tgalloc_mutex_destroy(&self->lock);
+#else
+    (void)self; // Mark as unused to prevent compiler warnings
+#endif
+}
+
+/**
+ * @brief Number of blocks allocated and not yet freed; 0 without TGA_CHECK
+ */
+static inline size_t tga_check_live_count(tga_check_t * self){
+#ifdef TGA_CHECK
+    _tgalloc_mutex_lock(&self->lock);
+    size_t live = self->live;
+    _tgalloc_mutex_unlock(&self->lock);
+    return live;
+#else
+    (void)self; // Mark as unused to prevent compiler warnings
+    return 0;
+#endif
+}
+
+/**
+ * @brief Write one line per live block with its allocation site, e.g. to find leaks
+ *
+ * @return Number of blocks written
+ */
+static inline size_t tga_check_dump_live(tga_check_t * self, FILE * out){
+    size_t count = 0;
+#ifdef TGA_CHECK
+    _tgalloc_mutex_lock(&self->lock);
+    for (size_t i = 0; i < self->capacity; i++) {
+        tga_check_record_t const * rec = &self->table[i];
+        if (rec->ptr == NULL || rec->ptr == _TGALLOC_CHECK_TOMBSTONE) continue;
+        fprintf(out, "%s:%u: %zu bytes at %p (alignment %zu, element size %u)\n", _tgalloc_check_file(rec->file),
+                (unsigned)rec->line, rec->size, rec->ptr, rec->alignment, (unsigned)rec->type_size);
+        count++;
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+#else
+    (void)self; // Mark as unused to prevent compiler warnings
+    (void)out;
+#endif
+    return count;
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the checking backend
+ */
+static inline void * tga_check_alloc_aligned_sized(tga_check_t * self, size_t alignment, size_t size){
+    void * ptr = self->upstream.alloc_a_s(self->upstream.self, alignment, size);
+#ifdef TGA_CHECK
+    tga_check_record_t call = _tgalloc_check_call(self, ptr, alignment, size);
+    if (ptr) _tgalloc_check_record(self, &call);
+    // A batch stops at its first failure, and the rest of its site must not describe later calls
+    else if (_tgalloc_check_pending.self == self) _tgalloc_check_pending.self = NULL;
+#endif
+    return ptr;
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the checking backend
+ */
+static inline void tga_check_free_aligned_sized(tga_check_t * self, void const * ptr, size_t alignment, size_t size){
+#ifdef TGA_CHECK
+    tga_check_record_t call = _tgalloc_check_call(self, ptr, alignment, size);
+    tga_check_record_t recorded;
+    if (ptr == NULL) return;
+    if (!_tgalloc_check_take(self, "free", &call, &recorded)) return;
+    alignment = recorded.alignment;
+    size = recorded.size;
+#endif
+    self->upstream.free_a_s(self->upstream.self, ptr, alignment, size);
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the checking backend
+ *
+ * An unknown pointer is reported and left alone, and NULL is returned.
+ */
+static inline void * tga_check_realloc_aligned_sized(tga_check_t * self, void * ptr, size_t alignment,
+                                                     size_t old_size, size_t new_size){
+#ifdef TGA_CHECK
+    if (ptr == NULL) return tga_check_alloc_aligned_sized(self, alignment, new_size);
+    tga_check_record_t call = _tgalloc_check_call(self, ptr, alignment, old_size);
+    tga_check_record_t recorded;
+    if (!_tgalloc_check_take(self, "realloc", &call, &recorded)) return NULL;
+    void * resized = self->upstream.realloc_a_s(self->upstream.self, ptr, recorded.alignment, recorded.size,
+                                                new_size);
+    if (resized) {
+        // The block now stems from this call
+        call.ptr = resized;
+        call.size = new_size;
+        call.alignment = recorded.alignment;
+        _tgalloc_check_record(self, &call);
+    } else if (new_size != 0) {
+        _tgalloc_check_record(self, &recorded);
+    }
+    return resized;
+#else
+    return self->upstream.realloc_a_s(self->upstream.self, ptr, alignment, old_size, new_size);
+#endif
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the checking backend
+ */
+static inline int tga_check_expand_aligned_sized(tga_check_t * self, void * ptr, size_t alignment,
+                                                 size_t old_size, size_t new_size){
+    if (ptr == NULL) return 0;
+#ifdef TGA_CHECK
+    tga_check_record_t call = _tgalloc_check_call(self, ptr, alignment, old_size);
+    tga_check_record_t recorded;
+    if (!_tgalloc_check_take(self, "expand", &call, &recorded)) return 0;
+    int expanded = self->expand(self->upstream.self, ptr, recorded.alignment, recorded.size, new_size);
+    if (expanded) recorded.size = new_size;
+    _tgalloc_check_record(self, &recorded);
+    return expanded;
+#else
+    return self->expand(self->upstream.self, ptr, alignment, old_size, new_size);
+#endif
+}
+
+#endif // TGALLOC_CHECK_H
@@ -0,0 +1,193 @@
+#ifndef TGALLOC_COMPOSE_H
+#define TGALLOC_COMPOSE_H
+
+/**
+ * @file tgalloc_compose.h
+ * @brief Backends generated by composing other backends
+ *
+ * Each macro here defines a new backend from existing ones, which can be
+ * used as TGA directly or composed further:
+ * - TGA_SEGREGATOR(name, threshold, Small, Large): requests up to threshold
+ *   bytes go to Small, the others to Large
+ * - TGA_FALLBACK(name, Primary, Secondary): requests Primary cannot serve
+ *   go to Secondary; Primary must be able to tell its own blocks
+ * - TGA_BUCKETIZER(name, min, max, step, Backend): one Backend instance per
+ *   step bytes of request sizes from min to max; other sizes fail
+ *
+ * A backend B here is named by its prefix: its instance type is B_t and its
+ * functions are B_alloc_aligned_sized, B_realloc_aligned_sized and
+ * B_free_aligned_sized, as for tga_arena, tga_region, tga_slab, tga_large
+ * and tga_persist. tga_default names the malloc-based default backend. The
+ * generated backend `name` follows the same convention, so composites nest.
+ *
+ * Dispatch only looks at the size and alignment palloc and pfree pass, which
+ * are constants at most call sites. Once the generated functions are inlined,
+ * the compiler resolves every branch and the call lands directly in the
+ * backend that serves the request.
+ *
+ * Usage:
+ * @code
+ * TGA_BUCKETIZER(small_objs, 1, 256, 16, tga_region)
+ * TGA_SEGREGATOR(mixed, 256, small_objs, tga_large)
+ *
+ * small_objs_t buckets;
+ * small_objs_init(&buckets);
+ * tga_large_t large;
+ * tga_large_init(&large);
+ * mixed_t mixed = {&buckets, &large};
+ *
+ * #define TGA (mixed_t*)&mixed
+ * #define TGA_ALLOC_A_S mixed_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S mixed_realloc_aligned_sized
+ * #define TGA_FREE_A_S mixed_free_aligned_sized
+ * @endcode
+ *
+ * Segregators and fallbacks point to instances of their parts, which the
+ * caller initialises and destroys. Bucketizers hold their instances and
+ * initialise them with B_init and B_destroy. Generated backends have no
+ * TGA_EXPAND_A_S hook, and are as thread-safe as their parts.
+ */
+
+#include <string.h>
+#include "tgalloc.h"
+
+/**
+ * @typedef tga_default_t
+ * @brief Instance type of tga_default, the malloc-based default backend; pass NULL
+ */
+typedef dflt_allo_t tga_default_t;
+
+#define tga_default_alloc_aligned_sized _tgalloc_dflt_alloc_aligned_sized
+#define tga_default_realloc_aligned_sized _tgalloc_dflt_realloc_aligned_sized
+#define tga_default_free_aligned_sized _tgalloc_dflt_free_aligned_sized
+
+// Finish moving a block to a new allocation; the caller frees the old block if this succeeded
+static inline void * _tgalloc_compose_moved(void * moved, void const * ptr, size_t old_size, size_t new_size){
+    if (moved && ptr) memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    return moved;
+}
+
+/**
+ * @brief Generate a backend sending requests up to threshold bytes to Small, others to Large
+ *
+ * Defines name_t, holding the pointers `small` and `large` to the two
+ * instances, and name_alloc_aligned_sized, name_realloc_aligned_sized and
+ * name_free_aligned_sized. A realloc crossing the threshold moves the block.
+ *
+ * @param name      Prefix of the generated type and functions
+ * @param threshold Largest request, in bytes, that goes to Small
+ * @param Small     Backend for requests up to threshold
+ * @param Large     Backend for larger requests
+ */
+#define TGA_SEGREGATOR(name, threshold, Small, Large) \
+    typedef struct name##_t { Small##_t * small; Large##_t * large; } name##_t; \
+    static inline void * name##_alloc_aligned_sized(name##_t * self, size_t alignment, size_t size){ \
+        if (size <= (threshold)) return Small##_alloc_aligned_sized(self->small, alignment, size); \
+        return Large##_alloc_aligned_sized(self->large, alignment, size); \
+    } \
+    static inline void name##_free_aligned_sized(name##_t * self, void const * ptr, size_t alignment, size_t size){ \
+        if (size <= (threshold)) Small##_free_aligned_sized(self->small, ptr, alignment, size); \
+        else Large##_free_aligned_sized(self->large, ptr, alignment, size); \
+    } \
+    static inline void * name##_realloc_aligned_sized(name##_t * self, void * ptr, size_t alignment, \
+                                                      size_t old_size, size_t new_size){ \
+        int was_small = old_size <= (threshold); \
+        int is_small = new_size <= (threshold); \
+        if (ptr && was_small == is_small) { \
+            if (is_small) return Small##_realloc_aligned_sized(self->small, ptr, alignment, old_size, new_size); \
+            return Large##_realloc_aligned_sized(self->large, ptr, alignment, old_size, new_size); \
+        } \
+        void * moved = _tgalloc_compose_moved(name##_alloc_aligned_sized(self, alignment, new_size), ptr, \
+                                              old_size, new_size); \
+        if (moved && ptr) name##_free_aligned_sized(self, ptr, alignment, old_size); \
+        return moved; \
+    }
+
+/**
+ * @brief Generate a backend trying Primary first and Secondary when Primary fails
+ *
+ * Defines name_t, holding the pointers `primary` and `secondary` to the two
+ * instances, and name_alloc_aligned_sized, name_realloc_aligned_sized and
+ * name_free_aligned_sized. Primary must provide
+ * `int Primary_owns(Primary_t const * self, void const * ptr)`, which tells
+ * frees where to go; tga_region and tga_persist do. A realloc Primary
+ * cannot serve moves the block to Secondary, where it stays.
+ *
+ * @param name      Prefix of the generated type and functions
+ * @param Primary   Backend tried first, typically bounded
+ * @param Secondary Backend for whatever Primary cannot serve
+ */
+#define TGA_FALLBACK(name, Primary, Secondary) \
+    typedef struct name##_t { Primary##_t * primary; Secondary##_t * secondary; } name##_t; \
+    static inline void * name##_alloc_aligned_sized(name##_t * self, size_t alignment, size_t size){ \
+        void * ptr = Primary##_alloc_aligned_sized(self->primary, alignment, size); \
+        if (ptr) return ptr; \
+        return Secondary##_alloc_aligned_sized(self->secondary, alignment, size); \
+    } \
+    static inline void name##_free_aligned_sized(name##_t * self, void const * ptr, size_t alignment, size_t size){ \
+        if (Primary##_owns(self->primary, ptr)) Primary##_free_aligned_sized(self->primary, ptr, alignment, size); \
+        else Secondary##_free_aligned_sized(self->secondary, ptr, alignment, size); \
+    } \
+    static inline void * name##_realloc_aligned_sized(name##_t * self, void * ptr, size_t alignment, \
+                                                      size_t old_size, size_t new_size){ \
+        if (ptr == NULL) return name##_alloc_aligned_sized(self, alignment, new_size); \
+        if (!Primary##_owns(self->primary, ptr)) { \
+            return Secondary##_realloc_aligned_sized(self->secondary, ptr, alignment, old_size, new_size); \
+        } \
+        void * resized = Primary##_realloc_aligned_sized(self->primary, ptr, alignment, old_size, new_size); \
+        if (resized) return resized; \
+        void * moved = _tgalloc_compose_moved(Secondary##_alloc_aligned_sized(self->secondary, alignment, new_size), \
+                                              ptr, old_size, new_size); \
+        if (moved) Primary##_free_aligned_sized(self->primary, ptr, alignment, old_size); \
+        return moved; \
+    }
+
+// Number of buckets of a bucketizer
+#define _tgalloc_bucketizer_count(min, max, step) (((max) - (min)) / (step) + 1)
+
+/**
+ * @brief Generate a backend with one Backend instance per step bytes of request size
+ *
+ * Requests of min to max bytes go to bucket (size - min) / step; allocating
+ * any other size fails, so a bucketizer usually sits under a segregator.
+ * Defines name_t, holding the array `buckets` of instances, name_init and
+ * name_destroy, which call Backend_init and Backend_destroy on every bucket,
+ * and name_alloc_aligned_sized, name_realloc_aligned_sized and
+ * name_free_aligned_sized. A realloc to another bucket moves the block.
+ *
+ * @param name    Prefix of the generated type and functions
+ * @param min     Smallest request served, in bytes
+ * @param max     Largest request served, in bytes
+ * @param step    Range of sizes, in bytes, served by each bucket
+ * @param Backend Backend of every bucket
+ */
+#define TGA_BUCKETIZER(name, min, max, step, Backend) \
+    typedef struct name##_t { Backend##_t buckets[_tgalloc_bucketizer_count(min, max, step)]; } name##_t; \
+    static inline void name##_init(name##_t * self){ \
+        for (size_t i = 0; i < _tgalloc_bucketizer_count(min, max, step); i++) Backend##_init(&self->buckets[i]); \
+    } \
+    static inline void name##_destroy(name##_t * self){ \
+        for (size_t i = 0; i < _tgalloc_bucketizer_count(min, max, step); i++) Backend##_destroy(&self->buckets[i]); \
+    } \
+    static inline void * name##_alloc_aligned_sized(name##_t * self, size_t alignment, size_t size){ \
+        if (size < (min) || size > (max)) return NULL; \
+        return Backend##_alloc_aligned_sized(&self->buckets[(size - (min)) / (step)], alignment, size); \
+    } \
+    static inline void name##_free_aligned_sized(name##_t * self, void const * ptr, size_t alignment, size_t size){ \
+        if (ptr == NULL) return; \
+        Backend##_free_aligned_sized(&self->buckets[(size - (min)) / (step)], ptr, alignment, size); \
+    } \
+    static inline void * name##_realloc_aligned_sized(name##_t * self, void * ptr, size_t alignment, \
+                                                      size_t old_size, size_t new_size){ \
+        if (ptr && new_size >= (min) && new_size <= (max) \
+            && (old_size - (min)) / (step) == (new_size - (min)) / (step)) { \
+            return Backend##_realloc_aligned_sized(&self->buckets[(new_size - (min)) / (step)], ptr, alignment, \
+                                                   old_size, new_size); \
+        } \
+        void * moved = _tgalloc_compose_moved(name##_alloc_aligned_sized(self, alignment, new_size), ptr, \
+                                              old_size, new_size); \
+        if (moved && ptr) name##_free_aligned_sized(self, ptr, alignment, old_size); \
+        return moved; \
+    }
+
+#endif // TGALLOC_COMPOSE_H
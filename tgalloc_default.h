@@ -5,12 +5,24 @@
 
 #endif // TGA_DEFAULT_H
 
-#undef ALLO
+#undef TGA
 #undef TGA_ALLOC_A_S
 #undef TGA_REALLOC_A_S
 #undef TGA_FREE_A_S
+#undef TGA_ALLOC_BATCH_A_S
+#undef TGA_FREE_BATCH_A_S
+#undef TGA_EXPAND_A_S
+#undef TGA_CALLOC_A_S
+#undef TGA_USABLE_SIZE_A_S
+#undef TGA_TRIM
 
-#define ALLO (dflt_allo_t*)NULL
+#define TGA (dflt_allo_t*)NULL
 #define TGA_ALLOC_A_S _tgalloc_dflt_alloc_aligned_sized
 #define TGA_REALLOC_A_S _tgalloc_dflt_realloc_aligned_sized
 #define TGA_FREE_A_S _tgalloc_dflt_free_aligned_sized
+#define TGA_ALLOC_BATCH_A_S TGA_ALLOC_BATCH_LOOP
+#define TGA_FREE_BATCH_A_S TGA_FREE_BATCH_LOOP
+#define TGA_EXPAND_A_S TGA_EXPAND_FALLBACK
+#define TGA_CALLOC_A_S TGA_CALLOC_FALLBACK
+#define TGA_USABLE_SIZE_A_S TGA_USABLE_SIZE_FALLBACK
+#define TGA_TRIM TGA_TRIM_FALLBACK
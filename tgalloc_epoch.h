@@ -0,0 +1,360 @@
+#ifndef TGALLOC_EPOCH_H
+#define TGALLOC_EPOCH_H
+
+/**
+ * @file tgalloc_epoch.h
+ * @brief Deferred frees for lock-free structures, reclaimed by quiescent-state epochs
+ *
+ * A node unlinked from a lock-free structure cannot be freed while readers
+ * may still be traversing it. pfree_deferred(ptr[, len]) queues it instead,
+ * together with the alignment, size and backend pfree would pass, in the
+ * domain selected by TGA_EPOCH. Every thread that reads the structure is
+ * registered as a reader of the domain and calls tga_epoch_quiescent at
+ * points where it holds no reference into it, such as between requests.
+ * Once every registered reader has passed such a point, the queued blocks
+ * can no longer be reached and are handed to their backend's TGA_FREE_A_S,
+ * a batch at a time.
+ *
+ * A quiescent point stores the current epoch in the reader's own state
+ * between two fences; readers never write shared memory. Every deferred
+ * free advances the epoch, and frees are queued in batches of
+ * TGA_EPOCH_BATCH. Filling a batch frees every earlier batch that all
+ * readers have moved past; tga_epoch_reclaim does the same on demand.
+ *
+ * Usage:
+ * @code
+ * tga_epoch_t epoch;
+ * tga_epoch_init(&epoch);
+ * #define TGA_EPOCH &epoch
+ *
+ * // every reader thread
+ * tga_epoch_reader_t reader;
+ * tga_epoch_register(&epoch, &reader);
+ * while (serving) {
+ *     lookup(table, key);            // lock-free traversal
+ *     tga_epoch_quiescent(&reader);  // no references held here
+ * }
+ * tga_epoch_unregister(&reader);
+ *
+ * // writers, after unlinking a node
+ * pfree_deferred(node);
+ * @endcode
+ *
+ * A reader about to block for long calls tga_epoch_offline, so that it does
+ * not hold reclamation up, and tga_epoch_online before reading again. The
+ * domain is thread-safe. The deferred frees go straight to the backend
+ * functions, so TGA_STATS, TGA_PROFILE and TGA_CHECK do not see them.
+ */
+
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+/**
+ * @def TGA_EPOCH_BATCH
+ * @brief Number of deferred frees queued before the domain tries to reclaim
+ */
+#ifndef TGA_EPOCH_BATCH
+#define TGA_EPOCH_BATCH 128
+#endif
+
+/**
+ * @struct tga_epoch_reader_t
+ * @brief A thread reading structures protected by an epoch domain
+ */
+typedef struct tga_epoch_reader_t {
+    size_t seen;                        // Epoch at the last quiescent point; 0 while offline
+    struct tga_epoch_reader_t * next;
+    struct tga_epoch_t * domain;
+} tga_epoch_reader_t;
+
+// A block waiting for its free, and the backend it goes back to
+typedef struct _tgalloc_epoch_item {
+    void * ptr;
+    size_t alignment;
+    size_t size;
+    void * self;
+    tga_free_fn free_a_s;
+} _tgalloc_epoch_item;
+
+// Deferred frees queued together; safe once every online reader has seen a later epoch
+typedef struct _tgalloc_epoch_batch {
+    struct _tgalloc_epoch_batch * next;
+    size_t epoch;                       // Epoch when the last of its frees was queued
+    size_t count;
+    _tgalloc_epoch_item items[TGA_EPOCH_BATCH];
+} _tgalloc_epoch_batch;
+
+/**
+ * @struct tga_epoch_t
+ * @brief Reclamation domain: its readers and the frees waiting for them
+ */
+typedef struct tga_epoch_t {
+    tga_backend_t upstream;             // Batches come from here; only touched under lock
+    _tgalloc_mutex_t lock;
+    size_t epoch;                       // Advanced by every deferred free; read without the lock
+    size_t pending;                     // Deferred frees not yet performed
+    tga_epoch_reader_t * readers;
+    _tgalloc_epoch_batch * open;        // Batch being filled
+    _tgalloc_epoch_batch * sealed;      // Full batches, oldest first
+    _tgalloc_epoch_batch * sealed_tail;
+    _tgalloc_epoch_batch * spare;       // One emptied batch kept for reuse
+} tga_epoch_t;
+
+/**
+ * @brief Initialise an epoch domain that takes its batches from a given backend
+ *
+ * @param self     Domain to initialise
+ * @param upstream Backend for the domain's own bookkeeping, not for the deferred blocks
+ * @return 0 on success, non-zero if the lock could not be created
+ */
+static inline int tga_epoch_init_with(tga_epoch_t * self, tga_backend_t upstream){
+    memset(self, 0, sizeof(*self));
+    self->upstream = upstream;
+    self->epoch = 1;
+    return _tgalloc_mutex_init(&self->lock);
+}
+
+/**
+ * @brief Initialise an epoch domain on top of the default allocator
+ *
+ * @return 0 on success, non-zero if the lock could not be created
+ */
+static inline int tga_epoch_init(tga_epoch_t * self){
+    return tga_epoch_init_with(self, TGA_BACKEND_DEFAULT);
+}
+
+// Free every block of a list of batches, then recycle the batches; called without the lock
+static inline void _tgalloc_epoch_release(tga_epoch_t * self, _tgalloc_epoch_batch * batch){
+    for (_tgalloc_epoch_batch * it = batch; it; it = it->next) {
+        for (size_t i = 0; i < it->count; i++) {
+            _tgalloc_epoch_item * item = &it->items[i];
+            item->free_a_s(item->self, item->ptr, item->alignment, item->size);
+        }
+    }
+    if (batch == NULL) return;
+    _tgalloc_mutex_lock(&self->lock);
+    while (batch) {
+        _tgalloc_epoch_batch * next = batch->next;
+        if (self->spare == NULL) {
+            self->spare = batch;
+        } else {
+            self->upstream.free_a_s(self->upstream.self, batch, _tgalloc_alignof(batch), sizeof(*batch));
+        }
+        batch = next;
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+// Move the open batch to the sealed list
+static inline void _tgalloc_epoch_seal(tga_epoch_t * self){
+    _tgalloc_epoch_batch * batch = self->open;
+    if (batch == NULL || batch->count == 0) return;
+    self->open = NULL;
+    batch->next = NULL;
+    if (self->sealed_tail) {
+        self->sealed_tail->next = batch;
+    } else {
+        self->sealed = batch;
+    }
+    self->sealed_tail = batch;
+}
+
+// Detach the sealed batches every online reader has moved past
+static inline _tgalloc_epoch_batch * _tgalloc_epoch_collect(tga_epoch_t * self){
+    // Pairs with the fences of the readers: either they see the epochs of the frees, or we see them
+    _tgalloc_atomic_fence();
+    size_t safe = _tgalloc_atomic_load(&self->epoch, _TGALLOC_RELAXED);
+    for (tga_epoch_reader_t * reader = self->readers; reader; reader = reader->next) {
+        size_t seen = _tgalloc_atomic_load(&reader->seen, _TGALLOC_ACQUIRE);
+        if (seen && seen < safe) safe = seen;
+    }
+
+    _tgalloc_epoch_batch * head = self->sealed;
+    _tgalloc_epoch_batch * last = NULL;
+    for (_tgalloc_epoch_batch * it = head; it && it->epoch < safe; it = it->next) {
+        self->pending -= it->count;
+        last = it;
+    }
+    if (last == NULL) return NULL;
+    self->sealed = last->next;
+    if (self->sealed == NULL) self->sealed_tail = NULL;
+    last->next = NULL;
+    return head;
+}
+
+/**
+ * @brief Free every deferred block that no reader can still reach
+ *
+ * Also seals the batch being filled, so that its blocks become eligible as
+ * soon as every reader passes its next quiescent point.
+ *
+ * @param self Domain to reclaim
+ * @return Number of blocks freed
+ */
+static inline size_t tga_epoch_reclaim(tga_epoch_t * self){
+    _tgalloc_mutex_lock(&self->lock);
+    _tgalloc_epoch_seal(self);
+    size_t before = self->pending;
+    _tgalloc_epoch_batch * ready = _tgalloc_epoch_collect(self);
+    size_t freed = before - self->pending;
+    _tgalloc_mutex_unlock(&self->lock);
+    _tgalloc_epoch_release(self, ready);
+    return freed;
+}
+
+// Queue one free; 0 if no batch could be allocated, leaving the block to the caller
+static inline int _tgalloc_epoch_defer(tga_epoch_t * self, void * backend, tga_free_fn free_fn, void * ptr,
+                                       size_t alignment, size_t size){
+    if (ptr == NULL) return 1;
+    _tgalloc_epoch_batch * ready = NULL;
+    _tgalloc_mutex_lock(&self->lock);
+    _tgalloc_epoch_batch * batch = self->open;
+    if (batch == NULL) {
+        batch = self->spare;
+        if (batch) {
+            self->spare = NULL;
+        } else {
+            batch = (_tgalloc_epoch_batch*)self->upstream.alloc_a_s(self->upstream.self, _tgalloc_alignof(batch),
+                                                                   sizeof(*batch));
+            if (batch == NULL) {
+                _tgalloc_mutex_unlock(&self->lock);
+                return 0;
+            }
+        }
+        batch->count = 0;
+        self->open = batch;
+    }
+    _tgalloc_epoch_item * item = &batch->items[batch->count++];
+    item->ptr = ptr;
+    item->alignment = alignment;
+    item->size = size;
+    item->self = backend;
+    item->free_a_s = free_fn;
+    // Readers arriving at a quiescent point from now on see a later epoch
+    batch->epoch = _tgalloc_atomic_fetch_add(&self->epoch, 1, _TGALLOC_ACQ_REL);
+    self->pending++;
+    if (batch->count == TGA_EPOCH_BATCH) {
+        _tgalloc_epoch_seal(self);
+        ready = _tgalloc_epoch_collect(self);
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+    _tgalloc_epoch_release(self, ready);
+    return 1;
+}
+
+/**
+ * @brief Free everything still queued and the domain's own memory
+ *
+ * No reader may hold references into the protected structures any more,
+ * and no thread may use the domain during or after this call.
+ *
+ * @param self Domain to destroy
+ */
+static inline void tga_epoch_destroy(tga_epoch_t * self){
+    _tgalloc_epoch_seal(self);
+    _tgalloc_epoch_batch * sealed = self->sealed;
+    self->sealed = self->sealed_tail = NULL;
+    _tgalloc_epoch_release(self, sealed);
+    _tgalloc_epoch_batch * batch = self->spare;
+    if (batch) self->upstream.free_a_s(self->upstream.self, batch, _tgalloc_alignof(batch), sizeof(*batch));
+    batch = self->open;  // Left open only when empty
+    if (batch) self->upstream.free_a_s(self->upstream.self, batch, _tgalloc_alignof(batch), sizeof(*batch));
+    _tgalloc_mutex_destroy(&self->lock);
+    memset(self, 0, sizeof(*self));
+}
+
+/**
+ * @brief Register the calling thread as a reader, starting online
+ *
+ * @param self   Domain whose structures the thread reads
+ * @param reader State of the reader, owned by the thread until tga_epoch_unregister
+ */
+static inline void tga_epoch_register(tga_epoch_t * self, tga_epoch_reader_t * reader){
+    reader->domain = self;
+    _tgalloc_mutex_lock(&self->lock);
+    _tgalloc_atomic_store(&reader->seen, _tgalloc_atomic_load(&self->epoch, _TGALLOC_RELAXED), _TGALLOC_RELAXED);
+    reader->next = self->readers;
+    self->readers = reader;
+    _tgalloc_mutex_unlock(&self->lock);
+    _tgalloc_atomic_fence();
+}
+
+/**
+ * @brief Remove a reader from its domain; it must hold no references any more
+ */
+static inline void tga_epoch_unregister(tga_epoch_reader_t * reader){
+    tga_epoch_t * self = reader->domain;
+    _tgalloc_mutex_lock(&self->lock);
+    tga_epoch_reader_t ** link = &self->readers;
+    while (*link && *link != reader) link = &(*link)->next;
+    if (*link) *link = reader->next;
+    _tgalloc_mutex_unlock(&self->lock);
+    reader->domain = NULL;
+}
+
+/**
+ * @brief Declare that the reader holds no references into the protected structures
+ *
+ * Everything deferred before this call may be freed once every other reader
+ * has done the same.
+ */
+static inline void tga_epoch_quiescent(tga_epoch_reader_t * reader){
+    _tgalloc_atomic_fence();
+    _tgalloc_atomic_store(&reader->seen, _tgalloc_atomic_load(&reader->domain->epoch, _TGALLOC_RELAXED),
+                          _TGALLOC_RELEASE);
+    _tgalloc_atomic_fence();
+}
+
+/**
+ * @brief Stop holding reclamation up, e.g. before blocking; no references may be kept
+ */
+static inline void tga_epoch_offline(tga_epoch_reader_t * reader){
+    _tgalloc_atomic_fence();
+    _tgalloc_atomic_store(&reader->seen, (size_t)0, _TGALLOC_RELEASE);
+}
+
+/**
+ * @brief Resume reading after tga_epoch_offline
+ */
+static inline void tga_epoch_online(tga_epoch_reader_t * reader){
+    _tgalloc_atomic_store(&reader->seen, _tgalloc_atomic_load(&reader->domain->epoch, _TGALLOC_RELAXED),
+                          _TGALLOC_RELAXED);
+    _tgalloc_atomic_fence();
+}
+
+/**
+ * @brief Number of deferred frees not yet performed
+ */
+static inline size_t tga_epoch_pending(tga_epoch_t * self){
+    _tgalloc_mutex_lock(&self->lock);
+    size_t pending = self->pending;
+    _tgalloc_mutex_unlock(&self->lock);
+    return pending;
+}
+
+// Helpers for pfree_deferred: queue the arguments pfree would pass to TGA_FREE_A_S
+#define _tgalloc_pfree_deferred1(ptr) _tgalloc_epoch_defer(TGA_EPOCH, (void*)(TGA), (tga_free_fn)(TGA_FREE_A_S), \
+    (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr))
+#define _tgalloc_pfree_deferred2(ptr, len) _tgalloc_epoch_defer(TGA_EPOCH, (void*)(TGA), \
+    (tga_free_fn)(TGA_FREE_A_S), (void*)(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, len))
+
+/**
+ * @brief Free like pfree, once no reader of the TGA_EPOCH domain can reach the memory
+ *
+ * The block must already be unreachable for readers arriving from now on.
+ * The backend TGA selects here is the one it is freed to.
+ *
+ * @param ptr Pointer to the memory to free
+ * @param ... Optional length parameter for array allocations
+ * @return Non-zero if queued; 0 if the queue could not grow, and the block is still the caller's
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202000L
+    #define pfree_deferred(ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_pfree_deferred2, \
+        _tgalloc_pfree_deferred1)(ptr __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define pfree_deferred(...) _tgalloc_palloc_arg3(__VA_ARGS__, _tgalloc_pfree_deferred2, \
+        _tgalloc_pfree_deferred1)(__VA_ARGS__)
+#endif
+
+#endif // TGALLOC_EPOCH_H
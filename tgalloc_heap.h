@@ -0,0 +1,85 @@
+#ifndef TGALLOC_HEAP_H
+#define TGALLOC_HEAP_H
+
+/**
+ * @file tgalloc_heap.h
+ * @brief JSON export of heap walks and heap reports
+ *
+ * The bundled backends describe their memory through two functions each:
+ * - tga_<backend>_walk(self, visit, ctx) calls visit on every chunk or page
+ *   with its size and its used and free bytes (arena, slab, region)
+ * - tga_<backend>_report(self, &report) sums the chunks into a
+ *   tga_heap_report_t and adds the occupancy of every size class (arena,
+ *   slab, region, large)
+ *
+ * This header writes both as JSON, one object per line, so that reports
+ * taken periodically from a long-running process can be appended to a log
+ * and compared later:
+ * @code
+ * tga_heap_report_t report;
+ * tga_slab_report(&slab, &report);
+ * tga_heap_report_json(log, "slab", &report);
+ * tga_slab_walk(&slab, tga_heap_chunk_json, log);
+ * @endcode
+ *
+ * Walks and reports read the backend's state without changing it, and must
+ * run on the thread that owns the backend; the large-object backend's
+ * report only reads counters and can run anywhere. Their cost is that of a
+ * trim: proportional to the pages for the slab and region, to the free
+ * blocks for the arena.
+ */
+
+#include <stdio.h>
+#include "tgalloc.h"
+
+/**
+ * @brief Share of the reserved bytes that are free but held by chunks still in use
+ *
+ * This is the memory a trim cannot return, the part of the resident set
+ * that fragmentation keeps above the live bytes.
+ *
+ * @param report Report to evaluate
+ * @return A ratio between 0 and 1, 0 for an empty report
+ */
+static inline double tga_heap_fragmentation(tga_heap_report_t const * report){
+    if (report->reserved_bytes == 0) return 0.0;
+    return (double)(report->free_bytes - report->releasable_bytes) / (double)report->reserved_bytes;
+}
+
+/**
+ * @brief Write a report as a single-line JSON object
+ *
+ * Size classes without any block are left out.
+ *
+ * @param out    Stream to write to
+ * @param name   Value of the "backend" field, e.g. "slab"
+ * @param report Report to write
+ */
+static inline void tga_heap_report_json(FILE * out, char const * name, tga_heap_report_t const * report){
+    fprintf(out, "{\"backend\":\"%s\",\"chunks\":%zu,\"reserved_bytes\":%zu,\"used_bytes\":%zu,"
+                 "\"free_bytes\":%zu,\"releasable_bytes\":%zu,\"fragmentation\":%.4f,\"classes\":[",
+            name, report->chunks, report->reserved_bytes, report->used_bytes, report->free_bytes,
+            report->releasable_bytes, tga_heap_fragmentation(report));
+    int first = 1;
+    for (size_t i = 0; i < report->class_count; i++) {
+        tga_heap_class_t const * cls = &report->classes[i];
+        if (cls->blocks == 0 && cls->free_blocks == 0) continue;
+        fprintf(out, "%s{\"block_size\":%zu,\"blocks\":%zu,\"free_blocks\":%zu}", first ? "" : ",",
+                cls->block_size, cls->blocks, cls->free_blocks);
+        first = 0;
+    }
+    fprintf(out, "]}\n");
+}
+
+/**
+ * @brief Heap walk visitor writing each chunk as a single-line JSON object
+ *
+ * @param out   The FILE* to write to, passed as the ctx of the walk
+ * @param chunk Chunk to write
+ */
+static inline void tga_heap_chunk_json(void * out, tga_heap_chunk_t const * chunk){
+    fprintf((FILE*)out, "{\"start\":\"%p\",\"size\":%zu,\"used_bytes\":%zu,\"free_bytes\":%zu,\"block_size\":%zu}\n",
+            chunk->start, chunk->size, chunk->used_bytes, chunk->free_bytes, chunk->block_size);
+}
+
+#endif // TGALLOC_HEAP_H
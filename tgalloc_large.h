@@ -0,0 +1,350 @@
+#ifndef TGALLOC_LARGE_H
+#define TGALLOC_LARGE_H
+
+/**
+ * @file tgalloc_large.h
+ * @brief Large-object backend that maps big blocks directly from the OS
+ *
+ * Requests of at least a threshold size are served by their own anonymous
+ * mapping; everything smaller goes to an upstream backend. Since tgalloc
+ * passes the exact size to every call, freeing unmaps precisely the pages
+ * that were mapped, with no header in front of the block.
+ *
+ * On Linux the mappings can use huge pages, either transparent huge pages
+ * requested with madvise(MADV_HUGEPAGE) or explicit MAP_HUGETLB pages, and
+ * they grow and shrink with mremap, so pprealloc of a large buffer moves
+ * page tables rather than copying bytes and pptry_expand grows in place
+ * when the address space behind the block is free. Elsewhere a growing
+ * block is copied into a new mapping.
+ *
+ * The backend itself only holds counters of its mappings, updated with
+ * relaxed atomics, so it is thread-safe whenever its upstream backend is.
+ *
+ * Usage:
+ * @code
+ * tga_large_t large;
+ * tga_large_init(&large);
+ *
+ * #define TGA (tga_large_t*)&large
+ * #define TGA_ALLOC_A_S tga_large_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_large_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_large_free_aligned_sized
+ * #define TGA_EXPAND_A_S tga_large_expand_aligned_sized
+ * #define TGA_CALLOC_A_S tga_large_calloc_aligned_sized
+ * @endcode
+ *
+ * MAP_ANONYMOUS, mremap and the huge page flags are only declared by the C
+ * library with _GNU_SOURCE (or _DEFAULT_SOURCE) defined; this header defines
+ * it on Linux, which takes effect when it is included before any system
+ * header. Features whose declarations are missing are not used.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #if defined(MAP_ANONYMOUS)
+        #define _TGALLOC_MAP_ANON MAP_ANONYMOUS
+    #elif defined(MAP_ANON)
+        #define _TGALLOC_MAP_ANON MAP_ANON
+    #else
+        #error "tgalloc_large.h needs MAP_ANONYMOUS: define _DEFAULT_SOURCE before including system headers"
+    #endif
+#endif
+
+/**
+ * @def TGA_LARGE_THRESHOLD
+ * @brief Default size from which requests get their own mapping
+ */
+#ifndef TGA_LARGE_THRESHOLD
+#define TGA_LARGE_THRESHOLD (2 * 1024 * 1024)
+#endif
+
+/**
+ * @def TGA_LARGE_HUGE_PAGE_SIZE
+ * @brief Size of a huge page, used to round and align huge page mappings
+ */
+#ifndef TGA_LARGE_HUGE_PAGE_SIZE
+#define TGA_LARGE_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+/**
+ * @brief Flags selecting the huge page policy of a large-object backend
+ *
+ * TGA_LARGE_THP aligns mappings of at least one huge page to the huge page
+ * size and asks for transparent huge pages. TGA_LARGE_HUGETLB asks for
+ * explicit huge pages, which must be reserved by the administrator; when
+ * none are available the mapping silently uses normal pages. Both are
+ * ignored where the system does not support them.
+ */
+enum {
+    TGA_LARGE_THP = 1,
+    TGA_LARGE_HUGETLB = 2
+};
+
+/**
+ * @struct tga_large_t
+ * @brief Configuration and mapping counters of a large-object backend
+ */
+typedef struct tga_large_t {
+    size_t threshold;    // Smallest request that gets its own mapping
+    size_t page_size;    // System page size, the alignment mappings guarantee
+    size_t granule;      // Mapping lengths are rounded up to a multiple of this
+    int flags;
+    tga_backend_t upstream;
+    size_t mappings;     // Counters for tga_large_report, updated atomically
+    size_t mapped_bytes;
+    size_t used_bytes;
+} tga_large_t;
+
+/**
+ * @brief Initialise a large-object backend
+ *
+ * @param self      Backend to initialise
+ * @param upstream  Backend for requests below the threshold
+ * @param threshold Smallest request size that gets its own mapping
+ * @param flags     Combination of TGA_LARGE_THP and TGA_LARGE_HUGETLB
+ */
+static inline void tga_large_init_with(tga_large_t * self, tga_backend_t upstream, size_t threshold, int flags){
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    self->page_size = info.dwPageSize;
+#else
+    self->page_size = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    self->threshold = threshold;
+    self->flags = flags;
+    self->granule = (flags & TGA_LARGE_HUGETLB) ? TGA_LARGE_HUGE_PAGE_SIZE : self->page_size;
+    self->upstream = upstream;
+    self->mappings = self->mapped_bytes = self->used_bytes = 0;
+}
+
+/**
+ * @brief Initialise a large-object backend with the default threshold,
+ * transparent huge pages and the malloc backend for smaller requests
+ *
+ * @param self Backend to initialise
+ */
+static inline void tga_large_init(tga_large_t * self){
+    tga_large_init_with(self, TGA_BACKEND_DEFAULT, TGA_LARGE_THRESHOLD, TGA_LARGE_THP);
+}
+
+// Whether a request is served by its own mapping. This only depends on the
+// alignment and size, so every call for a block takes the same path.
+static inline int _tgalloc_large_is_large(tga_large_t const * self, size_t alignment, size_t size){
+    return size >= self->threshold && alignment <= self->page_size;
+}
+
+// Length of the mapping that backs a block of the given size
+static inline size_t _tgalloc_large_length(tga_large_t const * self, size_t size){
+    return (size + self->granule - 1) / self->granule * self->granule;
+}
+
+// Map `length` bytes of fresh memory, honouring the huge page flags
+static inline void * _tgalloc_large_map(tga_large_t const * self, size_t length){
+#if defined(_WIN32)
+    (void)self;      // Mark as unused to prevent compiler warnings
+    return VirtualAlloc(NULL, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+   #if defined(MAP_HUGETLB)
+    if (self->flags & TGA_LARGE_HUGETLB) {
+        void * huge = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | _TGALLOC_MAP_ANON | MAP_HUGETLB, -1, 0);
+        if (huge != MAP_FAILED) return huge;
+    }
+   #endif
+   #if defined(MADV_HUGEPAGE)
+    if ((self->flags & TGA_LARGE_THP) && length >= TGA_LARGE_HUGE_PAGE_SIZE) {
+        // Over-map, then trim so the block starts on a huge page boundary
+        size_t padded = length + TGA_LARGE_HUGE_PAGE_SIZE;
+        char * raw = (char*)mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | _TGALLOC_MAP_ANON, -1, 0);
+        if (raw == MAP_FAILED) return NULL;
+        char * block = (char*)(((uintptr_t)raw + TGA_LARGE_HUGE_PAGE_SIZE - 1)
+                               & ~(uintptr_t)(TGA_LARGE_HUGE_PAGE_SIZE - 1));
+        if (block > raw) munmap(raw, (size_t)(block - raw));
+        if (raw + padded > block + length) munmap(block + length, (size_t)(raw + padded - (block + length)));
+        madvise(block, length, MADV_HUGEPAGE);
+        return block;
+    }
+   #endif
+    void * ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | _TGALLOC_MAP_ANON, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+#endif
+}
+
+// Account for mappings made, resized or removed; deltas wrap around for decrements
+static inline void _tgalloc_large_note(tga_large_t * self, size_t mappings, size_t mapped_bytes, size_t used_bytes){
+    _tgalloc_atomic_fetch_add(&self->mappings, mappings, _TGALLOC_RELAXED);
+    _tgalloc_atomic_fetch_add(&self->mapped_bytes, mapped_bytes, _TGALLOC_RELAXED);
+    _tgalloc_atomic_fetch_add(&self->used_bytes, used_bytes, _TGALLOC_RELAXED);
+}
+
+// Mapping that backs a new block of the given size
+static inline void * _tgalloc_large_map_block(tga_large_t * self, size_t size){
+    void * ptr = _tgalloc_large_map(self, _tgalloc_large_length(self, size));
+    if (ptr) _tgalloc_large_note(self, 1, _tgalloc_large_length(self, size), size);
+    return ptr;
+}
+
+static inline void _tgalloc_large_unmap(void * ptr, size_t length){
+#if defined(_WIN32)
+    (void)length;    // Mark as unused to prevent compiler warnings
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, length);
+#endif
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the large-object backend
+ */
+static inline void * tga_large_alloc_aligned_sized(tga_large_t * self, size_t alignment, size_t size){
+    if (!_tgalloc_large_is_large(self, alignment, size)) {
+        return self->upstream.alloc_a_s(self->upstream.self, alignment, size);
+    }
+    return _tgalloc_large_map_block(self, size);
+}
+
+/**
+ * @brief TGA_CALLOC_A_S implementation of the large-object backend
+ *
+ * Fresh mappings are already zero, so only blocks below the threshold are
+ * cleared, by the upstream backend's calloc or explicitly.
+ */
+static inline void * tga_large_calloc_aligned_sized(tga_large_t * self, size_t alignment, size_t size){
+    if (!_tgalloc_large_is_large(self, alignment, size)) {
+        return _tgalloc_calloc(self->upstream.self, _tgalloc_calloc_fallback(self->upstream.alloc_a_s),
+                               self->upstream.alloc_a_s, alignment, size);
+    }
+    return _tgalloc_large_map_block(self, size);
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the large-object backend
+ */
+static inline void tga_large_free_aligned_sized(tga_large_t * self, void const * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (!_tgalloc_large_is_large(self, alignment, size)) {
+        self->upstream.free_a_s(self->upstream.self, ptr, alignment, size);
+        return;
+    }
+    _tgalloc_large_unmap((void*)ptr, _tgalloc_large_length(self, size));
+    _tgalloc_large_note(self, (size_t)0 - 1, (size_t)0 - _tgalloc_large_length(self, size), (size_t)0 - size);
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the large-object backend
+ *
+ * Mapped blocks shrink by unmapping their tail and, on Linux, grow with
+ * mremap when the pages behind them are free. Blocks below the threshold
+ * are left to the upstream backend.
+ */
+static inline int tga_large_expand_aligned_sized(tga_large_t * self, void * ptr, size_t alignment,
+                                                 size_t old_size, size_t new_size){
+    if (ptr == NULL) return 0;
+    int old_large = _tgalloc_large_is_large(self, alignment, old_size);
+    int new_large = _tgalloc_large_is_large(self, alignment, new_size);
+    if (!old_large && !new_large) {
+        return _tgalloc_expand_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment,
+                                                                  old_size, new_size);
+    }
+    if (!old_large || !new_large) return 0;
+
+    size_t old_length = _tgalloc_large_length(self, old_size);
+    size_t new_length = _tgalloc_large_length(self, new_size);
+    int resized = new_length == old_length;
+#if !defined(_WIN32)
+    if (new_length < old_length) {
+        munmap((char*)ptr + new_length, old_length - new_length);
+        resized = 1;
+    }
+   #if defined(MREMAP_MAYMOVE)
+    else if (new_length > old_length) resized = mremap(ptr, old_length, new_length, 0) != MAP_FAILED;
+   #endif
+#endif
+    if (resized) _tgalloc_large_note(self, 0, new_length - old_length, new_size - old_size);
+    return resized;
+}
+
+/**
+ * @brief TGA_USABLE_SIZE_A_S implementation of the large-object backend
+ *
+ * Mapped blocks can hold their whole mapping; the upstream backend answers
+ * for blocks below the threshold.
+ */
+static inline size_t tga_large_usable_size_aligned_sized(tga_large_t * self, void const * ptr, size_t alignment,
+                                                         size_t size){
+    if (_tgalloc_large_is_large(self, alignment, size)) return _tgalloc_large_length(self, size);
+    return _tgalloc_usable_size_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment, size);
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the large-object backend
+ *
+ * Mapped blocks are resized in place when possible; on Linux a growing block
+ * that has to move is remapped instead of copied. Blocks crossing the
+ * threshold are copied between the two paths.
+ */
+static inline void * tga_large_realloc_aligned_sized(tga_large_t * self, void * ptr, size_t alignment,
+                                                     size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_large_alloc_aligned_sized(self, alignment, new_size);
+    int old_large = _tgalloc_large_is_large(self, alignment, old_size);
+    int new_large = _tgalloc_large_is_large(self, alignment, new_size);
+    if (!old_large && !new_large) {
+        return self->upstream.realloc_a_s(self->upstream.self, ptr, alignment, old_size, new_size);
+    }
+    if (old_large && new_large) {
+        if (tga_large_expand_aligned_sized(self, ptr, alignment, old_size, new_size)) return ptr;
+#if defined(MREMAP_MAYMOVE)
+        void * moved = mremap(ptr, _tgalloc_large_length(self, old_size), _tgalloc_large_length(self, new_size),
+                              MREMAP_MAYMOVE);
+        if (moved == MAP_FAILED) return NULL;
+        _tgalloc_large_note(self, 0, _tgalloc_large_length(self, new_size) - _tgalloc_large_length(self, old_size),
+                            new_size - old_size);
+    #if defined(MADV_HUGEPAGE)
+        if (self->flags & TGA_LARGE_THP) madvise(moved, _tgalloc_large_length(self, new_size), MADV_HUGEPAGE);
+    #endif
+        return moved;
+#endif
+    }
+    void * moved = tga_large_alloc_aligned_sized(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_large_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+/**
+ * @brief Summarise the mappings of the backend
+ *
+ * Mappings are not tracked individually, so there is no walk: the report
+ * holds their count and bytes, with the rounding up to whole pages as free
+ * bytes. Blocks passed to the upstream backend are not included. Safe to
+ * call while other threads allocate.
+ *
+ * @param self Backend to inspect
+ * @param out  Receives the report
+ * @return 1
+ */
+static inline int tga_large_report(tga_large_t * self, tga_heap_report_t * out){
+    memset(out, 0, sizeof(*out));
+    out->chunks = _tgalloc_atomic_load(&self->mappings, _TGALLOC_RELAXED);
+    out->reserved_bytes = _tgalloc_atomic_load(&self->mapped_bytes, _TGALLOC_RELAXED);
+    out->used_bytes = _tgalloc_atomic_load(&self->used_bytes, _TGALLOC_RELAXED);
+    out->free_bytes = out->reserved_bytes > out->used_bytes ? out->reserved_bytes - out->used_bytes : 0;
+    return 1;
+}
+
+#endif // TGALLOC_LARGE_H
@@ -0,0 +1,478 @@
+#ifndef TGALLOC_NUMA_H
+#define TGALLOC_NUMA_H
+
+/**
+ * @file tgalloc_numa.h
+ * @brief NUMA-aware backend with one arena per memory node
+ *
+ * Small blocks come from one size-class arena per NUMA node. Each arena
+ * carves its chunks from a slice of one address range reserved up front,
+ * and each slice is bound to its node once with mbind, so pages are
+ * placed on that node when first touched. A block's node is therefore its
+ * offset in the range divided by the slice size; no header or lookup is
+ * needed to free it into the right arena, whichever thread frees it.
+ * Requests between the arena classes and TGA_NUMA_LARGE_THRESHOLD are cut
+ * from the same slice, in coarser classes with a free list each per node.
+ * Large blocks get their own mapping through tgalloc_large.h and are bound
+ * to the node one by one. Only requests aligned beyond what the classes
+ * provide are passed to an upstream backend, and are not node-placed.
+ *
+ * By default a block is placed on the node of the CPU the caller runs on.
+ * palloc_on_node(p, n, node) asks for a specific node instead. A realloc
+ * that moves a block to another tier keeps it on the node it was on.
+ *
+ * The system calls are used directly, so there is no libnuma dependency.
+ * Elsewhere than on Linux the backend behaves as if there were one node,
+ * except on Windows where small-block chunks are committed on their node.
+ *
+ * The backend is thread-safe: each node's arena has its own lock, and large
+ * blocks are mapped without locking, so the upstream backend must be
+ * thread-safe itself.
+ *
+ * Usage:
+ * @code
+ * tga_numa_t numa;
+ * tga_numa_init(&numa);
+ *
+ * #define TGA (tga_numa_t*)&numa
+ * #define TGA_ALLOC_A_S tga_numa_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_numa_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_numa_free_aligned_sized
+ *
+ * double * local = NULL, * remote = NULL;
+ * palloc(local, 1024);             // on the caller's current node
+ * palloc_on_node(remote, 1024, 1); // on node 1
+ * @endcode
+ *
+ * Include this header before any system header, as for tgalloc_large.h.
+ */
+
+#include "tgalloc_large.h"
+#include "tgalloc_arena.h"
+#include "__tgalloc_sync.h"
+#include <stdio.h>
+
+#if defined(__linux__)
+    #include <sys/syscall.h>
+#endif
+
+/**
+ * @def TGA_NUMA_MAX_NODES
+ * @brief Largest number of nodes a backend distinguishes
+ */
+#ifndef TGA_NUMA_MAX_NODES
+#define TGA_NUMA_MAX_NODES 16
+#endif
+
+/**
+ * @def TGA_NUMA_NODE_SPAN
+ * @brief Address space reserved per node for small-block chunks
+ *
+ * Only reserved, not committed: pages are backed when first touched.
+ */
+#ifndef TGA_NUMA_NODE_SPAN
+#define TGA_NUMA_NODE_SPAN (sizeof(void*) >= 8 ? (size_t)1 << 34 : (size_t)1 << 26)
+#endif
+
+/**
+ * @def TGA_NUMA_LARGE_THRESHOLD
+ * @brief Smallest request that gets its own node-bound mapping
+ */
+#ifndef TGA_NUMA_LARGE_THRESHOLD
+#define TGA_NUMA_LARGE_THRESHOLD (64 * 1024)
+#endif
+
+// Alignment of the blocks of the medium classes
+#define _TGALLOC_NUMA_MID_ALIGN 64
+
+// Medium classes: four of 64 bytes up to 256, then four per power of two, enough for thresholds up to 4 GiB
+#define _TGALLOC_NUMA_MID_CLASSES (4 + 4 * 24)
+
+// A free medium block, linked into the list of its class
+typedef struct _tgalloc_numa_mid_block {
+    struct _tgalloc_numa_mid_block * next;
+} _tgalloc_numa_mid_block;
+
+// Per-node state: an arena, the free medium blocks and the unused part of the node's slice
+typedef struct _tgalloc_numa_node {
+    _tgalloc_mutex_t lock;          // Guards the arena, the medium lists and the slice
+    tga_arena_t arena;
+    _tgalloc_numa_mid_block * mid[_TGALLOC_NUMA_MID_CLASSES];
+    char * cursor;
+    char * limit;
+    size_t index;
+} _tgalloc_numa_node;
+
+/**
+ * @struct tga_numa_t
+ * @brief State of a NUMA-aware backend
+ */
+typedef struct tga_numa_t {
+    size_t node_count;
+    size_t span;                    // Bytes reserved per node
+    char * base;                    // Start of the reservation, node_count * span bytes
+    tga_large_t large;              // Blocks outside the arenas
+    _tgalloc_numa_node nodes[TGA_NUMA_MAX_NODES];
+} tga_numa_t;
+
+// Node requested for the next allocation by palloc_on_node, or -1
+static _tgalloc_thread_local long _tgalloc_numa_hint = -1;
+
+// Number of nodes the system has, capped at TGA_NUMA_MAX_NODES
+static inline size_t _tgalloc_numa_system_nodes(void){
+    size_t count = 1;
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest)) count = (size_t)highest + 1;
+#elif defined(__linux__)
+    // A list of ranges such as "0-1" or "0,2-3"; the last number is the highest node
+    FILE * file = fopen("/sys/devices/system/node/possible", "r");
+    if (file) {
+        unsigned long highest = 0, value = 0;
+        int c, digits = 0;
+        while ((c = fgetc(file)) != EOF) {
+            if (c >= '0' && c <= '9') {
+                value = value * 10 + (unsigned long)(c - '0');
+                digits = 1;
+            } else {
+                if (digits && value > highest) highest = value;
+                value = 0;
+                digits = 0;
+            }
+        }
+        if (digits && value > highest) highest = value;
+        fclose(file);
+        count = (size_t)highest + 1;
+    }
+#endif
+    return count < TGA_NUMA_MAX_NODES ? count : TGA_NUMA_MAX_NODES;
+}
+
+/**
+ * @brief Node of the CPU the calling thread currently runs on, or 0 if unknown
+ */
+static inline size_t tga_numa_current_node(void){
+#if defined(_WIN32)
+    PROCESSOR_NUMBER cpu;
+    USHORT node = 0;
+    GetCurrentProcessorNumberEx(&cpu);
+    return GetNumaProcessorNodeEx(&cpu, &node) ? node : 0;
+#elif defined(__linux__) && defined(SYS_getcpu)
+    unsigned node = 0;
+    return syscall(SYS_getcpu, NULL, &node, NULL) == 0 ? node : 0;
+#else
+    return 0;
+#endif
+}
+
+// Prefer `node` for future page faults in [addr, addr + length); best effort
+static inline void _tgalloc_numa_bind(void * addr, size_t length, size_t node){
+#if defined(__linux__) && defined(SYS_mbind)
+    enum { preferred = 1 };    // MPOL_PREFERRED: fall back to other nodes when full
+    unsigned long mask[(TGA_NUMA_MAX_NODES + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    (void)syscall(SYS_mbind, addr, length, preferred, mask, (unsigned long)(8 * sizeof(mask) + 1), 0);
+#else
+    (void)addr;      // Mark as unused to prevent compiler warnings
+    (void)length;    // Mark as unused to prevent compiler warnings
+    (void)node;      // Mark as unused to prevent compiler warnings
+#endif
+}
+
+// Chunk source of a node's arena, and of its medium blocks: the next piece of the node's slice.
+// Pieces are never returned individually; the reservation goes as a whole.
+static inline void * _tgalloc_numa_chunk_alloc(_tgalloc_numa_node * node, size_t alignment, size_t size){
+    (void)alignment; // Slices start on a page and pieces are multiples of _TGALLOC_NUMA_MID_ALIGN
+    size = (size + _TGALLOC_NUMA_MID_ALIGN - 1) / _TGALLOC_NUMA_MID_ALIGN * _TGALLOC_NUMA_MID_ALIGN;
+    if ((size_t)(node->limit - node->cursor) < size) return NULL;
+    void * chunk = node->cursor;
+#if defined(_WIN32)
+    if (!VirtualAllocExNuma(GetCurrentProcess(), chunk, size, MEM_COMMIT, PAGE_READWRITE, (DWORD)node->index)) {
+        return NULL;
+    }
+#endif
+    node->cursor += size;
+    return chunk;
+}
+
+static inline void * _tgalloc_numa_chunk_realloc(_tgalloc_numa_node * node, void * ptr, size_t alignment,
+                                                 size_t old_size, size_t new_size){
+    (void)node;      // Mark as unused to prevent compiler warnings
+    (void)ptr;       // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    (void)old_size;  // Mark as unused to prevent compiler warnings
+    (void)new_size;  // Mark as unused to prevent compiler warnings
+    return NULL;     // The arena only asks its upstream for chunks
+}
+
+static inline void _tgalloc_numa_chunk_free(_tgalloc_numa_node * node, void const * ptr, size_t alignment,
+                                            size_t size){
+    (void)node;      // Mark as unused to prevent compiler warnings
+    (void)ptr;       // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    (void)size;      // Mark as unused to prevent compiler warnings
+}
+
+/**
+ * @brief Initialise a NUMA-aware backend for a given number of nodes
+ *
+ * @param self       Backend to initialise
+ * @param upstream   Thread-safe backend for requests aligned beyond what the
+ *                   size classes and large mappings provide
+ * @param node_count Number of nodes, at most TGA_NUMA_MAX_NODES
+ * @return 0 on success, -1 if the address space could not be reserved
+ */
+static inline int tga_numa_init_with(tga_numa_t * self, tga_backend_t upstream, size_t node_count){
+    memset(self, 0, sizeof(*self));
+    if (node_count == 0) node_count = 1;
+    if (node_count > TGA_NUMA_MAX_NODES) node_count = TGA_NUMA_MAX_NODES;
+    self->node_count = node_count;
+    self->span = TGA_NUMA_NODE_SPAN;
+    tga_large_init_with(&self->large, upstream, TGA_NUMA_LARGE_THRESHOLD, TGA_LARGE_THP);
+
+#if defined(_WIN32)
+    self->base = (char*)VirtualAlloc(NULL, node_count * self->span, MEM_RESERVE, PAGE_NOACCESS);
+    if (self->base == NULL) return -1;
+#else
+   #if defined(MAP_NORESERVE)
+    int flags = MAP_PRIVATE | _TGALLOC_MAP_ANON | MAP_NORESERVE;
+   #else
+    int flags = MAP_PRIVATE | _TGALLOC_MAP_ANON;
+   #endif
+    void * base = mmap(NULL, node_count * self->span, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED) return -1;
+    self->base = (char*)base;
+#endif
+
+    for (size_t i = 0; i < node_count; i++) {
+        _tgalloc_numa_node * node = &self->nodes[i];
+        node->index = i;
+        node->cursor = self->base + i * self->span;
+        node->limit = node->cursor + self->span;
+        _tgalloc_numa_bind(node->cursor, self->span, i);
+        _tgalloc_mutex_init(&node->lock);
+        tga_arena_init_with(&node->arena, TGA_BACKEND(node, _tgalloc_numa_chunk_alloc,
+                                                      _tgalloc_numa_chunk_realloc, _tgalloc_numa_chunk_free));
+    }
+    return 0;
+}
+
+/**
+ * @brief Initialise a NUMA-aware backend for the nodes of this system, on
+ * top of the malloc backend
+ *
+ * @param self Backend to initialise
+ * @return 0 on success, -1 if the address space could not be reserved
+ */
+static inline int tga_numa_init(tga_numa_t * self){
+    return tga_numa_init_with(self, TGA_BACKEND_DEFAULT, _tgalloc_numa_system_nodes());
+}
+
+/**
+ * @brief Release the reservation of a NUMA-aware backend
+ *
+ * All small blocks become invalid. Other blocks are not tracked and must be
+ * freed individually beforehand. No other thread may use the backend during
+ * or after this call.
+ *
+ * @param self Backend to destroy
+ */
+static inline void tga_numa_destroy(tga_numa_t * self){
+    for (size_t i = 0; i < self->node_count; i++) _tgalloc_mutex_destroy(&self->nodes[i].lock);
+#if defined(_WIN32)
+    VirtualFree(self->base, 0, MEM_RELEASE);
+#else
+    munmap(self->base, self->node_count * self->span);
+#endif
+    self->base = NULL;
+    self->node_count = 0;
+}
+
+/**
+ * @brief Node whose slice holds a small or medium block, or -1 for any other block
+ *
+ * @param self Backend the block was allocated from
+ * @param ptr  Block to look up
+ */
+static inline long tga_numa_node_of(tga_numa_t const * self, void const * ptr){
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)self->base;
+    if ((uintptr_t)ptr < (uintptr_t)self->base || offset >= self->node_count * self->span) return -1;
+    return (long)(offset / self->span);
+}
+
+// Node whose arena holds a small block
+static inline _tgalloc_numa_node * _tgalloc_numa_owner(tga_numa_t * self, void const * ptr){
+    return &self->nodes[((uintptr_t)ptr - (uintptr_t)self->base) / self->span];
+}
+
+// Node for an allocation: the palloc_on_node hint, else the current node
+static inline _tgalloc_numa_node * _tgalloc_numa_pick(tga_numa_t * self){
+    long hint = _tgalloc_numa_hint;
+    size_t node = hint >= 0 ? (size_t)hint : tga_numa_current_node();
+    _tgalloc_numa_hint = -1;
+    return &self->nodes[node % self->node_count];
+}
+
+// Node a block was placed on: from its offset in the reservation, else from the policy of its
+// mapping; the current node when neither tells, as for blocks from upstream
+static inline size_t _tgalloc_numa_node_at(tga_numa_t const * self, void const * ptr){
+    long node = tga_numa_node_of(self, ptr);
+    if (node >= 0) return (size_t)node;
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    enum { address = 2 };      // MPOL_F_ADDR: the policy of the mapping holding the address
+    size_t bits = 8 * sizeof(unsigned long);
+    unsigned long mask[(TGA_NUMA_MAX_NODES + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))] = {0};
+    int mode = 0;
+    if (syscall(SYS_get_mempolicy, &mode, mask, (unsigned long)(8 * sizeof(mask)), ptr, address) == 0) {
+        for (size_t i = 0; i < self->node_count; i++) {
+            if ((mask[i / bits] >> (i % bits)) & 1) return i;
+        }
+    }
+#endif
+    return tga_numa_current_node();
+}
+
+// Whether a request that is not small is served by the medium classes
+static inline int _tgalloc_numa_is_mid(size_t alignment, size_t size){
+    return size < TGA_NUMA_LARGE_THRESHOLD && alignment <= _TGALLOC_NUMA_MID_ALIGN;
+}
+
+// Medium class of a request
+static inline size_t _tgalloc_numa_mid_class(size_t size){
+    if (size <= 4 * _TGALLOC_NUMA_MID_ALIGN) return size ? (size - 1) / _TGALLOC_NUMA_MID_ALIGN : 0;
+    size_t group = 0;
+    while ((size - 1) >> (9 + group)) group++;
+    size_t step = (size_t)_TGALLOC_NUMA_MID_ALIGN << group;
+    return 4 + 4 * group + (size - ((size_t)256 << group) + step - 1) / step - 1;
+}
+
+// Byte size of the blocks of a medium class
+static inline size_t _tgalloc_numa_mid_class_size(size_t cls){
+    if (cls < 4) return (cls + 1) * _TGALLOC_NUMA_MID_ALIGN;
+    return (5 + (cls - 4) % 4) * ((size_t)_TGALLOC_NUMA_MID_ALIGN << ((cls - 4) / 4));
+}
+
+// Take a medium block from the node's list of its class, or cut one from the slice; the node must be locked
+static inline void * _tgalloc_numa_mid_alloc(_tgalloc_numa_node * node, size_t cls){
+    _tgalloc_numa_mid_block * block = node->mid[cls];
+    if (block) {
+        node->mid[cls] = block->next;
+        return block;
+    }
+    return _tgalloc_numa_chunk_alloc(node, _TGALLOC_NUMA_MID_ALIGN, _tgalloc_numa_mid_class_size(cls));
+}
+
+// Set the node for the next allocation and pass the backend instance through with its type
+#define _tgalloc_numa_on_node(self, node) (_tgalloc_numa_hint = (long)(node), (self))
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the NUMA-aware backend
+ */
+static inline void * tga_numa_alloc_aligned_sized(tga_numa_t * self, size_t alignment, size_t size){
+    _tgalloc_numa_node * node = _tgalloc_numa_pick(self);
+    if (_tgalloc_arena_is_small(alignment, size)) {
+        _tgalloc_mutex_lock(&node->lock);
+        void * ptr = tga_arena_alloc_aligned_sized(&node->arena, alignment, size);
+        _tgalloc_mutex_unlock(&node->lock);
+        return ptr;
+    }
+    if (_tgalloc_numa_is_mid(alignment, size)) {
+        _tgalloc_mutex_lock(&node->lock);
+        void * ptr = _tgalloc_numa_mid_alloc(node, _tgalloc_numa_mid_class(size));
+        _tgalloc_mutex_unlock(&node->lock);
+        return ptr;
+    }
+    void * ptr = tga_large_alloc_aligned_sized(&self->large, alignment, size);
+    if (ptr && _tgalloc_large_is_large(&self->large, alignment, size)) {
+        _tgalloc_numa_bind(ptr, _tgalloc_large_length(&self->large, size), node->index);
+    }
+    return ptr;
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the NUMA-aware backend
+ *
+ * Small and medium blocks return to the node they were placed on.
+ */
+static inline void tga_numa_free_aligned_sized(tga_numa_t * self, void const * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (_tgalloc_arena_is_small(alignment, size)) {
+        _tgalloc_numa_node * node = _tgalloc_numa_owner(self, ptr);
+        _tgalloc_mutex_lock(&node->lock);
+        tga_arena_free_aligned_sized(&node->arena, ptr, alignment, size);
+        _tgalloc_mutex_unlock(&node->lock);
+        return;
+    }
+    if (_tgalloc_numa_is_mid(alignment, size)) {
+        _tgalloc_numa_node * node = _tgalloc_numa_owner(self, ptr);
+        size_t cls = _tgalloc_numa_mid_class(size);
+        _tgalloc_numa_mid_block * block = (_tgalloc_numa_mid_block*)ptr;
+        _tgalloc_mutex_lock(&node->lock);
+        block->next = node->mid[cls];
+        node->mid[cls] = block;
+        _tgalloc_mutex_unlock(&node->lock);
+        return;
+    }
+    tga_large_free_aligned_sized(&self->large, ptr, alignment, size);
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the NUMA-aware backend
+ *
+ * Small blocks stay on their node, and so do medium blocks, which are
+ * moved only when their class changes. Large blocks are resized by the
+ * large object backend, whose mappings keep their binding when remapped.
+ * A block moved to another tier is placed on the node it was on.
+ */
+static inline void * tga_numa_realloc_aligned_sized(tga_numa_t * self, void * ptr, size_t alignment,
+                                                    size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_numa_alloc_aligned_sized(self, alignment, new_size);
+    int old_small = _tgalloc_arena_is_small(alignment, old_size);
+    int new_small = _tgalloc_arena_is_small(alignment, new_size);
+    if (old_small && new_small) {
+        _tgalloc_numa_node * node = _tgalloc_numa_owner(self, ptr);
+        _tgalloc_mutex_lock(&node->lock);
+        void * resized = tga_arena_realloc_aligned_sized(&node->arena, ptr, alignment, old_size, new_size);
+        _tgalloc_mutex_unlock(&node->lock);
+        return resized;
+    }
+    int old_mid = !old_small && _tgalloc_numa_is_mid(alignment, old_size);
+    int new_mid = !new_small && _tgalloc_numa_is_mid(alignment, new_size);
+    if (old_mid && new_mid && _tgalloc_numa_mid_class(old_size) == _tgalloc_numa_mid_class(new_size)) return ptr;
+    if (!old_small && !new_small && !old_mid && !new_mid && _tgalloc_large_is_large(&self->large, alignment, old_size)
+        == _tgalloc_large_is_large(&self->large, alignment, new_size)) {
+        return tga_large_realloc_aligned_sized(&self->large, ptr, alignment, old_size, new_size);
+    }
+    // Changing class or tier: place the new block on the node of the old one
+    void * moved = tga_numa_alloc_aligned_sized(_tgalloc_numa_on_node(self, _tgalloc_numa_node_at(self, ptr)),
+                                                alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_numa_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+/**
+ * @brief Allocate an array on a given NUMA node
+ *
+ * Like palloc(ptr, len), but the memory is placed on `node` rather than
+ * the caller's current node. Only valid while the NUMA-aware backend is the
+ * active TGA, or the backend a tga_check_t active as TGA wraps: the node is
+ * taken by the next allocation of the NUMA-aware backend, so it passes
+ * through the checker. Node numbers wrap around the backend's node count.
+ *
+ * @param ptr  Pointer that will receive the allocated memory
+ * @param len  Number of elements
+ * @param node Node to place the memory on
+ * @return The assigned pointer (for chaining operations)
+ */
+#define palloc_on_node(ptr, len, node) \
+    ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_call_alloc(TGA_ALLOC_A_S, _tgalloc_numa_on_node(_tgalloc_tga(_tgalloc_sizeof(ptr)), node), \
+    _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof_n(ptr, len)))
+
+/**
+ * @brief Allocate an array on a given NUMA node through a pointer to pointer
+ */
+#define ppalloc_on_node(pptr, len, node) palloc_on_node(*(pptr), len, node)
+
+#endif // TGALLOC_NUMA_H
@@ -0,0 +1,213 @@
+#ifndef TGALLOC_OOM_H
+#define TGALLOC_OOM_H
+
+/**
+ * @file tgalloc_oom.h
+ * @brief Out-of-memory handler, emergency reserve and allocations that cannot fail
+ *
+ * Defining TGA_OOM before including tgalloc.h makes palloc, pcalloc and
+ * pprealloc react to a failed allocation instead of handing NULL straight
+ * back. The handler installed with tga_oom_set_handler runs first, so that
+ * shedding caches under memory pressure happens in one place rather than at
+ * every call site. If it reports that it released nothing, the emergency
+ * reserve set aside with tga_oom_reserve is given back to malloc. When
+ * either freed something, the allocation is retried once; only if that
+ * fails too does the caller see NULL.
+ *
+ * palloc_or_die and pprealloc_or_die do the same whether or not TGA_OOM is
+ * defined, and abort with a message when the retry fails as well. They
+ * never return NULL, so hot code needs no null branch; the failure path is
+ * kept out of line.
+ *
+ * The handler, the reserve and the failure count are shared by all
+ * translation units and threads of a program. The handler runs on the thread
+ * whose allocation failed, and an allocation failing inside the handler
+ * does not run it again. The reserve comes from malloc, so it helps the
+ * default backend and every backend drawing from it.
+ *
+ * Usage:
+ * @code
+ * #define TGA_OOM
+ * #include "tgalloc_oom.h"
+ *
+ * int shed_caches(void * ctx, size_t alignment, size_t size){
+ *     return cache_evict_all((cache_t*)ctx) > 0;   // non-zero: worth a retry
+ * }
+ *
+ * tga_oom_set_handler(shed_caches, &cache);
+ * tga_oom_reserve(4 << 20);
+ *
+ * Node * node = NULL;
+ * palloc_or_die(node);          // never NULL
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define _tgalloc_likely(x) __builtin_expect(!!(x), 1)
+    #define _TGALLOC_COLD __attribute__((cold))
+    #define _TGALLOC_NORETURN __attribute__((noreturn))
+#elif defined(_MSC_VER)
+    #define _tgalloc_likely(x) (x)
+    #define _TGALLOC_COLD
+    #define _TGALLOC_NORETURN __declspec(noreturn)
+#else
+    #define _tgalloc_likely(x) (x)
+    #define _TGALLOC_COLD
+    #define _TGALLOC_NORETURN
+#endif
+
+/**
+ * @typedef tga_oom_handler_fn
+ * @brief Function run when an allocation fails
+ *
+ * @param ctx       Context given to tga_oom_set_handler
+ * @param alignment Alignment of the failed request
+ * @param size      Size of the failed request in bytes
+ * @return Non-zero if it released memory and the allocation should be retried
+ */
+typedef int (*tga_oom_handler_fn)(void * ctx, size_t alignment, size_t size);
+
+// Process-wide state, shared by every translation unit
+typedef struct _tgalloc_oom_state {
+    tga_oom_handler_fn handler;
+    void * ctx;
+    void * reserve;
+    size_t reserve_size;
+    size_t failures;
+} _tgalloc_oom_state;
+
+_TGALLOC_WEAK _tgalloc_oom_state _tgalloc_oom_global = {0};
+
+// Set while the handler runs on this thread, so that it is not re-entered from any translation unit
+_TGALLOC_WEAK _tgalloc_thread_local int _tgalloc_oom_in_handler;
+
+// Result of the first attempt, held while deciding whether to retry
+static _tgalloc_thread_local void * _tgalloc_oom_result;
+
+/**
+ * @brief Install the function run when an allocation fails
+ *
+ * @param handler Function to run, or NULL to only use the emergency reserve
+ * @param ctx     Passed to every call of the handler
+ */
+static inline void tga_oom_set_handler(tga_oom_handler_fn handler, void * ctx){
+    _tgalloc_atomic_store(&_tgalloc_oom_global.ctx, ctx, _TGALLOC_RELAXED);
+    _tgalloc_atomic_store(&_tgalloc_oom_global.handler, handler, _TGALLOC_RELEASE);
+}
+
+/**
+ * @brief Set aside memory to give back when an allocation fails
+ *
+ * The pages are touched so the memory is really committed. A reserve that is
+ * still held is replaced. Call it again to re-arm the reserve once memory
+ * pressure is over.
+ *
+ * @param size Bytes to set aside, or 0 to drop the reserve
+ * @return 0 on success, -1 if the reserve could not be allocated
+ */
+static inline int tga_oom_reserve(size_t size){
+    void * reserve = NULL;
+    if (size) {
+        reserve = malloc(size);
+        if (reserve == NULL) return -1;
+        memset(reserve, 0xa5, size);
+    }
+    _tgalloc_atomic_store(&_tgalloc_oom_global.reserve_size, size, _TGALLOC_RELAXED);
+    free(_tgalloc_atomic_exchange(&_tgalloc_oom_global.reserve, reserve, _TGALLOC_ACQ_REL));
+    return 0;
+}
+
+/**
+ * @brief Bytes still held in the emergency reserve; 0 once it has been used
+ */
+static inline size_t tga_oom_reserve_size(void){
+    return _tgalloc_atomic_load(&_tgalloc_oom_global.reserve, _TGALLOC_ACQUIRE)
+           ? _tgalloc_atomic_load(&_tgalloc_oom_global.reserve_size, _TGALLOC_RELAXED) : 0;
+}
+
+/**
+ * @brief Number of allocations that have failed so far, retried or not
+ */
+static inline size_t tga_oom_failures(void){
+    return _tgalloc_atomic_load(&_tgalloc_oom_global.failures, _TGALLOC_RELAXED);
+}
+
+// Try to free memory after a failed request; non-zero if a retry is worthwhile
+static inline _TGALLOC_COLD int _tgalloc_oom_recover(size_t alignment, size_t size){
+    // A NULL for 0 bytes is not a failure, and realloc to 0 may have freed the block
+    if (size == 0 || _tgalloc_oom_in_handler) return 0;
+    _tgalloc_atomic_fetch_add(&_tgalloc_oom_global.failures, 1, _TGALLOC_RELAXED);
+    tga_oom_handler_fn handler = _tgalloc_atomic_load(&_tgalloc_oom_global.handler, _TGALLOC_ACQUIRE);
+    if (handler) {
+        // The handler's own allocations go through the same result slot, and the failed one must not see them
+        void * failed = _tgalloc_oom_result;
+        _tgalloc_oom_in_handler = 1;
+        int released = handler(_tgalloc_atomic_load(&_tgalloc_oom_global.ctx, _TGALLOC_RELAXED), alignment, size);
+        _tgalloc_oom_in_handler = 0;
+        _tgalloc_oom_result = failed;
+        if (released) return 1;
+    }
+    void * reserve = _tgalloc_atomic_exchange(&_tgalloc_oom_global.reserve, (void*)NULL, _TGALLOC_ACQ_REL);
+    if (reserve == NULL) return 0;
+    free(reserve);
+    return 1;
+}
+
+static inline _TGALLOC_COLD _TGALLOC_NORETURN void _tgalloc_oom_die(size_t alignment, size_t size){
+    fprintf(stderr, "tgalloc: out of memory allocating %lu bytes aligned to %lu\n",
+            (unsigned long)size, (unsigned long)alignment);
+    abort();
+}
+
+// The result of an allocation that must not fail
+static inline void * _tgalloc_or_die(void * ptr, size_t alignment, size_t size){
+    if (_tgalloc_likely(ptr != NULL || size == 0)) return ptr;
+    _tgalloc_oom_die(alignment, size);
+}
+
+// Evaluate an allocation, and once more after a successful recovery
+#define _tgalloc_retry_always(call, alignment, size) \
+    (_tgalloc_likely((_tgalloc_oom_result = (void*)(call)) != NULL) || !_tgalloc_oom_recover(alignment, size) \
+     ? _tgalloc_oom_result : (void*)(call))
+
+#define _tgalloc_palloc_or_die1(ptr) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_or_die(_tgalloc_retry_always( \
+    _tgalloc_alloc1(ptr), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr)), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr)))
+#define _tgalloc_palloc_or_die2(ptr, len) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_or_die(_tgalloc_retry_always( \
+    _tgalloc_alloc2(ptr, len), _tgalloc_alignof(ptr), _tgalloc_sizeof_n(ptr, len)), _tgalloc_alignof(ptr), \
+    _tgalloc_sizeof_n(ptr, len)))
+
+/**
+ * @brief Allocate like palloc, aborting instead of returning NULL
+ *
+ * On failure the handler and the emergency reserve get their chance and the
+ * allocation is retried once, even without TGA_OOM.
+ *
+ * @param ptr Pointer that will receive the allocated memory
+ * @param ... Optional length parameter for array allocations
+ * @return The assigned pointer, never NULL
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202000L
+    #define palloc_or_die(ptr, ...) _tgalloc_palloc_arg2(__VA_ARGS__ __VA_OPT__(,) _tgalloc_palloc_or_die2, \
+        _tgalloc_palloc_or_die1)(ptr __VA_OPT__(,) __VA_ARGS__)
+#else
+    #define palloc_or_die(...) _tgalloc_palloc_arg3(__VA_ARGS__, _tgalloc_palloc_or_die2, \
+        _tgalloc_palloc_or_die1)(__VA_ARGS__)
+#endif
+
+/**
+ * @brief Reallocate like pprealloc, aborting instead of returning NULL
+ *
+ * @param pptr    Pointer to pointer to the memory to reallocate
+ * @param old_len Current number of elements
+ * @param new_len New number of elements
+ */
+#define pprealloc_or_die(pptr, old_len, new_len) (*(pptr) = _tgalloc_or_die(_tgalloc_retry_always( \
+    _tgalloc_realloc_call(*(pptr), old_len, new_len), _tgalloc_alignof(*(pptr)), \
+    _tgalloc_sizeof_n(*(pptr), new_len)), _tgalloc_alignof(*(pptr)), _tgalloc_sizeof_n(*(pptr), new_len)))
+
+#endif // TGALLOC_OOM_H
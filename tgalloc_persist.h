@@ -0,0 +1,376 @@
+#ifndef TGALLOC_PERSIST_H
+#define TGALLOC_PERSIST_H
+
+/**
+ * @file tgalloc_persist.h
+ * @brief File-backed arena whose allocations survive a restart
+ *
+ * A tga_persist_t maps a file with MAP_SHARED and carves every allocation
+ * out of it. All allocator state lives in the file as well: a header with
+ * the bump cursor, a root pointer and one free list per size class, linked
+ * by file offsets. Opening the file again, in the same or a later process,
+ * brings back every block as it was left, so tables built with palloc can
+ * be reloaded with an mmap instead of being rebuilt.
+ *
+ * The file is mapped at the address it had before whenever that range is
+ * free, and raw pointers stored in the file stay valid. If the mapping
+ * lands elsewhere, tga_persist_t::relocated is set; data structures that
+ * must survive that store tga_poff_t offsets instead of pointers, converted
+ * with tga_persist_offset and tga_persist_pointer. TGA_PERSIST_FIXED makes
+ * opening fail rather than relocate.
+ *
+ * Sizes up to TGA_PERSIST_MAX_SMALL are rounded to TGA_PERSIST_QUANTUM,
+ * larger ones and larger alignments to a power of two. Freed blocks are
+ * reused for their class. The file is created sparse at full capacity, so
+ * only touched pages take disk space. Changes reach the file when the kernel
+ * writes back the pages, or on tga_persist_sync; there is no protection
+ * against a crash halfway through an update. A persistent arena is not
+ * thread-safe.
+ *
+ * Usage:
+ * @code
+ * tga_persist_t heap;
+ * if (tga_persist_open(&heap, "tables.heap", (size_t)1 << 30, NULL, TGA_PERSIST_CREATE) != 0) ...
+ *
+ * #define TGA (tga_persist_t*)&heap
+ * #define TGA_ALLOC_A_S tga_persist_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_persist_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_persist_free_aligned_sized
+ * #define TGA_EXPAND_A_S tga_persist_expand_aligned_sized
+ *
+ * Table * table = (Table*)tga_persist_get_root(&heap);
+ * if (table == NULL) {
+ *     palloc(table);
+ *     build(table);
+ *     tga_persist_set_root(&heap, table);
+ * }
+ * tga_persist_close(&heap);
+ * @endcode
+ *
+ * The file format is that of the machine that wrote it and is not portable
+ * between architectures.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include "tgalloc.h"
+
+#if defined(_WIN32)
+    #error "tgalloc_persist.h needs mmap and is not available on Windows"
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @def TGA_PERSIST_QUANTUM
+ * @brief Granularity of the small size classes, also the alignment they guarantee
+ */
+#ifndef TGA_PERSIST_QUANTUM
+#define TGA_PERSIST_QUANTUM 16
+#endif
+
+/**
+ * @def TGA_PERSIST_MAX_SMALL
+ * @brief Largest request rounded to TGA_PERSIST_QUANTUM rather than a power of two
+ */
+#ifndef TGA_PERSIST_MAX_SMALL
+#define TGA_PERSIST_MAX_SMALL 1024
+#endif
+
+// Largest alignment blocks can have; the data area starts on such a boundary
+#define _TGALLOC_PERSIST_PAGE 4096
+
+#define _TGALLOC_PERSIST_SMALL_CLASSES (TGA_PERSIST_MAX_SMALL / TGA_PERSIST_QUANTUM)
+// Power-of-two classes from 2^5 to 2^47 bytes
+#define _TGALLOC_PERSIST_MIN_SHIFT 5
+#define _TGALLOC_PERSIST_MAX_SHIFT 47
+#define _TGALLOC_PERSIST_CLASSES \
+    (_TGALLOC_PERSIST_SMALL_CLASSES + _TGALLOC_PERSIST_MAX_SHIFT - _TGALLOC_PERSIST_MIN_SHIFT + 1)
+
+#define _TGALLOC_PERSIST_MAGIC 0x3153524550414754ull  // "TGAPERS1" on little-endian machines
+#define _TGALLOC_PERSIST_VERSION 1
+
+/**
+ * @typedef tga_poff_t
+ * @brief Offset of a block in a persistent arena; 0 stands for NULL
+ */
+typedef uint64_t tga_poff_t;
+
+/**
+ * @enum tga_persist_flags_t
+ * @brief Options of tga_persist_open
+ */
+typedef enum tga_persist_flags_t {
+    TGA_PERSIST_CREATE = 1,  // Create the file if it does not exist
+    TGA_PERSIST_FIXED = 2    // Fail with EADDRINUSE instead of mapping at another address
+} tga_persist_flags_t;
+
+// Start of the file: everything needed to carry on allocating after a reopen
+typedef struct _tgalloc_persist_header {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t capacity;      // Size of the file and of the mapping
+    uint64_t base;          // Address the file was last mapped at
+    tga_poff_t cursor;      // First uncarved byte
+    tga_poff_t root;
+    tga_poff_t free_lists[_TGALLOC_PERSIST_CLASSES];
+} _tgalloc_persist_header;
+
+/**
+ * @struct tga_persist_t
+ * @brief An open persistent arena
+ */
+typedef struct tga_persist_t {
+    char * base;                      // Start of the mapping
+    _tgalloc_persist_header * header;
+    size_t capacity;
+    int fd;
+    int reopened;   // Whether the file already held an arena
+    int relocated;  // Whether it was mapped at a different address than last time
+} tga_persist_t;
+
+// Offset of the first block
+#define _tgalloc_persist_data_start \
+    ((sizeof(_tgalloc_persist_header) + _TGALLOC_PERSIST_PAGE - 1) / _TGALLOC_PERSIST_PAGE * _TGALLOC_PERSIST_PAGE)
+
+/**
+ * @brief Offset of a block of the arena, to store in place of a pointer
+ */
+static inline tga_poff_t tga_persist_offset(tga_persist_t const * self, void const * ptr){
+    return ptr ? (tga_poff_t)((char const*)ptr - self->base) : 0;
+}
+
+/**
+ * @brief Pointer to the block at a stored offset in the current mapping
+ */
+static inline void * tga_persist_pointer(tga_persist_t const * self, tga_poff_t offset){
+    return offset ? self->base + offset : NULL;
+}
+
+/**
+ * @brief The block last passed to tga_persist_set_root, or NULL in a fresh arena
+ */
+static inline void * tga_persist_get_root(tga_persist_t const * self){
+    return tga_persist_pointer(self, self->header->root);
+}
+
+/**
+ * @brief Remember a block as the entry point to find again after reopening
+ */
+static inline void tga_persist_set_root(tga_persist_t * self, void const * ptr){
+    self->header->root = tga_persist_offset(self, ptr);
+}
+
+/**
+ * @brief Whether ptr points into the arena's mapping
+ */
+static inline int tga_persist_owns(tga_persist_t const * self, void const * ptr){
+    return (char const*)ptr >= self->base && (char const*)ptr < self->base + self->capacity;
+}
+
+// Map the file at the wanted address if possible
+static inline char * _tgalloc_persist_map(int fd, size_t capacity, void * wanted, int fixed){
+    int flags = MAP_SHARED;
+#if defined(MAP_FIXED_NOREPLACE)
+    if (fixed && wanted) flags |= MAP_FIXED_NOREPLACE;
+#endif
+    void * addr = mmap(wanted, capacity, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (addr == MAP_FAILED) {
+        if (fixed && (errno == EEXIST || errno == EINVAL)) errno = EADDRINUSE;
+        return NULL;
+    }
+    if (fixed && wanted && addr != wanted) {
+        munmap(addr, capacity);
+        errno = EADDRINUSE;
+        return NULL;
+    }
+    return (char*)addr;
+}
+
+/**
+ * @brief Open a persistent arena, creating it if asked to
+ *
+ * @param self     Arena to open
+ * @param path     File holding the arena
+ * @param capacity Size of a new file; an existing file keeps its own
+ * @param base     Address to map a new file at, or NULL to let the system choose;
+ *                 an existing file is mapped where it was last time if possible
+ * @param flags    TGA_PERSIST_CREATE and TGA_PERSIST_FIXED
+ * @return 0 on success, -1 with errno set on failure
+ */
+static inline int tga_persist_open(tga_persist_t * self, char const * path, size_t capacity, void * base, int flags){
+    memset(self, 0, sizeof(*self));
+    self->fd = -1;
+    int fd = open(path, O_RDWR | ((flags & TGA_PERSIST_CREATE) ? O_CREAT : 0), 0644);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) goto fail;
+    _tgalloc_persist_header existing;
+    int reopened = st.st_size > 0;
+    if (reopened) {
+        if (pread(fd, &existing, sizeof(existing), 0) != (ssize_t)sizeof(existing)
+            || existing.magic != _TGALLOC_PERSIST_MAGIC || existing.version != _TGALLOC_PERSIST_VERSION
+            || (uint64_t)st.st_size < existing.capacity) {
+            errno = EINVAL;
+            goto fail;
+        }
+        capacity = (size_t)existing.capacity;
+        base = (void*)(uintptr_t)existing.base;
+    } else {
+        capacity = (capacity + _TGALLOC_PERSIST_PAGE - 1) / _TGALLOC_PERSIST_PAGE * _TGALLOC_PERSIST_PAGE;
+        if (capacity <= _tgalloc_persist_data_start) {
+            errno = EINVAL;
+            goto fail;
+        }
+        if (ftruncate(fd, (off_t)capacity) != 0) goto fail;
+    }
+
+    char * addr = _tgalloc_persist_map(fd, capacity, base, (flags & TGA_PERSIST_FIXED) != 0);
+    if (addr == NULL) goto fail;
+    self->base = addr;
+    self->header = (_tgalloc_persist_header*)addr;
+    self->capacity = capacity;
+    self->fd = fd;
+    self->reopened = reopened;
+    self->relocated = reopened && addr != (char*)base;
+    if (!reopened) {
+        self->header->magic = _TGALLOC_PERSIST_MAGIC;
+        self->header->version = _TGALLOC_PERSIST_VERSION;
+        self->header->capacity = capacity;
+        self->header->cursor = _tgalloc_persist_data_start;
+    }
+    self->header->base = (uint64_t)(uintptr_t)addr;
+    return 0;
+
+fail:
+    {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+    }
+    return -1;
+}
+
+/**
+ * @brief Flush the arena to its file
+ *
+ * @return 0 on success, -1 with errno set on failure
+ */
+static inline int tga_persist_sync(tga_persist_t * self){
+    return msync(self->base, self->capacity, MS_SYNC);
+}
+
+/**
+ * @brief Unmap and close the arena; its contents stay in the file
+ */
+static inline void tga_persist_close(tga_persist_t * self){
+    if (self->base) munmap(self->base, self->capacity);
+    if (self->fd >= 0) close(self->fd);
+    self->base = NULL;
+    self->header = NULL;
+    self->fd = -1;
+}
+
+// Class of a request; power-of-two classes also cover alignments above the quantum
+static inline size_t _tgalloc_persist_class(size_t alignment, size_t size){
+    if (size <= TGA_PERSIST_MAX_SMALL && alignment <= TGA_PERSIST_QUANTUM) {
+        return size ? (size - 1) / TGA_PERSIST_QUANTUM : 0;
+    }
+    size_t need = size > alignment ? size : alignment;
+    size_t shift = _TGALLOC_PERSIST_MIN_SHIFT;
+    while (shift < _TGALLOC_PERSIST_MAX_SHIFT && ((size_t)1 << shift) < need) shift++;
+    return _TGALLOC_PERSIST_SMALL_CLASSES + shift - _TGALLOC_PERSIST_MIN_SHIFT;
+}
+
+static inline size_t _tgalloc_persist_class_size(size_t cls){
+    if (cls < _TGALLOC_PERSIST_SMALL_CLASSES) return (cls + 1) * TGA_PERSIST_QUANTUM;
+    return (size_t)1 << (cls - _TGALLOC_PERSIST_SMALL_CLASSES + _TGALLOC_PERSIST_MIN_SHIFT);
+}
+
+// Whether the arena can serve a request at all
+#define _tgalloc_persist_fits(alignment, size) \
+    ((alignment) <= _TGALLOC_PERSIST_PAGE && (size) <= ((size_t)1 << _TGALLOC_PERSIST_MAX_SHIFT))
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the persistent arena
+ */
+static inline void * tga_persist_alloc_aligned_sized(tga_persist_t * self, size_t alignment, size_t size){
+    if (!_tgalloc_persist_fits(alignment, size)) return NULL;
+    size_t cls = _tgalloc_persist_class(alignment, size);
+    _tgalloc_persist_header * header = self->header;
+    if (header->free_lists[cls]) {
+        char * block = self->base + header->free_lists[cls];
+        memcpy(&header->free_lists[cls], block, sizeof(tga_poff_t));
+        return block;
+    }
+    size_t block_size = _tgalloc_persist_class_size(cls);
+    size_t block_align = block_size < _TGALLOC_PERSIST_PAGE ? block_size : _TGALLOC_PERSIST_PAGE;
+    if (cls < _TGALLOC_PERSIST_SMALL_CLASSES) block_align = TGA_PERSIST_QUANTUM;
+    tga_poff_t start = (header->cursor + block_align - 1) / block_align * block_align;
+    if (start > self->capacity || self->capacity - start < block_size) return NULL;
+    header->cursor = start + block_size;
+    return self->base + start;
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the persistent arena
+ */
+static inline void tga_persist_free_aligned_sized(tga_persist_t * self, void const * ptr, size_t alignment,
+                                                  size_t size){
+    if (ptr == NULL) return;
+    size_t cls = _tgalloc_persist_class(alignment, size);
+    memcpy((void*)ptr, &self->header->free_lists[cls], sizeof(tga_poff_t));
+    self->header->free_lists[cls] = tga_persist_offset(self, ptr);
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the persistent arena
+ *
+ * Succeeds within a size class.
+ */
+static inline int tga_persist_expand_aligned_sized(tga_persist_t * self, void * ptr, size_t alignment,
+                                                   size_t old_size, size_t new_size){
+    (void)self; // Mark as unused to prevent compiler warnings
+    if (ptr == NULL || !_tgalloc_persist_fits(alignment, new_size)) return 0;
+    return _tgalloc_persist_class(alignment, old_size) == _tgalloc_persist_class(alignment, new_size);
+}
+
+/**
+ * @brief TGA_USABLE_SIZE_A_S implementation of the persistent arena
+ *
+ * Every block can hold its whole size class.
+ */
+static inline size_t tga_persist_usable_size_aligned_sized(tga_persist_t * self, void const * ptr, size_t alignment,
+                                                           size_t size){
+    (void)self; // Mark as unused to prevent compiler warnings
+    (void)ptr;  // Mark as unused to prevent compiler warnings
+    if (!_tgalloc_persist_fits(alignment, size)) return size;
+    return _tgalloc_persist_class_size(_tgalloc_persist_class(alignment, size));
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the persistent arena
+ *
+ * Resizing within a size class returns the same block; every other case
+ * allocates, copies and frees.
+ */
+static inline void * tga_persist_realloc_aligned_sized(tga_persist_t * self, void * ptr, size_t alignment,
+                                                       size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_persist_alloc_aligned_sized(self, alignment, new_size);
+    if (tga_persist_expand_aligned_sized(self, ptr, alignment, old_size, new_size)) return ptr;
+    void * moved = tga_persist_alloc_aligned_sized(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_persist_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+#endif // TGALLOC_PERSIST_H
@@ -0,0 +1,220 @@
+#ifndef TGALLOC_POOL_H
+#define TGALLOC_POOL_H
+
+/**
+ * @file tgalloc_pool.h
+ * @brief Fixed-size object pools generated per type
+ *
+ * TGPOOL_DEFINE(T) generates a backend that stores objects of exactly one
+ * type T on a free list. The object size and alignment are compile-time
+ * constants of the generated functions, so once palloc and pfree are bound
+ * to a pool and inlined, there is no size-class lookup left: allocating
+ * pops the free list and freeing pushes onto it. Objects are carved from
+ * slabs obtained from an upstream backend; other sizes, such as arrays of
+ * T, are passed to the upstream backend unchanged.
+ *
+ * T must be a single identifier, such as a typedef name. A pool is not
+ * thread-safe.
+ *
+ * Usage:
+ * @code
+ * TGPOOL_DEFINE(Message)
+ *
+ * tgpool(Message) pool;
+ * tgpool_Message_init(&pool);
+ *
+ * #define TGA (tgpool(Message)*)&pool
+ * #define TGA_ALLOC_A_S tgpool_Message_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tgpool_Message_realloc_aligned_sized
+ * #define TGA_FREE_A_S tgpool_Message_free_aligned_sized
+ * #define TGA_EXPAND_A_S tgpool_Message_expand_aligned_sized
+ *
+ * Message * msg = NULL;
+ * palloc(msg);     // pops the free list
+ * pfree(msg);      // pushes it back
+ * @endcode
+ */
+
+#include <string.h>
+#include "tgalloc.h"
+
+/**
+ * @def TGA_POOL_SLAB_SIZE
+ * @brief Approximate number of bytes requested from upstream when a pool grows
+ */
+#ifndef TGA_POOL_SLAB_SIZE
+#define TGA_POOL_SLAB_SIZE (16 * 1024)
+#endif
+
+// Free objects are linked through their first bytes
+typedef struct _tgalloc_pool_node {
+    struct _tgalloc_pool_node * next;
+} _tgalloc_pool_node;
+
+// Slabs are linked so the pool can return them upstream
+typedef struct _tgalloc_pool_slab {
+    struct _tgalloc_pool_slab * next;
+    size_t size;  // Total byte size including this header
+} _tgalloc_pool_slab;
+
+// State shared by all generated pool types
+typedef struct _tgalloc_pool_state {
+    _tgalloc_pool_node * free_list;
+    _tgalloc_pool_slab * slabs;
+    tga_backend_t upstream;
+} _tgalloc_pool_state;
+
+// Alignment of pooled objects: the type's own, but at least a pointer's
+#define _tgalloc_pool_align(elem_align) \
+    ((elem_align) > _tgalloc_alignof_impl(_tgalloc_pool_node) ? (elem_align) : _tgalloc_alignof_impl(_tgalloc_pool_node))
+
+// Distance between pooled objects; every object must hold a free-list link
+#define _tgalloc_pool_stride(elem_size, elem_align) \
+    (((elem_size) > sizeof(_tgalloc_pool_node) ? (elem_size) : sizeof(_tgalloc_pool_node)) \
+     + _tgalloc_pool_align(elem_align) - 1) / _tgalloc_pool_align(elem_align) * _tgalloc_pool_align(elem_align)
+
+// Offset of the first object in a slab
+#define _tgalloc_pool_header(elem_align) \
+    ((sizeof(_tgalloc_pool_slab) + _tgalloc_pool_align(elem_align) - 1) \
+     / _tgalloc_pool_align(elem_align) * _tgalloc_pool_align(elem_align))
+
+static inline void _tgalloc_pool_init(_tgalloc_pool_state * pool, tga_backend_t upstream){
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    pool->upstream = upstream;
+}
+
+static inline void _tgalloc_pool_destroy(_tgalloc_pool_state * pool, size_t elem_align){
+    _tgalloc_pool_slab * slab = pool->slabs;
+    while (slab) {
+        _tgalloc_pool_slab * next = slab->next;
+        pool->upstream.free_a_s(pool->upstream.self, slab, _tgalloc_pool_align(elem_align), slab->size);
+        slab = next;
+    }
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+}
+
+// Slow path: carve a new slab, keep all but its first object on the free list
+static inline void * _tgalloc_pool_refill(_tgalloc_pool_state * pool, size_t elem_size, size_t elem_align){
+    size_t stride = _tgalloc_pool_stride(elem_size, elem_align);
+    size_t header = _tgalloc_pool_header(elem_align);
+    size_t count = TGA_POOL_SLAB_SIZE > header + stride ? (TGA_POOL_SLAB_SIZE - header) / stride : 1;
+    size_t slab_size = header + count * stride;
+    _tgalloc_pool_slab * slab = (_tgalloc_pool_slab*)pool->upstream.alloc_a_s(
+        pool->upstream.self, _tgalloc_pool_align(elem_align), slab_size);
+    if (slab == NULL) return NULL;
+    slab->size = slab_size;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    char * first = (char*)slab + header;
+    _tgalloc_pool_node * head = pool->free_list;
+    for (size_t i = count; i-- > 1;) {
+        _tgalloc_pool_node * node = (_tgalloc_pool_node*)(first + i * stride);
+        node->next = head;
+        head = node;
+    }
+    pool->free_list = head;
+    return first;
+}
+
+// Whether a request is one pooled object; constant-folded for palloc(p)
+#define _tgalloc_pool_owns(alignment, size, elem_size, elem_align) \
+    ((size) == (elem_size) && (alignment) <= (elem_align))
+
+static inline void * _tgalloc_pool_alloc(_tgalloc_pool_state * pool, size_t alignment, size_t size,
+                                         size_t elem_size, size_t elem_align){
+    if (!_tgalloc_pool_owns(alignment, size, elem_size, elem_align)) {
+        return pool->upstream.alloc_a_s(pool->upstream.self, alignment, size);
+    }
+    _tgalloc_pool_node * node = pool->free_list;
+    if (node) {
+        pool->free_list = node->next;
+        return node;
+    }
+    return _tgalloc_pool_refill(pool, elem_size, elem_align);
+}
+
+static inline void _tgalloc_pool_free(_tgalloc_pool_state * pool, void const * ptr, size_t alignment, size_t size,
+                                      size_t elem_size, size_t elem_align){
+    if (ptr == NULL) return;
+    if (!_tgalloc_pool_owns(alignment, size, elem_size, elem_align)) {
+        pool->upstream.free_a_s(pool->upstream.self, ptr, alignment, size);
+        return;
+    }
+    _tgalloc_pool_node * node = (_tgalloc_pool_node*)ptr;
+    node->next = pool->free_list;
+    pool->free_list = node;
+}
+
+static inline void * _tgalloc_pool_realloc(_tgalloc_pool_state * pool, void * ptr, size_t alignment,
+                                           size_t old_size, size_t new_size, size_t elem_size, size_t elem_align){
+    if (ptr == NULL) return _tgalloc_pool_alloc(pool, alignment, new_size, elem_size, elem_align);
+    int old_pooled = _tgalloc_pool_owns(alignment, old_size, elem_size, elem_align);
+    int new_pooled = _tgalloc_pool_owns(alignment, new_size, elem_size, elem_align);
+    if (old_pooled && new_pooled) return ptr;
+    if (!old_pooled && !new_pooled) {
+        return pool->upstream.realloc_a_s(pool->upstream.self, ptr, alignment, old_size, new_size);
+    }
+    void * moved = _tgalloc_pool_alloc(pool, alignment, new_size, elem_size, elem_align);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    _tgalloc_pool_free(pool, ptr, alignment, old_size, elem_size, elem_align);
+    return moved;
+}
+
+static inline int _tgalloc_pool_expand(_tgalloc_pool_state * pool, void * ptr, size_t alignment,
+                                       size_t old_size, size_t new_size, size_t elem_size, size_t elem_align){
+    if (ptr == NULL) return 0;
+    int old_pooled = _tgalloc_pool_owns(alignment, old_size, elem_size, elem_align);
+    int new_pooled = _tgalloc_pool_owns(alignment, new_size, elem_size, elem_align);
+    if (old_pooled || new_pooled) return old_pooled && new_pooled;
+    return _tgalloc_expand_fallback(pool->upstream.alloc_a_s)(pool->upstream.self, ptr, alignment,
+                                                              old_size, new_size);
+}
+
+/**
+ * @brief Name of the pool type generated for T by TGPOOL_DEFINE
+ */
+#define tgpool(T) tgpool_##T
+
+/**
+ * @brief Generate the pool type tgpool(T) and its backend functions
+ *
+ * Defines, for a type name T:
+ * - tgpool_T_init(pool) and tgpool_T_init_with(pool, upstream)
+ * - tgpool_T_destroy(pool), which returns all slabs upstream
+ * - tgpool_T_alloc_aligned_sized, _realloc_aligned_sized, _free_aligned_sized
+ *   and _expand_aligned_sized for use as TGA_*_A_S
+ */
+#define TGPOOL_DEFINE(T) \
+    typedef struct tgpool_##T { _tgalloc_pool_state state; } tgpool_##T; \
+    static inline void tgpool_##T##_init_with(tgpool_##T * self, tga_backend_t upstream){ \
+        _tgalloc_pool_init(&self->state, upstream); \
+    } \
+    static inline void tgpool_##T##_init(tgpool_##T * self){ \
+        _tgalloc_pool_init(&self->state, TGA_BACKEND_DEFAULT); \
+    } \
+    static inline void tgpool_##T##_destroy(tgpool_##T * self){ \
+        _tgalloc_pool_destroy(&self->state, _tgalloc_alignof_impl(T)); \
+    } \
+    static inline void * tgpool_##T##_alloc_aligned_sized(tgpool_##T * self, size_t alignment, size_t size){ \
+        return _tgalloc_pool_alloc(&self->state, alignment, size, sizeof(T), _tgalloc_alignof_impl(T)); \
+    } \
+    static inline void tgpool_##T##_free_aligned_sized(tgpool_##T * self, void const * ptr, size_t alignment, \
+                                                       size_t size){ \
+        _tgalloc_pool_free(&self->state, ptr, alignment, size, sizeof(T), _tgalloc_alignof_impl(T)); \
+    } \
+    static inline void * tgpool_##T##_realloc_aligned_sized(tgpool_##T * self, void * ptr, size_t alignment, \
+                                                            size_t old_size, size_t new_size){ \
+        return _tgalloc_pool_realloc(&self->state, ptr, alignment, old_size, new_size, \
+                                     sizeof(T), _tgalloc_alignof_impl(T)); \
+    } \
+    static inline int tgpool_##T##_expand_aligned_sized(tgpool_##T * self, void * ptr, size_t alignment, \
+                                                        size_t old_size, size_t new_size){ \
+        return _tgalloc_pool_expand(&self->state, ptr, alignment, old_size, new_size, \
+                                    sizeof(T), _tgalloc_alignof_impl(T)); \
+    }
+
+#endif // TGALLOC_POOL_H
@@ -0,0 +1,363 @@
+#ifndef TGALLOC_PROFILE_H
+#define TGALLOC_PROFILE_H
+
+/**
+ * @file tgalloc_profile.h
+ * @brief Per-call-site allocation profiling
+ *
+ * Defining TGA_PROFILE before including tgalloc.h makes every palloc,
+ * pfree, pprealloc, pptry_expand, palloc_many and pfree_many record its
+ * call site. Since these are macros, __FILE__ and __LINE__ name the line
+ * that used them, not a wrapper, and the sizeof and alignof of the pointee
+ * type come for free.
+ * Calls, bytes and the type are aggregated per site in a fixed-size table
+ * that is filled and updated without locks.
+ *
+ * tga_profile_dump_folded writes the table as folded stacks, the input
+ * format of flamegraph.pl, inferno and speedscope, so the sites that
+ * dominate bytes or calls can be read off a flame graph of a live process.
+ *
+ * Frees and reallocs are attributed to the site that performs them, not the
+ * site that allocated the block. TGA_PROFILE can be combined with TGA_STATS.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+/**
+ * @def TGA_PROFILE_SITES
+ * @brief Capacity of the call-site table; must be a power of two
+ *
+ * Sites beyond the capacity are not recorded but counted in
+ * tga_profile_dropped.
+ */
+#ifndef TGA_PROFILE_SITES
+#define TGA_PROFILE_SITES 1024
+#endif
+
+/**
+ * @struct tga_profile_site_t
+ * @brief Aggregated counters of one call site
+ */
+typedef struct tga_profile_site_t {
+    char const * file;
+    size_t line;
+    size_t type_size;       // sizeof of the pointee type at this site
+    size_t alignment;
+    size_t alloc_count;     // palloc and palloc_many objects
+    size_t alloc_bytes;
+    size_t realloc_count;
+    size_t realloc_bytes;   // Sum of the new sizes
+    size_t free_count;
+    size_t free_bytes;
+} tga_profile_site_t;
+
+// Number of consecutive counters starting at alloc_count
+#define _TGALLOC_PROFILE_COUNTERS 6
+
+/**
+ * @enum tga_profile_metric_t
+ * @brief Value reported per site by tga_profile_dump_folded
+ */
+typedef enum tga_profile_metric_t {
+    TGA_PROFILE_BYTES,  // Bytes requested by allocations and reallocs
+    TGA_PROFILE_CALLS   // Number of allocation, realloc and free calls
+} tga_profile_metric_t;
+
+// Slot states of the site table
+#define _TGALLOC_PROFILE_EMPTY 0
+#define _TGALLOC_PROFILE_CLAIMED 1
+#define _TGALLOC_PROFILE_READY 2
+
+typedef struct _tgalloc_profile_slot {
+    size_t state;
+    tga_profile_site_t site;
+} _tgalloc_profile_slot;
+
+typedef struct _tgalloc_profile_table {
+    _tgalloc_profile_slot slots[TGA_PROFILE_SITES];
+    size_t dropped;
+} _tgalloc_profile_table;
+
+_TGALLOC_WEAK _tgalloc_profile_table _tgalloc_profile_global = {0};
+
+// Find or insert the slot of a site. Sites are keyed by the address of the
+// __FILE__ literal, so a file seen from several translation units may own
+// several slots; the readers merge them.
+static inline tga_profile_site_t * _tgalloc_profile_site(char const * file, size_t line, size_t alignment,
+                                                         size_t type_size){
+    size_t hash = ((size_t)(uintptr_t)file >> 3) ^ (line * (size_t)2654435761u);
+    hash ^= hash >> 15;
+    for (size_t probe = 0; probe < TGA_PROFILE_SITES; probe++) {
+        _tgalloc_profile_slot * slot = &_tgalloc_profile_global.slots[(hash + probe) & (TGA_PROFILE_SITES - 1)];
+        size_t state = _tgalloc_atomic_load(&slot->state, _TGALLOC_ACQUIRE);
+        if (state == _TGALLOC_PROFILE_EMPTY) {
+            size_t expected = _TGALLOC_PROFILE_EMPTY;
+            if (_tgalloc_atomic_cas(&slot->state, &expected, _TGALLOC_PROFILE_CLAIMED, _TGALLOC_ACQ_REL)) {
+                slot->site.file = file;
+                slot->site.line = line;
+                slot->site.type_size = type_size;
+                slot->site.alignment = alignment;
+                _tgalloc_atomic_store(&slot->state, _TGALLOC_PROFILE_READY, _TGALLOC_RELEASE);
+                return &slot->site;
+            }
+            state = expected;
+        }
+        // Another thread is filling in the key; it only takes a few stores
+        while (state == _TGALLOC_PROFILE_CLAIMED) state = _tgalloc_atomic_load(&slot->state, _TGALLOC_ACQUIRE);
+        if (slot->site.file == file && slot->site.line == line) return &slot->site;
+    }
+    _tgalloc_atomic_fetch_add(&_tgalloc_profile_global.dropped, 1, _TGALLOC_RELAXED);
+    return NULL;
+}
+
+static inline void _tgalloc_profile_add(size_t * counter, size_t amount){
+    _tgalloc_atomic_fetch_add(counter, amount, _TGALLOC_RELAXED);
+}
+
+// Backend calls the profiling wrappers forward to: the TGA_STATS wrappers
+// when both layers are active, the plain calls otherwise
+#ifdef TGA_STATS
+    #define _tgalloc_profile_next_alloc _tgalloc_stats_alloc
+    #define _tgalloc_profile_next_calloc _tgalloc_stats_calloc
+    #define _tgalloc_profile_next_realloc _tgalloc_stats_realloc
+    #define _tgalloc_profile_next_free _tgalloc_stats_free
+    #define _tgalloc_profile_next_expand _tgalloc_stats_expand
+    #define _tgalloc_profile_next_alloc_batch _tgalloc_stats_alloc_batch
+    #define _tgalloc_profile_next_free_batch _tgalloc_stats_free_batch
+#else
+    static inline void * _tgalloc_profile_next_alloc(void * self, tga_alloc_fn alloc_fn, size_t alignment,
+                                                     size_t size){
+        return alloc_fn(self, alignment, size);
+    }
+    static inline void * _tgalloc_profile_next_calloc(void * self, tga_alloc_fn calloc_fn, tga_alloc_fn alloc_fn,
+                                                      size_t alignment, size_t size){
+        return _tgalloc_calloc(self, calloc_fn, alloc_fn, alignment, size);
+    }
+    static inline void * _tgalloc_profile_next_realloc(void * self, tga_realloc_fn realloc_fn, void * ptr,
+                                                       size_t alignment, size_t old_size, size_t new_size){
+        return realloc_fn(self, ptr, alignment, old_size, new_size);
+    }
+    static inline void _tgalloc_profile_next_free(void * self, tga_free_fn free_fn, void const * ptr,
+                                                  size_t alignment, size_t size){
+        free_fn(self, ptr, alignment, size);
+    }
+    static inline int _tgalloc_profile_next_expand(void * self, tga_expand_fn expand_fn, void * ptr,
+                                                   size_t alignment, size_t old_size, size_t new_size){
+        return expand_fn(self, ptr, alignment, old_size, new_size);
+    }
+    #define _tgalloc_profile_next_alloc_batch(done, alignment, size) (done)
+    #define _tgalloc_profile_next_free_batch(count, alignment, size) (count)
+#endif
+
+typedef void * (*_tgalloc_profile_next_alloc_fn)(void *, tga_alloc_fn, size_t, size_t);
+typedef void * (*_tgalloc_profile_next_calloc_fn)(void *, tga_alloc_fn, tga_alloc_fn, size_t, size_t);
+typedef void * (*_tgalloc_profile_next_realloc_fn)(void *, tga_realloc_fn, void *, size_t, size_t, size_t);
+typedef void (*_tgalloc_profile_next_free_fn)(void *, tga_free_fn, void const *, size_t, size_t);
+typedef int (*_tgalloc_profile_next_expand_fn)(void *, tga_expand_fn, void *, size_t, size_t, size_t);
+
+// Recording wrappers used by the palloc family when TGA_PROFILE is defined
+static inline void * _tgalloc_profile_alloc(char const * file, size_t line, _tgalloc_profile_next_alloc_fn next,
+                                            void * self, tga_alloc_fn alloc_fn, size_t alignment, size_t type_size,
+                                            size_t size){
+    void * ptr = next(self, alloc_fn, alignment, size);
+    tga_profile_site_t * site = ptr ? _tgalloc_profile_site(file, line, alignment, type_size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->alloc_count, 1);
+        _tgalloc_profile_add(&site->alloc_bytes, size);
+    }
+    return ptr;
+}
+
+// Zeroed allocations count as allocations of the site
+static inline void * _tgalloc_profile_calloc(char const * file, size_t line, _tgalloc_profile_next_calloc_fn next,
+                                             void * self, tga_alloc_fn calloc_fn, tga_alloc_fn alloc_fn,
+                                             size_t alignment, size_t type_size, size_t size){
+    void * ptr = next(self, calloc_fn, alloc_fn, alignment, size);
+    tga_profile_site_t * site = ptr ? _tgalloc_profile_site(file, line, alignment, type_size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->alloc_count, 1);
+        _tgalloc_profile_add(&site->alloc_bytes, size);
+    }
+    return ptr;
+}
+
+static inline void * _tgalloc_profile_realloc(char const * file, size_t line, _tgalloc_profile_next_realloc_fn next,
+                                              void * self, tga_realloc_fn realloc_fn, void * ptr, size_t alignment,
+                                              size_t type_size, size_t old_size, size_t new_size){
+    void * resized = next(self, realloc_fn, ptr, alignment, old_size, new_size);
+    tga_profile_site_t * site = resized ? _tgalloc_profile_site(file, line, alignment, type_size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->realloc_count, 1);
+        _tgalloc_profile_add(&site->realloc_bytes, new_size);
+    }
+    return resized;
+}
+
+// A successful in-place resize counts as a realloc of the site
+static inline int _tgalloc_profile_expand(char const * file, size_t line, _tgalloc_profile_next_expand_fn next,
+                                          void * self, tga_expand_fn expand_fn, void * ptr, size_t alignment,
+                                          size_t type_size, size_t old_size, size_t new_size){
+    int expanded = next(self, expand_fn, ptr, alignment, old_size, new_size);
+    tga_profile_site_t * site = expanded ? _tgalloc_profile_site(file, line, alignment, type_size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->realloc_count, 1);
+        _tgalloc_profile_add(&site->realloc_bytes, new_size);
+    }
+    return expanded;
+}
+
+static inline void _tgalloc_profile_free(char const * file, size_t line, _tgalloc_profile_next_free_fn next,
+                                         void * self, tga_free_fn free_fn, void const * ptr, size_t alignment,
+                                         size_t type_size, size_t size){
+    tga_profile_site_t * site = ptr ? _tgalloc_profile_site(file, line, alignment, type_size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->free_count, 1);
+        _tgalloc_profile_add(&site->free_bytes, size);
+    }
+    next(self, free_fn, ptr, alignment, size);
+}
+
+static inline size_t _tgalloc_profile_alloc_batch(char const * file, size_t line, size_t done, size_t alignment,
+                                                  size_t size){
+    tga_profile_site_t * site = done ? _tgalloc_profile_site(file, line, alignment, size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->alloc_count, done);
+        _tgalloc_profile_add(&site->alloc_bytes, done * size);
+    }
+    return done;
+}
+
+static inline size_t _tgalloc_profile_free_batch(char const * file, size_t line, size_t count, size_t alignment,
+                                                 size_t size){
+    tga_profile_site_t * site = count ? _tgalloc_profile_site(file, line, alignment, size) : NULL;
+    if (site) {
+        _tgalloc_profile_add(&site->free_count, count);
+        _tgalloc_profile_add(&site->free_bytes, count * size);
+    }
+    return count;
+}
+
+#ifdef TGA_PROFILE
+    #undef _tgalloc_call_alloc
+    #undef _tgalloc_call_calloc
+    #undef _tgalloc_call_realloc
+    #undef _tgalloc_call_free
+    #undef _tgalloc_call_expand
+    #undef _tgalloc_note_alloc_batch
+    #undef _tgalloc_note_free_batch
+    #define _tgalloc_call_alloc(fn, self, alignment, type_size, size) \
+        _tgalloc_profile_alloc(__FILE__, __LINE__, _tgalloc_profile_next_alloc, (void*)(self), \
+            (tga_alloc_fn)(fn), alignment, type_size, size)
+    #define _tgalloc_call_calloc(fn, alloc_fn, self, alignment, type_size, size) \
+        _tgalloc_profile_calloc(__FILE__, __LINE__, _tgalloc_profile_next_calloc, (void*)(self), \
+            (tga_alloc_fn)(fn), (tga_alloc_fn)(alloc_fn), alignment, type_size, size)
+    #define _tgalloc_call_realloc(fn, self, ptr, alignment, type_size, old_size, new_size) \
+        _tgalloc_profile_realloc(__FILE__, __LINE__, _tgalloc_profile_next_realloc, (void*)(self), \
+            (tga_realloc_fn)(fn), ptr, alignment, type_size, old_size, new_size)
+    #define _tgalloc_call_free(fn, self, ptr, alignment, type_size, size) \
+        _tgalloc_profile_free(__FILE__, __LINE__, _tgalloc_profile_next_free, (void*)(self), \
+            (tga_free_fn)(fn), ptr, alignment, type_size, size)
+    #define _tgalloc_call_expand(fn, self, ptr, alignment, type_size, old_size, new_size) \
+        _tgalloc_profile_expand(__FILE__, __LINE__, _tgalloc_profile_next_expand, (void*)(self), \
+            (tga_expand_fn)(fn), ptr, alignment, type_size, old_size, new_size)
+    #define _tgalloc_note_alloc_batch(done, alignment, size) \
+        _tgalloc_profile_alloc_batch(__FILE__, __LINE__, _tgalloc_profile_next_alloc_batch(done, alignment, size), \
+            alignment, size)
+    #define _tgalloc_note_free_batch(count, alignment, size) \
+        _tgalloc_profile_next_free_batch(_tgalloc_profile_free_batch(__FILE__, __LINE__, count, alignment, size), \
+            alignment, size)
+#endif
+
+/**
+ * @brief Copy the recorded call sites, one entry per distinct file and line
+ *
+ * Counters keep moving while the copy is taken. Entries come out in table
+ * order, not sorted.
+ *
+ * @param out Receives the sites; may be NULL when max is 0
+ * @param max Capacity of out
+ * @return Number of sites found; if larger than max, call again with more room
+ */
+static inline size_t tga_profile_sites(tga_profile_site_t * out, size_t max){
+    size_t count = 0;
+    for (size_t i = 0; i < TGA_PROFILE_SITES; i++) {
+        _tgalloc_profile_slot * slot = &_tgalloc_profile_global.slots[i];
+        if (_tgalloc_atomic_load(&slot->state, _TGALLOC_ACQUIRE) != _TGALLOC_PROFILE_READY) continue;
+
+        tga_profile_site_t site = slot->site;
+        size_t const * src = &slot->site.alloc_count;
+        size_t * dst = &site.alloc_count;
+        for (size_t j = 0; j < _TGALLOC_PROFILE_COUNTERS; j++) dst[j] = _tgalloc_atomic_load(&src[j], _TGALLOC_RELAXED);
+
+        // Merge slots of the same site seen from different translation units
+        size_t k = 0;
+        while (k < count && k < max && !(out[k].line == site.line && strcmp(out[k].file, site.file) == 0)) k++;
+        if (k < count && k < max) {
+            size_t * merged = &out[k].alloc_count;
+            for (size_t j = 0; j < _TGALLOC_PROFILE_COUNTERS; j++) merged[j] += dst[j];
+            continue;
+        }
+        if (count < max) out[count] = site;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Number of call sites that did not fit into the table
+ */
+static inline size_t tga_profile_dropped(void){
+    return _tgalloc_atomic_load(&_tgalloc_profile_global.dropped, _TGALLOC_RELAXED);
+}
+
+/**
+ * @brief Zero the counters of every site
+ *
+ * The sites stay in the table. Not synchronised with concurrent calls,
+ * whose updates may be partly lost.
+ */
+static inline void tga_profile_reset(void){
+    for (size_t i = 0; i < TGA_PROFILE_SITES; i++) {
+        size_t * counters = &_tgalloc_profile_global.slots[i].site.alloc_count;
+        for (size_t j = 0; j < _TGALLOC_PROFILE_COUNTERS; j++) _tgalloc_atomic_store(&counters[j], 0, _TGALLOC_RELAXED);
+    }
+    _tgalloc_atomic_store(&_tgalloc_profile_global.dropped, 0, _TGALLOC_RELAXED);
+}
+
+/**
+ * @brief Write the sites as folded stacks for flame graph tools
+ *
+ * Each line has the form "file;file:line type_size B align N value", so the
+ * graph groups sites by file. Sites whose value is zero are skipped.
+ *
+ * @param out    Stream to write to
+ * @param metric Value to report per site
+ */
+static inline void tga_profile_dump_folded(FILE * out, tga_profile_metric_t metric){
+    for (size_t i = 0; i < TGA_PROFILE_SITES; i++) {
+        _tgalloc_profile_slot * slot = &_tgalloc_profile_global.slots[i];
+        if (_tgalloc_atomic_load(&slot->state, _TGALLOC_ACQUIRE) != _TGALLOC_PROFILE_READY) continue;
+
+        tga_profile_site_t const * site = &slot->site;
+        size_t value;
+        if (metric == TGA_PROFILE_BYTES) {
+            value = _tgalloc_atomic_load(&site->alloc_bytes, _TGALLOC_RELAXED)
+                  + _tgalloc_atomic_load(&site->realloc_bytes, _TGALLOC_RELAXED);
+        } else {
+            value = _tgalloc_atomic_load(&site->alloc_count, _TGALLOC_RELAXED)
+                  + _tgalloc_atomic_load(&site->realloc_count, _TGALLOC_RELAXED)
+                  + _tgalloc_atomic_load(&site->free_count, _TGALLOC_RELAXED);
+        }
+        // Slots of one site from several translation units become equal
+        // stacks, which the flame graph tools add up
+        if (value) {
+            fprintf(out, "%s;%s:%zu %zu B align %zu %zu\n", site->file, site->file, site->line,
+                    site->type_size, site->alignment, value);
+        }
+    }
+}
+
+#endif // TGALLOC_PROFILE_H
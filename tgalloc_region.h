@@ -0,0 +1,293 @@
+#ifndef TGALLOC_REGION_H
+#define TGALLOC_REGION_H
+
+/**
+ * @file tgalloc_region.h
+ * @brief Linear region backend with bulk reset
+ *
+ * A region hands out memory by bumping a pointer through a chain of chunks,
+ * honouring the alignment tgalloc computes for each type. Freeing a single
+ * block does nothing; instead the whole region, or everything allocated after
+ * a saved mark, is released at once in constant time. The chunks themselves
+ * are kept and reused by later allocations until the region is destroyed.
+ *
+ * This suits request-scoped work: allocate freely while handling a request,
+ * then call tga_region_reset. A region is not thread-safe.
+ *
+ * Usage:
+ * @code
+ * tga_region_t region;
+ * tga_region_init(&region);
+ *
+ * #define TGA (tga_region_t*)&region
+ * #define TGA_ALLOC_A_S tga_region_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_region_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_region_free_aligned_sized
+ * #define TGA_EXPAND_A_S tga_region_expand_aligned_sized
+ * @endcode
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "tgalloc.h"
+
+/**
+ * @def TGA_REGION_CHUNK_SIZE
+ * @brief Default number of bytes requested from upstream when a region grows
+ */
+#ifndef TGA_REGION_CHUNK_SIZE
+#define TGA_REGION_CHUNK_SIZE (64 * 1024)
+#endif
+
+// Chunks form a chain; those past the current one are spares kept for reuse
+typedef struct _tgalloc_region_chunk {
+    struct _tgalloc_region_chunk * next;
+    size_t size;  // Total byte size including this header
+} _tgalloc_region_chunk;
+
+/**
+ * @struct tga_region_t
+ * @brief State of a linear region
+ */
+typedef struct tga_region_t {
+    _tgalloc_region_chunk * first;    // Oldest chunk, start of the chain
+    _tgalloc_region_chunk * current;  // Chunk being bumped, NULL before the first allocation
+    char * cursor;                    // Next free byte of the current chunk
+    char * limit;                     // End of the current chunk
+    size_t chunk_size;
+    tga_backend_t upstream;
+} tga_region_t;
+
+/**
+ * @struct tga_region_mark_t
+ * @brief Saved allocation position of a region
+ */
+typedef struct tga_region_mark_t {
+    _tgalloc_region_chunk * chunk;
+    char * cursor;
+} tga_region_mark_t;
+
+// Offset of the first usable byte in a chunk
+#define _tgalloc_region_chunk_header \
+    ((sizeof(_tgalloc_region_chunk) + _tgalloc_max_align - 1) / _tgalloc_max_align * _tgalloc_max_align)
+
+/**
+ * @brief Initialise a region with a given upstream backend and chunk size
+ *
+ * @param self       Region to initialise
+ * @param upstream   Backend the chunks are obtained from
+ * @param chunk_size Minimum byte size of each chunk
+ */
+static inline void tga_region_init_with(tga_region_t * self, tga_backend_t upstream, size_t chunk_size){
+    memset(self, 0, sizeof(*self));
+    self->chunk_size = chunk_size;
+    self->upstream = upstream;
+}
+
+/**
+ * @brief Initialise a region on top of the default malloc backend
+ *
+ * @param self Region to initialise
+ */
+static inline void tga_region_init(tga_region_t * self){
+    tga_region_init_with(self, TGA_BACKEND_DEFAULT, TGA_REGION_CHUNK_SIZE);
+}
+
+/**
+ * @brief Return all chunks to the upstream backend
+ *
+ * @param self Region to destroy
+ */
+static inline void tga_region_destroy(tga_region_t * self){
+    _tgalloc_region_chunk * chunk = self->first;
+    while (chunk) {
+        _tgalloc_region_chunk * next = chunk->next;
+        self->upstream.free_a_s(self->upstream.self, chunk, _tgalloc_max_align, chunk->size);
+        chunk = next;
+    }
+    self->first = self->current = NULL;
+    self->cursor = self->limit = NULL;
+}
+
+/**
+ * @brief Remember the current allocation position
+ *
+ * @param self Region to query
+ * @return Mark to pass to tga_region_restore
+ */
+static inline tga_region_mark_t tga_region_save(tga_region_t const * self){
+    tga_region_mark_t mark;
+    mark.chunk = self->current;
+    mark.cursor = self->cursor;
+    return mark;
+}
+
+/**
+ * @brief Release everything allocated since a mark was saved
+ *
+ * Marks saved after this one become invalid. Runs in constant time.
+ *
+ * @param self Region to rewind
+ * @param mark Mark obtained from tga_region_save on the same region
+ */
+static inline void tga_region_restore(tga_region_t * self, tga_region_mark_t mark){
+    self->current = mark.chunk;
+    self->cursor = mark.cursor;
+    self->limit = mark.chunk ? (char*)mark.chunk + mark.chunk->size : NULL;
+}
+
+/**
+ * @brief Release every allocation of the region in constant time
+ *
+ * The chunks stay with the region and are reused by later allocations.
+ *
+ * @param self Region to reset
+ */
+static inline void tga_region_reset(tga_region_t * self){
+    tga_region_mark_t start;
+    start.chunk = self->first;
+    start.cursor = self->first ? (char*)self->first + _tgalloc_region_chunk_header : NULL;
+    tga_region_restore(self, start);
+}
+
+/**
+ * @brief Whether ptr points into one of the region's chunks
+ *
+ * Walks the chunk chain, so the cost grows with the number of chunks.
+ */
+static inline int tga_region_owns(tga_region_t const * self, void const * ptr){
+    for (_tgalloc_region_chunk const * chunk = self->first; chunk; chunk = chunk->next) {
+        if ((char const*)ptr >= (char const*)chunk && (char const*)ptr < (char const*)chunk + chunk->size) return 1;
+    }
+    return 0;
+}
+
+// Slow path: move on to a spare chunk or a new one that fits the request
+static inline void * _tgalloc_region_grow(tga_region_t * self, size_t alignment, size_t size){
+    size_t needed = _tgalloc_region_chunk_header + size + (alignment > _tgalloc_max_align ? alignment : 0);
+    _tgalloc_region_chunk * next = self->current ? self->current->next : self->first;
+    if (next == NULL || next->size < needed) {
+        size_t chunk_size = needed > self->chunk_size ? needed : self->chunk_size;
+        _tgalloc_region_chunk * chunk = (_tgalloc_region_chunk*)self->upstream.alloc_a_s(
+            self->upstream.self, _tgalloc_max_align, chunk_size);
+        if (chunk == NULL) return NULL;
+        chunk->size = chunk_size;
+        chunk->next = next;
+        if (self->current) self->current->next = chunk;
+        else self->first = chunk;
+        next = chunk;
+    }
+    self->current = next;
+    self->cursor = (char*)next + _tgalloc_region_chunk_header;
+    self->limit = (char*)next + next->size;
+
+    char * block = (char*)(((uintptr_t)self->cursor + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    self->cursor = block + size;
+    return block;
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the region
+ */
+static inline void * tga_region_alloc_aligned_sized(tga_region_t * self, size_t alignment, size_t size){
+    char * block = (char*)(((uintptr_t)self->cursor + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (self->cursor != NULL && block <= self->limit && size <= (size_t)(self->limit - block)) {
+        self->cursor = block + size;
+        return block;
+    }
+    return _tgalloc_region_grow(self, alignment, size);
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the region; does nothing
+ */
+static inline void tga_region_free_aligned_sized(tga_region_t * self, void const * ptr, size_t alignment, size_t size){
+    (void)self;      // Mark as unused to prevent compiler warnings
+    (void)ptr;       // Mark as unused to prevent compiler warnings
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    (void)size;      // Mark as unused to prevent compiler warnings
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the region
+ *
+ * Shrinking never moves a block. The most recent allocation grows in place
+ * while its chunk has room; anything else is copied to a new block.
+ */
+static inline void * tga_region_realloc_aligned_sized(tga_region_t * self, void * ptr, size_t alignment,
+                                                      size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_region_alloc_aligned_sized(self, alignment, new_size);
+    if (new_size <= old_size) {
+        if ((char*)ptr + old_size == self->cursor) self->cursor = (char*)ptr + new_size;
+        return ptr;
+    }
+    if ((char*)ptr + old_size == self->cursor && new_size <= (size_t)(self->limit - (char*)ptr)) {
+        self->cursor = (char*)ptr + new_size;
+        return ptr;
+    }
+    void * moved = tga_region_alloc_aligned_sized(self, alignment, new_size);
+    if (moved) memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the region
+ *
+ * Shrinking always succeeds; growing succeeds for the most recent
+ * allocation while its chunk has room.
+ */
+static inline int tga_region_expand_aligned_sized(tga_region_t * self, void * ptr, size_t alignment,
+                                                  size_t old_size, size_t new_size){
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    if (ptr == NULL) return 0;
+    int last = (char*)ptr + old_size == self->cursor;
+    if (new_size <= old_size) {
+        if (last) self->cursor = (char*)ptr + new_size;
+        return 1;
+    }
+    if (!last || new_size > (size_t)(self->limit - (char*)ptr)) return 0;
+    self->cursor = (char*)ptr + new_size;
+    return 1;
+}
+
+/**
+ * @brief Call visit on every chunk of the region, oldest first
+ *
+ * Single frees are no-ops, so everything before the cursor counts as used,
+ * including what sits past the last block of a filled chunk. Spare chunks
+ * after the current one are entirely free.
+ *
+ * @param self  Region to walk
+ * @param visit Function called on every chunk
+ * @param ctx   Passed on to visit
+ * @return 1
+ */
+static inline int tga_region_walk(tga_region_t const * self, tga_heap_visit_fn visit, void * ctx){
+    int spare = self->current == NULL;
+    for (_tgalloc_region_chunk const * region_chunk = self->first; region_chunk; region_chunk = region_chunk->next) {
+        tga_heap_chunk_t chunk;
+        size_t usable = region_chunk->size - _tgalloc_region_chunk_header;
+        chunk.start = region_chunk;
+        chunk.size = region_chunk->size;
+        chunk.free_bytes = spare ? usable : region_chunk == self->current ? (size_t)(self->limit - self->cursor) : 0;
+        chunk.used_bytes = usable - chunk.free_bytes;
+        chunk.block_size = 0;
+        visit(ctx, &chunk);
+        if (region_chunk == self->current) spare = 1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Summarise the chunks of the region; it has no size classes
+ *
+ * @param self Region to inspect
+ * @param out  Receives the report
+ * @return 1
+ */
+static inline int tga_region_report(tga_region_t const * self, tga_heap_report_t * out){
+    memset(out, 0, sizeof(*out));
+    return tga_region_walk(self, _tgalloc_heap_tally, out);
+}
+
+#endif // TGALLOC_REGION_H
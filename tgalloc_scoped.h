@@ -0,0 +1,125 @@
+#ifndef TGALLOC_SCOPED_H
+#define TGALLOC_SCOPED_H
+
+/**
+ * @file tgalloc_scoped.h
+ * @brief Scratch allocations released automatically at scope exit
+ *
+ * tga_scoped(T, name, n) declares `T * name` pointing to n elements that
+ * stay valid until the enclosing block is left, by whatever path: falling
+ * off the end, return, break, continue or goto. Nothing has to be freed by
+ * hand, so early returns cannot leak or pass the wrong length.
+ *
+ * Requests are carved from a per-thread stack buffer of TGA_SCOPED_STACK_SIZE
+ * bytes, which costs about as much as alloca but cannot overflow the thread's
+ * stack. Scopes nest, so the buffer is released in LIFO order just by
+ * resetting its top. Requests that do not fit in what is left of the buffer
+ * go to the TGA active where tga_scoped is used, and are freed there with
+ * their exact size. These calls go straight to the backend functions, so
+ * TGA_STATS and TGA_PROFILE do not see them.
+ *
+ * Usage:
+ * @code
+ * int checksum(char const * path, size_t len){
+ *     tga_scoped(char, buf, len);
+ *     if (buf == NULL) return -1;
+ *     if (read_file(path, buf, len) < 0) return -1;  // buf released here
+ *     return crc(buf, len);                           // and here
+ * }
+ * @endcode
+ *
+ * Leaving a scope with longjmp skips the release. The memory is not zeroed.
+ * Needs the cleanup attribute of GCC and Clang.
+ */
+
+#include <stdint.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+#if !defined(__GNUC__) && !defined(__clang__)
+    #error "tgalloc_scoped.h needs __attribute__((cleanup)), available with GCC and Clang"
+#endif
+
+/**
+ * @def TGA_SCOPED_STACK_SIZE
+ * @brief Bytes of the per-thread buffer scoped allocations are carved from
+ *
+ * Must be the same in every translation unit of a program.
+ */
+#ifndef TGA_SCOPED_STACK_SIZE
+#define TGA_SCOPED_STACK_SIZE (16 * 1024)
+#endif
+
+// Per-thread LIFO buffer, shared by every translation unit
+typedef struct _tgalloc_scoped_stack {
+    size_t top;  // Offset of the first byte in use by no scope
+    char bytes[TGA_SCOPED_STACK_SIZE];
+} _tgalloc_scoped_stack;
+
+_TGALLOC_WEAK _tgalloc_thread_local _tgalloc_scoped_stack _tgalloc_scoped_tls;
+
+// Marks a block that came from the backend rather than the buffer
+#define _TGALLOC_SCOPED_HEAP SIZE_MAX
+
+// What a scope has to undo when it ends
+typedef struct _tgalloc_scope {
+    void * ptr;
+    size_t mark;       // Buffer top to restore, or _TGALLOC_SCOPED_HEAP
+    size_t alignment;
+    size_t size;
+    tga_backend_t backend;
+} _tgalloc_scope;
+
+// Reserve count elements from the buffer, or from the backend if they do not fit
+static inline _tgalloc_scope _tgalloc_scope_acquire(tga_backend_t backend, size_t alignment, size_t elem_size,
+                                                    size_t count){
+    _tgalloc_scope scope = {NULL, _TGALLOC_SCOPED_HEAP, alignment, 0, backend};
+    if (count > SIZE_MAX / elem_size) return scope;
+    scope.size = elem_size * count;
+
+    _tgalloc_scoped_stack * stack = &_tgalloc_scoped_tls;
+    uintptr_t base = (uintptr_t)stack->bytes;
+    size_t start = (size_t)(((base + stack->top + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+    if (start <= TGA_SCOPED_STACK_SIZE && TGA_SCOPED_STACK_SIZE - start >= scope.size) {
+        scope.ptr = stack->bytes + start;
+        scope.mark = stack->top;
+        stack->top = start + scope.size;
+        return scope;
+    }
+    scope.ptr = backend.alloc_a_s(backend.self, alignment, scope.size);
+    return scope;
+}
+
+// Cleanup handler run when a tga_scoped variable goes out of scope
+static inline void _tgalloc_scope_release(_tgalloc_scope * scope){
+    if (scope->mark != _TGALLOC_SCOPED_HEAP) {
+        _tgalloc_scoped_tls.top = scope->mark;
+    } else if (scope->ptr) {
+        scope->backend.free_a_s(scope->backend.self, scope->ptr, scope->alignment, scope->size);
+    }
+}
+
+/**
+ * @brief Declare `T * name` pointing to n scratch elements freed at scope exit
+ *
+ * name is NULL if the elements fit neither in the buffer nor in the backend.
+ * It must not be freed, and must not be used once its block has been left.
+ *
+ * @param T    Element type
+ * @param name Name of the pointer variable to declare
+ * @param n    Number of elements, evaluated once
+ */
+#define tga_scoped(T, name, n) \
+    __attribute__((cleanup(_tgalloc_scope_release))) _tgalloc_scope _tgalloc_scope_##name = \
+        _tgalloc_scope_acquire(TGA_BACKEND_CURRENT, _tgalloc_alignof_impl(T), sizeof(T), n); \
+    T * name = (T*)_tgalloc_scope_##name.ptr
+
+/**
+ * @brief Bytes of the calling thread's buffer currently held by open scopes,
+ * including alignment padding
+ */
+static inline size_t tga_scoped_stack_used(void){
+    return _tgalloc_scoped_tls.top;
+}
+
+#endif // TGALLOC_SCOPED_H
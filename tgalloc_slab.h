@@ -0,0 +1,407 @@
+#ifndef TGALLOC_SLAB_H
+#define TGALLOC_SLAB_H
+
+/**
+ * @file tgalloc_slab.h
+ * @brief Headerless small-object backend built on sized frees
+ *
+ * Because pfree always passes the size, a block needs no header telling
+ * its size class. A tga_slab_t keeps small objects in pages aligned to
+ * TGA_SLAB_PAGE_SIZE, each holding blocks of a single class and a bitmap of
+ * the free ones at its start. A freed pointer finds its page by masking off
+ * the low bits, and its bit from the offset, so a 16-byte node takes exactly
+ * 16 bytes plus one bit. Allocation scans the bitmap for a set bit a word at
+ * a time, starting from the lowest word that may have one.
+ *
+ * Pages with free blocks are reused first; a page that becomes entirely free
+ * is returned to the upstream backend unless it is the last one of its
+ * class, which tga_slab_trim releases once it has stayed empty. Requests
+ * above TGA_SLAB_MAX_SMALL, and alignments above what a class naturally
+ * provides, are passed to the upstream backend. A slab is not thread-safe;
+ * wrap it in a tga_tcache_t to share it between threads.
+ *
+ * Usage:
+ * @code
+ * tga_slab_t slab;
+ * tga_slab_init(&slab);
+ *
+ * #define TGA (tga_slab_t*)&slab
+ * #define TGA_ALLOC_A_S tga_slab_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_slab_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_slab_free_aligned_sized
+ * #define TGA_EXPAND_A_S tga_slab_expand_aligned_sized
+ *
+ * tga_slab_destroy(&slab);
+ * @endcode
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "tgalloc.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+/**
+ * @def TGA_SLAB_QUANTUM
+ * @brief Granularity of the size classes
+ */
+#ifndef TGA_SLAB_QUANTUM
+#define TGA_SLAB_QUANTUM 8
+#endif
+
+/**
+ * @def TGA_SLAB_MAX_SMALL
+ * @brief Largest request served from the slab pages
+ */
+#ifndef TGA_SLAB_MAX_SMALL
+#define TGA_SLAB_MAX_SMALL 256
+#endif
+
+/**
+ * @def TGA_SLAB_PAGE_SIZE
+ * @brief Size and alignment of a slab page; a power of two
+ */
+#ifndef TGA_SLAB_PAGE_SIZE
+#define TGA_SLAB_PAGE_SIZE (64 * 1024)
+#endif
+
+#define TGA_SLAB_NUM_CLASSES (TGA_SLAB_MAX_SMALL / TGA_SLAB_QUANTUM)
+
+// Blocks start on a cache line boundary after the page header
+#define _tgalloc_slab_block_offset_align 64
+
+// Every page sits on the partial or the full list of its class
+typedef struct _tgalloc_slab_page {
+    struct _tgalloc_slab_page * next;
+    struct _tgalloc_slab_page * prev;
+    uint32_t cls;
+    uint32_t block_size;
+    uint32_t first;       // Offset of the first block
+    uint32_t count;       // Number of blocks
+    uint32_t free_count;
+    uint32_t hint;        // No word below this one has a set bit
+    uint32_t idle;        // Number of trims that found the page empty since it last became so
+    uint64_t bits[];      // Set bits mark free blocks
+} _tgalloc_slab_page;
+
+/**
+ * @struct tga_slab_t
+ * @brief State of a slab allocator
+ */
+typedef struct tga_slab_t {
+    _tgalloc_slab_page * partial[TGA_SLAB_NUM_CLASSES];  // Pages with free blocks
+    _tgalloc_slab_page * full[TGA_SLAB_NUM_CLASSES];
+    tga_backend_t upstream;  // Source of pages and of large blocks
+    unsigned trim_decay;     // Trims an empty page must survive before it is released
+} tga_slab_t;
+
+// Size class of a request; size 0 shares the smallest class
+#define _tgalloc_slab_class(size) ((size) ? ((size) - 1) / TGA_SLAB_QUANTUM : 0)
+
+// Byte size of the blocks of a class
+#define _tgalloc_slab_class_size(cls) (((cls) + 1) * TGA_SLAB_QUANTUM)
+
+// Alignment every block of a class has: the lowest set bit of its size, up to the block offset alignment
+#define _tgalloc_slab_class_align(cls) \
+    ((_tgalloc_slab_class_size(cls) & (0 - _tgalloc_slab_class_size(cls))) < _tgalloc_slab_block_offset_align \
+     ? (_tgalloc_slab_class_size(cls) & (0 - _tgalloc_slab_class_size(cls))) : _tgalloc_slab_block_offset_align)
+
+// Whether a request is served by the slab pages
+#define _tgalloc_slab_is_small(alignment, size) \
+    ((size) <= TGA_SLAB_MAX_SMALL && (alignment) <= _tgalloc_slab_class_align(_tgalloc_slab_class(size)))
+
+// Page a small block belongs to
+#define _tgalloc_slab_page_of(ptr) \
+    ((_tgalloc_slab_page*)((uintptr_t)(ptr) & ~(uintptr_t)(TGA_SLAB_PAGE_SIZE - 1)))
+
+// Index of the lowest set bit of a non-zero word
+static inline unsigned _tgalloc_slab_ctz(uint64_t word){
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctzll(word);
+#endif
+}
+
+// Offset of the first block when a page holds count blocks
+static inline size_t _tgalloc_slab_first(size_t count){
+    size_t header = sizeof(_tgalloc_slab_page) + (count + 63) / 64 * sizeof(uint64_t);
+    return (header + _tgalloc_slab_block_offset_align - 1) / _tgalloc_slab_block_offset_align
+           * _tgalloc_slab_block_offset_align;
+}
+
+/**
+ * @brief Initialise a slab allocator that takes its pages from a given backend
+ *
+ * @param self     Slab to initialise
+ * @param upstream Backend used for pages and for requests outside the size classes
+ */
+static inline void tga_slab_init_with(tga_slab_t * self, tga_backend_t upstream){
+    memset(self, 0, sizeof(*self));
+    self->upstream = upstream;
+    self->trim_decay = TGA_TRIM_DECAY;
+}
+
+/**
+ * @brief Initialise a slab allocator on top of the default allocator
+ */
+static inline void tga_slab_init(tga_slab_t * self){
+    tga_slab_init_with(self, TGA_BACKEND_DEFAULT);
+}
+
+static inline void _tgalloc_slab_release_list(tga_slab_t * self, _tgalloc_slab_page * page){
+    while (page) {
+        _tgalloc_slab_page * next = page->next;
+        self->upstream.free_a_s(self->upstream.self, page, TGA_SLAB_PAGE_SIZE, TGA_SLAB_PAGE_SIZE);
+        page = next;
+    }
+}
+
+/**
+ * @brief Return every page to the upstream backend
+ *
+ * Blocks that were passed to the upstream backend are not tracked and must
+ * be freed individually beforehand.
+ */
+static inline void tga_slab_destroy(tga_slab_t * self){
+    for (size_t cls = 0; cls < TGA_SLAB_NUM_CLASSES; cls++) {
+        _tgalloc_slab_release_list(self, self->partial[cls]);
+        _tgalloc_slab_release_list(self, self->full[cls]);
+        self->partial[cls] = NULL;
+        self->full[cls] = NULL;
+    }
+}
+
+static inline void _tgalloc_slab_unlink(_tgalloc_slab_page ** list, _tgalloc_slab_page * page){
+    if (page->prev) page->prev->next = page->next;
+    else *list = page->next;
+    if (page->next) page->next->prev = page->prev;
+}
+
+static inline void _tgalloc_slab_push(_tgalloc_slab_page ** list, _tgalloc_slab_page * page){
+    page->prev = NULL;
+    page->next = *list;
+    if (*list) (*list)->prev = page;
+    *list = page;
+}
+
+// Get a fresh page for a class and put it on the partial list
+static inline _tgalloc_slab_page * _tgalloc_slab_new_page(tga_slab_t * self, size_t cls){
+    _tgalloc_slab_page * page = (_tgalloc_slab_page*)self->upstream.alloc_a_s(self->upstream.self,
+                                                                              TGA_SLAB_PAGE_SIZE, TGA_SLAB_PAGE_SIZE);
+    if (page == NULL) return NULL;
+    size_t block_size = _tgalloc_slab_class_size(cls);
+    // Estimate with one bit of bitmap per block, then shrink until header and blocks fit
+    size_t count = (TGA_SLAB_PAGE_SIZE - sizeof(_tgalloc_slab_page) - _tgalloc_slab_block_offset_align) * 8
+                   / (block_size * 8 + 1);
+    while (_tgalloc_slab_first(count) + count * block_size > TGA_SLAB_PAGE_SIZE) count--;
+
+    page->cls = (uint32_t)cls;
+    page->block_size = (uint32_t)block_size;
+    page->first = (uint32_t)_tgalloc_slab_first(count);
+    page->count = (uint32_t)count;
+    page->free_count = (uint32_t)count;
+    page->hint = 0;
+    page->idle = 0;
+    size_t words = (count + 63) / 64;
+    memset(page->bits, 0xff, (count / 64) * sizeof(uint64_t));
+    if (count % 64) page->bits[words - 1] = ((uint64_t)1 << (count % 64)) - 1;
+    _tgalloc_slab_push(&self->partial[cls], page);
+    return page;
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the slab
+ */
+static inline void * tga_slab_alloc_aligned_sized(tga_slab_t * self, size_t alignment, size_t size){
+    if (!_tgalloc_slab_is_small(alignment, size)) {
+        return self->upstream.alloc_a_s(self->upstream.self, alignment, size);
+    }
+    size_t cls = _tgalloc_slab_class(size);
+    _tgalloc_slab_page * page = self->partial[cls];
+    if (page == NULL) {
+        page = _tgalloc_slab_new_page(self, cls);
+        if (page == NULL) return NULL;
+    }
+    uint32_t word = page->hint;
+    while (page->bits[word] == 0) word++;
+    unsigned bit = _tgalloc_slab_ctz(page->bits[word]);
+    page->bits[word] &= page->bits[word] - 1;
+    page->hint = word;
+    if (--page->free_count == 0) {
+        _tgalloc_slab_unlink(&self->partial[cls], page);
+        _tgalloc_slab_push(&self->full[cls], page);
+    }
+    return (char*)page + page->first + ((size_t)word * 64 + bit) * page->block_size;
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the slab
+ */
+static inline void tga_slab_free_aligned_sized(tga_slab_t * self, void const * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (!_tgalloc_slab_is_small(alignment, size)) {
+        self->upstream.free_a_s(self->upstream.self, ptr, alignment, size);
+        return;
+    }
+    _tgalloc_slab_page * page = _tgalloc_slab_page_of(ptr);
+    size_t cls = page->cls;
+    size_t index = ((size_t)((char const*)ptr - (char const*)page) - page->first) / page->block_size;
+    uint32_t word = (uint32_t)(index / 64);
+    page->bits[word] |= (uint64_t)1 << (index % 64);
+    if (word < page->hint) page->hint = word;
+
+    if (page->free_count++ == 0) {
+        _tgalloc_slab_unlink(&self->full[cls], page);
+        _tgalloc_slab_push(&self->partial[cls], page);
+    } else if (page->free_count == page->count) {
+        if (page->prev || page->next) {
+            _tgalloc_slab_unlink(&self->partial[cls], page);
+            self->upstream.free_a_s(self->upstream.self, page, TGA_SLAB_PAGE_SIZE, TGA_SLAB_PAGE_SIZE);
+        } else {
+            // Keep one empty page per class so a single alloc/free pair does not thrash upstream
+            page->idle = 0;
+        }
+    }
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the slab
+ *
+ * Resizing within a size class returns the same block. Blocks that stay
+ * outside the size classes are resized by the upstream backend; every other
+ * case allocates, copies and frees.
+ */
+static inline void * tga_slab_realloc_aligned_sized(tga_slab_t * self, void * ptr, size_t alignment,
+                                                    size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_slab_alloc_aligned_sized(self, alignment, new_size);
+    int old_small = _tgalloc_slab_is_small(alignment, old_size);
+    int new_small = _tgalloc_slab_is_small(alignment, new_size);
+    if (old_small && new_small && _tgalloc_slab_class(old_size) == _tgalloc_slab_class(new_size)) {
+        return ptr;
+    }
+    if (!old_small && !new_small) {
+        return self->upstream.realloc_a_s(self->upstream.self, ptr, alignment, old_size, new_size);
+    }
+    void * moved = tga_slab_alloc_aligned_sized(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_slab_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the slab
+ *
+ * Succeeds within a size class, and for blocks outside the size classes
+ * whenever the upstream backend can resize them in place.
+ */
+static inline int tga_slab_expand_aligned_sized(tga_slab_t * self, void * ptr, size_t alignment,
+                                                size_t old_size, size_t new_size){
+    if (ptr == NULL) return 0;
+    int old_small = _tgalloc_slab_is_small(alignment, old_size);
+    int new_small = _tgalloc_slab_is_small(alignment, new_size);
+    if (old_small && new_small) return _tgalloc_slab_class(old_size) == _tgalloc_slab_class(new_size);
+    if (!old_small && !new_small) {
+        return _tgalloc_expand_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment,
+                                                                  old_size, new_size);
+    }
+    return 0;
+}
+
+/**
+ * @brief TGA_USABLE_SIZE_A_S implementation of the slab
+ *
+ * Blocks in the size classes can hold their whole class; the upstream
+ * backend answers for the others.
+ */
+static inline size_t tga_slab_usable_size_aligned_sized(tga_slab_t * self, void const * ptr, size_t alignment,
+                                                        size_t size){
+    if (_tgalloc_slab_is_small(alignment, size)) return _tgalloc_slab_class_size(_tgalloc_slab_class(size));
+    return _tgalloc_usable_size_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment, size);
+}
+
+/**
+ * @brief TGA_TRIM implementation of the slab
+ *
+ * Returns to the upstream backend the empty pages kept for their class,
+ * once trim_decay earlier trims have also found them empty, then trims the
+ * upstream backend.
+ *
+ * @return Number of bytes released
+ */
+static inline size_t tga_slab_trim(tga_slab_t * self){
+    size_t released = 0;
+    for (size_t cls = 0; cls < TGA_SLAB_NUM_CLASSES; cls++) {
+        _tgalloc_slab_page * page = self->partial[cls];
+        while (page) {
+            _tgalloc_slab_page * next = page->next;
+            if (page->free_count == page->count && page->idle++ >= self->trim_decay) {
+                _tgalloc_slab_unlink(&self->partial[cls], page);
+                self->upstream.free_a_s(self->upstream.self, page, TGA_SLAB_PAGE_SIZE, TGA_SLAB_PAGE_SIZE);
+                released += TGA_SLAB_PAGE_SIZE;
+            }
+            page = next;
+        }
+    }
+    return released + _tgalloc_trim_upstream(&self->upstream);
+}
+
+static inline void _tgalloc_slab_walk_list(_tgalloc_slab_page const * page, tga_heap_visit_fn visit, void * ctx){
+    for (; page; page = page->next) {
+        tga_heap_chunk_t chunk;
+        chunk.start = page;
+        chunk.size = TGA_SLAB_PAGE_SIZE;
+        chunk.used_bytes = (size_t)(page->count - page->free_count) * page->block_size;
+        chunk.free_bytes = (size_t)page->free_count * page->block_size;
+        chunk.block_size = page->block_size;
+        visit(ctx, &chunk);
+    }
+}
+
+/**
+ * @brief Call visit on every page of the slab, class by class
+ *
+ * Reads only the page headers, so it takes time proportional to the pages.
+ *
+ * @param self  Slab to walk
+ * @param visit Function called on every page
+ * @param ctx   Passed on to visit
+ * @return 1
+ */
+static inline int tga_slab_walk(tga_slab_t const * self, tga_heap_visit_fn visit, void * ctx){
+    for (size_t cls = 0; cls < TGA_SLAB_NUM_CLASSES; cls++) {
+        _tgalloc_slab_walk_list(self->partial[cls], visit, ctx);
+        _tgalloc_slab_walk_list(self->full[cls], visit, ctx);
+    }
+    return 1;
+}
+
+/**
+ * @brief Summarise the pages of the slab and the occupancy of every size class
+ *
+ * Blocks passed to the upstream backend are not included.
+ *
+ * @param self Slab to inspect
+ * @param out  Receives the report
+ * @return 1
+ */
+static inline int tga_slab_report(tga_slab_t const * self, tga_heap_report_t * out){
+    memset(out, 0, sizeof(*out));
+    for (size_t cls = 0; cls < TGA_SLAB_NUM_CLASSES; cls++) {
+        size_t blocks = 0, free_blocks = 0;
+        for (_tgalloc_slab_page const * page = self->partial[cls]; page; page = page->next) {
+            blocks += page->count;
+            free_blocks += page->free_count;
+        }
+        for (_tgalloc_slab_page const * page = self->full[cls]; page; page = page->next) blocks += page->count;
+        _tgalloc_heap_add_class(out, _tgalloc_slab_class_size(cls), blocks, free_blocks);
+    }
+    return tga_slab_walk(self, _tgalloc_heap_tally, out);
+}
+
+#endif // TGALLOC_SLAB_H
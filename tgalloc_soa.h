@@ -0,0 +1,187 @@
+#ifndef TGALLOC_SOA_H
+#define TGALLOC_SOA_H
+
+/**
+ * @file tgalloc_soa.h
+ * @brief Struct-of-arrays containers in a single allocation
+ *
+ * A loop over one field of an array of structs drags every other field
+ * through the cache with it, and the compiler cannot load consecutive
+ * values of that field into one vector register. TGSOA_DEFINE generates a
+ * container holding one column array per field instead. All columns live
+ * in a single block from the active backend, each starting on a
+ * TGA_SOA_ALIGN boundary, so every field can be processed with aligned
+ * vector loads.
+ *
+ * Fields are listed in an X-macro, which receives the macro to apply to
+ * every (type, name) pair:
+ * @code
+ * #define PARTICLE_FIELDS(X) X(float, x) X(float, y) X(float, vx) X(float, vy) X(int, id)
+ * TGSOA_DEFINE(particles, PARTICLE_FIELDS)
+ *
+ * particles_t p = TGSOA_INIT;
+ * if (!tgsoa_resize(particles, p, 1000)) handle_oom();
+ * for (size_t i = 0; i < p.len; i++) p.x[i] += p.vx[i];
+ * tgsoa_free(particles, p);
+ * @endcode
+ *
+ * Like tgvec, the storage goes through whichever TGA is active where the
+ * tgsoa macros are used, and growing is a single realloc of the whole
+ * block, after which the columns are moved to their new offsets. Every
+ * call passes the backend TGA_SOA_ALIGN and the exact byte size of the
+ * block, which sized-free backends rely on. The macros evaluate the
+ * container argument several times, so it should be a plain variable or
+ * member.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "tgalloc.h"
+
+/**
+ * @def TGA_SOA_ALIGN
+ * @brief Alignment of every column; a power of two at least the alignment of every field type
+ */
+#ifndef TGA_SOA_ALIGN
+#define TGA_SOA_ALIGN 64
+#endif
+
+/**
+ * @brief Initialiser for an empty container, which owns no memory
+ */
+#define TGSOA_INIT {0}
+
+// Bytes a column of the given size takes up in the block
+static inline size_t _tgalloc_soa_round(size_t bytes){
+    return (bytes + TGA_SOA_ALIGN - 1) & ~(size_t)(TGA_SOA_ALIGN - 1);
+}
+
+// Byte size of the block holding count columns of cap elements; 0 if it does not fit in a size_t
+static inline size_t _tgalloc_soa_bytes(size_t const * sizes, size_t count, size_t cap){
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (total > SIZE_MAX - TGA_SOA_ALIGN || cap > (SIZE_MAX - TGA_SOA_ALIGN - total) / sizes[i]) return 0;
+        total += _tgalloc_soa_round(cap * sizes[i]);
+    }
+    return total;
+}
+
+// Capacity when n rows are needed: at least double the current one, so that growing row by row stays linear
+static inline size_t _tgalloc_soa_grow_cap(size_t const * sizes, size_t count, size_t cap, size_t n){
+    if (n <= cap || cap > SIZE_MAX / 2 || cap * 2 <= n) return n;
+    return _tgalloc_soa_bytes(sizes, count, cap * 2) ? cap * 2 : n;
+}
+
+// Start the next column at *cursor, unless there is no block
+static inline void * _tgalloc_soa_column(char ** cursor, size_t bytes){
+    char * column = *cursor;
+    if (column) *cursor = column + _tgalloc_soa_round(bytes);
+    return column;
+}
+
+// Move len rows of every column from their offsets for old_cap to those for new_cap. Columns only move
+// towards the end of the block as the capacity grows, so the last one goes first.
+static inline void _tgalloc_soa_grow_columns(char * block, size_t const * sizes, size_t count, size_t len,
+                                             size_t old_cap, size_t new_cap){
+    size_t old_offset = _tgalloc_soa_bytes(sizes, count, old_cap);
+    size_t new_offset = _tgalloc_soa_bytes(sizes, count, new_cap);
+    for (size_t i = count; i-- > 0;) {
+        old_offset -= _tgalloc_soa_round(old_cap * sizes[i]);
+        new_offset -= _tgalloc_soa_round(new_cap * sizes[i]);
+        if (len && old_offset != new_offset) memmove(block + new_offset, block + old_offset, len * sizes[i]);
+    }
+}
+
+// Per-field expansions of the field list
+#define _tgalloc_soa_member(T, field) T * field;
+#define _tgalloc_soa_size(T, field) sizeof(T),
+#define _tgalloc_soa_carve(T, field) self->field = (T*)_tgalloc_soa_column(&cursor, cap * sizeof(T));
+
+/**
+ * @brief Generate the container type name_t for a list of fields
+ *
+ * name_t holds a `T * field` column for every X(T, field) of FIELDS, the
+ * number of rows len, the capacity cap and the block holding the columns.
+ * It also defines the helpers the tgsoa macros call:
+ * - name_bytes(cap), the byte size of the block for cap rows, or 0 if it
+ *   would not fit in a size_t
+ * - name_grow_cap(cap, n), the capacity tgsoa_resize grows to
+ * - name_carve(self, block, cap), which points the columns into a block
+ * - name_adopt(self, block, new_cap), which moves the columns of a block
+ *   just grown to new_cap rows into place
+ *
+ * @param name   Prefix of the generated type and functions
+ * @param FIELDS X-macro applying its argument to every (type, name) pair
+ */
+#define TGSOA_DEFINE(name, FIELDS) \
+    typedef struct name##_t { FIELDS(_tgalloc_soa_member) size_t len; size_t cap; void * block; } name##_t; \
+    static size_t const name##_sizes[] = { FIELDS(_tgalloc_soa_size) }; \
+    static inline size_t name##_bytes(size_t cap){ \
+        return _tgalloc_soa_bytes(name##_sizes, sizeof(name##_sizes) / sizeof(size_t), cap); \
+    } \
+    static inline size_t name##_grow_cap(size_t cap, size_t n){ \
+        return _tgalloc_soa_grow_cap(name##_sizes, sizeof(name##_sizes) / sizeof(size_t), cap, n); \
+    } \
+    static inline void name##_carve(name##_t * self, void * block, size_t cap){ \
+        char * cursor = (char*)block; \
+        FIELDS(_tgalloc_soa_carve) \
+        self->block = block; \
+        self->cap = cap; \
+    } \
+    static inline int name##_adopt(name##_t * self, void * block, size_t new_cap){ \
+        if (block == NULL) return 0; \
+        _tgalloc_soa_grow_columns((char*)block, name##_sizes, sizeof(name##_sizes) / sizeof(size_t), self->len, \
+                                  self->cap, new_cap); \
+        name##_carve(self, block, new_cap); \
+        return 1; \
+    }
+
+// Grow the block to new_cap rows, which must be above the current capacity; non-zero on success
+#define _tgalloc_soa_grow(name, s, new_cap) \
+    name##_adopt(&(s), (s).block \
+        ? _tgalloc_retry(_tgalloc_call_realloc(TGA_REALLOC_A_S, _tgalloc_tga(1), (s).block, TGA_SOA_ALIGN, 1, \
+            name##_bytes((s).cap), name##_bytes(new_cap)), TGA_SOA_ALIGN, name##_bytes(new_cap)) \
+        : _tgalloc_retry(_tgalloc_call_alloc(TGA_ALLOC_A_S, _tgalloc_tga(1), TGA_SOA_ALIGN, 1, \
+            name##_bytes(new_cap)), TGA_SOA_ALIGN, name##_bytes(new_cap)), \
+        new_cap)
+
+/**
+ * @brief Make room for at least n rows without further allocation
+ *
+ * On failure the container is left unchanged. n is evaluated more than
+ * once and must not depend on the container itself.
+ *
+ * @param name Prefix given to TGSOA_DEFINE
+ * @param s    Container
+ * @param n    Required capacity
+ * @return Non-zero on success, 0 if the block could not be grown
+ */
+#define tgsoa_reserve(name, s, n) \
+    ((n) <= (s).cap ? 1 : name##_bytes(n) == 0 ? 0 : _tgalloc_soa_grow(name, s, (n)))
+
+/**
+ * @brief Set the number of rows, growing the capacity geometrically when needed
+ *
+ * New rows are uninitialised. On failure the container is left unchanged.
+ * n is evaluated more than once.
+ *
+ * @param name Prefix given to TGSOA_DEFINE
+ * @param s    Container
+ * @param n    New number of rows
+ * @return Non-zero on success, 0 if the block could not be grown
+ */
+#define tgsoa_resize(name, s, n) \
+    (tgsoa_reserve(name, s, name##_grow_cap((s).cap, (n))) ? ((s).len = (n), 1) : 0)
+
+/**
+ * @brief Release the block of a container and leave it empty
+ *
+ * @param name Prefix given to TGSOA_DEFINE
+ * @param s    Container
+ */
+#define tgsoa_free(name, s) \
+    ((s).block ? _tgalloc_call_free(TGA_FREE_A_S, _tgalloc_tga(1), (s).block, TGA_SOA_ALIGN, 1, \
+                                    name##_bytes((s).cap)) : (void)0, \
+     name##_carve(&(s), NULL, 0), (void)((s).len = 0))
+
+#endif // TGALLOC_SOA_H
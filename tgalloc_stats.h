@@ -0,0 +1,293 @@
+#ifndef TGALLOC_STATS_H
+#define TGALLOC_STATS_H
+
+/**
+ * @file tgalloc_stats.h
+ * @brief Allocation statistics for whichever backend is active
+ *
+ * Defining TGA_STATS before including tgalloc.h makes every palloc, pfree,
+ * pprealloc, pptry_expand, palloc_many and pfree_many report to a process-wide set of
+ * counters: call counts, histograms of sizes (by power of two) and of
+ * alignments, realloc growth ratios, and live and peak live bytes. This
+ * works with any backend because the counting happens around the
+ * TGA_ALLOC_A_S / TGA_REALLOC_A_S / TGA_FREE_A_S calls.
+ *
+ * Counters are spread over TGA_STATS_SHARDS shards updated with relaxed
+ * atomics, each thread sticking to one shard, so they are cheap enough to
+ * leave enabled. Only the live byte count is a single shared counter, which
+ * keeps the peak exact.
+ *
+ * The counters are shared by all translation units of a program. A unit
+ * that only reads them, through tga_stats_snapshot or tga_stats_dump, can
+ * include this header without defining TGA_STATS.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+/**
+ * @def TGA_STATS_SHARDS
+ * @brief Number of independent counter sets threads are spread over
+ */
+#ifndef TGA_STATS_SHARDS
+#define TGA_STATS_SHARDS 16
+#endif
+
+#define TGA_STATS_SIZE_BUCKETS 48
+#define TGA_STATS_ALIGN_BUCKETS 16
+#define TGA_STATS_GROWTH_BUCKETS 8
+
+/**
+ * @struct tga_stats_t
+ * @brief Snapshot of the allocation statistics
+ *
+ * size_hist[k] counts allocations of more than 2^(k-1) and at most 2^k bytes
+ * (size_hist[0] covers 0 and 1 byte), align_hist[k] counts allocations aligned
+ * to 2^k bytes. growth_hist buckets reallocs by new_size / old_size:
+ * shrink, [1, 1.25), [1.25, 1.5), [1.5, 2), [2, 4), [4, 8), [8, inf), and
+ * growth from zero bytes.
+ */
+typedef struct tga_stats_t {
+    size_t alloc_count;
+    size_t free_count;
+    size_t realloc_count;
+    size_t failed_count;
+    size_t allocated_bytes;   // Sum of all sizes ever allocated, growth included
+    size_t freed_bytes;       // Sum of all sizes ever freed, shrinkage included
+    size_t live_bytes;
+    size_t peak_live_bytes;
+    size_t size_hist[TGA_STATS_SIZE_BUCKETS];
+    size_t align_hist[TGA_STATS_ALIGN_BUCKETS];
+    size_t growth_hist[TGA_STATS_GROWTH_BUCKETS];
+} tga_stats_t;
+
+// One set of counters; everything but live/peak bytes lives in shards
+typedef struct _tgalloc_stats_state {
+    tga_stats_t shards[TGA_STATS_SHARDS];
+    size_t live_bytes;
+    size_t peak_live_bytes;
+    size_t next_shard;
+} _tgalloc_stats_state;
+
+_TGALLOC_WEAK _tgalloc_stats_state _tgalloc_stats_global = {0};
+
+// Shard of the calling thread, plus one; 0 until first use
+static _tgalloc_thread_local size_t _tgalloc_stats_my_shard;
+
+static inline tga_stats_t * _tgalloc_stats_shard(void){
+    if (_tgalloc_stats_my_shard == 0) {
+        size_t next = _tgalloc_atomic_fetch_add(&_tgalloc_stats_global.next_shard, 1, _TGALLOC_RELAXED);
+        _tgalloc_stats_my_shard = next % TGA_STATS_SHARDS + 1;
+    }
+    return &_tgalloc_stats_global.shards[_tgalloc_stats_my_shard - 1];
+}
+
+// Index of the smallest power of two that is >= value
+static inline size_t _tgalloc_stats_log2_ceil(size_t value){
+    size_t bucket = 0;
+    while (bucket < TGA_STATS_SIZE_BUCKETS - 1 && ((size_t)1 << bucket) < value) bucket++;
+    return bucket;
+}
+
+static inline void _tgalloc_stats_add(size_t * counter, size_t amount){
+    _tgalloc_atomic_fetch_add(counter, amount, _TGALLOC_RELAXED);
+}
+
+static inline void _tgalloc_stats_grow_live(size_t bytes){
+    size_t live = _tgalloc_atomic_fetch_add(&_tgalloc_stats_global.live_bytes, bytes, _TGALLOC_RELAXED) + bytes;
+    size_t peak = _tgalloc_atomic_load(&_tgalloc_stats_global.peak_live_bytes, _TGALLOC_RELAXED);
+    while (live > peak && !_tgalloc_atomic_cas(&_tgalloc_stats_global.peak_live_bytes, &peak, live, _TGALLOC_RELAXED)) {}
+}
+
+static inline void _tgalloc_stats_shrink_live(size_t bytes){
+    _tgalloc_atomic_fetch_add(&_tgalloc_stats_global.live_bytes, (size_t)0 - bytes, _TGALLOC_RELAXED);
+}
+
+// Record `count` successful allocations of `size` bytes each
+static inline void _tgalloc_stats_note_alloc(size_t count, size_t alignment, size_t size){
+    if (count == 0) return;
+    tga_stats_t * shard = _tgalloc_stats_shard();
+    _tgalloc_stats_add(&shard->alloc_count, count);
+    _tgalloc_stats_add(&shard->allocated_bytes, count * size);
+    _tgalloc_stats_add(&shard->size_hist[_tgalloc_stats_log2_ceil(size)], count);
+    size_t align_bucket = _tgalloc_stats_log2_ceil(alignment);
+    if (align_bucket >= TGA_STATS_ALIGN_BUCKETS) align_bucket = TGA_STATS_ALIGN_BUCKETS - 1;
+    _tgalloc_stats_add(&shard->align_hist[align_bucket], count);
+    _tgalloc_stats_grow_live(count * size);
+}
+
+// Record `count` frees of `size` bytes each
+static inline void _tgalloc_stats_note_free(size_t count, size_t size){
+    if (count == 0) return;
+    tga_stats_t * shard = _tgalloc_stats_shard();
+    _tgalloc_stats_add(&shard->free_count, count);
+    _tgalloc_stats_add(&shard->freed_bytes, count * size);
+    _tgalloc_stats_shrink_live(count * size);
+}
+
+static inline void _tgalloc_stats_note_failure(void){
+    _tgalloc_stats_add(&_tgalloc_stats_shard()->failed_count, 1);
+}
+
+// Bucket of growth_hist for a resize
+static inline size_t _tgalloc_stats_growth_bucket(size_t old_size, size_t new_size){
+    if (old_size == 0) return 7;
+    if (new_size < old_size) return 0;
+    if (new_size * 4 < old_size * 5) return 1;
+    if (new_size * 2 < old_size * 3) return 2;
+    if (new_size < old_size * 2) return 3;
+    if (new_size < old_size * 4) return 4;
+    if (new_size < old_size * 8) return 5;
+    return 6;
+}
+
+static inline void _tgalloc_stats_note_realloc(size_t old_size, size_t new_size){
+    tga_stats_t * shard = _tgalloc_stats_shard();
+    _tgalloc_stats_add(&shard->realloc_count, 1);
+    _tgalloc_stats_add(&shard->growth_hist[_tgalloc_stats_growth_bucket(old_size, new_size)], 1);
+    if (new_size > old_size) {
+        _tgalloc_stats_add(&shard->allocated_bytes, new_size - old_size);
+        _tgalloc_stats_grow_live(new_size - old_size);
+    } else {
+        _tgalloc_stats_add(&shard->freed_bytes, old_size - new_size);
+        _tgalloc_stats_shrink_live(old_size - new_size);
+    }
+}
+
+// Counting wrappers used by the palloc family when TGA_STATS is defined
+static inline void * _tgalloc_stats_alloc(void * self, tga_alloc_fn alloc_fn, size_t alignment, size_t size){
+    void * ptr = alloc_fn(self, alignment, size);
+    if (ptr) _tgalloc_stats_note_alloc(1, alignment, size);
+    else _tgalloc_stats_note_failure();
+    return ptr;
+}
+
+static inline void * _tgalloc_stats_calloc(void * self, tga_alloc_fn calloc_fn, tga_alloc_fn alloc_fn, size_t alignment,
+                                           size_t size){
+    void * ptr = _tgalloc_calloc(self, calloc_fn, alloc_fn, alignment, size);
+    if (ptr) _tgalloc_stats_note_alloc(1, alignment, size);
+    else _tgalloc_stats_note_failure();
+    return ptr;
+}
+
+static inline void * _tgalloc_stats_realloc(void * self, tga_realloc_fn realloc_fn, void * ptr, size_t alignment,
+                                            size_t old_size, size_t new_size){
+    void * resized = realloc_fn(self, ptr, alignment, old_size, new_size);
+    if (resized || new_size == 0) _tgalloc_stats_note_realloc(ptr ? old_size : 0, new_size);
+    else _tgalloc_stats_note_failure();
+    return resized;
+}
+
+static inline void _tgalloc_stats_free(void * self, tga_free_fn free_fn, void const * ptr, size_t alignment, size_t size){
+    if (ptr) _tgalloc_stats_note_free(1, size);
+    free_fn(self, ptr, alignment, size);
+}
+
+static inline int _tgalloc_stats_expand(void * self, tga_expand_fn expand_fn, void * ptr, size_t alignment,
+                                        size_t old_size, size_t new_size){
+    int expanded = expand_fn(self, ptr, alignment, old_size, new_size);
+    if (expanded) _tgalloc_stats_note_realloc(old_size, new_size);
+    return expanded;
+}
+
+static inline size_t _tgalloc_stats_alloc_batch(size_t done, size_t alignment, size_t size){
+    _tgalloc_stats_note_alloc(done, alignment, size);
+    return done;
+}
+
+static inline size_t _tgalloc_stats_free_batch(size_t count, size_t alignment, size_t size){
+    (void)alignment; // Mark as unused to prevent compiler warnings
+    _tgalloc_stats_note_free(count, size);
+    return count;
+}
+
+#ifdef TGA_STATS
+    #undef _tgalloc_call_alloc
+    #undef _tgalloc_call_calloc
+    #undef _tgalloc_call_realloc
+    #undef _tgalloc_call_free
+    #undef _tgalloc_call_expand
+    #undef _tgalloc_note_alloc_batch
+    #undef _tgalloc_note_free_batch
+    #define _tgalloc_call_alloc(fn, self, alignment, type_size, size) \
+        _tgalloc_stats_alloc((void*)(self), (tga_alloc_fn)(fn), alignment, size)
+    #define _tgalloc_call_calloc(fn, alloc_fn, self, alignment, type_size, size) \
+        _tgalloc_stats_calloc((void*)(self), (tga_alloc_fn)(fn), (tga_alloc_fn)(alloc_fn), alignment, size)
+    #define _tgalloc_call_realloc(fn, self, ptr, alignment, type_size, old_size, new_size) \
+        _tgalloc_stats_realloc((void*)(self), (tga_realloc_fn)(fn), ptr, alignment, old_size, new_size)
+    #define _tgalloc_call_free(fn, self, ptr, alignment, type_size, size) \
+        _tgalloc_stats_free((void*)(self), (tga_free_fn)(fn), ptr, alignment, size)
+    #define _tgalloc_call_expand(fn, self, ptr, alignment, type_size, old_size, new_size) \
+        _tgalloc_stats_expand((void*)(self), (tga_expand_fn)(fn), ptr, alignment, old_size, new_size)
+    #define _tgalloc_note_alloc_batch(done, alignment, size) _tgalloc_stats_alloc_batch(done, alignment, size)
+    #define _tgalloc_note_free_batch(count, alignment, size) _tgalloc_stats_free_batch(count, alignment, size)
+#endif
+
+/**
+ * @brief Copy the current statistics, summed over all shards
+ *
+ * Counters keep moving while the copy is taken, so the totals of a busy
+ * program are only approximately consistent with each other.
+ *
+ * @param out Receives the statistics
+ */
+static inline void tga_stats_snapshot(tga_stats_t * out){
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < TGA_STATS_SHARDS; i++) {
+        size_t const * src = (size_t const *)&_tgalloc_stats_global.shards[i];
+        size_t * dst = (size_t *)out;
+        for (size_t j = 0; j < sizeof(*out) / sizeof(size_t); j++) {
+            dst[j] += _tgalloc_atomic_load(&src[j], _TGALLOC_RELAXED);
+        }
+    }
+    out->live_bytes = _tgalloc_atomic_load(&_tgalloc_stats_global.live_bytes, _TGALLOC_RELAXED);
+    out->peak_live_bytes = _tgalloc_atomic_load(&_tgalloc_stats_global.peak_live_bytes, _TGALLOC_RELAXED);
+}
+
+/**
+ * @brief Zero all counters; the peak restarts from the current live bytes
+ *
+ * Not synchronised with concurrent allocations, which may be partly lost.
+ */
+static inline void tga_stats_reset(void){
+    size_t live = _tgalloc_atomic_load(&_tgalloc_stats_global.live_bytes, _TGALLOC_RELAXED);
+    memset(_tgalloc_stats_global.shards, 0, sizeof(_tgalloc_stats_global.shards));
+    _tgalloc_atomic_store(&_tgalloc_stats_global.peak_live_bytes, live, _TGALLOC_RELAXED);
+}
+
+/**
+ * @brief Print the statistics in a human readable form
+ *
+ * Empty histogram buckets are skipped.
+ *
+ * @param out Stream to write to, e.g. stderr
+ */
+static inline void tga_stats_dump(FILE * out){
+    static char const * const growth_labels[TGA_STATS_GROWTH_BUCKETS] = {
+        "shrink", "x1-1.25", "x1.25-1.5", "x1.5-2", "x2-4", "x4-8", "x8+", "from 0"
+    };
+    tga_stats_t stats;
+    tga_stats_snapshot(&stats);
+
+    fprintf(out, "tgalloc statistics\n");
+    fprintf(out, "  allocs %zu  frees %zu  reallocs %zu  failures %zu\n",
+            stats.alloc_count, stats.free_count, stats.realloc_count, stats.failed_count);
+    fprintf(out, "  live bytes %zu  peak live bytes %zu\n", stats.live_bytes, stats.peak_live_bytes);
+    fprintf(out, "  allocated bytes %zu  freed bytes %zu\n", stats.allocated_bytes, stats.freed_bytes);
+    fprintf(out, "  sizes:\n");
+    for (size_t k = 0; k < TGA_STATS_SIZE_BUCKETS; k++) {
+        if (stats.size_hist[k]) fprintf(out, "    <= %zu B: %zu\n", (size_t)1 << k, stats.size_hist[k]);
+    }
+    fprintf(out, "  alignments:\n");
+    for (size_t k = 0; k < TGA_STATS_ALIGN_BUCKETS; k++) {
+        if (stats.align_hist[k]) fprintf(out, "    %zu B: %zu\n", (size_t)1 << k, stats.align_hist[k]);
+    }
+    fprintf(out, "  realloc growth:\n");
+    for (size_t k = 0; k < TGA_STATS_GROWTH_BUCKETS; k++) {
+        if (stats.growth_hist[k]) fprintf(out, "    %s: %zu\n", growth_labels[k], stats.growth_hist[k]);
+    }
+}
+
+#endif // TGALLOC_STATS_H
@@ -0,0 +1,371 @@
+#ifndef TGALLOC_TCACHE_H
+#define TGALLOC_TCACHE_H
+
+/**
+ * @file tgalloc_tcache.h
+ * @brief Thread-caching front-end for any TGA backend
+ *
+ * A tga_tcache_t wraps a backend that need not be thread-safe (an arena, a
+ * pool, ...) and makes it usable from many threads at once. Small requests
+ * are rounded up to a size class and served from a per-thread magazine, a
+ * small stack of cached blocks, without any locking. Only when a magazine
+ * runs empty or overflows is the lock on the wrapped backend taken, and then
+ * a whole batch of blocks is moved at once.
+ *
+ * Blocks may be freed on a different thread than the one that allocated
+ * them; they simply join the freeing thread's magazine. A thread's cached
+ * blocks go back to the backend when the thread exits, when it calls
+ * tga_tcache_flush, or when the cache is destroyed.
+ *
+ * Usage:
+ * @code
+ * tga_arena_t arena;
+ * tga_tcache_t tcache;
+ * tga_arena_init(&arena);
+ * tga_tcache_init(&tcache, TGA_BACKEND(&arena, tga_arena_alloc_aligned_sized,
+ *     tga_arena_realloc_aligned_sized, tga_arena_free_aligned_sized));
+ *
+ * #define TGA (tga_tcache_t*)&tcache
+ * #define TGA_ALLOC_A_S tga_tcache_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_tcache_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_tcache_free_aligned_sized
+ * @endcode
+ */
+
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+/**
+ * @def TGA_TCACHE_QUANTUM
+ * @brief Granularity of the cached size classes, also the alignment they guarantee
+ */
+#ifndef TGA_TCACHE_QUANTUM
+#define TGA_TCACHE_QUANTUM 16
+#endif
+
+/**
+ * @def TGA_TCACHE_MAX_SMALL
+ * @brief Largest request that is cached per thread
+ */
+#ifndef TGA_TCACHE_MAX_SMALL
+#define TGA_TCACHE_MAX_SMALL 256
+#endif
+
+/**
+ * @def TGA_TCACHE_MAG_SIZE
+ * @brief Number of blocks a thread caches per size class
+ */
+#ifndef TGA_TCACHE_MAG_SIZE
+#define TGA_TCACHE_MAG_SIZE 64
+#endif
+
+/**
+ * @def TGA_TCACHE_BATCH
+ * @brief Number of blocks moved to or from the backend under one lock
+ */
+#ifndef TGA_TCACHE_BATCH
+#define TGA_TCACHE_BATCH (TGA_TCACHE_MAG_SIZE / 2)
+#endif
+
+#define TGA_TCACHE_NUM_CLASSES (TGA_TCACHE_MAX_SMALL / TGA_TCACHE_QUANTUM)
+
+// Cached blocks of one size class
+typedef struct _tgalloc_tcache_mag {
+    size_t count;
+    void * slots[TGA_TCACHE_MAG_SIZE];
+} _tgalloc_tcache_mag;
+
+// Everything a single thread caches for a single tga_tcache_t
+typedef struct _tgalloc_tcache_local {
+    struct tga_tcache_t * owner;
+    struct _tgalloc_tcache_local * prev;
+    struct _tgalloc_tcache_local * next;
+    _tgalloc_tcache_mag mags[TGA_TCACHE_NUM_CLASSES];
+} _tgalloc_tcache_local;
+
+/**
+ * @struct tga_tcache_t
+ * @brief Shared state of a thread cache
+ */
+typedef struct tga_tcache_t {
+    tga_backend_t backend;             // Wrapped backend, only touched under lock
+    _tgalloc_mutex_t lock;
+    _tgalloc_tls_key_t key;            // Maps each thread to its _tgalloc_tcache_local
+    _tgalloc_tcache_local * locals;    // Caches of all live threads
+} tga_tcache_t;
+
+// Size class of a request; size 0 shares the smallest class
+#define _tgalloc_tcache_class(size) ((size) ? ((size) - 1) / TGA_TCACHE_QUANTUM : 0)
+
+// Byte size the backend is asked for on behalf of a class
+#define _tgalloc_tcache_class_size(cls) (((cls) + 1) * TGA_TCACHE_QUANTUM)
+
+// Whether a request goes through the per-thread magazines
+#define _tgalloc_tcache_is_small(alignment, size) \
+    ((size) <= TGA_TCACHE_MAX_SMALL && (alignment) <= TGA_TCACHE_QUANTUM)
+
+// Return the oldest `count` blocks of a magazine to the backend; lock must be held
+static inline void _tgalloc_tcache_drain_locked(tga_tcache_t * self, _tgalloc_tcache_mag * mag, size_t cls, size_t count){
+    for (size_t i = 0; i < count; i++) {
+        self->backend.free_a_s(self->backend.self, mag->slots[i], TGA_TCACHE_QUANTUM, _tgalloc_tcache_class_size(cls));
+    }
+    memmove(mag->slots, mag->slots + count, (mag->count - count) * sizeof(void*));
+    mag->count -= count;
+}
+
+// Empty every magazine of a thread, unlink and free it; lock must be held
+static inline void _tgalloc_tcache_release_locked(tga_tcache_t * self, _tgalloc_tcache_local * local){
+    for (size_t cls = 0; cls < TGA_TCACHE_NUM_CLASSES; cls++) {
+        _tgalloc_tcache_drain_locked(self, &local->mags[cls], cls, local->mags[cls].count);
+    }
+    if (local->prev) local->prev->next = local->next;
+    else self->locals = local->next;
+    if (local->next) local->next->prev = local->prev;
+    self->backend.free_a_s(self->backend.self, local, _tgalloc_alignof(local), sizeof(*local));
+}
+
+// Thread exit hook installed on the TLS key
+static inline void _TGALLOC_TLS_DTOR _tgalloc_tcache_thread_exit(void * value){
+    _tgalloc_tcache_local * local = (_tgalloc_tcache_local*)value;
+    tga_tcache_t * self = local->owner;
+    _tgalloc_mutex_lock(&self->lock);
+    _tgalloc_tcache_release_locked(self, local);
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+// Find or create the calling thread's cache; NULL if it could not be created
+static inline _tgalloc_tcache_local * _tgalloc_tcache_local_get(tga_tcache_t * self){
+    _tgalloc_tcache_local * local = (_tgalloc_tcache_local*)_tgalloc_tls_get(self->key);
+    if (local) return local;
+    _tgalloc_mutex_lock(&self->lock);
+    local = (_tgalloc_tcache_local*)self->backend.alloc_a_s(self->backend.self, _tgalloc_alignof(local), sizeof(*local));
+    if (local) {
+        memset(local, 0, sizeof(*local));
+        local->owner = self;
+        local->next = self->locals;
+        if (self->locals) self->locals->prev = local;
+        self->locals = local;
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+    if (local) _tgalloc_tls_set(self->key, local);
+    return local;
+}
+
+// Slow path: fetch a batch of blocks for an empty magazine
+static inline int _tgalloc_tcache_refill(tga_tcache_t * self, _tgalloc_tcache_mag * mag, size_t cls){
+    _tgalloc_mutex_lock(&self->lock);
+    while (mag->count < TGA_TCACHE_BATCH) {
+        void * block = self->backend.alloc_a_s(self->backend.self, TGA_TCACHE_QUANTUM, _tgalloc_tcache_class_size(cls));
+        if (block == NULL) break;
+        mag->slots[mag->count++] = block;
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+    return mag->count != 0;
+}
+
+/**
+ * @brief Initialise a thread cache in front of a backend
+ *
+ * The per-thread caches themselves are allocated from the backend as well.
+ *
+ * @param self    Thread cache to initialise
+ * @param backend Backend to wrap; it is only ever called with the lock held
+ * @return 0 on success, -1 if no thread-specific storage key or lock could be created
+ */
+static inline int tga_tcache_init(tga_tcache_t * self, tga_backend_t backend){
+    memset(self, 0, sizeof(*self));
+    self->backend = backend;
+    if (_tgalloc_tls_create(&self->key, _tgalloc_tcache_thread_exit) != 0) return -1;
+    if (_tgalloc_mutex_init(&self->lock) != 0) {
+        _tgalloc_tls_delete(self->key);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Return the calling thread's cached blocks to the backend
+ *
+ * @param self Thread cache to flush
+ */
+static inline void tga_tcache_flush(tga_tcache_t * self){
+    _tgalloc_tcache_local * local = (_tgalloc_tcache_local*)_tgalloc_tls_get(self->key);
+    if (local == NULL) return;
+    _tgalloc_mutex_lock(&self->lock);
+    for (size_t cls = 0; cls < TGA_TCACHE_NUM_CLASSES; cls++) {
+        _tgalloc_tcache_drain_locked(self, &local->mags[cls], cls, local->mags[cls].count);
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+/**
+ * @brief Return the cached blocks of every thread to the backend
+ *
+ * No other thread may use the cache during or after this call. The wrapped
+ * backend itself is left alone.
+ *
+ * @param self Thread cache to destroy
+ */
+static inline void tga_tcache_destroy(tga_tcache_t * self){
+    _tgalloc_mutex_lock(&self->lock);
+    while (self->locals) _tgalloc_tcache_release_locked(self, self->locals);
+    _tgalloc_mutex_unlock(&self->lock);
+    _tgalloc_tls_delete(self->key);
+    _tgalloc_mutex_destroy(&self->lock);
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the thread cache
+ */
+static inline void * tga_tcache_alloc_aligned_sized(tga_tcache_t * self, size_t alignment, size_t size){
+    if (_tgalloc_tcache_is_small(alignment, size)) {
+        size_t cls = _tgalloc_tcache_class(size);
+        _tgalloc_tcache_local * local = _tgalloc_tcache_local_get(self);
+        if (local) {
+            _tgalloc_tcache_mag * mag = &local->mags[cls];
+            if (mag->count || _tgalloc_tcache_refill(self, mag, cls)) return mag->slots[--mag->count];
+            return NULL;
+        }
+        alignment = TGA_TCACHE_QUANTUM;
+        size = _tgalloc_tcache_class_size(cls);
+    }
+    _tgalloc_mutex_lock(&self->lock);
+    void * ptr = self->backend.alloc_a_s(self->backend.self, alignment, size);
+    _tgalloc_mutex_unlock(&self->lock);
+    return ptr;
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the thread cache
+ */
+static inline void tga_tcache_free_aligned_sized(tga_tcache_t * self, void const * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (_tgalloc_tcache_is_small(alignment, size)) {
+        size_t cls = _tgalloc_tcache_class(size);
+        _tgalloc_tcache_local * local = _tgalloc_tcache_local_get(self);
+        if (local) {
+            _tgalloc_tcache_mag * mag = &local->mags[cls];
+            if (mag->count == TGA_TCACHE_MAG_SIZE) {
+                _tgalloc_mutex_lock(&self->lock);
+                _tgalloc_tcache_drain_locked(self, mag, cls, TGA_TCACHE_BATCH);
+                _tgalloc_mutex_unlock(&self->lock);
+            }
+            mag->slots[mag->count++] = (void*)ptr;
+            return;
+        }
+        alignment = TGA_TCACHE_QUANTUM;
+        size = _tgalloc_tcache_class_size(cls);
+    }
+    _tgalloc_mutex_lock(&self->lock);
+    self->backend.free_a_s(self->backend.self, ptr, alignment, size);
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+/**
+ * @brief TGA_ALLOC_BATCH_A_S implementation of the thread cache
+ *
+ * Takes what the calling thread's magazine holds and fetches the rest from
+ * the backend under a single lock acquisition.
+ */
+static inline size_t tga_tcache_alloc_batch_aligned_sized(tga_tcache_t * self, size_t alignment, size_t size,
+                                                          void ** out, size_t count){
+    size_t done = 0;
+    if (_tgalloc_tcache_is_small(alignment, size)) {
+        size_t cls = _tgalloc_tcache_class(size);
+        _tgalloc_tcache_local * local = _tgalloc_tcache_local_get(self);
+        if (local) {
+            _tgalloc_tcache_mag * mag = &local->mags[cls];
+            while (done < count && mag->count) out[done++] = mag->slots[--mag->count];
+        }
+        alignment = TGA_TCACHE_QUANTUM;
+        size = _tgalloc_tcache_class_size(cls);
+    }
+    if (done < count) {
+        _tgalloc_mutex_lock(&self->lock);
+        done += _tgalloc_alloc_batch_loop(self->backend.self, self->backend.alloc_a_s, alignment, size,
+                                          out + done, count - done);
+        _tgalloc_mutex_unlock(&self->lock);
+    }
+    return done;
+}
+
+/**
+ * @brief TGA_FREE_BATCH_A_S implementation of the thread cache
+ *
+ * Fills the calling thread's magazine and returns the overflow to the
+ * backend under a single lock acquisition.
+ */
+static inline void tga_tcache_free_batch_aligned_sized(tga_tcache_t * self, void * const * ptrs, size_t alignment,
+                                                       size_t size, size_t count){
+    size_t done = 0;
+    if (_tgalloc_tcache_is_small(alignment, size)) {
+        size_t cls = _tgalloc_tcache_class(size);
+        _tgalloc_tcache_local * local = _tgalloc_tcache_local_get(self);
+        if (local) {
+            _tgalloc_tcache_mag * mag = &local->mags[cls];
+            for (; done < count && mag->count < TGA_TCACHE_MAG_SIZE; done++) {
+                if (ptrs[done]) mag->slots[mag->count++] = ptrs[done];
+            }
+        }
+        alignment = TGA_TCACHE_QUANTUM;
+        size = _tgalloc_tcache_class_size(cls);
+    }
+    if (done < count) {
+        _tgalloc_mutex_lock(&self->lock);
+        _tgalloc_free_batch_loop(self->backend.self, self->backend.free_a_s, ptrs + done, alignment, size,
+                                 count - done);
+        _tgalloc_mutex_unlock(&self->lock);
+    }
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the thread cache
+ *
+ * Resizing within a size class returns the same block, and blocks that stay
+ * outside the classes are resized by the backend under the lock.
+ */
+static inline void * tga_tcache_realloc_aligned_sized(tga_tcache_t * self, void * ptr, size_t alignment,
+                                                      size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_tcache_alloc_aligned_sized(self, alignment, new_size);
+    int old_small = _tgalloc_tcache_is_small(alignment, old_size);
+    int new_small = _tgalloc_tcache_is_small(alignment, new_size);
+    if (old_small && new_small && _tgalloc_tcache_class(old_size) == _tgalloc_tcache_class(new_size)) {
+        return ptr;
+    }
+    if (!old_small && !new_small) {
+        _tgalloc_mutex_lock(&self->lock);
+        void * resized = self->backend.realloc_a_s(self->backend.self, ptr, alignment, old_size, new_size);
+        _tgalloc_mutex_unlock(&self->lock);
+        return resized;
+    }
+    void * moved = tga_tcache_alloc_aligned_sized(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_tcache_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the thread cache
+ *
+ * Succeeds within a size class, and for large blocks whenever the backend
+ * can resize them in place.
+ */
+static inline int tga_tcache_expand_aligned_sized(tga_tcache_t * self, void * ptr, size_t alignment,
+                                                  size_t old_size, size_t new_size){
+    if (ptr == NULL) return 0;
+    int old_small = _tgalloc_tcache_is_small(alignment, old_size);
+    int new_small = _tgalloc_tcache_is_small(alignment, new_size);
+    if (old_small && new_small) return _tgalloc_tcache_class(old_size) == _tgalloc_tcache_class(new_size);
+    if (!old_small && !new_small) {
+        _tgalloc_mutex_lock(&self->lock);
+        int expanded = _tgalloc_expand_fallback(self->backend.alloc_a_s)(self->backend.self, ptr, alignment,
+                                                                         old_size, new_size);
+        _tgalloc_mutex_unlock(&self->lock);
+        return expanded;
+    }
+    return 0;
+}
+
+#endif // TGALLOC_TCACHE_H
@@ -0,0 +1,349 @@
+#ifndef TGALLOC_THEAP_H
+#define TGALLOC_THEAP_H
+
+/**
+ * @file tgalloc_theap.h
+ * @brief Per-thread heaps with lock-free frees from other threads
+ *
+ * Every thread that allocates through a tga_theap_t gets its own heap,
+ * which carves small blocks from chunks aligned to their own size. The
+ * start of each chunk records the heap that owns it, so freeing finds the
+ * owner by masking the pointer; the sized free supplies the size class,
+ * so no per-block header is needed. A block freed by its owner goes
+ * straight onto the owner's free list. A block freed by any other thread
+ * is pushed, lock-free, onto the owner's remote list, which has a single
+ * consumer: the owner takes the whole list with one atomic exchange the
+ * next time one of its free lists runs empty.
+ *
+ * This suits pipelines where objects are allocated on a producer thread and
+ * freed on a consumer thread. Neither side takes a lock for small blocks
+ * except to fetch a new chunk.
+ *
+ * When a thread exits its heap is kept, with all its blocks, for the next
+ * new thread to adopt, since other threads may still free blocks into it.
+ * Chunks only go back to the upstream backend when the whole tga_theap_t is
+ * destroyed. Large or over-aligned requests are passed to the upstream
+ * backend under a lock.
+ *
+ * Usage:
+ * @code
+ * tga_theap_t theap;
+ * tga_theap_init(&theap, TGA_BACKEND_DEFAULT);
+ *
+ * #define TGA (tga_theap_t*)&theap
+ * #define TGA_ALLOC_A_S tga_theap_alloc_aligned_sized
+ * #define TGA_REALLOC_A_S tga_theap_realloc_aligned_sized
+ * #define TGA_FREE_A_S tga_theap_free_aligned_sized
+ * #define TGA_EXPAND_A_S tga_theap_expand_aligned_sized
+ * @endcode
+ */
+
+#include <string.h>
+#include "tgalloc.h"
+#include "__tgalloc_sync.h"
+
+/**
+ * @def TGA_THEAP_QUANTUM
+ * @brief Granularity of the size classes, also the alignment they guarantee
+ *
+ * Must be at least twice the size of a pointer, the space a free block needs
+ * to sit on a remote list.
+ */
+#ifndef TGA_THEAP_QUANTUM
+#define TGA_THEAP_QUANTUM 16
+#endif
+
+/**
+ * @def TGA_THEAP_MAX_SMALL
+ * @brief Largest request served by the per-thread heaps
+ */
+#ifndef TGA_THEAP_MAX_SMALL
+#define TGA_THEAP_MAX_SMALL 1024
+#endif
+
+/**
+ * @def TGA_THEAP_CHUNK_SIZE
+ * @brief Size and alignment of the chunks small blocks are carved from; a power of two
+ */
+#ifndef TGA_THEAP_CHUNK_SIZE
+#define TGA_THEAP_CHUNK_SIZE (64 * 1024)
+#endif
+
+#define TGA_THEAP_NUM_CLASSES (TGA_THEAP_MAX_SMALL / TGA_THEAP_QUANTUM)
+
+// A free block, linked into a free list or a remote list. Remote frees
+// record the size class because the owner sorts them into its free lists.
+typedef struct _tgalloc_theap_node {
+    struct _tgalloc_theap_node * next;
+    size_t cls;
+} _tgalloc_theap_node;
+
+// Header at the start of every chunk
+typedef struct _tgalloc_theap_chunk {
+    struct _tgalloc_theap_heap * owner;
+    struct _tgalloc_theap_chunk * next;
+} _tgalloc_theap_chunk;
+
+// The heap of one thread; only the thread that holds it touches anything
+// but the remote list
+typedef struct _tgalloc_theap_heap {
+    struct tga_theap_t * shared;
+    _tgalloc_theap_node * remote;           // Pushed by other threads, taken by the owner
+    struct _tgalloc_theap_heap * next;      // All heaps of the tga_theap_t
+    struct _tgalloc_theap_heap * next_orphan;
+    char * bump;                            // Unused part of the newest chunk
+    char * end;
+    _tgalloc_theap_chunk * chunks;
+    _tgalloc_theap_node * free_lists[TGA_THEAP_NUM_CLASSES];
+} _tgalloc_theap_heap;
+
+/**
+ * @struct tga_theap_t
+ * @brief Shared state of a set of per-thread heaps
+ */
+typedef struct tga_theap_t {
+    tga_backend_t upstream;             // Only touched under lock
+    _tgalloc_mutex_t lock;
+    _tgalloc_tls_key_t key;             // Maps each thread to its heap
+    _tgalloc_theap_heap * heaps;        // Every heap ever created
+    _tgalloc_theap_heap * orphans;      // Heaps of exited threads, waiting to be adopted
+} tga_theap_t;
+
+// Size class of a request; size 0 shares the smallest class
+#define _tgalloc_theap_class(size) ((size) ? ((size) - 1) / TGA_THEAP_QUANTUM : 0)
+
+// Byte size of the blocks of a class
+#define _tgalloc_theap_class_size(cls) (((cls) + 1) * TGA_THEAP_QUANTUM)
+
+// Whether a request is served by the per-thread heaps
+#define _tgalloc_theap_is_small(alignment, size) \
+    ((size) <= TGA_THEAP_MAX_SMALL && (alignment) <= TGA_THEAP_QUANTUM)
+
+// Offset of the first block in a chunk
+#define _tgalloc_theap_chunk_header \
+    ((sizeof(_tgalloc_theap_chunk) + TGA_THEAP_QUANTUM - 1) / TGA_THEAP_QUANTUM * TGA_THEAP_QUANTUM)
+
+// Heap owning a small block
+static inline _tgalloc_theap_heap * _tgalloc_theap_owner(void const * ptr){
+    uintptr_t chunk = (uintptr_t)ptr & ~(uintptr_t)(TGA_THEAP_CHUNK_SIZE - 1);
+    return ((_tgalloc_theap_chunk*)chunk)->owner;
+}
+
+// Thread exit hook installed on the TLS key: leave the heap for adoption
+static inline void _TGALLOC_TLS_DTOR _tgalloc_theap_thread_exit(void * value){
+    _tgalloc_theap_heap * heap = (_tgalloc_theap_heap*)value;
+    tga_theap_t * self = heap->shared;
+    _tgalloc_mutex_lock(&self->lock);
+    heap->next_orphan = self->orphans;
+    self->orphans = heap;
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+// Find, adopt or create the calling thread's heap; NULL if none could be created
+static inline _tgalloc_theap_heap * _tgalloc_theap_heap_get(tga_theap_t * self){
+    _tgalloc_theap_heap * heap = (_tgalloc_theap_heap*)_tgalloc_tls_get(self->key);
+    if (heap) return heap;
+    _tgalloc_mutex_lock(&self->lock);
+    heap = self->orphans;
+    if (heap) {
+        self->orphans = heap->next_orphan;
+    } else {
+        heap = (_tgalloc_theap_heap*)self->upstream.alloc_a_s(self->upstream.self, _tgalloc_alignof(heap),
+                                                              sizeof(*heap));
+        if (heap) {
+            memset(heap, 0, sizeof(*heap));
+            heap->shared = self;
+            heap->next = self->heaps;
+            self->heaps = heap;
+        }
+    }
+    _tgalloc_mutex_unlock(&self->lock);
+    if (heap) _tgalloc_tls_set(self->key, heap);
+    return heap;
+}
+
+// Sort everything other threads freed into the heap's own free lists
+static inline void _tgalloc_theap_collect(_tgalloc_theap_heap * heap){
+    _tgalloc_theap_node * node = _tgalloc_atomic_exchange(&heap->remote, (_tgalloc_theap_node*)NULL, _TGALLOC_ACQUIRE);
+    while (node) {
+        _tgalloc_theap_node * next = node->next;
+        node->next = heap->free_lists[node->cls];
+        heap->free_lists[node->cls] = node;
+        node = next;
+    }
+}
+
+// Slow path: a block of a class whose free list is empty
+static inline void * _tgalloc_theap_refill(tga_theap_t * self, _tgalloc_theap_heap * heap, size_t cls){
+    _tgalloc_theap_collect(heap);
+    _tgalloc_theap_node * node = heap->free_lists[cls];
+    if (node) {
+        heap->free_lists[cls] = node->next;
+        return node;
+    }
+
+    size_t size = _tgalloc_theap_class_size(cls);
+    if ((size_t)(heap->end - heap->bump) < size) {
+        _tgalloc_mutex_lock(&self->lock);
+        _tgalloc_theap_chunk * chunk = (_tgalloc_theap_chunk*)self->upstream.alloc_a_s(
+            self->upstream.self, TGA_THEAP_CHUNK_SIZE, TGA_THEAP_CHUNK_SIZE);
+        _tgalloc_mutex_unlock(&self->lock);
+        if (chunk == NULL) return NULL;
+        chunk->owner = heap;
+        chunk->next = heap->chunks;
+        heap->chunks = chunk;
+        heap->bump = (char*)chunk + _tgalloc_theap_chunk_header;
+        heap->end = (char*)chunk + TGA_THEAP_CHUNK_SIZE;
+    }
+    void * block = heap->bump;
+    heap->bump += size;
+    return block;
+}
+
+/**
+ * @brief Initialise a set of per-thread heaps
+ *
+ * @param self     Heaps to initialise
+ * @param upstream Backend for chunks, heap bookkeeping and large requests;
+ *                 it is only ever called with the lock held, and must
+ *                 support alignments up to TGA_THEAP_CHUNK_SIZE
+ * @return 0 on success, -1 if no thread-specific storage key or lock could be created
+ */
+static inline int tga_theap_init(tga_theap_t * self, tga_backend_t upstream){
+    memset(self, 0, sizeof(*self));
+    self->upstream = upstream;
+    if (_tgalloc_tls_create(&self->key, _tgalloc_theap_thread_exit) != 0) return -1;
+    if (_tgalloc_mutex_init(&self->lock) != 0) {
+        _tgalloc_tls_delete(self->key);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Return every chunk of every heap to the upstream backend
+ *
+ * No other thread may use the heaps during or after this call, and every
+ * block they handed out becomes invalid. Large blocks held by the caller
+ * are left alone.
+ *
+ * @param self Heaps to destroy
+ */
+static inline void tga_theap_destroy(tga_theap_t * self){
+    _tgalloc_mutex_lock(&self->lock);
+    while (self->heaps) {
+        _tgalloc_theap_heap * heap = self->heaps;
+        self->heaps = heap->next;
+        while (heap->chunks) {
+            _tgalloc_theap_chunk * chunk = heap->chunks;
+            heap->chunks = chunk->next;
+            self->upstream.free_a_s(self->upstream.self, chunk, TGA_THEAP_CHUNK_SIZE, TGA_THEAP_CHUNK_SIZE);
+        }
+        self->upstream.free_a_s(self->upstream.self, heap, _tgalloc_alignof(heap), sizeof(*heap));
+    }
+    self->orphans = NULL;
+    _tgalloc_mutex_unlock(&self->lock);
+    _tgalloc_tls_delete(self->key);
+    _tgalloc_mutex_destroy(&self->lock);
+}
+
+/**
+ * @brief TGA_ALLOC_A_S implementation of the per-thread heaps
+ */
+static inline void * tga_theap_alloc_aligned_sized(tga_theap_t * self, size_t alignment, size_t size){
+    if (_tgalloc_theap_is_small(alignment, size)) {
+        _tgalloc_theap_heap * heap = _tgalloc_theap_heap_get(self);
+        if (heap == NULL) return NULL;
+        size_t cls = _tgalloc_theap_class(size);
+        _tgalloc_theap_node * node = heap->free_lists[cls];
+        if (node) {
+            heap->free_lists[cls] = node->next;
+            return node;
+        }
+        return _tgalloc_theap_refill(self, heap, cls);
+    }
+    _tgalloc_mutex_lock(&self->lock);
+    void * ptr = self->upstream.alloc_a_s(self->upstream.self, alignment, size);
+    _tgalloc_mutex_unlock(&self->lock);
+    return ptr;
+}
+
+/**
+ * @brief TGA_FREE_A_S implementation of the per-thread heaps
+ *
+ * Small blocks go back to the heap that allocated them: directly when the
+ * caller owns it, through its lock-free remote list otherwise.
+ */
+static inline void tga_theap_free_aligned_sized(tga_theap_t * self, void const * ptr, size_t alignment, size_t size){
+    if (ptr == NULL) return;
+    if (_tgalloc_theap_is_small(alignment, size)) {
+        _tgalloc_theap_node * node = (_tgalloc_theap_node*)ptr;
+        _tgalloc_theap_heap * owner = _tgalloc_theap_owner(ptr);
+        size_t cls = _tgalloc_theap_class(size);
+        if (owner == (_tgalloc_theap_heap*)_tgalloc_tls_get(self->key)) {
+            node->next = owner->free_lists[cls];
+            owner->free_lists[cls] = node;
+            return;
+        }
+        node->cls = cls;
+        _tgalloc_theap_node * head = _tgalloc_atomic_load(&owner->remote, _TGALLOC_RELAXED);
+        do {
+            node->next = head;
+        } while (!_tgalloc_atomic_cas(&owner->remote, &head, node, _TGALLOC_RELEASE));
+        return;
+    }
+    _tgalloc_mutex_lock(&self->lock);
+    self->upstream.free_a_s(self->upstream.self, ptr, alignment, size);
+    _tgalloc_mutex_unlock(&self->lock);
+}
+
+/**
+ * @brief TGA_REALLOC_A_S implementation of the per-thread heaps
+ *
+ * Resizing within a size class returns the same block, and blocks that stay
+ * outside the classes are resized by the upstream backend under the lock.
+ */
+static inline void * tga_theap_realloc_aligned_sized(tga_theap_t * self, void * ptr, size_t alignment,
+                                                     size_t old_size, size_t new_size){
+    if (ptr == NULL) return tga_theap_alloc_aligned_sized(self, alignment, new_size);
+    int old_small = _tgalloc_theap_is_small(alignment, old_size);
+    int new_small = _tgalloc_theap_is_small(alignment, new_size);
+    if (old_small && new_small && _tgalloc_theap_class(old_size) == _tgalloc_theap_class(new_size)) {
+        return ptr;
+    }
+    if (!old_small && !new_small) {
+        _tgalloc_mutex_lock(&self->lock);
+        void * resized = self->upstream.realloc_a_s(self->upstream.self, ptr, alignment, old_size, new_size);
+        _tgalloc_mutex_unlock(&self->lock);
+        return resized;
+    }
+    void * moved = tga_theap_alloc_aligned_sized(self, alignment, new_size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    tga_theap_free_aligned_sized(self, ptr, alignment, old_size);
+    return moved;
+}
+
+/**
+ * @brief TGA_EXPAND_A_S implementation of the per-thread heaps
+ *
+ * Succeeds within a size class, and for large blocks whenever the upstream
+ * backend can resize them in place.
+ */
+static inline int tga_theap_expand_aligned_sized(tga_theap_t * self, void * ptr, size_t alignment,
+                                                 size_t old_size, size_t new_size){
+    if (ptr == NULL) return 0;
+    int old_small = _tgalloc_theap_is_small(alignment, old_size);
+    int new_small = _tgalloc_theap_is_small(alignment, new_size);
+    if (old_small && new_small) return _tgalloc_theap_class(old_size) == _tgalloc_theap_class(new_size);
+    if (!old_small && !new_small) {
+        _tgalloc_mutex_lock(&self->lock);
+        int expanded = _tgalloc_expand_fallback(self->upstream.alloc_a_s)(self->upstream.self, ptr, alignment,
+                                                                          old_size, new_size);
+        _tgalloc_mutex_unlock(&self->lock);
+        return expanded;
+    }
+    return 0;
+}
+
+#endif // TGALLOC_THEAP_H
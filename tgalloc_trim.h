@@ -0,0 +1,121 @@
+#ifndef TGALLOC_TRIM_H
+#define TGALLOC_TRIM_H
+
+/**
+ * @file tgalloc_trim.h
+ * @brief Shrinking arrays so that their released tail leaves the resident set
+ *
+ * pprealloc to a smaller length tells the backend the tail is no longer
+ * needed, but malloc usually keeps the tail of a big block resident: it is
+ * split off into a free chunk in the middle of the heap, which the system
+ * never gets back. ptrim first discards the whole pages of the tail with
+ * madvise, then shrinks the block through TGA_REALLOC_A_S as usual, so the
+ * resident set drops right away whatever the backend does with the tail.
+ *
+ * Pages are discarded with MADV_DONTNEED, which frees them immediately.
+ * Define TGA_TRIM_LAZY to use MADV_FREE where available instead: the kernel
+ * then only takes the pages under memory pressure, which is cheaper when the
+ * memory is likely to be reused soon.
+ *
+ * madvise and its flags are only declared with _GNU_SOURCE (or
+ * _DEFAULT_SOURCE) defined; this header defines it on Linux, which takes
+ * effect when it is included before any system header. Without them ptrim
+ * only shrinks the block.
+ *
+ * Usage:
+ * @code
+ * #include "tgalloc_trim.h"
+ *
+ * double* samples = NULL;
+ * palloc(samples, 1 << 24);
+ * size_t kept = filter(samples, 1 << 24);
+ * ptrim(samples, 1 << 24, kept);
+ * tga_trim();   // let the backend give back its idle memory as well
+ * @endcode
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "tgalloc.h"
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+// Size of the pages madvise works on
+static inline size_t _tgalloc_trim_page_size(void){
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+#else
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+#endif
+}
+
+/**
+ * @brief Discard the contents of every whole page in a range
+ *
+ * The range stays allocated and accessible, but the pages stop counting
+ * against the resident set until they are written again; their contents are
+ * lost. Partial pages at either end are left alone.
+ *
+ * @param ptr  Start of the range
+ * @param size Number of bytes in the range
+ * @return Number of bytes discarded
+ */
+static inline size_t tga_release_pages(void * ptr, size_t size){
+    if (ptr == NULL) return 0;
+    size_t page = _tgalloc_trim_page_size();
+    uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(uintptr_t)(page - 1);
+    uintptr_t end = ((uintptr_t)ptr + size) & ~(uintptr_t)(page - 1);
+    if (end <= start) return 0;
+    size_t length = (size_t)(end - start);
+#if defined(_WIN32)
+    if (VirtualAlloc((void*)start, length, MEM_RESET, PAGE_READWRITE) == NULL) return 0;
+#elif defined(TGA_TRIM_LAZY) && defined(MADV_FREE)
+    if (madvise((void*)start, length, MADV_FREE) != 0) return 0;
+#elif defined(MADV_DONTNEED)
+    if (madvise((void*)start, length, MADV_DONTNEED) != 0) return 0;
+#elif defined(POSIX_MADV_DONTNEED)
+    // Only a hint: the pages may stay resident
+    if (posix_madvise((void*)start, length, POSIX_MADV_DONTNEED) != 0) return 0;
+#else
+    return 0;
+#endif
+    return length;
+}
+
+// Discard the tail a shrink gives up, while the block still owns it
+static inline void * _tgalloc_release_tail(void * ptr, size_t old_size, size_t new_size){
+    if (new_size < old_size) tga_release_pages((char*)ptr + new_size, old_size - new_size);
+    return ptr;
+}
+
+/**
+ * @brief Shrink an array and return the pages of its tail to the system
+ *
+ * Like pprealloc to a smaller length, except that the whole pages past the
+ * new end are discarded first, so they leave the resident set even when the
+ * backend keeps the block where it is. The array may move, and is always
+ * updated in place like with palloc.
+ *
+ * @param ptr     Pointer to the array to shrink
+ * @param old_len Current number of elements
+ * @param new_len New number of elements; at most old_len
+ */
+#define ptrim(ptr, old_len, new_len) ((ptr) = (_tgalloc_typeof(ptr))_tgalloc_call_realloc(TGA_REALLOC_A_S, \
+    _tgalloc_tga(_tgalloc_sizeof(ptr)), _tgalloc_release_tail((void*)(ptr), _tgalloc_sizeof_n(ptr, old_len), \
+    _tgalloc_sizeof_n(ptr, new_len)), _tgalloc_alignof(ptr), _tgalloc_sizeof(ptr), _tgalloc_sizeof_n(ptr, old_len), \
+    _tgalloc_sizeof_n(ptr, new_len)))
+
+#endif // TGALLOC_TRIM_H
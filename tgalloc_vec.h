@@ -0,0 +1,148 @@
+#ifndef TGALLOC_VEC_H
+#define TGALLOC_VEC_H
+
+/**
+ * @file tgalloc_vec.h
+ * @brief Type-generic growable array on top of the active backend
+ *
+ * A tgvec(T) keeps its length and capacity next to the data, so pushing
+ * grows the storage geometrically instead of by one element, and every
+ * resize and free hands the backend the exact byte sizes it was given,
+ * which sized-free backends rely on. When growing, the capacity also takes
+ * in whatever slack the backend rounded the block up to (see
+ * palloc_at_least). All storage goes through whichever TGA is active where
+ * the macros are used.
+ *
+ * Usage:
+ * @code
+ * typedef tgvec(int) int_vec;
+ *
+ * int_vec v = TGVEC_INIT;
+ * for (int i = 0; i < 1000; i++) {
+ *     if (!tgvec_push(v, i)) handle_oom();
+ * }
+ * tgvec_free(v);
+ * @endcode
+ *
+ * The macros evaluate the vector argument several times, so it should be a
+ * plain variable or member; the other arguments are evaluated at most once
+ * per operation except where noted.
+ */
+
+#include <stdint.h>
+#include "tgalloc.h"
+
+/**
+ * @def TGA_VEC_MIN_CAP
+ * @brief Capacity of a vector's first allocation when pushing
+ */
+#ifndef TGA_VEC_MIN_CAP
+#define TGA_VEC_MIN_CAP 4
+#endif
+
+/**
+ * @brief Declare a vector of T
+ *
+ * Each use declares a distinct struct type, so name it with a typedef to
+ * pass vectors between functions.
+ */
+#define tgvec(T) struct { T * data; size_t len; size_t cap; }
+
+/**
+ * @brief Initialiser for an empty vector, which owns no memory
+ */
+#define TGVEC_INIT {NULL, 0, 0}
+
+// Next capacity when pushing onto a full vector of cap elements; the caller
+// makes sure cap is below the largest representable element count
+static inline size_t _tgalloc_vec_grow_cap(size_t cap, size_t elem_size){
+    size_t max = SIZE_MAX / elem_size;
+    size_t grown = cap <= max / 2 ? cap * 2 : max;
+    if (grown < TGA_VEC_MIN_CAP) grown = TGA_VEC_MIN_CAP < max ? TGA_VEC_MIN_CAP : max;
+    return grown;
+}
+
+// Adopt a resized block, or keep the old one and its capacity on failure
+static inline void * _tgalloc_vec_adopt(void * resized, void * old, size_t * cap, size_t new_cap){
+    if (resized == NULL) return old;
+    *cap = new_cap;
+    return resized;
+}
+
+// Storage for exactly n elements, allocated or resized from the current capacity
+#define _tgalloc_vec_resize(v, n) \
+    ((v).data = (_tgalloc_typeof((v).data))_tgalloc_vec_adopt((v).data \
+        ? _tgalloc_realloc2((v).data, (v).cap, n) \
+        : _tgalloc_retry(_tgalloc_call_alloc(TGA_ALLOC_A_S, _tgalloc_tga(_tgalloc_sizeof((v).data)), \
+            _tgalloc_alignof((v).data), _tgalloc_sizeof((v).data), _tgalloc_sizeof_n((v).data, n)), \
+            _tgalloc_alignof((v).data), _tgalloc_sizeof_n((v).data, n)), \
+        (v).data, &(v).cap, n))
+
+// Extend the capacity over the slack the backend left behind the storage
+#define _tgalloc_vec_take_slack(v) \
+    ((v).data ? (void)((v).cap = _tgalloc_take_slack((v).data, (v).cap)) : (void)0)
+
+/**
+ * @brief Make room for at least n elements without further allocation
+ *
+ * On failure the vector is left unchanged. The capacity may end up above n
+ * when the backend rounds the block up. n is evaluated more than once and
+ * must not depend on the vector itself.
+ *
+ * @param v Vector
+ * @param n Required capacity
+ * @return Non-zero on success, 0 if the storage could not be grown
+ */
+#define tgvec_reserve(v, n) \
+    ((n) <= (v).cap ? 1 \
+     : (n) > SIZE_MAX / _tgalloc_sizeof((v).data) ? 0 \
+     : (_tgalloc_vec_resize(v, (n)), _tgalloc_vec_take_slack(v), (v).cap >= (n)))
+
+// Grow a full vector geometrically; non-zero if there is room afterwards
+#define _tgalloc_vec_grow(v) \
+    ((v).cap < SIZE_MAX / _tgalloc_sizeof((v).data) \
+     && (_tgalloc_vec_resize(v, _tgalloc_vec_grow_cap((v).cap, _tgalloc_sizeof((v).data))), \
+         _tgalloc_vec_take_slack(v), (v).len < (v).cap))
+
+/**
+ * @brief Append an element, growing the storage geometrically when full
+ *
+ * @param v     Vector
+ * @param value Value to append, evaluated only if there is room
+ * @return Non-zero on success, 0 if the storage could not be grown
+ */
+#define tgvec_push(v, value) \
+    (((v).len < (v).cap || _tgalloc_vec_grow(v)) ? ((v).data[(v).len++] = (value), 1) : 0)
+
+/**
+ * @brief Remove and return the last element; the vector must not be empty
+ */
+#define tgvec_pop(v) ((v).data[--(v).len])
+
+/**
+ * @brief Remove all elements but keep the storage
+ */
+#define tgvec_clear(v) ((void)((v).len = 0))
+
+/**
+ * @brief Release the storage of a vector and leave it empty
+ */
+#define tgvec_free(v) \
+    ((v).data ? _tgalloc_pfree2((v).data, (v).cap) : (void)0, \
+     (v).data = NULL, (v).len = 0, (void)((v).cap = 0))
+
+/**
+ * @brief Shrink the storage to the current length
+ *
+ * An empty vector releases its storage entirely. If the backend cannot
+ * resize, the vector keeps its current storage.
+ *
+ * @param v Vector
+ * @return Non-zero if the capacity now equals the length
+ */
+#define tgvec_shrink_to_fit(v) \
+    ((v).len == (v).cap ? 1 \
+     : (v).len == 0 ? (tgvec_free(v), 1) \
+     : (_tgalloc_vec_resize(v, (v).len), (v).cap == (v).len))
+
+#endif // TGALLOC_VEC_H